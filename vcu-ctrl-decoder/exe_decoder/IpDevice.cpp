@@ -41,6 +41,8 @@
 #include "IpDevice.h"
 #include "lib_app/console.h"
 #include "lib_app/utils.h"
+#include "lib_app/AllocatorTracker.h"
+#include "lib_app/SharedStatusDispatcher.h"
 
 
 extern "C"
@@ -64,35 +66,55 @@ AL_TAllocator* createDmaAllocator(const char* deviceName)
 extern "C"
 {
 #include "lib_common/HardwareDriver.h"
-AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver*);
+AL_TIDecChannel* AL_DecChannelMcu_CreateWithDispatcher(AL_TDriver*, AL_TStatusDispatcher*);
 }
 
-static unique_ptr<CIpDevice> createMcuIpDevice()
+static AL_TIDecChannel* createMcuDecChannel(int iStatusWorkers)
+{
+  auto pDecChannel = AL_DecChannelMcu_CreateWithDispatcher(AL_GetHardwareDriver(), getStatusDispatcher(iStatusWorkers));
+
+  if(!pDecChannel)
+    throw runtime_error("Failed to create MCU scheduler");
+
+  return pDecChannel;
+}
+
+static unique_ptr<CIpDevice> createMcuIpDevice(bool trackDma, int iStatusWorkers)
 {
   auto device = make_unique<CIpDevice>();
 
-  device->m_pAllocator.reset(createDmaAllocator("/dev/allegroDecodeIP"), &AL_Allocator_Destroy);
+  AL_TAllocator* pAllocator = createDmaAllocator("/dev/allegroDecodeIP");
 
-  if(!device->m_pAllocator)
+  if(!pAllocator)
     throw runtime_error("Can't open DMA allocator");
 
-  device->m_pDecChannel = AL_DecChannelMcu_Create(AL_GetHardwareDriver());
+  if(trackDma)
+    pAllocator = createAllocatorTracker(pAllocator, true);
 
-  if(!device->m_pDecChannel)
-    throw runtime_error("Failed to create MCU scheduler");
+  device->m_pAllocator.reset(pAllocator, &AL_Allocator_Destroy);
+
+  device->m_pDecChannel = createMcuDecChannel(iStatusWorkers);
 
   return device;
 }
 
 
-shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int uNumCore, int hangers)
+shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int uNumCore, int hangers, int iStatusWorkers)
 {
-  (void)iUseBoard, (void)wrapIpCtrl, (void)uNumCore, (void)trackDma, (void)hangers;
+  (void)iUseBoard, (void)wrapIpCtrl, (void)uNumCore, (void)hangers;
+
 
 
+  if(iSchedulerType == SCHEDULER_TYPE_MCU)
+    return createMcuIpDevice(trackDma, iStatusWorkers);
 
+  throw runtime_error("No support for this scheduling type");
+}
+
+AL_TIDecChannel* CreateDecChannel(int iSchedulerType, int iStatusWorkers)
+{
   if(iSchedulerType == SCHEDULER_TYPE_MCU)
-    return createMcuIpDevice();
+    return createMcuDecChannel(iStatusWorkers);
 
   throw runtime_error("No support for this scheduling type");
 }
@@ -55,5 +55,8 @@ struct CIpDevice
   AL_Timer* m_pTimer;
 };
 
-std::shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int uNumCore = 0, int hangers = 0);
+std::shared_ptr<CIpDevice> CreateIpDevice(int* iUseBoard, int iSchedulerType, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int uNumCore = 0, int hangers = 0, int iStatusWorkers = 0);
+
+/* The decoder owns its channel: each decoder sharing the device needs one more */
+AL_TIDecChannel* CreateDecChannel(int iSchedulerType, int iStatusWorkers = 0);
 
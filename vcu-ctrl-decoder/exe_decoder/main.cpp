@@ -50,6 +50,8 @@
 #include <mutex>
 #include <queue>
 #include <map>
+#include <thread>
+#include <vector>
 extern "C"
 {
 #include "lib_common/BufferSrcMeta.h"
@@ -65,6 +67,7 @@ extern "C"
 #include "lib_app/convert.h"
 #include "lib_app/timing.h"
 #include "lib_app/utils.h"
+#include "lib_app/AllocatorTracker.h"
 #include "lib_app/CommandLineParser.h"
 
 
@@ -153,11 +156,15 @@ struct Config
   IpCtrlMode ipCtrlMode = IPCTRL_MODE_STANDARD;
   string logsFile = "";
   bool trackDma = false;
+  string sDmaTimeline = "";
+  int iStatusWorkers = 0;
   int hangers = 0;
   int iLoop = 1;
   int iTimeoutInSeconds = -1;
   int iMaxFrames = INT_MAX;
   string seiFile = "";
+  string sFarmList = "";
+  string sFarmSummary = "";
 };
 
 /******************************************************************************/
@@ -379,6 +386,21 @@ static Config ParseCommandLine(int argc, char* argv[])
   opt.addInt("-loop", &Config.iLoop, "Number of Decoding loop (optional)");
 
   opt.addString("--log", &Config.logsFile, "A file where logged events will be dumped");
+  opt.addFlag("--track-dma", &Config.trackDma, "Account the dma allocations and print where the memory went and how many dmabufs were imported on exit");
+  opt.addOption("--track-dma-csv", [&]()
+  {
+    Config.sDmaTimeline = opt.popWord();
+    Config.trackDma = true;
+  }, "Track the dma allocations and dump the usage per category in a csv file every 100ms");
+  opt.addInt("--status-workers", &Config.iStatusWorkers, "Collect the channel statuses on a pool of n threads shared by all the channels instead of one thread per channel (0 by default)");
+  opt.addOption("--thread-cfg", [&]()
+  {
+    SetThreadConfig(opt.popWord());
+  }, "Pin and prioritize a named thread: 'name:cpus[:policy[:priority[:stacksize]]]', e.g. 'al_dec_feeder:2,3:fifo:50'. Can be repeated");
+  opt.addOption("--rtos-pool", [&]()
+  {
+    EnableRtosMallocPool();
+  }, "Serve the small control allocations from per-thread pools and print the pool statistics on exit");
 
 
   string preAllocArgs = "";
@@ -386,6 +408,8 @@ static Config ParseCommandLine(int argc, char* argv[])
   opt.addInt("--max-frames", &Config.iMaxFrames, "Abort after max number of decoded frames (approximative abort)");
   opt.addString("--prealloc-args", &preAllocArgs, "Specify stream's parameters: '1920x1080:video-mode:422:10:profile-idc:level'.");
   opt.addString("--sei-file", &Config.seiFile, "File in which the SEI decoded by the decoder will be dumped");
+  opt.addString("--farm", &Config.sFarmList, "Decode concurrently the streams listed in this file, one '<bitstream> [-avc|-hevc]' per line, with a shared dma allocator. No yuv is written, -loop and --max-frames apply to each stream");
+  opt.addString("--farm-summary", &Config.sFarmSummary, "Json file receiving the per-channel and aggregated statistics of --farm (default: stdout)");
 
   opt.parse(argc, argv);
 
@@ -440,7 +464,13 @@ static Config ParseCommandLine(int argc, char* argv[])
     Config.tDecSettings.iStackSize = max(1, Config.tDecSettings.iStackSize);
   }
 
-  if(Config.sIn.empty())
+  if(!Config.sFarmList.empty())
+  {
+    /* the farm reports the memory usage from the allocator tracker */
+    Config.trackDma = true;
+    Config.bEnableYUVOutput = false;
+  }
+  else if(Config.sIn.empty())
     throw runtime_error("No input file specified (use -h to get help)");
 
   return Config;
@@ -798,6 +828,10 @@ struct Display
   unsigned int MaxFrames = UINT_MAX;
   mutex hMutex;
   int iNumFrameConceal = 0;
+  bool bShowStatus = true;
+  uint64_t uFirstFrameTime = 0; /* GetPerfTime of the first and last displayed pictures */
+  uint64_t uLastFrameTime = 0;
+  uint64_t uMaxFrameInterval = 0;
 };
 
 struct ResChgParam
@@ -809,6 +843,8 @@ struct ResChgParam
   AL_TAllocator* pAllocator;
   AL_TDecSettings* pSettings;
   mutex hMutex;
+  AL_TDimension tDim {};
+  size_t zFrameBufferBytes = 0;
 };
 
 struct DecodeParam
@@ -898,9 +934,18 @@ void Display::Process(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo)
     AL_Decoder_PutDisplayPicture(hDec, pFrame);
 
     // TODO: increase only when last frame
-    DisplayFrameStatus(NumFrames);
+    if(bShowStatus)
+      DisplayFrameStatus(NumFrames);
     NumFrames++;
 
+    auto const uNow = GetPerfTime();
+
+    if(!uFirstFrameTime)
+      uFirstFrameTime = uNow;
+    else
+      uMaxFrameInterval = max(uMaxFrameInterval, uNow - uLastFrameTime);
+    uLastFrameTime = uNow;
+
     if(NumFrames > MaxFrames)
       Rtos_SetEvent(hExitMain);
   }
@@ -1044,6 +1089,8 @@ static AL_ERR sResolutionFound(int BufferNumber, int BufferSizeLib, AL_TStreamSe
     return AL_ERR_NO_MEMORY;
 
   p->bPoolIsInit = true;
+  p->tDim = tDimension;
+  p->zFrameBufferBytes = BufPoolConfig.zBufSize * BufPoolConfig.uNumBuf;
 
   for(int i = 0; i < (int)BufPoolConfig.uNumBuf; ++i)
   {
@@ -1085,8 +1132,9 @@ void ShowStatistics(double durationInSeconds, int iNumFrameConceal, int decodedF
 /******************************************************************************/
 struct AsyncFileInput
 {
-  AsyncFileInput(AL_HDecoder hDec_, string path, BufPool& bufPool_)
-    : hDec(hDec_), bufPool(bufPool_)
+  /* iLoop: number of times the file is fed, the decoder is only flushed after the last one */
+  AsyncFileInput(AL_HDecoder hDec_, string path, BufPool& bufPool_, int iLoop_ = 1)
+    : hDec(hDec_), bufPool(bufPool_), iLoop(iLoop_)
   {
     exit = false;
     OpenInput(ifFileStream, path);
@@ -1120,6 +1168,13 @@ private:
 
       if(!uAvailSize)
       {
+        if(--iLoop > 0)
+        {
+          ifFileStream.clear();
+          ifFileStream.seekg(0);
+          continue;
+        }
+
         // end of input
         AL_Decoder_Flush(hDec);
         break;
@@ -1135,10 +1190,331 @@ private:
   const AL_HDecoder hDec;
   ifstream ifFileStream;
   BufPool& bufPool;
+  int iLoop;
   atomic<bool> exit;
   thread m_thread;
 };
 
+/******************************************************************************/
+struct FarmStream
+{
+  string sIn;
+  AL_ECodec eCodec;
+};
+
+static vector<FarmStream> ReadFarmList(string const& sListFile, AL_ECodec eDefaultCodec)
+{
+  ifstream ifList;
+  OpenInput(ifList, sListFile, false);
+
+  vector<FarmStream> streams;
+  string sLine;
+
+  while(getline(ifList, sLine))
+  {
+    stringstream ss(sLine);
+    FarmStream stream { "", eDefaultCodec };
+
+    if(!(ss >> stream.sIn) || stream.sIn[0] == '#')
+      continue;
+
+    string sOption;
+
+    while(ss >> sOption)
+    {
+      if(sOption == "-avc")
+        stream.eCodec = AL_CODEC_AVC;
+      else if(sOption == "-hevc")
+        stream.eCodec = AL_CODEC_HEVC;
+      else
+        throw runtime_error("Unknown option '" + sOption + "' in " + sListFile);
+    }
+
+    streams.push_back(stream);
+  }
+
+  if(streams.empty())
+    throw runtime_error("No bitstream listed in " + sListFile);
+
+  return streams;
+}
+
+/******************************************************************************/
+struct FarmChannel
+{
+  ~FarmChannel()
+  {
+    /* unblocks the feeder if the channel timed out */
+    streamPool.Decommit();
+    producer.reset();
+
+    if(hDec)
+      AL_Decoder_Destroy(hDec);
+  }
+
+  FarmStream tStream;
+  AL_TDecSettings Settings;
+  BufPool streamPool;
+  Display display;
+  ResChgParam resChg;
+  DecodeParam decodeParam {};
+  AL_HDecoder hDec = NULL;
+  unique_ptr<AsyncFileInput> producer;
+  bool bTimeout = false;
+};
+
+/* the processes' counters are only known on linux: -1 elsewhere */
+static long ReadProcValue(string const& sFile, string const& sKey)
+{
+  ifstream ifProc(sFile);
+  string sLine;
+
+  while(getline(ifProc, sLine))
+  {
+    if(sLine.compare(0, sKey.size(), sKey) == 0 && sLine.size() > sKey.size() && sLine[sKey.size()] == ':')
+      return atol(sLine.c_str() + sKey.size() + 1);
+  }
+
+  return -1;
+}
+
+struct FarmMonitor
+{
+  FarmMonitor()
+  {
+    iCmaTotalKB = ReadProcValue("/proc/meminfo", "CmaTotal");
+    m_thread = thread(&FarmMonitor::run, this);
+  }
+
+  ~FarmMonitor()
+  {
+    Stop();
+  }
+
+  void Stop()
+  {
+    if(!m_thread.joinable())
+      return;
+    exit = true;
+    m_thread.join();
+  }
+
+  long iCmaTotalKB = -1;
+  long iCmaMinFreeKB = -1;
+  long iMaxThreads = -1;
+
+private:
+  void run()
+  {
+    while(!exit)
+    {
+      auto iCmaFreeKB = ReadProcValue("/proc/meminfo", "CmaFree");
+
+      if(iCmaFreeKB >= 0 && (iCmaMinFreeKB < 0 || iCmaFreeKB < iCmaMinFreeKB))
+        iCmaMinFreeKB = iCmaFreeKB;
+
+      iMaxThreads = max(iMaxThreads, ReadProcValue("/proc/self/status", "Threads"));
+      this_thread::sleep_for(chrono::milliseconds(100));
+    }
+  }
+
+  atomic<bool> exit { false };
+  thread m_thread;
+};
+
+static string ToJson(string const& s)
+{
+  stringstream ss;
+  ss << '"';
+
+  for(auto c : s)
+  {
+    if(c == '"' || c == '\\')
+      ss << '\\' << c;
+    else if((unsigned char)c < 0x20)
+      ss << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec;
+    else
+      ss << c;
+  }
+
+  ss << '"';
+  return ss.str();
+}
+
+static void WriteFarmSummary(ostream& out, vector<unique_ptr<FarmChannel>>& channels, uint64_t uBegin, uint64_t uEnd, FarmMonitor const& monitor, AL_TAllocator* pAllocator)
+{
+  auto const duration = max<uint64_t>(uEnd - uBegin, 1) / 1000.0;
+  int iTotalFrames = 0;
+
+  out << "{" << endl << "  \"channels\": [" << endl;
+
+  for(size_t i = 0; i < channels.size(); ++i)
+  {
+    auto& chan = *channels[i];
+    auto& display = chan.display;
+    unique_lock<mutex> lock(display.hMutex);
+    auto const eErr = AL_Decoder_GetLastError(chan.hDec);
+    int const iFrames = display.NumFrames;
+    iTotalFrames += iFrames;
+
+    /* the frame rate is measured until the last picture was displayed */
+    auto const active = (iFrames ? max<uint64_t>(display.uLastFrameTime - uBegin, 1) : max<uint64_t>(uEnd - uBegin, 1)) / 1000.0;
+    auto const avgInterval = iFrames > 1 ? double(display.uLastFrameTime - display.uFirstFrameTime) / (iFrames - 1) : 0.0;
+
+    out << "    {";
+    out << " \"id\": " << i;
+    out << ", \"input\": " << ToJson(chan.tStream.sIn);
+    out << ", \"codec\": \"" << (chan.tStream.eCodec == AL_CODEC_AVC ? "avc" : "hevc") << "\"";
+    out << ", \"width\": " << chan.resChg.tDim.iWidth;
+    out << ", \"height\": " << chan.resChg.tDim.iHeight;
+    out << ", \"frames\": " << iFrames;
+    out << ", \"concealed_frames\": " << display.iNumFrameConceal;
+    out << ", \"fps\": " << iFrames / active;
+    out << ", \"first_frame_latency_ms\": " << (iFrames ? display.uFirstFrameTime - uBegin : 0);
+    out << ", \"avg_frame_interval_ms\": " << avgInterval;
+    out << ", \"max_frame_interval_ms\": " << display.uMaxFrameInterval;
+    out << ", \"frame_buffers_bytes\": " << chan.resChg.zFrameBufferBytes;
+    out << ", \"timeout\": " << (chan.bTimeout ? "true" : "false");
+    out << ", \"error\": " << (eErr != AL_SUCCESS ? ToJson(ToString(eErr)) : "null");
+    out << " }" << (i + 1 < channels.size() ? "," : "") << endl;
+  }
+
+  auto const total = GetAllocatorTrackerTotal(pAllocator);
+  auto const byCategory = GetAllocatorTrackerStatsByCategory(pAllocator);
+
+  out << "  ]," << endl << "  \"aggregate\": {" << endl;
+  out << "    \"channels\": " << channels.size() << "," << endl;
+  out << "    \"duration_s\": " << duration << "," << endl;
+  out << "    \"frames\": " << iTotalFrames << "," << endl;
+  out << "    \"fps\": " << iTotalFrames / duration << "," << endl;
+  out << "    \"max_threads\": " << monitor.iMaxThreads << "," << endl;
+  out << "    \"cma_total_kb\": " << monitor.iCmaTotalKB << "," << endl;
+  out << "    \"cma_min_free_kb\": " << monitor.iCmaMinFreeKB << "," << endl;
+  out << "    \"dma_peak_bytes\": " << total.peakBytes << "," << endl;
+  out << "    \"dma_current_bytes\": " << total.currentBytes << "," << endl;
+  out << "    \"dma_alloc_count\": " << total.allocCount << "," << endl;
+  out << "    \"dma_peak_bytes_by_category\": {";
+
+  bool bFirst = true;
+
+  for(auto& category : byCategory)
+  {
+    if(!category.second.allocCount)
+      continue;
+    out << (bFirst ? " " : ", ") << ToJson(category.first) << ": " << category.second.peakBytes;
+    bFirst = false;
+  }
+
+  out << " }" << endl << "  }" << endl << "}" << endl;
+}
+
+/******************************************************************************/
+static void RunFarm(Config const& Config, vector<FarmStream> const& streams, shared_ptr<CIpDevice> pIpDevice, int iUseBoard)
+{
+  auto pAllocator = pIpDevice->m_pAllocator.get();
+
+  vector<unique_ptr<FarmChannel>> channels;
+
+  for(size_t i = 0; i < streams.size(); ++i)
+  {
+    channels.emplace_back(new FarmChannel);
+    auto& chan = *channels.back();
+    chan.tStream = streams[i];
+
+    AL_TBufPoolConfig BufPoolConfig {};
+    BufPoolConfig.zBufSize = Config.zInputBufferSize;
+    BufPoolConfig.uNumBuf = Config.uInputBufferNum;
+    BufPoolConfig.pMetaData = nullptr;
+    BufPoolConfig.debugName = "stream";
+
+    if(!chan.streamPool.Init(AL_GetDefaultAllocator(), BufPoolConfig))
+      throw runtime_error("Can't create BufPool");
+
+    chan.display.iBitDepth = Config.tDecSettings.iBitDepth;
+    chan.display.MaxFrames = Config.iMaxFrames;
+    chan.display.bShowStatus = false;
+
+    chan.Settings = Config.tDecSettings;
+    chan.Settings.eCodec = chan.tStream.eCodec;
+
+    chan.resChg.pAllocator = pAllocator;
+    chan.resChg.bPoolIsInit = false;
+    chan.resChg.pDecSettings = &chan.Settings;
+    chan.decodeParam.hExitMain = chan.display.hExitMain;
+
+    AL_TDecCallBacks CB {};
+    CB.endDecodingCB = { &sFrameDecoded, &chan.decodeParam };
+    CB.displayCB = { &sFrameDisplay, &chan.display };
+    CB.resolutionFoundCB = { &sResolutionFound, &chan.resChg };
+    CB.parsedSeiCB = { &sParsedSei, nullptr };
+
+    chan.Settings.iBitDepth = HW_IP_BIT_DEPTH;
+
+    /* the first channel was created with the device */
+    auto pDecChannel = i == 0 ? pIpDevice->m_pDecChannel : CreateDecChannel(Config.iSchedulerType, Config.iStatusWorkers);
+    auto error = AL_Decoder_Create(&chan.hDec, pDecChannel, pAllocator, &chan.Settings, &CB);
+
+    if(error != AL_SUCCESS)
+      throw codec_error(error);
+
+    chan.display.hDec = chan.hDec;
+    chan.decodeParam.hDec = chan.hDec;
+    chan.resChg.hDec = chan.hDec;
+
+    AL_Decoder_SetParam(chan.hDec, Config.bConceal, iUseBoard ? true : false, Config.iNumTrace, Config.iNumberTrace, Config.bForceCleanBuffers);
+
+    if(!invalidPreallocSettings(Config.tDecSettings.tStream))
+    {
+      if(!AL_Decoder_PreallocateBuffers(chan.hDec))
+        if(auto eErr = AL_Decoder_GetLastError(chan.hDec))
+          throw codec_error(eErr);
+    }
+  }
+
+  Message(CC_DEFAULT, "Decoding %d streams\n", (int)channels.size());
+
+  FarmMonitor monitor;
+  auto const uBegin = GetPerfTime();
+
+  for(auto& chan : channels)
+    chan->producer.reset(new AsyncFileInput(chan->hDec, chan->tStream.sIn, chan->streamPool, Config.iLoop));
+
+  auto const uDeadline = uBegin + (uint64_t)Config.iTimeoutInSeconds * 1000;
+
+  for(auto& chan : channels)
+  {
+    auto timeout = AL_WAIT_FOREVER;
+
+    if(Config.iTimeoutInSeconds >= 0)
+    {
+      auto const uNow = GetPerfTime();
+      timeout = uNow < uDeadline ? (uint32_t)(uDeadline - uNow) : 0;
+    }
+
+    chan->bTimeout = !Rtos_WaitEvent(chan->display.hExitMain, timeout);
+  }
+
+  auto const uEnd = GetPerfTime();
+  monitor.Stop();
+
+  for(auto& chan : channels)
+  {
+    unique_lock<mutex> lock(chan->display.hMutex);
+    Message(CC_DEFAULT, "  [%2d] %s: %d frames, %d concealed%s\n", int(&chan - &channels[0]), chan->tStream.sIn.c_str(),
+            chan->display.NumFrames, chan->display.iNumFrameConceal, chan->bTimeout ? ", TIMEOUT" : "");
+  }
+
+  if(Config.sFarmSummary.empty())
+  {
+    WriteFarmSummary(cout, channels, uBegin, uEnd, monitor, pAllocator);
+    return;
+  }
+
+  ofstream summary;
+  OpenOutput(summary, Config.sFarmSummary, false);
+  WriteFarmSummary(summary, channels, uBegin, uEnd, monitor, pAllocator);
+}
+
 /******************************************************************************/
 void SafeMain(int argc, char** argv)
 {
@@ -1149,11 +1525,20 @@ void SafeMain(int argc, char** argv)
 
   DisplayVersionInfo();
 
+  auto scopeMallocStats = scopeExit([]() {
+    PrintRtosMallocStats();
+  });
+
   ofstream seiOutput;
 
   if(!Config.seiFile.empty())
     OpenOutput(seiOutput, Config.seiFile);
 
+  vector<FarmStream> farmStreams;
+
+  if(!Config.sFarmList.empty())
+    farmStreams = ReadFarmList(Config.sFarmList, Config.tDecSettings.eCodec);
+
   // IP Device ------------------------------------------------------------
   auto iUseBoard = Config.iUseBoard;
 
@@ -1169,9 +1554,18 @@ void SafeMain(int argc, char** argv)
     break;
   }
 
-  auto pIpDevice = CreateIpDevice(&iUseBoard, Config.iSchedulerType, wrapIpCtrl, Config.trackDma, Config.tDecSettings.uNumCore, Config.hangers);
+  auto pIpDevice = CreateIpDevice(&iUseBoard, Config.iSchedulerType, wrapIpCtrl, Config.trackDma, Config.tDecSettings.uNumCore, Config.hangers, Config.iStatusWorkers);
+
+  if(!Config.sDmaTimeline.empty())
+    StartAllocatorTrackerTimeline(pIpDevice->m_pAllocator.get(), Config.sDmaTimeline);
 
 
+  if(!Config.sFarmList.empty())
+  {
+    RunFarm(Config, farmStreams, pIpDevice, iUseBoard);
+    return;
+  }
+
   auto pAllocator = pIpDevice->m_pAllocator.get();
   auto pDecChannel = pIpDevice->m_pDecChannel;
 
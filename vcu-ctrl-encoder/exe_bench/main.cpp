@@ -0,0 +1,1039 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* Checks of the encoder app pieces that can run without the hardware.
+ *
+ * --transcode runs the FrameBridge of the transcode mode between a stand-in
+ * decoder and a stand-in encoder pipeline. The stand-in decoder owns a few
+ * frame buffers and only pushes a frame once the bridge gave it back, the
+ * stand-in encoder keeps references on the last frames like the source
+ * pipeline does. Each case checks the pictures sent, dropped and repeated
+ * for a frame rate conversion and a picture limit, that no frame is copied or
+ * lost, and that every frame is stamped for the latency from the first one.
+ * It also checks that the frames still queued are given back on close.
+ *
+ * --yuv-read reads a 1080p NV12 file through YuvFileInput. The file is sparse
+ * and larger than 4GB: only its last frames are written, so the pictures are
+ * read past the 32-bit offsets. Each case picks the frames with a stride, a
+ * frame rate conversion or a loop, in a buffer with the file rows and in one
+ * with padded rows, and checks the content of every row, the frames read and
+ * the frames skipped. The read throughput is printed next to the one of the
+ * same frames read with std::ifstream seeks.
+ *
+ * The process exits with 1 as soon as a check failed. The harness isn't part of
+ * the encoder app: main.cpp is built with the app include paths and linked with
+ * exe_encoder/TranscodeSource.cpp, exe_encoder/YuvFileInput.cpp,
+ * exe_encoder/CodecUtils.cpp, exe_encoder/SceneChangeDetector.cpp,
+ * exe_encoder/SyntheticSource.cpp, lib_app and the control software library. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "exe_encoder/SceneChangeDetector.h"
+#include "exe_encoder/SyntheticSource.h"
+#include "exe_encoder/TranscodeSource.h"
+#include "exe_encoder/YuvFileInput.h"
+#include "exe_encoder/sink_latency.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "lib_common/Allocator.h"
+#include "lib_common/BufferSrcMeta.h"
+#include "lib_common/Utils.h"
+}
+
+using namespace std;
+
+static int const iNumFrames = 4; /* decoder frame buffers */
+static int const iNumHeld = 3; /* frames kept by the encoder pipeline */
+static AL_TDimension const tAllocDim = { 64, 72 };
+static AL_TDimension const tDisplayDim = { 60, 70 };
+
+struct TTranscodeCase
+{
+  char const* pName;
+  int iInFrameRate;
+  int iOutFrameRate;
+  int iNumPushed;
+  int iMaxPict;
+};
+
+/* what FrameBridge::Run is expected to do with the case */
+struct TExpected
+{
+  int iSent = 0;
+  int iFirstSent = 0;
+  int iRepeated = 0;
+  int iDropped = 0;
+  int iNotSent = 0;
+};
+
+static TExpected GetExpected(TTranscodeCase const& tCase)
+{
+  TExpected tExp;
+  int iOutput = 0;
+
+  for(int iInput = 0; iInput < tCase.iNumPushed; ++iInput)
+  {
+    int iShown = 0;
+
+    while(iOutput != tCase.iMaxPict && (int64_t)iOutput * tCase.iInFrameRate / tCase.iOutFrameRate == iInput)
+    {
+      ++iShown;
+      ++iOutput;
+    }
+
+    tExp.iSent += iShown;
+
+    if(iShown)
+    {
+      ++tExp.iFirstSent;
+      tExp.iRepeated += iShown - 1;
+    }
+    else
+    {
+      ++tExp.iNotSent;
+
+      if(iOutput != tCase.iMaxPict)
+        ++tExp.iDropped;
+    }
+  }
+
+  return tExp;
+}
+
+/*****************************************************************************/
+/* the decoder frame buffers, given back by the bridge release hook */
+struct StandInDecoder
+{
+  StandInDecoder()
+  {
+    for(int i = 0; i < iNumFrames; ++i)
+    {
+      auto pFrame = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), tAllocDim.iWidth * tAllocDim.iHeight * 3 / 2, [](AL_TBuffer*) {});
+
+      if(!pFrame)
+        throw runtime_error("Can't allocate the stand-in decoder frames");
+
+      AL_TPitches tPitches { tAllocDim.iWidth, tAllocDim.iWidth };
+      AL_TOffsetYC tOffsetYC { 0, tAllocDim.iWidth * tAllocDim.iHeight };
+      AL_Buffer_AddMetaData(pFrame, (AL_TMetaData*)AL_SrcMetaData_Create(tAllocDim, tPitches, tOffsetYC, FOURCC(NV12)));
+      frames.push_back(pFrame);
+      freeFrames.push_back(pFrame);
+    }
+  }
+
+  ~StandInDecoder()
+  {
+    for(auto pFrame : frames)
+      AL_Buffer_Destroy(pFrame);
+  }
+
+  AL_TBuffer* GetFreeFrame()
+  {
+    unique_lock<mutex> lock(m_mutex);
+    m_frameReleased.wait(lock, [&]() {
+      return !freeFrames.empty();
+    });
+    auto pFrame = freeFrames.front();
+    freeFrames.pop_front();
+    return pFrame;
+  }
+
+  void Release(AL_TBuffer* pFrame)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    freeFrames.push_back(pFrame);
+    ++iReleased;
+    m_frameReleased.notify_one();
+  }
+
+  bool IsFrameData(AL_TBuffer* pAlias)
+  {
+    for(auto pFrame : frames)
+    {
+      if(AL_Buffer_GetData(pFrame) == AL_Buffer_GetData(pAlias))
+        return true;
+    }
+
+    return false;
+  }
+
+  vector<AL_TBuffer*> frames;
+  deque<AL_TBuffer*> freeFrames;
+  int iReleased = 0;
+
+private:
+  mutex m_mutex;
+  condition_variable m_frameReleased;
+};
+
+/* the frames stamped by the bridge hooks and not taken by the latency sink yet */
+struct StampChecker
+{
+  void Queued(AL_TBuffer const* pFrame)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    ++iQueued;
+    stamped.insert(pFrame);
+  }
+
+  void Dropped(AL_TBuffer const* pFrame)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    ++iDropped;
+    stamped.erase(pFrame);
+  }
+
+  /* false if the frame wasn't stamped or was already sent */
+  bool TakeStamped(AL_TBuffer const* pFrame)
+  {
+    lock_guard<mutex> lock(m_mutex);
+    return stamped.erase(pFrame) != 0;
+  }
+
+  int iQueued = 0;
+  int iDropped = 0;
+  set<AL_TBuffer const*> stamped;
+
+private:
+  mutex m_mutex;
+};
+
+/* in front of the latency sink: the frames must reach it stamped */
+struct StampCheckSink : IFrameSink
+{
+  explicit StampCheckSink(StampChecker& checker) : m_checker(checker)
+  {
+  }
+
+  void ProcessFrame(AL_TBuffer* Src) override
+  {
+    if(Src && m_checker.TakeStamped(Src))
+      ++iStampedSent;
+    next->ProcessFrame(Src);
+  }
+
+  IFrameSink* next;
+  int iStampedSent = 0;
+
+private:
+  StampChecker& m_checker;
+};
+
+struct StandInEncoder : IFrameSink
+{
+  StandInEncoder(StandInDecoder& decoder, LatencySink& latency) : m_decoder(decoder), m_latency(latency)
+  {
+  }
+
+  void ProcessFrame(AL_TBuffer* Src) override
+  {
+    if(!Src)
+    {
+      for(auto pHeld : held)
+        AL_Buffer_Unref(pHeld);
+
+      held.clear();
+      bEndOfStream = true;
+      return;
+    }
+
+    auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(Src, AL_META_TYPE_SOURCE);
+
+    if(!pMeta || pMeta->tDim.iWidth != tDisplayDim.iWidth || pMeta->tDim.iHeight != tDisplayDim.iHeight || !m_decoder.IsFrameData(Src))
+      ++iBadFrames;
+
+    AL_Buffer_Ref(Src);
+    held.push_back(Src);
+
+    if((int)held.size() > iNumHeld)
+    {
+      AL_Buffer_Unref(held.front());
+      held.pop_front();
+    }
+
+    m_latency.EndFrame(Src, true);
+    ++iSent;
+  }
+
+  deque<AL_TBuffer*> held;
+  int iSent = 0;
+  int iBadFrames = 0;
+  bool bEndOfStream = false;
+
+private:
+  StandInDecoder& m_decoder;
+  LatencySink& m_latency;
+};
+
+/*****************************************************************************/
+static int Check(bool bOk, char const* pCase, char const* pWhat, int iValue, int iExpected)
+{
+  if(bOk)
+    return 0;
+  printf("FAILED %s: %s is %d instead of %d\n", pCase, pWhat, iValue, iExpected);
+  return 1;
+}
+
+static int CheckCase(TTranscodeCase const& tCase, double& fFramesPerSec)
+{
+  StandInDecoder decoder;
+  StampChecker checker;
+  auto stamps = make_shared<FrameStamps>();
+
+  int iLimitReached = 0;
+  FrameBridge bridge([&](AL_TBuffer* pFrame) {
+    decoder.Release(pFrame);
+  }, [&](AL_TBuffer const* pFrame) {
+    checker.Queued(pFrame);
+    stamps->Begin(pFrame);
+  }, [&](AL_TBuffer const* pFrame) {
+    checker.Dropped(pFrame);
+    stamps->Cancel(pFrame);
+  });
+  bridge.m_limitReached = [&]() {
+    ++iLimitReached;
+  };
+
+  LatencySink latency;
+  latency.stamps = stamps;
+  StandInEncoder encoder(decoder, latency);
+  StampCheckSink checkSink(checker);
+  latency.next = &encoder;
+  checkSink.next = &latency;
+
+  auto const tBegin = chrono::steady_clock::now();
+
+  thread decoding([&]() {
+    for(int i = 0; i < tCase.iNumPushed; ++i)
+    {
+      auto pFrame = decoder.GetFreeFrame();
+      /* the decoder holds its frame during the display callback */
+      AL_Buffer_Ref(pFrame);
+      bridge.Push(pFrame, tDisplayDim);
+      AL_Buffer_Unref(pFrame);
+    }
+
+    bridge.PushEndOfStream();
+  });
+
+  bridge.Run(&checkSink, tCase.iMaxPict, tCase.iInFrameRate, tCase.iOutFrameRate);
+  decoding.join();
+
+  chrono::duration<double> const tElapsed = chrono::steady_clock::now() - tBegin;
+  fFramesPerSec = tCase.iNumPushed / tElapsed.count();
+
+  auto const tExp = GetExpected(tCase);
+  int iFailures = 0;
+
+  iFailures += Check(encoder.iSent == tExp.iSent, tCase.pName, "the number of pictures sent", encoder.iSent, tExp.iSent);
+  iFailures += Check(bridge.GetRepeatedCount() == tExp.iRepeated, tCase.pName, "the number of repeated pictures", bridge.GetRepeatedCount(), tExp.iRepeated);
+  iFailures += Check(bridge.GetDroppedCount() == tExp.iDropped, tCase.pName, "the number of dropped pictures", bridge.GetDroppedCount(), tExp.iDropped);
+  iFailures += Check(encoder.iBadFrames == 0, tCase.pName, "the number of frames with another dimension or memory", encoder.iBadFrames, 0);
+  iFailures += Check(encoder.bEndOfStream, tCase.pName, "the end of stream", encoder.bEndOfStream, 1);
+  iFailures += Check(iLimitReached == (tCase.iMaxPict != -1 && tExp.iSent == tCase.iMaxPict), tCase.pName, "the number of limit notifications", iLimitReached, tCase.iMaxPict != -1 && tExp.iSent == tCase.iMaxPict);
+  iFailures += Check(checker.iQueued == tCase.iNumPushed, tCase.pName, "the number of frames stamped", checker.iQueued, tCase.iNumPushed);
+  iFailures += Check(checkSink.iStampedSent == tExp.iFirstSent, tCase.pName, "the number of stamped frames sent", checkSink.iStampedSent, tExp.iFirstSent);
+  iFailures += Check(checker.iDropped == tExp.iNotSent, tCase.pName, "the number of frames unstamped", checker.iDropped, tExp.iNotSent);
+  iFailures += Check(checker.stamped.empty(), tCase.pName, "the number of stamps left", (int)checker.stamped.size(), 0);
+  iFailures += Check(decoder.iReleased == tCase.iNumPushed, tCase.pName, "the number of frames given back", decoder.iReleased, tCase.iNumPushed);
+  iFailures += Check((int)decoder.freeFrames.size() == iNumFrames, tCase.pName, "the number of free decoder frames", (int)decoder.freeFrames.size(), iNumFrames);
+
+  return iFailures;
+}
+
+/* the frames queued when the bridge is closed and the ones pushed after are given back */
+static int CheckClose()
+{
+  StandInDecoder decoder;
+  StampChecker checker;
+  int iFailures = 0;
+  {
+    FrameBridge bridge([&](AL_TBuffer* pFrame) {
+      decoder.Release(pFrame);
+    }, [&](AL_TBuffer const* pFrame) {
+      checker.Queued(pFrame);
+    }, [&](AL_TBuffer const* pFrame) {
+      checker.Dropped(pFrame);
+    });
+
+    auto pFrame = decoder.GetFreeFrame();
+    bridge.Push(pFrame, tDisplayDim);
+    pFrame = decoder.GetFreeFrame();
+    bridge.Push(pFrame, tDisplayDim);
+    bridge.Close();
+
+    pFrame = decoder.GetFreeFrame();
+    bridge.Push(pFrame, tDisplayDim);
+
+    iFailures += Check(decoder.iReleased == 3, "close", "the number of frames given back", decoder.iReleased, 3);
+    iFailures += Check(checker.iQueued == 2 && checker.iDropped == 2, "close", "the number of frames unstamped", checker.iDropped, 2);
+  }
+
+  return iFailures;
+}
+
+/*****************************************************************************/
+static int Bench_Transcode(int iIterations)
+{
+  TTranscodeCase const cases[] =
+  {
+    { "same rate", 30, 30, 60, -1 },
+    { "half rate", 60, 30, 60, -1 },
+    { "double rate", 30, 60, 60, -1 },
+    { "25 to 30 fps", 25, 30, 60, -1 },
+    { "30 to 25 fps", 30, 25, 60, -1 },
+    { "picture limit", 30, 30, 60, 20 },
+    { "limit after repeat", 30, 60, 60, 41 },
+    { "no picture", 30, 30, 10, 0 },
+  };
+
+  int iFailures = 0;
+
+  for(auto const& tCase : cases)
+  {
+    double fBest = 0.0;
+
+    for(int i = 0; i < iIterations; ++i)
+    {
+      double fFramesPerSec;
+      int const iCaseFailures = CheckCase(tCase, fFramesPerSec);
+      fBest = max(fBest, fFramesPerSec);
+      iFailures += iCaseFailures;
+
+      /* one report per case is enough, the next iterations would repeat it */
+      if(iCaseFailures)
+        break;
+    }
+
+    printf("%-28s %10.0f frames/s through the bridge\n", tCase.pName, fBest);
+  }
+
+  iFailures += CheckClose();
+
+  printf("%s\n", iFailures ? "transcode checks FAILED" : "transcode checks passed");
+  return iFailures ? 1 : 0;
+}
+
+/*****************************************************************************/
+static AL_TDimension const tYuvDim = { 1920, 1080 };
+static int64_t const iYuvFrameSize = tYuvDim.iWidth * tYuvDim.iHeight * 3 / 2;
+static int const iYuvNumFrames = 1500; /* 4.6GB */
+static int const iYuvFirstWritten = 1400; /* the frames before are holes */
+
+struct TYuvReadCase
+{
+  char const* pName;
+  int iFirstPict;
+  int iPictStride;
+  int iFileFrameRate;
+  int iEncFrameRate;
+  int iNumPict;
+  bool bLoop;
+  int iSkipped;
+};
+
+/* row y of the frame f holds (f + y) for the luma, (f + y + 128) for the chroma */
+static uint8_t GetRowValue(int64_t iFrame, int iRow, bool bChroma)
+{
+  if(iFrame < iYuvFirstWritten)
+    return 0;
+  return (uint8_t)(iFrame + iRow + (bChroma ? 128 : 0));
+}
+
+static string CreateYuvFile()
+{
+  char sFileName[] = "/tmp/exe_bench_yuv_XXXXXX";
+  int iFd = mkstemp(sFileName);
+
+  if(iFd < 0)
+    throw runtime_error("Can't create the yuv file");
+
+  vector<uint8_t> frame(iYuvFrameSize);
+  bool bWritten = ftruncate(iFd, (off_t)iYuvNumFrames * iYuvFrameSize) == 0;
+
+  for(int64_t iFrame = iYuvFirstWritten; bWritten && iFrame < iYuvNumFrames; ++iFrame)
+  {
+    for(int iRow = 0; iRow < tYuvDim.iHeight * 3 / 2; ++iRow)
+    {
+      bool const bChroma = iRow >= tYuvDim.iHeight;
+      memset(&frame[iRow * tYuvDim.iWidth], GetRowValue(iFrame, bChroma ? iRow - tYuvDim.iHeight : iRow, bChroma), tYuvDim.iWidth);
+    }
+
+    bWritten = pwrite(iFd, frame.data(), frame.size(), iFrame * iYuvFrameSize) == (ssize_t)frame.size();
+  }
+
+  close(iFd);
+
+  if(!bWritten)
+  {
+    unlink(sFileName);
+    throw runtime_error("Can't write the yuv file");
+  }
+
+  return sFileName;
+}
+
+static AL_TBuffer* CreateYuvBuffer(int iPitch)
+{
+  auto pBuf = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), iPitch * tYuvDim.iHeight * 3 / 2, [](AL_TBuffer*) {});
+
+  if(!pBuf)
+    throw runtime_error("Can't allocate the yuv buffer");
+
+  AL_TPitches tPitches { iPitch, iPitch };
+  AL_TOffsetYC tOffsetYC { 0, iPitch * tYuvDim.iHeight };
+  AL_Buffer_AddMetaData(pBuf, (AL_TMetaData*)AL_SrcMetaData_Create(tYuvDim, tPitches, tOffsetYC, FOURCC(NV12)));
+  return pBuf;
+}
+
+/* the rows of the frame and the padding after them */
+static bool IsFrameRead(AL_TBuffer* pBuf, int64_t iFrame)
+{
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
+  int const iPitch = pMeta->tPitches.iLuma;
+
+  for(int iRow = 0; iRow < tYuvDim.iHeight * 3 / 2; ++iRow)
+  {
+    bool const bChroma = iRow >= tYuvDim.iHeight;
+    uint8_t const* pRow = AL_Buffer_GetData(pBuf) + iRow * iPitch;
+    uint8_t const uValue = GetRowValue(iFrame, bChroma ? iRow - tYuvDim.iHeight : iRow, bChroma);
+    uint8_t const uPadding = bChroma ? 0x80 : 0;
+
+    for(int i = 0; i < iPitch; ++i)
+    {
+      if(pRow[i] != (i < tYuvDim.iWidth ? uValue : uPadding))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+static int CheckYuvCase(string const& sFileName, TYuvReadCase const& tCase, AL_TBuffer* pBuf, char const* pLayout, double& fReadRate)
+{
+  TYUVFileInfo tFileInfo {};
+  tFileInfo.FourCC = FOURCC(NV12);
+  tFileInfo.PictWidth = tYuvDim.iWidth;
+  tFileInfo.PictHeight = tYuvDim.iHeight;
+  tFileInfo.FrameRate = tCase.iFileFrameRate;
+
+  YuvFileInput input(sFileName, tFileInfo, tCase.iFirstPict, tCase.iPictStride, tCase.iEncFrameRate);
+
+  string const sCase = string(tCase.pName) + ", " + pLayout;
+  int iFailures = 0;
+  int iBadFrames = 0;
+  int iPict = 0;
+
+  while(iPict < tCase.iNumPict && input.ReadPicture(iPict, pBuf, tCase.bLoop))
+  {
+    if(!IsFrameRead(pBuf, input.GetFrameIndex(iPict) % iYuvNumFrames))
+      ++iBadFrames;
+    ++iPict;
+  }
+
+  fReadRate = input.GetReadRate();
+
+  iFailures += Check(input.GetNumFrames() == iYuvNumFrames, sCase.c_str(), "the number of file frames", (int)input.GetNumFrames(), iYuvNumFrames);
+  iFailures += Check(iPict == tCase.iNumPict, sCase.c_str(), "the number of pictures read", iPict, tCase.iNumPict);
+  iFailures += Check(input.GetReadCount() == tCase.iNumPict, sCase.c_str(), "the read count", input.GetReadCount(), tCase.iNumPict);
+  iFailures += Check(input.GetSkipCount() == tCase.iSkipped, sCase.c_str(), "the skip count", (int)input.GetSkipCount(), tCase.iSkipped);
+  iFailures += Check(iBadFrames == 0, sCase.c_str(), "the number of pictures with another content", iBadFrames, 0);
+
+  return iFailures;
+}
+
+/* the same frames read by seeking a std::ifstream, in a buffer with the file rows */
+static double GetStreamReadRate(string const& sFileName, TYuvReadCase const& tCase, AL_TBuffer* pBuf)
+{
+  ifstream file(sFileName, ios::binary);
+  int64_t iNextFrame = -1;
+
+  auto const tBegin = chrono::steady_clock::now();
+
+  for(int iPict = 0; iPict < tCase.iNumPict; ++iPict)
+  {
+    int64_t iFrame = tCase.iFirstPict + (int64_t)iPict * tCase.iPictStride * tCase.iFileFrameRate / tCase.iEncFrameRate;
+    iFrame %= iYuvNumFrames;
+
+    if(iFrame != iNextFrame)
+      file.seekg(iFrame * iYuvFrameSize, ios::beg);
+
+    file.read((char*)AL_Buffer_GetData(pBuf), iYuvFrameSize);
+    iNextFrame = iFrame + 1;
+  }
+
+  chrono::duration<double, micro> const tElapsed = chrono::steady_clock::now() - tBegin;
+
+  if(!file.good())
+    throw runtime_error("Can't read the yuv file with std::ifstream");
+
+  return tCase.iNumPict * iYuvFrameSize / tElapsed.count();
+}
+
+static int Bench_YuvRead(int iIterations)
+{
+  TYuvReadCase const cases[] =
+  {
+    { "sequential", iYuvFirstWritten, 1, 30, 30, 100, false, 0 },
+    { "stride 2", iYuvFirstWritten, 2, 30, 30, 50, false, 49 },
+    { "stride 7", iYuvFirstWritten, 7, 30, 30, 15, false, 84 },
+    { "60 to 30 fps", iYuvFirstWritten, 1, 60, 30, 50, false, 49 },
+    { "30 to 60 fps", iYuvFirstWritten, 1, 30, 60, 200, false, 0 },
+    { "loop", iYuvNumFrames - 20, 1, 30, 30, 40, true, 0 },
+  };
+
+  auto const sFileName = CreateYuvFile();
+  auto pBuf = CreateYuvBuffer(tYuvDim.iWidth);
+  auto pPaddedBuf = CreateYuvBuffer(2048);
+  int iFailures = 0;
+
+  printf("%-16s %14s %14s %14s\n", "", "file rows", "padded rows", "std::ifstream");
+
+  for(auto const& tCase : cases)
+  {
+    double fBest = 0.0;
+    double fBestPadded = 0.0;
+    double fBestStream = 0.0;
+
+    for(int i = 0; i < iIterations; ++i)
+    {
+      double fReadRate;
+      int iCaseFailures = CheckYuvCase(sFileName, tCase, pBuf, "file rows", fReadRate);
+      fBest = max(fBest, fReadRate);
+      iCaseFailures += CheckYuvCase(sFileName, tCase, pPaddedBuf, "padded rows", fReadRate);
+      fBestPadded = max(fBestPadded, fReadRate);
+      fBestStream = max(fBestStream, GetStreamReadRate(sFileName, tCase, pBuf));
+      iFailures += iCaseFailures;
+
+      if(iCaseFailures)
+        break;
+    }
+
+    printf("%-16s %9.0f MB/s %9.0f MB/s %9.0f MB/s\n", tCase.pName, fBest, fBestPadded, fBestStream);
+  }
+
+  AL_Buffer_Destroy(pPaddedBuf);
+  AL_Buffer_Destroy(pBuf);
+  unlink(sFileName.c_str());
+
+  printf("%s\n", iFailures ? "yuv read checks FAILED" : "yuv read checks passed");
+  return iFailures ? 1 : 0;
+}
+
+/*****************************************************************************/
+static AL_TDimension const tSourceDim = { 1920, 1080 };
+
+struct TSourceLayout
+{
+  char const* pName;
+  TFourCC tFourCC;
+};
+
+static TSourceLayout const sourceLayouts[] =
+{
+  { "NV12", FOURCC(NV12) },
+  { "P010", FOURCC(P010) },
+  { "XV15", FOURCC(XV15) },
+  { "T608", FOURCC(T608) },
+  { "T60A", FOURCC(T60A) },
+};
+
+/* a 4:2:0 semi planar source buffer in the layout of the encoder sources */
+static AL_TBuffer* CreateSourceBuffer(AL_TDimension tDim, TFourCC tFourCC)
+{
+  int iPitch = tDim.iWidth * AL_GetPixelSize(tFourCC);
+  int iNumRows = tDim.iHeight;
+  int iNumRowsC = tDim.iHeight / 2;
+
+  if(AL_IsTiled(tFourCC))
+  {
+    // one pitch line holds 4 pixel lines
+    iPitch = RoundUp(tDim.iWidth, 64) * 4 * AL_GetBitDepth(tFourCC) / 8;
+    iNumRows = RoundUp(tDim.iHeight, 4) / 4;
+    iNumRowsC = RoundUp(tDim.iHeight / 2, 4) / 4;
+  }
+  else if(AL_Is10bitPacked(tFourCC))
+    iPitch = (tDim.iWidth + 2) / 3 * 4;
+
+  auto pBuf = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), iPitch * (iNumRows + iNumRowsC), [](AL_TBuffer*) {});
+
+  if(!pBuf)
+    throw runtime_error("Can't allocate the source buffer");
+
+  AL_TPitches tPitches { iPitch, iPitch };
+  AL_TOffsetYC tOffsetYC { 0, iPitch * iNumRows };
+  AL_Buffer_AddMetaData(pBuf, (AL_TMetaData*)AL_SrcMetaData_Create(tDim, tPitches, tOffsetYC, tFourCC));
+  return pBuf;
+}
+
+struct TSceneCase
+{
+  char const* pName;
+  int iMinInterval;
+  vector<int> cuts; /* first frame of each scene but the first one */
+  vector<int> detected; /* cuts expected to be reported */
+};
+
+/* the scenes cycle through the patterns, each one moving in its own direction */
+static void FillScene(vector<SyntheticSource>& scenes, AL_TBuffer* pBuf, vector<int> const& cuts, int iFrame)
+{
+  int iScene = 0;
+
+  while(iScene < (int)cuts.size() && iFrame >= cuts[iScene])
+    ++iScene;
+
+  scenes[iScene % scenes.size()].Fill(pBuf, iFrame);
+}
+
+static int CheckSceneCase(TSceneCase const& tCase, TSourceLayout const& tLayout, int iNumFrames, double& fCost)
+{
+  vector<SyntheticSource> scenes;
+  ESyntheticPattern const patterns[] = { SYNTHETIC_BARS, SYNTHETIC_GRADIENT, SYNTHETIC_PLAIN };
+
+  for(int i = 0; i < 3; ++i)
+  {
+    TSyntheticParam tParam;
+    tParam.ePattern = patterns[i];
+    tParam.iMotionX = 4 - 3 * i;
+    tParam.iMotionY = 2 + i;
+    scenes.emplace_back(tParam, tSourceDim.iWidth, tSourceDim.iHeight);
+  }
+
+  TSceneChangeParam tParam;
+  tParam.iMinInterval = tCase.iMinInterval;
+  SceneChangeDetector detector(tParam);
+
+  auto pBuf = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+  vector<int> detected;
+
+  for(int iFrame = 0; iFrame < iNumFrames; ++iFrame)
+  {
+    FillScene(scenes, pBuf, tCase.cuts, iFrame);
+
+    if(detector.Process(pBuf))
+      detected.push_back(iFrame);
+  }
+
+  AL_Buffer_Destroy(pBuf);
+  fCost = detector.GetAverageCost();
+
+  string const sCase = string(tCase.pName) + ", " + tLayout.pName;
+  int iFailures = 0;
+  iFailures += Check(detector.GetFrameCount() == iNumFrames, sCase.c_str(), "the number of frames analysed", detector.GetFrameCount(), iNumFrames);
+  iFailures += Check(detected.size() == tCase.detected.size(), sCase.c_str(), "the number of scene changes", (int)detected.size(), (int)tCase.detected.size());
+
+  for(size_t i = 0; i < min(detected.size(), tCase.detected.size()); ++i)
+    iFailures += Check(detected[i] == tCase.detected[i], sCase.c_str(), "the frame of a scene change", detected[i], tCase.detected[i]);
+
+  return iFailures;
+}
+
+static int Bench_SceneChange(int iIterations)
+{
+  int const iNumFrames = 60;
+  TSceneCase const cases[] =
+  {
+    { "cuts", 5, { 10, 25, 40, 52 }, { 10, 25, 40, 52 } },
+    { "close cuts", 5, { 10, 12, 30, 33, 38 }, { 10, 30, 38 } },
+  };
+
+  int iFailures = 0;
+
+  printf("%-12s", "");
+
+  for(auto const& tLayout : sourceLayouts)
+    printf(" %12s", tLayout.pName);
+
+  printf("\n");
+
+  for(auto const& tCase : cases)
+  {
+    printf("%-12s", tCase.pName);
+
+    for(auto const& tLayout : sourceLayouts)
+    {
+      double fBest = 0.0;
+
+      for(int i = 0; i < iIterations; ++i)
+      {
+        double fCost;
+        int const iCaseFailures = CheckSceneCase(tCase, tLayout, iNumFrames, fCost);
+        fBest = (i == 0) ? fCost : min(fBest, fCost);
+        iFailures += iCaseFailures;
+
+        if(iCaseFailures)
+          break;
+      }
+
+      printf(" %7.1f us/f", fBest);
+    }
+
+    printf("\n");
+  }
+
+  printf("%s\n", iFailures ? "scene change checks FAILED" : "scene change checks passed");
+  return iFailures ? 1 : 0;
+}
+
+/*****************************************************************************/
+static int GetLumaSample(AL_TBuffer* pBuf, int x, int y)
+{
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
+  uint8_t const* pLuma = AL_Buffer_GetData(pBuf) + pMeta->tOffsetYC.iLuma;
+  int const iPitch = pMeta->tPitches.iLuma;
+  int const iBitDepth = AL_GetBitDepth(pMeta->tFourCC);
+
+  if(AL_IsTiled(pMeta->tFourCC))
+  {
+    uint8_t const* pBlk = pLuma + (y / 4) * iPitch + (x / 4) * 16 * iBitDepth / 8;
+    int const iSample = (y % 4) * 4 + x % 4;
+
+    if(iBitDepth == 8)
+      return pBlk[iSample];
+
+    int const iBit = iSample * 10;
+    return ((pBlk[iBit / 8] | (pBlk[iBit / 8 + 1] << 8)) >> (iBit % 8)) & 0x3FF;
+  }
+
+  if(AL_Is10bitPacked(pMeta->tFourCC))
+    return (((uint32_t const*)(pLuma + y * iPitch))[x / 3] >> (10 * (x % 3))) & 0x3FF;
+
+  if(AL_GetPixelSize(pMeta->tFourCC) == 1)
+    return pLuma[y * iPitch + x];
+
+  return ((uint16_t const*)(pLuma + y * iPitch))[x];
+}
+
+/* the luma of pFrame is the one of pFirst shifted by the motion of iFrame frames,
+ * give or take iNoise */
+static int CountBadSamples(AL_TBuffer* pFirst, AL_TBuffer* pFrame, TSyntheticParam const& tParam, int iFrame, int iNoise, int& iNoisySamples)
+{
+  int const iOffsetX = (iFrame * tParam.iMotionX) % tSourceDim.iWidth;
+  int const iOffsetY = (iFrame * tParam.iMotionY) % tSourceDim.iHeight;
+  int iBadSamples = 0;
+
+  for(int y = 0; y < tSourceDim.iHeight; ++y)
+  {
+    for(int x = 0; x < tSourceDim.iWidth; ++x)
+    {
+      int const iExpected = GetLumaSample(pFirst, (x + iOffsetX) % tSourceDim.iWidth, (y + iOffsetY) % tSourceDim.iHeight);
+      int const iDiff = abs(GetLumaSample(pFrame, x, y) - iExpected);
+
+      if(iDiff > iNoise)
+        ++iBadSamples;
+      else if(iDiff)
+        ++iNoisySamples;
+    }
+  }
+
+  return iBadSamples;
+}
+
+static int CheckSynthetic(TSourceLayout const& tLayout, int iNoise)
+{
+  TSyntheticParam tParam;
+  tParam.ePattern = SYNTHETIC_BARS;
+  SyntheticSource reference(tParam, tSourceDim.iWidth, tSourceDim.iHeight);
+  tParam.iNoise = iNoise;
+  SyntheticSource source(tParam, tSourceDim.iWidth, tSourceDim.iHeight);
+
+  auto pFirst = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+  auto pFrame = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+  reference.Fill(pFirst, 0);
+
+  string const sCase = string(iNoise ? "noise, " : "motion, ") + tLayout.pName;
+  int const iMaxNoise = iNoise << (AL_GetBitDepth(tLayout.tFourCC) - 8);
+  int iFailures = 0;
+
+  /* 500 frames move the pattern by more than the picture width */
+  for(int iFrame : { 0, 1, 7, 500 })
+  {
+    int iNoisySamples = 0;
+    source.Fill(pFrame, iFrame);
+    int const iBadSamples = CountBadSamples(pFirst, pFrame, tParam, iFrame, iMaxNoise, iNoisySamples);
+    iFailures += Check(iBadSamples == 0, sCase.c_str(), "the number of luma samples off the shifted first frame", iBadSamples, 0);
+
+    if(iNoise)
+      iFailures += Check(iNoisySamples > 0, sCase.c_str(), "the number of luma samples with noise", iNoisySamples, 1);
+  }
+
+  AL_Buffer_Destroy(pFrame);
+  AL_Buffer_Destroy(pFirst);
+  return iFailures;
+}
+
+static double GetGenerationRate(TSourceLayout const& tLayout, int iNoise, int iNumFrames)
+{
+  TSyntheticParam tParam;
+  tParam.ePattern = SYNTHETIC_BARS;
+  tParam.iNoise = iNoise;
+  SyntheticSource source(tParam, tSourceDim.iWidth, tSourceDim.iHeight);
+  auto pBuf = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+
+  // the first frame renders the canvas
+  source.Fill(pBuf, 0);
+  auto const tBegin = chrono::steady_clock::now();
+
+  for(int iFrame = 1; iFrame <= iNumFrames; ++iFrame)
+    source.Fill(pBuf, iFrame);
+
+  chrono::duration<double> const tElapsed = chrono::steady_clock::now() - tBegin;
+  AL_Buffer_Destroy(pBuf);
+  return iNumFrames / tElapsed.count();
+}
+
+static double GetCopyRate(TSourceLayout const& tLayout, int iNumFrames)
+{
+  auto pSrc = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+  auto pDst = CreateSourceBuffer(tSourceDim, tLayout.tFourCC);
+  memset(AL_Buffer_GetData(pSrc), 0x80, pSrc->zSize);
+  auto const tBegin = chrono::steady_clock::now();
+
+  for(int iFrame = 0; iFrame < iNumFrames; ++iFrame)
+    memcpy(AL_Buffer_GetData(pDst), AL_Buffer_GetData(pSrc), pSrc->zSize);
+
+  chrono::duration<double> const tElapsed = chrono::steady_clock::now() - tBegin;
+  AL_Buffer_Destroy(pDst);
+  AL_Buffer_Destroy(pSrc);
+  return iNumFrames / tElapsed.count();
+}
+
+static int Bench_Synthetic(int iIterations)
+{
+  int const iNumFrames = 30;
+  int iFailures = 0;
+
+  printf("%-6s %14s %14s %14s\n", "", "motion", "noise 8", "memcpy");
+
+  for(auto const& tLayout : sourceLayouts)
+  {
+    int const iLayoutFailures = CheckSynthetic(tLayout, 0) + CheckSynthetic(tLayout, 8);
+    iFailures += iLayoutFailures;
+
+    if(iLayoutFailures)
+      continue;
+
+    double fBest = 0.0;
+    double fBestNoise = 0.0;
+    double fBestCopy = 0.0;
+
+    for(int i = 0; i < iIterations; ++i)
+    {
+      fBest = max(fBest, GetGenerationRate(tLayout, 0, iNumFrames));
+      fBestNoise = max(fBestNoise, GetGenerationRate(tLayout, 8, iNumFrames));
+      fBestCopy = max(fBestCopy, GetCopyRate(tLayout, iNumFrames));
+    }
+
+    printf("%-6s %10.0f f/s %10.0f f/s %10.0f f/s\n", tLayout.pName, fBest, fBestNoise, fBestCopy);
+  }
+
+  printf("%s\n", iFailures ? "synthetic source checks FAILED" : "synthetic source checks passed");
+  return iFailures ? 1 : 0;
+}
+
+/*****************************************************************************/
+static void Usage(char const* pExe)
+{
+  fprintf(stderr, "Usage: %s <mode> [options]\n", pExe);
+  fprintf(stderr, "Modes:\n");
+  fprintf(stderr, "  --transcode           Check the transcode frame bridge with a stand-in decoder and encoder\n");
+  fprintf(stderr, "  --yuv-read            Check and time the yuv input reads in a sparse file larger than 4GB\n");
+  fprintf(stderr, "  --scene-change        Check and time the scene change detector on synthetic scenes\n");
+  fprintf(stderr, "  --synthetic           Check and time the synthetic source in each source layout\n");
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --iterations <n>      Number of runs per case ('20')\n");
+}
+
+int main(int argc, char** argv)
+{
+  char const* pMode = nullptr;
+  int iIterations = 20;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(!strcmp(argv[i], "--iterations") && i + 1 < argc)
+      iIterations = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "--transcode") || !strcmp(argv[i], "--yuv-read") || !strcmp(argv[i], "--scene-change") || !strcmp(argv[i], "--synthetic"))
+      pMode = argv[i];
+    else
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(!pMode || iIterations <= 0)
+  {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  try
+  {
+    if(!strcmp(pMode, "--yuv-read"))
+      return Bench_YuvRead(iIterations);
+
+    if(!strcmp(pMode, "--scene-change"))
+      return Bench_SceneChange(iIterations);
+
+    if(!strcmp(pMode, "--synthetic"))
+      return Bench_Synthetic(iIterations);
+    return Bench_Transcode(iIterations);
+  }
+  catch(runtime_error const& error)
+  {
+    printf("FAILED: %s\n", error.what());
+    return 1;
+  }
+}
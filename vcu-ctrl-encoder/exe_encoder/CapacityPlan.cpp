@@ -0,0 +1,134 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "CapacityPlan.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+/*****************************************************************************/
+TPlanRequest CreateEncoderPlanRequest(string const& sCfgFileName, ConfigFile const& cfg)
+{
+  auto const& tChParam = cfg.Settings.tChParam[0];
+  TPlanRequest request;
+  request.sName = sCfgFileName;
+  request.tChannel.eCodec = AL_PLANNER_ENCODER;
+  request.tChannel.iWidth = tChParam.uWidth;
+  request.tChannel.iHeight = tChParam.uHeight;
+  request.tChannel.iFrameRate = tChParam.tRCParam.uFrameRate;
+  request.tChannel.iClkRatio = tChParam.tRCParam.uClkRatio;
+  request.tChannel.iNumCore = tChParam.uNumCore;
+  return request;
+}
+
+/*****************************************************************************/
+TPlanRequest CreateDecoderPlanRequest(string const& sDescription)
+{
+  TPlanRequest request;
+  request.sName = sDescription;
+  request.tChannel.eCodec = AL_PLANNER_DECODER;
+  request.tChannel.iClkRatio = 1000;
+  request.tChannel.iNumCore = 0;
+
+  if(sscanf(sDescription.c_str(), "%dx%d@%d", &request.tChannel.iWidth, &request.tChannel.iHeight, &request.tChannel.iFrameRate) != 3)
+    throw runtime_error("Invalid decoder channel description '" + sDescription + "', expected WIDTHxHEIGHT@FPS");
+
+  return request;
+}
+
+/*****************************************************************************/
+static char const* ToString(AL_EPlannerCodec eCodec)
+{
+  return eCodec == AL_PLANNER_ENCODER ? "enc" : "dec";
+}
+
+/*****************************************************************************/
+static void PrintReport(AL_TChannelPlanner const& planner, AL_EPlannerCodec eCodec, ostream& out)
+{
+  AL_TPlannerReport tReport;
+  AL_ChannelPlanner_GetReport(&planner, eCodec, &tReport);
+
+  for(int iCore = 0; iCore < tReport.iNumCores; ++iCore)
+    out << ToString(eCodec) << ".core" << iCore << ".load_percent=" << tReport.iCoreLoadPercent[iCore] << endl;
+
+  out << ToString(eCodec) << ".channels=" << tReport.iNumChannels << endl;
+  out << ToString(eCodec) << ".capacity=" << tReport.iCapacity << endl;
+  out << ToString(eCodec) << ".load=" << tReport.iLoad << endl;
+  out << ToString(eCodec) << ".headroom=" << tReport.iHeadroom << endl;
+}
+
+/*****************************************************************************/
+bool RunCapacityPlan(vector<TPlanRequest> const& requests, ostream& out)
+{
+  AL_TChannelPlanner planner;
+  AL_ChannelPlanner_Init(&planner);
+
+  bool bAllFit = true;
+  int iRequest = 0;
+
+  for(auto& request : requests)
+  {
+    auto const& tChannel = request.tChannel;
+    int const iChannelId = AL_ChannelPlanner_AddChannel(&planner, &tChannel);
+    string const sPrefix = "channel" + to_string(iRequest++) + ".";
+
+    out << sPrefix << "name=" << request.sName << endl;
+    out << sPrefix << "type=" << ToString(tChannel.eCodec) << endl;
+    out << sPrefix << "resolution=" << tChannel.iWidth << "x" << tChannel.iHeight << "@" << tChannel.iFrameRate << endl;
+    out << sPrefix << "fits=" << (iChannelId >= 0 ? 1 : 0) << endl;
+
+    if(iChannelId < 0)
+    {
+      bAllFit = false;
+      continue;
+    }
+
+    auto pSlot = AL_ChannelPlanner_GetChannel(&planner, iChannelId);
+    out << sPrefix << "resources=" << pSlot->iResources << endl;
+    out << sPrefix << "num_core=" << pSlot->iNumCore << endl;
+    out << sPrefix << "core_mask=0x" << hex << pSlot->uCoreMask << dec << endl;
+  }
+
+  PrintReport(planner, AL_PLANNER_ENCODER, out);
+  PrintReport(planner, AL_PLANNER_DECODER, out);
+  out << "all_fit=" << (bAllFit ? 1 : 0) << endl;
+
+  return bAllFit;
+}
+
@@ -127,6 +127,21 @@ static void populateInputSection(ConfigParser& parser, ConfigFile& cfg)
   }, "Specifies YUV input format");
   parser.addPath(curSection, "CmdFile", cfg.sCmdFileName, "File containing the dynamic commands to send to the encoder");
   parser.addPath(curSection, "ROIFile", cfg.sRoiFileName, "File containing the Regions of Interest used to encode");
+  std::map<string, int> synthetics {};
+  synthetics["NONE"] = SYNTHETIC_NONE;
+  synthetics["BARS"] = SYNTHETIC_BARS;
+  synthetics["TILES"] = SYNTHETIC_TILES;
+  synthetics["GRADIENT"] = SYNTHETIC_GRADIENT;
+  synthetics["PLAIN"] = SYNTHETIC_PLAIN;
+  parser.addEnum(curSection, "Synthetic", cfg.tSynthetic.ePattern, synthetics, "Generates a moving test pattern in memory instead of reading the YUV input file");
+  parser.addArith(curSection, "SyntheticMotionX", cfg.tSynthetic.iMotionX, "Horizontal motion of the synthetic pattern in pixels per frame");
+  parser.addArith(curSection, "SyntheticMotionY", cfg.tSynthetic.iMotionY, "Vertical motion of the synthetic pattern in pixels per frame");
+  parser.addArith(curSection, "SyntheticNoise", cfg.tSynthetic.iNoise, "Amplitude of the random noise added to the synthetic luma (0 .. 255)");
+  parser.addPath(curSection, "TranscodeFile", cfg.TranscodeFileName, "Decodes this AVC or HEVC bitstream and encodes its frames, without copy, instead of reading the YUV input file");
+  std::map<string, int> transcodeCodecs {};
+  transcodeCodecs["AVC"] = AL_CODEC_AVC;
+  transcodeCodecs["HEVC"] = AL_CODEC_HEVC;
+  parser.addEnum(curSection, "TranscodeCodec", cfg.eTranscodeCodec, transcodeCodecs, "Codec of the TranscodeFile. When it isn't set, the .264, .h264 and .avc extensions select AVC and anything else HEVC");
 #if AL_ENABLE_TWOPASS
   parser.addPath(curSection, "TwoPassFile", cfg.sTwoPassFileName, "File containing the first pass statistics");
 #endif
@@ -423,8 +438,14 @@ static void populateRunSection(ConfigParser& parser, ConfigFile& cfg)
   maxPicts["ALL"] = -1;
   parser.addArithOrEnum(curSection, "MaxPicture", cfg.RunInfo.iMaxPict, maxPicts, "Number of frame to encode");
   parser.addArith(curSection, "FirstPicture", cfg.RunInfo.iFirstPict, "Specifies the first frame to encode");
+  parser.addArith(curSection, "PictureStride", cfg.RunInfo.iPictStride, "Specifies the number of input frames to advance between two encoded frames");
   parser.addArith(curSection, "ScnChgLookAhead", cfg.RunInfo.iScnChgLookAhead);
   parser.addArith(curSection, "InputSleep", cfg.RunInfo.uInputSleepInMilliseconds);
+  parser.addBool(curSection, "SceneChangeDetection", cfg.RunInfo.bSceneChangeDetection, "Specifies if scene changes should be detected on the source frames by the host");
+  parser.addArith(curSection, "ScdDecimation", cfg.RunInfo.tScdParam.iDecimation, "Luma decimation factor used by the scene change detection (4, 8, 16 or 32)");
+  parser.addArith(curSection, "ScdSadThreshold", cfg.RunInfo.tScdParam.iSadThreshold, "Mean absolute luma difference above which a scene change can be detected (0 .. 255)");
+  parser.addArith(curSection, "ScdHistThreshold", cfg.RunInfo.tScdParam.iHistThreshold, "Luma histogram distance above which a scene change can be detected (0 .. 1000)");
+  parser.addArith(curSection, "ScdMinInterval", cfg.RunInfo.tScdParam.iMinInterval, "Minimum number of frames between two detected scene changes");
 }
 
 
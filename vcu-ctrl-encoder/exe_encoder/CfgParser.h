@@ -45,6 +45,8 @@
 #pragma once
 #include "lib_app/InputFiles.h"
 #include "lib_app/utils.h"
+#include "SceneChangeDetector.h"
+#include "SyntheticSource.h"
 
 extern "C"
 {
@@ -56,6 +58,12 @@ extern "C"
 #include <iostream>
 
 
+typedef enum
+{
+  REC_HASH_MD5, /*!< MD5 of the whole reconstructed sequence */
+  REC_HASH_64, /*!< XXH64 of each plane of each reconstructed frame */
+}ERecHash;
+
 /*************************************************************************//*!
    \brief Mimics structure for RUN Section of cfg file
 *****************************************************************************/
@@ -66,14 +74,20 @@ typedef AL_INTROSPECT (category = "debug") struct tCfgRunInfo
   bool bLoop;
   int iMaxPict;
   unsigned int iFirstPict;
+  int iPictStride = 1;
   unsigned int iScnChgLookAhead;
   std::string sMd5Path;
+  ERecHash eRecHash = REC_HASH_MD5;
   int eVQDescr;
   IpCtrlMode ipCtrlMode;
   std::string logsFile = "";
   bool trackDma = false;
+  std::string sDmaTimeline = ""; /* csv file, enables trackDma */
+  int iStatusWorkers = 0;
   bool printPictureType = false;
   AL_64U uInputSleepInMilliseconds;
+  bool bSceneChangeDetection = false;
+  TSceneChangeParam tScdParam;
 }TCfgRunInfo;
 
 
@@ -112,6 +126,15 @@ AL_INTROSPECT(category = "debug") struct ConfigFile
   // \brief Information relative to YUV input file (from section INPUT)
   TYUVFileInfo FileInfo;
 
+  // \brief Procedurally generated source used instead of the YUV input file
+  TSyntheticParam tSynthetic;
+
+  // \brief Bitstream decoded and encoded again instead of the YUV input file
+  std::string TranscodeFileName;
+
+  // \brief Codec of the transcode input. AL_CODEC_INVALID: guessed from the file extension
+  AL_ECodec eTranscodeCodec = AL_CODEC_INVALID;
+
   // \brief FOURCC Code of the reconstructed picture output file
   TFourCC RecFourCC;
 
@@ -43,6 +43,8 @@
 #include <string>
 #include <cassert>
 #include <climits>
+#include <cerrno>
+#include <unistd.h>
 
 extern "C"
 {
@@ -66,37 +68,6 @@ void DisplayFrameStatus(int iFrameNum)
   fflush(stdout);
 }
 
-/*****************************************************************************/
-static int PictureSize(TYUVFileInfo FI)
-{
-  std::ifstream::pos_type iSize;
-  switch(AL_GetChromaMode(FI.FourCC))
-  {
-  case CHROMA_MONO:
-    iSize = FI.PictWidth * FI.PictHeight;
-    break;
-  case CHROMA_4_2_0:
-    iSize = (FI.PictWidth * FI.PictHeight * 3) / 2;
-    break;
-  case CHROMA_4_2_2:
-    iSize = FI.PictWidth * FI.PictHeight * 2;
-    break;
-  default:
-    iSize = 0;
-  }
-
-  auto iPixSize = AL_GetPixelSize(FI.FourCC);
-
-  return iSize * iPixSize;
-}
-
-/*****************************************************************************/
-void GotoFirstPicture(TYUVFileInfo const& FI, std::ifstream& File, unsigned int iFirstPict)
-{
-  int64_t const iPictLen = PictureSize(FI);
-  File.seekg(iPictLen * iFirstPict);
-}
-
 /*****************************************************************************/
 uint32_t GetIOLumaRowSize(TFourCC fourCC, uint32_t uWidth)
 {
@@ -110,24 +81,23 @@ uint32_t GetIOLumaRowSize(TFourCC fourCC, uint32_t uWidth)
 }
 
 /*****************************************************************************/
-int GotoNextPicture(TYUVFileInfo const& FI, std::ifstream& File, int iEncFrameRate, int iEncPictCount, int iFilePictCount)
+int64_t GetFileFrameSize(TYUVFileInfo const& FI)
 {
-  int iMove = ((iEncPictCount * FI.FrameRate) / iEncFrameRate) - iFilePictCount;
+  int64_t const iRowSize = GetIOLumaRowSize(FI.FourCC, FI.PictWidth);
+  int64_t iSize = iRowSize * FI.PictHeight;
 
-  if(iMove != 0)
-  {
-    int iRowSize = GetIOLumaRowSize(FI.FourCC, FI.PictWidth) * FI.PictHeight;
+  if(AL_GetChromaMode(FI.FourCC) == CHROMA_MONO)
+    return iSize;
 
-    if(AL_GetChromaMode(FI.FourCC) != CHROMA_MONO)
-    {
-      int iRx, iRy;
-      AL_GetSubsampling(FI.FourCC, &iRx, &iRy);
-      iRowSize += 2 * (iRowSize / (iRx * iRy));
-    }
+  /* same layout as the one read by ReadOneFrameYuv */
+  int64_t const iNumRowC = (AL_GetChromaMode(FI.FourCC) == CHROMA_4_2_0) ? FI.PictHeight >> 1 : FI.PictHeight;
 
-    File.seekg(iRowSize * iMove, std::ios_base::cur);
-  }
-  return iMove;
+  if(AL_IsSemiPlanar(FI.FourCC))
+    iSize += iRowSize * iNumRowC;
+  else
+    iSize += 2 * (iRowSize >> 1) * iNumRowC;
+
+  return iSize;
 }
 
 typedef struct tPaddingParams
@@ -205,7 +175,8 @@ static void PadBuffer(char* pTmp, TPaddingParams tPadParams, TFourCC tFourCC)
 }
 
 /*****************************************************************************/
-static uint32_t ReadFileLumaPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint32_t uFileRowSize, uint32_t uFileNumRow, bool bPadding = false)
+template<typename TFile>
+static uint32_t ReadFileLumaPlanar(TFile& File, AL_TBuffer* pBuf, uint32_t uFileRowSize, uint32_t uFileNumRow, bool bPadding = false)
 {
   char* pTmp = reinterpret_cast<char*>(AL_Buffer_GetData(pBuf));
 
@@ -243,7 +214,8 @@ static uint32_t ReadFileLumaPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint32
 }
 
 /*****************************************************************************/
-static uint32_t ReadFileChromaPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint32_t uOffset, uint32_t uFileRowSize, uint32_t uFileNumRow, bool bPadding = false)
+template<typename TFile>
+static uint32_t ReadFileChromaPlanar(TFile& File, AL_TBuffer* pBuf, uint32_t uOffset, uint32_t uFileRowSize, uint32_t uFileNumRow, bool bPadding = false)
 {
   char* pTmp = reinterpret_cast<char*>(AL_Buffer_GetData(pBuf) + uOffset);
   AL_TSrcMetaData* pSrcMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
@@ -290,7 +262,8 @@ static uint32_t ReadFileChromaPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint
 }
 
 /*****************************************************************************/
-static void ReadFileChromaSemiPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint32_t uOffset, uint32_t uFileRowSize, uint32_t uFileNumRow)
+template<typename TFile>
+static void ReadFileChromaSemiPlanar(TFile& File, AL_TBuffer* pBuf, uint32_t uOffset, uint32_t uFileRowSize, uint32_t uFileNumRow)
 {
   char* pTmp = reinterpret_cast<char*>(AL_Buffer_GetData(pBuf) + uOffset);
   AL_TSrcMetaData* pSrcMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
@@ -316,7 +289,8 @@ static void ReadFileChromaSemiPlanar(std::ifstream& File, AL_TBuffer* pBuf, uint
 }
 
 /*****************************************************************************/
-static void ReadFile(std::ifstream& File, AL_TBuffer* pBuf, uint32_t uFileRowSize, uint32_t uFileNumRow)
+template<typename TFile>
+static void ReadFile(TFile& File, AL_TBuffer* pBuf, uint32_t uFileRowSize, uint32_t uFileNumRow)
 {
   uint32_t uOffset = ReadFileLumaPlanar(File, pBuf, uFileRowSize, uFileNumRow);
 
@@ -339,31 +313,107 @@ bool IsConversionNeeded(TFourCC const& FourCC, AL_TPicFormat const& picFmt)
   return FourCC != AL_GetFourCC(picFmt);
 }
 
+/* the frame is read from its offset with pread, the file position isn't used */
+class PositionalFile
+{
+public:
+  PositionalFile(int iFd, int64_t iOffset) : m_iFd(iFd), m_iOffset(iOffset)
+  {
+  }
+
+  void read(char* pData, uint32_t uSize)
+  {
+    while(uSize && m_bGood)
+    {
+      ssize_t iRead = pread(m_iFd, pData, uSize, m_iOffset);
+
+      if(iRead < 0 && errno == EINTR)
+        continue;
+
+      if(iRead <= 0)
+      {
+        m_bGood = false;
+        break;
+      }
+
+      pData += iRead;
+      uSize -= iRead;
+      m_iOffset += iRead;
+    }
+  }
+
+  bool good() const { return m_bGood; }
+
+private:
+  int const m_iFd;
+  int64_t m_iOffset;
+  bool m_bGood = true;
+};
+
+/* a frame already read, copied row by row in the padded buffer */
+class MemoryFile
+{
+public:
+  explicit MemoryFile(char const* pData) : m_pData(pData)
+  {
+  }
+
+  void read(char* pData, uint32_t uSize)
+  {
+    memcpy(pData, m_pData, uSize);
+    m_pData += uSize;
+  }
+
+private:
+  char const* m_pData;
+};
+
 /*****************************************************************************/
-bool ReadOneFrameYuv(std::ifstream& File, AL_TBuffer* pBuf, bool bLoop)
+static bool IsPaddingNeeded(AL_TSrcMetaData* pSrcMeta, uint32_t uRowSizeLuma)
 {
-  if(!pBuf || !File.is_open())
-    throw std::runtime_error("invalid argument");
+  if(GetColumnPaddingParameters(pSrcMeta, uRowSizeLuma, true).uNBByteToPad)
+    return true;
 
-  if((File.peek() == EOF) && !bLoop)
+  if(AL_GetChromaMode(pSrcMeta->tFourCC) == CHROMA_MONO)
     return false;
 
+  uint32_t const uRowSizeChroma = AL_IsSemiPlanar(pSrcMeta->tFourCC) ? uRowSizeLuma : uRowSizeLuma >> 1;
+  return GetColumnPaddingParameters(pSrcMeta, uRowSizeChroma, false).uNBByteToPad != 0;
+}
+
+/*****************************************************************************/
+bool ReadOneFrameYuv(int iFd, int64_t iOffset, AL_TBuffer* pBuf, std::vector<char>& FrameData)
+{
+  if(!pBuf || iFd < 0)
+    throw std::runtime_error("invalid argument");
+
   AL_TSrcMetaData* pSrcMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
 
   uint32_t uRowSizeLuma = GetIOLumaRowSize(pSrcMeta->tFourCC, pSrcMeta->tDim.iWidth);
 
-  ReadFile(File, pBuf, uRowSizeLuma, pSrcMeta->tDim.iHeight);
-
-  if((File.rdstate() & std::ios::failbit) && bLoop)
+  // the planes are read straight in the buffer when its rows are the file ones
+  if(!IsPaddingNeeded(pSrcMeta, uRowSizeLuma))
   {
-    File.clear();
-    File.seekg(0, std::ios::beg);
+    PositionalFile File(iFd, iOffset);
     ReadFile(File, pBuf, uRowSizeLuma, pSrcMeta->tDim.iHeight);
+    return File.good();
   }
 
-  if(File.rdstate() & std::ios::failbit)
-    throw std::runtime_error("not enough data for a complete frame");
+  // otherwise the whole frame is read at once, not one row at a time
+  TYUVFileInfo tFrameInfo {};
+  tFrameInfo.FourCC = pSrcMeta->tFourCC;
+  tFrameInfo.PictWidth = pSrcMeta->tDim.iWidth;
+  tFrameInfo.PictHeight = pSrcMeta->tDim.iHeight;
+  FrameData.resize(GetFileFrameSize(tFrameInfo));
+
+  PositionalFile File(iFd, iOffset);
+  File.read(FrameData.data(), FrameData.size());
+
+  if(!File.good())
+    return false;
 
+  MemoryFile Frame(FrameData.data());
+  ReadFile(Frame, pBuf, uRowSizeLuma, pSrcMeta->tDim.iHeight);
   return true;
 }
 
@@ -539,3 +589,47 @@ int WriteStream(std::ofstream& HEVCFile, AL_TBuffer* pStream, const AL_TEncChanP
   return iNumFrame;
 }
 
+/*****************************************************************************/
+AL_TOffsetYC GetOffsetYC(int iPitchY, int iHeight, TFourCC fourCC)
+{
+  AL_TOffsetYC tOffsetYC;
+  tOffsetYC.iLuma = 0;
+  auto const iNumLinesInPitch = AL_GetNumLinesInPitch(AL_GetStorageMode(fourCC));
+  tOffsetYC.iChroma = (int)(iPitchY * iHeight / iNumLinesInPitch);
+  return tOffsetYC;
+}
+
+/*****************************************************************************/
+std::shared_ptr<AL_TBuffer> AllocateConversionBuffer(std::vector<uint8_t>& YuvBuffer, int iWidth, int iHeight, TFourCC tFourCC)
+{
+  /* we want to read from /write to a file, so no alignement is necessary */
+  int const iWidthInBytes = GetIOLumaRowSize(tFourCC, static_cast<uint32_t>(iWidth));
+  AL_TPitches tPitches {
+    iWidthInBytes, AL_IsSemiPlanar(tFourCC) ? iWidthInBytes : iWidthInBytes / 2
+  };
+  uint32_t uSize = tPitches.iLuma * iHeight;
+  switch(AL_GetChromaMode(tFourCC))
+  {
+  case CHROMA_4_2_0:
+    uSize += uSize / 2;
+    break;
+  case CHROMA_4_2_2:
+    uSize += uSize;
+    break;
+  default:
+    break;
+  }
+
+  YuvBuffer.resize(uSize);
+  AL_TBuffer* Yuv = AL_Buffer_WrapData(YuvBuffer.data(), uSize, NULL);
+
+  AL_TOffsetYC tOffsetYC = GetOffsetYC(tPitches.iLuma, iHeight, tFourCC);
+  AL_TDimension tDimension = { iWidth, iHeight };
+  AL_TMetaData* pMeta = (AL_TMetaData*)AL_SrcMetaData_Create(tDimension, tPitches, tOffsetYC, tFourCC);
+
+  if(!pMeta)
+    throw std::runtime_error("Couldn't allocate conversion buffer");
+  AL_Buffer_AddMetaData(Yuv, pMeta);
+
+  return std::shared_ptr<AL_TBuffer>(Yuv, &AL_Buffer_Destroy);
+}
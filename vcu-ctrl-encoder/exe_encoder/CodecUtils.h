@@ -38,7 +38,9 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include "lib_app/console.h"
 #include "lib_app/InputFiles.h"
@@ -54,13 +56,19 @@ extern "C"
 bool IsConversionNeeded(TFourCC const& FourCC, AL_TPicFormat const& picFmt);
 
 /*****************************************************************************/
-void GotoFirstPicture(TYUVFileInfo const& FI, std::ifstream& File, unsigned int iFirstPict = 0);
+int64_t GetFileFrameSize(TYUVFileInfo const& FI);
 
 /*****************************************************************************/
-int GotoNextPicture(TYUVFileInfo const& FI, std::ifstream& File, int iEncFrameRate, int iEncPictCount, int iFilePictCount);
+/* reads the frame at iOffset in the file. FrameData holds the frame when the
+** buffer rows are padded. Returns false when the file ends before the frame */
+bool ReadOneFrameYuv(int iFd, int64_t iOffset, AL_TBuffer* pBuf, std::vector<char>& FrameData);
 
 /*****************************************************************************/
-bool ReadOneFrameYuv(std::ifstream& File, AL_TBuffer* pBuf, bool bLoop);
+AL_TOffsetYC GetOffsetYC(int iPitchY, int iHeight, TFourCC fourCC);
+
+/*****************************************************************************/
+/* a frame buffer without padding, as the yuv files store the frames */
+std::shared_ptr<AL_TBuffer> AllocateConversionBuffer(std::vector<uint8_t>& YuvBuffer, int iWidth, int iHeight, TFourCC tFourCC);
 
 /*****************************************************************************/
 bool WriteOneFrame(std::ofstream& File, AL_TBuffer const* pBuf, int iWidth, int iHeight);
@@ -0,0 +1,196 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "Hash64.h"
+#include <string.h>
+
+static AL_64U const PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static AL_64U const PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static AL_64U const PRIME64_3 = 0x165667B19E3779F9ULL;
+static AL_64U const PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static AL_64U const PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline AL_64U Rot64(AL_64U X, int s)
+{
+  return (X << s) | (X >> (64 - s));
+}
+
+inline AL_64U Read64(uint8_t const* p)
+{
+  AL_64U uVal;
+  memcpy(&uVal, p, sizeof(uVal)); // little endian host
+  return uVal;
+}
+
+inline uint32_t Read32(uint8_t const* p)
+{
+  uint32_t uVal;
+  memcpy(&uVal, p, sizeof(uVal));
+  return uVal;
+}
+
+inline AL_64U Round(AL_64U uAcc, AL_64U uInput)
+{
+  uAcc += uInput * PRIME64_2;
+  return Rot64(uAcc, 31) * PRIME64_1;
+}
+
+inline AL_64U MergeRound(AL_64U uAcc, AL_64U uVal)
+{
+  uAcc ^= Round(0, uVal);
+  return uAcc * PRIME64_1 + PRIME64_4;
+}
+
+/*************************************************************************************/
+CHash64::CHash64(AL_64U uSeed)
+{
+  m_pAcc[0] = uSeed + PRIME64_1 + PRIME64_2;
+  m_pAcc[1] = uSeed + PRIME64_2;
+  m_pAcc[2] = uSeed;
+  m_pAcc[3] = uSeed - PRIME64_1;
+
+  m_uSeed = uSeed;
+  m_uNumBytes = 0;
+  m_uBound = 0;
+}
+
+/*************************************************************************************/
+void CHash64::UpdateStripe(uint8_t const* pStripe)
+{
+  m_pAcc[0] = Round(m_pAcc[0], Read64(pStripe));
+  m_pAcc[1] = Round(m_pAcc[1], Read64(pStripe + 8));
+  m_pAcc[2] = Round(m_pAcc[2], Read64(pStripe + 16));
+  m_pAcc[3] = Round(m_pAcc[3], Read64(pStripe + 24));
+}
+
+/*************************************************************************************/
+void CHash64::Update(uint8_t const* pBuffer, size_t zSize)
+{
+  m_uNumBytes += zSize;
+
+  if(m_uBound)
+  {
+    while(zSize && m_uBound < sizeof(m_pBound))
+    {
+      m_pBound[m_uBound++] = *pBuffer++;
+      zSize--;
+    }
+
+    if(m_uBound < sizeof(m_pBound))
+      return;
+
+    UpdateStripe(m_pBound);
+    m_uBound = 0;
+  }
+
+  // keep the 4 lanes in registers for the bulk of the data
+  AL_64U v1 = m_pAcc[0], v2 = m_pAcc[1], v3 = m_pAcc[2], v4 = m_pAcc[3];
+
+  while(zSize >= sizeof(m_pBound))
+  {
+    v1 = Round(v1, Read64(pBuffer));
+    v2 = Round(v2, Read64(pBuffer + 8));
+    v3 = Round(v3, Read64(pBuffer + 16));
+    v4 = Round(v4, Read64(pBuffer + 24));
+    pBuffer += sizeof(m_pBound);
+    zSize -= sizeof(m_pBound);
+  }
+
+  m_pAcc[0] = v1;
+  m_pAcc[1] = v2;
+  m_pAcc[2] = v3;
+  m_pAcc[3] = v4;
+
+  while(zSize--)
+    m_pBound[m_uBound++] = *pBuffer++;
+}
+
+/*************************************************************************************/
+AL_64U CHash64::GetHash() const
+{
+  AL_64U h;
+
+  if(m_uNumBytes >= sizeof(m_pBound))
+  {
+    h = Rot64(m_pAcc[0], 1) + Rot64(m_pAcc[1], 7) + Rot64(m_pAcc[2], 12) + Rot64(m_pAcc[3], 18);
+
+    for(int i = 0; i < 4; ++i)
+      h = MergeRound(h, m_pAcc[i]);
+  }
+  else
+    h = m_uSeed + PRIME64_5;
+
+  h += m_uNumBytes;
+
+  uint8_t const* p = m_pBound;
+  uint32_t uRemain = m_uBound;
+
+  for(; uRemain >= 8; uRemain -= 8, p += 8)
+    h = Rot64(h ^ Round(0, Read64(p)), 27) * PRIME64_1 + PRIME64_4;
+
+  if(uRemain >= 4)
+  {
+    h = Rot64(h ^ (Read32(p) * PRIME64_1), 23) * PRIME64_2 + PRIME64_3;
+    uRemain -= 4;
+    p += 4;
+  }
+
+  for(; uRemain; --uRemain, ++p)
+    h = Rot64(h ^ (*p * PRIME64_5), 11) * PRIME64_1;
+
+  h ^= h >> 33;
+  h *= PRIME64_2;
+  h ^= h >> 29;
+  h *= PRIME64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+/*************************************************************************************/
+std::string CHash64::GetHashString() const
+{
+  static const char* sToHex = "0123456789abcdef";
+  AL_64U const uHash = GetHash();
+  std::string sHash;
+
+  for(int s = 60; s >= 0; s -= 4)
+    sHash += sToHex[(uHash >> s) & 15];
+
+  return sHash;
+}
+
@@ -41,6 +41,8 @@
 #include "IpDevice.h"
 #include "lib_app/console.h"
 #include "lib_app/utils.h"
+#include "lib_app/AllocatorTracker.h"
+#include "lib_app/SharedStatusDispatcher.h"
 #include <algorithm>
 
 extern "C"
@@ -68,16 +70,21 @@ extern "C"
 #include "lib_common/HardwareDriver.h"
 }
 
-static unique_ptr<CIpDevice> createMcuIpDevice()
+static unique_ptr<CIpDevice> createMcuIpDevice(bool trackDma, int iStatusWorkers)
 {
   auto device = make_unique<CIpDevice>();
 
-  device->m_pAllocator.reset(createDmaAllocator("/dev/allegroIP"), &AL_Allocator_Destroy);
+  AL_TAllocator* pAllocator = createDmaAllocator("/dev/allegroIP");
 
-  if(!device->m_pAllocator)
+  if(!pAllocator)
     throw runtime_error("Can't open DMA allocator");
 
-  device->m_pScheduler = AL_SchedulerMcu_Create(AL_GetHardwareDriver(), device->m_pAllocator.get());
+  if(trackDma)
+    pAllocator = createAllocatorTracker(pAllocator, true);
+
+  device->m_pAllocator.reset(pAllocator, &AL_Allocator_Destroy);
+
+  device->m_pScheduler = AL_SchedulerMcu_CreateWithDispatcher(AL_GetHardwareDriver(), device->m_pAllocator.get(), getStatusDispatcher(iStatusWorkers));
 
   if(!device->m_pScheduler)
     throw std::runtime_error("Failed to create MCU scheduler");
@@ -86,15 +93,49 @@ static unique_ptr<CIpDevice> createMcuIpDevice()
 }
 
 
-shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int eVqDescr)
+shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma, int eVqDescr, int iStatusWorkers)
 {
-  (void)bUseRefSoftware, (void)Settings, (void)wrapIpCtrl, (void)eVqDescr, (void)trackDma;
+  (void)bUseRefSoftware, (void)Settings, (void)wrapIpCtrl, (void)eVqDescr;
 
 
 
   if(iSchedulerType == SCHEDULER_TYPE_MCU)
-    return createMcuIpDevice();
+    return createMcuIpDevice(trackDma, iStatusWorkers);
 
   throw runtime_error("No support for this scheduling type");
 }
 
+extern "C"
+{
+AL_TIDecChannel* AL_DecChannelMcu_CreateWithDispatcher(AL_TDriver*, AL_TStatusDispatcher*);
+}
+
+static unique_ptr<CDecIpDevice> createMcuDecIpDevice(bool trackDma, int iStatusWorkers)
+{
+  auto device = make_unique<CDecIpDevice>();
+
+  AL_TAllocator* pAllocator = createDmaAllocator("/dev/allegroDecodeIP");
+
+  if(!pAllocator)
+    throw runtime_error("Can't open DMA allocator");
+
+  if(trackDma)
+    pAllocator = createAllocatorTracker(pAllocator, true);
+
+  device->m_pAllocator.reset(pAllocator, &AL_Allocator_Destroy);
+
+  device->m_pDecChannel = AL_DecChannelMcu_CreateWithDispatcher(AL_GetHardwareDriver(), getStatusDispatcher(iStatusWorkers));
+
+  if(!device->m_pDecChannel)
+    throw runtime_error("Failed to create MCU decoder channel");
+
+  return device;
+}
+
+shared_ptr<CDecIpDevice> CreateDecIpDevice(int iSchedulerType, bool trackDma, int iStatusWorkers)
+{
+  if(iSchedulerType == SCHEDULER_TYPE_MCU)
+    return createMcuDecIpDevice(trackDma, iStatusWorkers);
+
+  throw runtime_error("No support for this scheduling type");
+}
@@ -50,6 +50,7 @@ extern "C"
 typedef struct AL_t_Allocator AL_TAllocator;
 typedef struct AL_t_IpCtrl AL_TIpCtrl;
 typedef struct AL_t_Timer AL_Timer;
+typedef struct AL_t_IDecChannel AL_TIDecChannel;
 
 /*****************************************************************************/
 struct CIpDevice
@@ -59,5 +60,14 @@ struct CIpDevice
   AL_Timer* m_pTimer;
 };
 
-std::shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int iVqDescr = 0);
+std::shared_ptr<CIpDevice> CreateIpDevice(bool bUseRefSoftware, int iSchedulerType, AL_TEncSettings& Settings, std::function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl, bool trackDma = false, int iVqDescr = 0, int iStatusWorkers = 0);
 
+/*****************************************************************************/
+/* decoding side of the transcode mode. The channel is owned by the decoder it is given to */
+struct CDecIpDevice
+{
+  AL_TIDecChannel* m_pDecChannel = nullptr;
+  std::shared_ptr<AL_TAllocator> m_pAllocator;
+};
+
+std::shared_ptr<CDecIpDevice> CreateDecIpDevice(int iSchedulerType, bool trackDma = false, int iStatusWorkers = 0);
@@ -0,0 +1,341 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "SceneChangeDetector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SCD_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCD_USE_SSE2 1
+#endif
+
+extern "C"
+{
+#include "lib_common/BufferSrcMeta.h"
+}
+
+static int const HIST_BINS = 32;
+
+/****************************************************************************/
+static uint32_t ComputeSad(uint8_t const* pA, uint8_t const* pB, int iSize)
+{
+  uint32_t uSad = 0;
+  int i = 0;
+#if SCD_USE_NEON
+  uint32x4_t vSad = vdupq_n_u32(0);
+
+  for(; i + 16 <= iSize; i += 16)
+  {
+    uint8x16_t vDiff = vabdq_u8(vld1q_u8(pA + i), vld1q_u8(pB + i));
+    vSad = vpadalq_u16(vSad, vpaddlq_u8(vDiff));
+  }
+
+  uint32_t uLanes[4];
+  vst1q_u32(uLanes, vSad);
+  uSad = uLanes[0] + uLanes[1] + uLanes[2] + uLanes[3];
+#elif SCD_USE_SSE2
+  __m128i vSad = _mm_setzero_si128();
+
+  for(; i + 16 <= iSize; i += 16)
+  {
+    __m128i vA = _mm_loadu_si128((__m128i const*)(pA + i));
+    __m128i vB = _mm_loadu_si128((__m128i const*)(pB + i));
+    vSad = _mm_add_epi64(vSad, _mm_sad_epu8(vA, vB));
+  }
+
+  uSad = (uint32_t)(_mm_cvtsi128_si32(vSad) + _mm_cvtsi128_si32(_mm_srli_si128(vSad, 8)));
+#endif
+
+  for(; i < iSize; ++i)
+    uSad += std::abs(pA[i] - pB[i]);
+
+  return uSad;
+}
+
+/****************************************************************************/
+SceneChangeDetector::SceneChangeDetector(TSceneChangeParam const& tParam) :
+  m_tParam(tParam)
+{
+  for(auto& hist : m_Hists)
+    hist.assign(HIST_BINS, 0);
+}
+
+/****************************************************************************/
+bool SceneChangeDetector::IsSupported(TFourCC tFourCC) const
+{
+  if(AL_IsCompressed(tFourCC))
+    return false;
+
+  if(AL_IsTiled(tFourCC) && AL_GetBitDepth(tFourCC) != 8 && AL_GetBitDepth(tFourCC) != 10)
+    return false;
+
+  int const iDecim = m_tParam.iDecimation;
+  return iDecim >= 4 && iDecim <= 32 && !(iDecim & (iDecim - 1));
+}
+
+/****************************************************************************/
+void SceneChangeDetector::DecimateRaster8(uint8_t const* pLuma, int iPitch)
+{
+  int const iDecim = m_tParam.iDecimation;
+  uint8_t* pThumb = m_Thumbs[m_iCur].data();
+
+  for(int ty = 0; ty < m_iThumbHeight; ++ty)
+  {
+    // sample two lines per block, the full luma is not needed to detect a cut
+    uint8_t const* pRow0 = pLuma + (ty * iDecim) * iPitch;
+    uint8_t const* pRow1 = pRow0 + (iDecim / 2) * iPitch;
+    int const iRowWidth = m_iThumbWidth * iDecim;
+
+    for(int x = 0; x < iRowWidth; ++x)
+      m_RowSum[x] = pRow0[x] + pRow1[x];
+
+    for(int tx = 0; tx < m_iThumbWidth; ++tx)
+    {
+      uint32_t uSum = 0;
+
+      for(int k = 0; k < iDecim; ++k)
+        uSum += m_RowSum[tx * iDecim + k];
+
+      *pThumb++ = (uint8_t)(uSum / (2 * iDecim));
+    }
+  }
+}
+
+/****************************************************************************/
+void SceneChangeDetector::DecimateRaster16(uint8_t const* pLuma, int iPitch, int iShift)
+{
+  int const iDecim = m_tParam.iDecimation;
+  uint8_t* pThumb = m_Thumbs[m_iCur].data();
+
+  for(int ty = 0; ty < m_iThumbHeight; ++ty)
+  {
+    uint16_t const* pRow0 = (uint16_t const*)(pLuma + (ty * iDecim) * iPitch);
+    uint16_t const* pRow1 = (uint16_t const*)(pLuma + (ty * iDecim + iDecim / 2) * iPitch);
+    int const iRowWidth = m_iThumbWidth * iDecim;
+
+    for(int x = 0; x < iRowWidth; ++x)
+      m_RowSum[x] = pRow0[x] + pRow1[x];
+
+    for(int tx = 0; tx < m_iThumbWidth; ++tx)
+    {
+      uint32_t uSum = 0;
+
+      for(int k = 0; k < iDecim; ++k)
+        uSum += m_RowSum[tx * iDecim + k];
+
+      *pThumb++ = (uint8_t)((uSum / (2 * iDecim)) >> iShift);
+    }
+  }
+}
+
+/****************************************************************************/
+void SceneChangeDetector::DecimateRasterXV(uint8_t const* pLuma, int iPitch)
+{
+  // three 10 bits samples per 32 bits word
+  int const iDecim = m_tParam.iDecimation;
+  uint8_t* pThumb = m_Thumbs[m_iCur].data();
+
+  for(int ty = 0; ty < m_iThumbHeight; ++ty)
+  {
+    uint32_t const* pRow = (uint32_t const*)(pLuma + (ty * iDecim + iDecim / 2) * iPitch);
+
+    for(int tx = 0; tx < m_iThumbWidth; ++tx)
+    {
+      uint32_t uSum = 0;
+
+      for(int x = tx * iDecim; x < (tx + 1) * iDecim; ++x)
+        uSum += (pRow[x / 3] >> (10 * (x % 3))) & 0x3FF;
+
+      *pThumb++ = (uint8_t)((uSum / iDecim) >> 2);
+    }
+  }
+}
+
+/****************************************************************************/
+void SceneChangeDetector::DecimateTiled(uint8_t const* pLuma, int iPitch, int iBitDepth)
+{
+  /* one pitch line holds 4 pixel lines. Whatever the tile width, the 4x4
+   * blocks of a pitch line are stored one after the other from left to right */
+  int const iDecim = m_tParam.iDecimation;
+  int const iBlkSize = 16 * iBitDepth / 8;
+  uint8_t* pThumb = m_Thumbs[m_iCur].data();
+
+  for(int ty = 0; ty < m_iThumbHeight; ++ty)
+  {
+    uint8_t const* pBlkRow = pLuma + ((ty * iDecim) / 4) * iPitch;
+
+    for(int tx = 0; tx < m_iThumbWidth; ++tx)
+    {
+      uint8_t const* pBlk = pBlkRow + (tx * iDecim / 4) * iBlkSize;
+      int const iNumSamples = 4 * iDecim;
+      uint32_t uSum = 0;
+
+      if(iBitDepth == 8)
+      {
+        for(int i = 0; i < iNumSamples; ++i)
+          uSum += pBlk[i];
+      }
+      else
+      {
+        for(int i = 0; i < iNumSamples; ++i)
+        {
+          int const iBit = i * 10;
+          uint16_t const uWord = pBlk[iBit / 8] | (pBlk[iBit / 8 + 1] << 8);
+          uSum += (uWord >> (iBit % 8)) & 0x3FF;
+        }
+      }
+
+      *pThumb++ = (uint8_t)((uSum / iNumSamples) >> (iBitDepth - 8));
+    }
+  }
+}
+
+/****************************************************************************/
+bool SceneChangeDetector::Decimate(AL_TBuffer* pSrc)
+{
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_SOURCE);
+
+  if(!pMeta || !IsSupported(pMeta->tFourCC))
+    return false;
+
+  int const iDecim = m_tParam.iDecimation;
+  int const iThumbWidth = pMeta->tDim.iWidth / iDecim;
+  int const iThumbHeight = pMeta->tDim.iHeight / iDecim;
+
+  if(iThumbWidth <= 0 || iThumbHeight <= 0)
+    return false;
+
+  if(iThumbWidth != m_iThumbWidth || iThumbHeight != m_iThumbHeight)
+  {
+    m_iThumbWidth = iThumbWidth;
+    m_iThumbHeight = iThumbHeight;
+
+    for(auto& thumb : m_Thumbs)
+      thumb.assign(iThumbWidth * iThumbHeight, 0);
+
+    m_RowSum.assign(iThumbWidth * iDecim, 0);
+    m_bHasPrev = false;
+  }
+
+  uint8_t const* pLuma = AL_Buffer_GetData(pSrc) + pMeta->tOffsetYC.iLuma;
+  int const iPitch = pMeta->tPitches.iLuma;
+  int const iBitDepth = AL_GetBitDepth(pMeta->tFourCC);
+
+  if(AL_IsTiled(pMeta->tFourCC))
+    DecimateTiled(pLuma, iPitch, iBitDepth);
+  else if(AL_Is10bitPacked(pMeta->tFourCC))
+    DecimateRasterXV(pLuma, iPitch);
+  else if(AL_GetPixelSize(pMeta->tFourCC) == 1)
+    DecimateRaster8(pLuma, iPitch);
+  else
+    DecimateRaster16(pLuma, iPitch, iBitDepth - 8);
+
+  auto& hist = m_Hists[m_iCur];
+  std::fill(hist.begin(), hist.end(), 0);
+
+  for(auto uPix : m_Thumbs[m_iCur])
+    ++hist[uPix * HIST_BINS / 256];
+
+  return true;
+}
+
+/****************************************************************************/
+int SceneChangeDetector::ComputeHistDistance() const
+{
+  auto& cur = m_Hists[m_iCur];
+  auto& prev = m_Hists[1 - m_iCur];
+  uint32_t uDist = 0;
+
+  for(int i = 0; i < HIST_BINS; ++i)
+    uDist += std::abs((int)cur[i] - (int)prev[i]);
+
+  // normalized so that two disjoint histograms give 1000
+  return (int)((uint64_t)uDist * 500 / (m_iThumbWidth * m_iThumbHeight));
+}
+
+/****************************************************************************/
+bool SceneChangeDetector::Process(AL_TBuffer* pSrc)
+{
+  auto const tStart = std::chrono::steady_clock::now();
+
+  if(!pSrc || !Decimate(pSrc))
+    return false;
+
+  bool bSceneChange = false;
+  ++m_iFrameCount;
+  ++m_iSinceLastChange;
+
+  if(m_bHasPrev)
+  {
+    int const iNumPix = m_iThumbWidth * m_iThumbHeight;
+    m_iLastSad = (int)(ComputeSad(m_Thumbs[m_iCur].data(), m_Thumbs[1 - m_iCur].data(), iNumPix) / iNumPix);
+    m_iLastHist = ComputeHistDistance();
+
+    bSceneChange = m_iLastSad >= m_tParam.iSadThreshold
+                   && m_iLastHist >= m_tParam.iHistThreshold
+                   && m_iSinceLastChange >= m_tParam.iMinInterval;
+  }
+
+  if(bSceneChange)
+  {
+    ++m_iSceneChangeCount;
+    m_iSinceLastChange = 0;
+  }
+
+  m_bHasPrev = true;
+  m_iCur = 1 - m_iCur;
+
+  auto const tEnd = std::chrono::steady_clock::now();
+  m_uTotalCost += std::chrono::duration_cast<std::chrono::nanoseconds>(tEnd - tStart).count();
+
+  return bSceneChange;
+}
+
+/****************************************************************************/
+double SceneChangeDetector::GetAverageCost() const
+{
+  if(m_iFrameCount == 0)
+    return 0.0;
+  return (double)m_uTotalCost / 1000.0 / m_iFrameCount;
+}
+
@@ -0,0 +1,109 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common/BufferAPI.h"
+#include "lib_common/FourCC.h"
+}
+
+/*************************************************************************//*!
+   \brief Tunable thresholds of the host side scene change detector
+*****************************************************************************/
+struct TSceneChangeParam
+{
+  int iDecimation = 8; /*!< Luma decimation factor in both directions (power of 2, 4 to 32) */
+  int iSadThreshold = 24; /*!< Mean absolute difference between two thumbnails (0 .. 255) */
+  int iHistThreshold = 350; /*!< Histogram distance between two thumbnails (0 .. 1000) */
+  int iMinInterval = 5; /*!< Minimum number of frames between two detected scene changes */
+};
+
+/*
+** Lightweight scene change detector working on a decimated copy of the luma
+** Each source frame (raster, 10 bits packed or tiled) is reduced to a small
+** 8 bits thumbnail. A scene change is reported when both the SAD and the luma
+** histogram distance between two consecutive thumbnails exceed their threshold.
+*/
+class SceneChangeDetector
+{
+public:
+  explicit SceneChangeDetector(TSceneChangeParam const& tParam);
+
+  /* returns true when pSrc starts a new scene */
+  bool Process(AL_TBuffer* pSrc);
+
+  /* false when the source format can't be analysed (compressed) */
+  bool IsSupported(TFourCC tFourCC) const;
+
+  int GetFrameCount() const { return m_iFrameCount; }
+  int GetSceneChangeCount() const { return m_iSceneChangeCount; }
+  /* average analysis cost in microseconds */
+  double GetAverageCost() const;
+
+  int GetLastSad() const { return m_iLastSad; }
+  int GetLastHistDistance() const { return m_iLastHist; }
+
+private:
+  bool Decimate(AL_TBuffer* pSrc);
+  void DecimateRaster8(uint8_t const* pLuma, int iPitch);
+  void DecimateRaster16(uint8_t const* pLuma, int iPitch, int iShift);
+  void DecimateRasterXV(uint8_t const* pLuma, int iPitch);
+  void DecimateTiled(uint8_t const* pLuma, int iPitch, int iBitDepth);
+  int ComputeHistDistance() const;
+
+  TSceneChangeParam const m_tParam;
+  int m_iThumbWidth = 0;
+  int m_iThumbHeight = 0;
+  std::vector<uint8_t> m_Thumbs[2];
+  std::vector<uint32_t> m_Hists[2];
+  std::vector<uint32_t> m_RowSum;
+  int m_iCur = 0;
+  bool m_bHasPrev = false;
+
+  int m_iFrameCount = 0;
+  int m_iSceneChangeCount = 0;
+  int m_iSinceLastChange = 0;
+  int m_iLastSad = 0;
+  int m_iLastHist = 0;
+  uint64_t m_uTotalCost = 0; /* in nanoseconds */
+};
+
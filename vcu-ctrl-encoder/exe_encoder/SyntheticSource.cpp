@@ -0,0 +1,359 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "SyntheticSource.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+extern "C"
+{
+#include "lib_common/BufferSrcMeta.h"
+#include "lib_common/Utils.h"
+}
+
+struct TColor
+{
+  uint8_t y, u, v;
+};
+
+static TColor MakeYuv601(int r, int g, int b)
+{
+  TColor color;
+  color.y = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+  color.u = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+  color.v = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  return color;
+}
+
+/* same layouts as the drmkmsdemo test patterns */
+static TColor GetBarsColor(int x, int y, int iWidth, int iHeight)
+{
+  static TColor const colorsTop[] =
+  {
+    MakeYuv601(191, 192, 192), MakeYuv601(192, 192, 0), MakeYuv601(0, 192, 192), MakeYuv601(0, 192, 0),
+    MakeYuv601(192, 0, 192), MakeYuv601(192, 0, 0), MakeYuv601(0, 0, 192),
+  };
+  static TColor const colorsMiddle[] =
+  {
+    MakeYuv601(0, 0, 192), MakeYuv601(19, 19, 19), MakeYuv601(192, 0, 192), MakeYuv601(19, 19, 19),
+    MakeYuv601(0, 192, 192), MakeYuv601(19, 19, 19), MakeYuv601(192, 192, 192),
+  };
+  static TColor const colorsBottom[] =
+  {
+    MakeYuv601(0, 33, 76), MakeYuv601(255, 255, 255), MakeYuv601(50, 0, 106), MakeYuv601(19, 19, 19),
+    MakeYuv601(9, 9, 9), MakeYuv601(19, 19, 19), MakeYuv601(29, 29, 29), MakeYuv601(19, 19, 19),
+  };
+
+  if(y < iHeight * 6 / 9)
+    return colorsTop[x * 7 / iWidth];
+
+  if(y < iHeight * 7 / 9)
+    return colorsMiddle[x * 7 / iWidth];
+
+  return colorsBottom[x * 8 / iWidth];
+}
+
+static TColor GetTilesColor(int x, int y, int iWidth)
+{
+  div_t d = div(x + y, iWidth);
+  uint32_t rgb32 = 0x00130502 * (d.quot >> 6) + 0x000a1120 * (d.rem >> 6);
+  return MakeYuv601((rgb32 >> 16) & 0xff, (rgb32 >> 8) & 0xff, rgb32 & 0xff);
+}
+
+static TColor GetGradientColor(int x, int y, int iWidth, int iHeight)
+{
+  TColor color;
+  color.y = (uint8_t)(16 + (x + y) * 219 / (iWidth + iHeight));
+  color.u = (uint8_t)(16 + x * 224 / iWidth);
+  color.v = (uint8_t)(16 + y * 224 / iHeight);
+  return color;
+}
+
+/****************************************************************************/
+SyntheticSource::SyntheticSource(TSyntheticParam const& tParam, int iWidth, int iHeight) :
+  m_tParam(tParam),
+  m_iWidth(iWidth),
+  m_iHeight(iHeight)
+{
+  if(m_tParam.ePattern == SYNTHETIC_NONE)
+    throw std::runtime_error("No synthetic pattern selected");
+
+  if(iWidth <= 0 || iHeight <= 0)
+    throw std::runtime_error("A synthetic source needs the input width and height");
+
+  m_Lines.resize(4 * (size_t)RoundUp(m_iWidth, 4));
+}
+
+/****************************************************************************/
+void SyntheticSource::GenerateCanvas(TFourCC tFourCC)
+{
+  m_tFourCC = tFourCC;
+  m_iBitDepth = AL_GetBitDepth(tFourCC);
+  AL_GetSubsampling(tFourCC, &m_iSubX, &m_iSubY);
+
+  if(AL_IsCompressed(tFourCC))
+    throw std::runtime_error("A synthetic source can't generate compressed frames");
+
+  int const iShift = m_iBitDepth - 8;
+  auto getColor = [&](int x, int y)
+                  {
+                    switch(m_tParam.ePattern)
+                    {
+                    case SYNTHETIC_BARS: return GetBarsColor(x, y, m_iWidth, m_iHeight);
+                    case SYNTHETIC_TILES: return GetTilesColor(x, y, m_iWidth);
+                    case SYNTHETIC_GRADIENT: return GetGradientColor(x, y, m_iWidth, m_iHeight);
+                    default: return MakeYuv601(128, 128, 128);
+                    }
+                  };
+
+  m_CanvasY.resize((size_t)m_iWidth * m_iHeight);
+
+  for(int y = 0; y < m_iHeight; ++y)
+    for(int x = 0; x < m_iWidth; ++x)
+      m_CanvasY[(size_t)y * m_iWidth + x] = getColor(x, y).y << iShift;
+
+  if(m_tParam.iNoise > 0)
+    GenerateNoise();
+
+  m_CanvasUV.clear();
+
+  if(AL_IsMonochrome(tFourCC))
+    return;
+
+  int const iHeightC = m_iHeight / m_iSubY;
+  m_CanvasUV.resize((size_t)m_iWidth * iHeightC);
+
+  for(int y = 0; y < iHeightC; ++y)
+  {
+    for(int x = 0; x + 1 < m_iWidth; x += 2)
+    {
+      TColor color = getColor(x / 2 * m_iSubX, y * m_iSubY);
+      m_CanvasUV[(size_t)y * m_iWidth + x] = color.u << iShift;
+      m_CanvasUV[(size_t)y * m_iWidth + x + 1] = color.v << iShift;
+    }
+  }
+}
+
+/****************************************************************************/
+void SyntheticSource::BuildLine(std::vector<uint16_t> const& canvas, int iCanvasWidth, int iCanvasHeight, int iOffsetX, int iOffsetY, int iLine, uint16_t* pLine)
+{
+  // the canvas is periodic, a shifted line is made of its two ends
+  uint16_t const* pRow = canvas.data() + (size_t)((iLine + iOffsetY) % iCanvasHeight) * iCanvasWidth;
+  std::copy(pRow + iOffsetX, pRow + iCanvasWidth, pLine);
+  std::copy(pRow, pRow + iOffsetX, pLine + iCanvasWidth - iOffsetX);
+}
+
+/****************************************************************************/
+uint32_t SyntheticSource::NextRandom()
+{
+  m_uSeed ^= m_uSeed << 13;
+  m_uSeed ^= m_uSeed >> 17;
+  m_uSeed ^= m_uSeed << 5;
+  return m_uSeed;
+}
+
+/****************************************************************************/
+void SyntheticSource::GenerateNoise()
+{
+  int const iAmplitude = m_tParam.iNoise << (m_iBitDepth - 8);
+  uint64_t const uRange = 2 * iAmplitude + 1;
+
+  m_Noise.resize(NOISE_PERIOD + (size_t)m_iWidth);
+
+  for(auto& noise : m_Noise)
+    noise = (int16_t)((NextRandom() * uRange) >> 32) - iAmplitude;
+}
+
+/****************************************************************************/
+void SyntheticSource::AddNoise(uint16_t* pLine, int iNumSamples)
+{
+  // each line reads the precomputed noise from a random position
+  int16_t const* pNoise = m_Noise.data() + (NextRandom() % NOISE_PERIOD);
+  int const iMaxVal = (1 << m_iBitDepth) - 1;
+
+  for(int i = 0; i < iNumSamples; ++i)
+  {
+    int iVal = pLine[i] + pNoise[i];
+    pLine[i] = (uint16_t)std::min(std::max(iVal, 0), iMaxVal);
+  }
+}
+
+/****************************************************************************/
+static int Modulo(int iVal, int iMod)
+{
+  return ((iVal % iMod) + iMod) % iMod;
+}
+
+/****************************************************************************/
+static void StoreTiledBlock(uint16_t const* pLines[4], int x, uint8_t* pDst, int iBitDepth)
+{
+  if(iBitDepth == 8)
+  {
+    for(int h = 0; h < 4; ++h)
+      for(int w = 0; w < 4; ++w)
+        *pDst++ = (uint8_t)pLines[h][x + w];
+
+    return;
+  }
+
+  // 4 samples of 10 bits fill exactly 5 bytes, lsb first
+  for(int h = 0; h < 4; ++h)
+  {
+    uint16_t const* pSrc = pLines[h] + x;
+    uint64_t const uRow = (uint64_t)(pSrc[0] & 0x3FF) | ((uint64_t)(pSrc[1] & 0x3FF) << 10) | ((uint64_t)(pSrc[2] & 0x3FF) << 20) | ((uint64_t)(pSrc[3] & 0x3FF) << 30);
+
+    for(int i = 0; i < 5; ++i)
+      *pDst++ = (uint8_t)(uRow >> (8 * i));
+  }
+}
+
+/****************************************************************************/
+void SyntheticSource::WritePlane(uint8_t* pPlane, int iPitch, int iNumLines, bool bLuma, int iFrame)
+{
+  int const iOffsetX = Modulo(iFrame * m_tParam.iMotionX, m_iWidth) / m_iSubX * m_iSubX;
+  int const iOffsetY = Modulo(iFrame * m_tParam.iMotionY, m_iHeight) / m_iSubY * m_iSubY;
+
+  auto const& canvas = bLuma ? m_CanvasY : m_CanvasUV;
+  int const iLineOffsetX = bLuma ? iOffsetX : iOffsetX / m_iSubX * 2;
+  int const iLineOffsetY = bLuma ? iOffsetY : iOffsetY / m_iSubY;
+  bool const bNoise = bLuma && m_tParam.iNoise > 0;
+
+  auto buildLine = [&](int iLine, uint16_t* pLine)
+                   {
+                     BuildLine(canvas, m_iWidth, iNumLines, iLineOffsetX, iLineOffsetY, iLine, pLine);
+
+                     if(bNoise)
+                       AddNoise(pLine, m_iWidth);
+                   };
+
+  if(AL_IsTiled(m_tFourCC))
+  {
+    int const iBlkSize = 16 * m_iBitDepth / 8;
+    int const iLineSize = RoundUp(m_iWidth, 4);
+    uint16_t const* pLines[4];
+
+    for(int h = 0; h < 4; ++h)
+      pLines[h] = &m_Lines[h * iLineSize];
+
+    for(int iLine = 0; iLine < iNumLines; iLine += 4)
+    {
+      for(int h = 0; h < 4; ++h)
+      {
+        uint16_t* pLine = &m_Lines[h * iLineSize];
+        buildLine(std::min(iLine + h, iNumLines - 1), pLine);
+        // the last block of the line is completed by edge replication
+        std::fill(pLine + m_iWidth, pLine + iLineSize, pLine[m_iWidth - 1]);
+      }
+
+      uint8_t* pRow = pPlane + (iLine / 4) * iPitch;
+
+      for(int x = 0; x < m_iWidth; x += 4)
+        StoreTiledBlock(pLines, x, pRow + (x / 4) * iBlkSize, m_iBitDepth);
+    }
+
+    return;
+  }
+
+  uint16_t* pLine = m_Lines.data();
+
+  for(int iLine = 0; iLine < iNumLines; ++iLine)
+  {
+    buildLine(iLine, pLine);
+    uint8_t* pDst = pPlane + iLine * iPitch;
+
+    if(AL_Is10bitPacked(m_tFourCC))
+    {
+      uint32_t* pDst32 = (uint32_t*)pDst;
+
+      for(int x = 0; x < m_iWidth; x += 3)
+      {
+        uint32_t uWord = pLine[x];
+
+        if(x + 1 < m_iWidth)
+          uWord |= (uint32_t)pLine[x + 1] << 10;
+
+        if(x + 2 < m_iWidth)
+          uWord |= (uint32_t)pLine[x + 2] << 20;
+        *pDst32++ = uWord;
+      }
+    }
+    else if(m_iBitDepth > 8)
+      std::memcpy(pDst, pLine, m_iWidth * sizeof(uint16_t));
+    else
+    {
+      for(int x = 0; x < m_iWidth; ++x)
+        pDst[x] = (uint8_t)pLine[x];
+    }
+  }
+}
+
+/****************************************************************************/
+void SyntheticSource::Fill(AL_TBuffer* pSrc, int iFrame)
+{
+  auto const tStart = std::chrono::steady_clock::now();
+
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_SOURCE);
+
+  if(!pMeta)
+    throw std::runtime_error("Source buffer without source metadata");
+
+  if(pMeta->tFourCC != m_tFourCC)
+    GenerateCanvas(pMeta->tFourCC);
+
+  uint8_t* pData = AL_Buffer_GetData(pSrc);
+  WritePlane(pData + pMeta->tOffsetYC.iLuma, pMeta->tPitches.iLuma, m_iHeight, true, iFrame);
+
+  if(!m_CanvasUV.empty())
+    WritePlane(pData + pMeta->tOffsetYC.iChroma, pMeta->tPitches.iChroma, m_iHeight / m_iSubY, false, iFrame);
+
+  ++m_iFrameCount;
+  auto const tEnd = std::chrono::steady_clock::now();
+  m_uTotalCost += std::chrono::duration_cast<std::chrono::microseconds>(tEnd - tStart).count();
+}
+
+/****************************************************************************/
+double SyntheticSource::GetGenerationRate() const
+{
+  if(m_uTotalCost == 0)
+    return 0.0;
+  return m_iFrameCount * 1000000.0 / m_uTotalCost;
+}
+
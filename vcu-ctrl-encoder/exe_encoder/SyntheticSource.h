@@ -0,0 +1,113 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+extern "C"
+{
+#include "lib_common/BufferAPI.h"
+#include "lib_common/FourCC.h"
+}
+
+typedef enum
+{
+  SYNTHETIC_NONE,
+  SYNTHETIC_BARS,
+  SYNTHETIC_TILES,
+  SYNTHETIC_GRADIENT,
+  SYNTHETIC_PLAIN,
+}ESyntheticPattern;
+
+/*************************************************************************//*!
+   \brief Parameters of the procedurally generated source
+*****************************************************************************/
+struct TSyntheticParam
+{
+  ESyntheticPattern ePattern = SYNTHETIC_NONE;
+  int iMotionX = 4; /*!< Horizontal pattern motion in pixels per frame */
+  int iMotionY = 2; /*!< Vertical pattern motion in pixels per frame */
+  int iNoise = 0; /*!< Amplitude of the random noise added to the luma (8 bits scale) */
+};
+
+/*
+** Generates moving test patterns directly inside the encoder source buffers,
+** whatever their layout (raster, 10 bits packed, 32x4 / 64x4 tiled, 8 or 10 bits).
+** The pattern is rendered once in a periodic canvas, each frame is the canvas
+** shifted by the motion vector, so the per frame cost is a copy in the
+** destination layout (plus the optional noise).
+*/
+class SyntheticSource
+{
+public:
+  SyntheticSource(TSyntheticParam const& tParam, int iWidth, int iHeight);
+
+  void Fill(AL_TBuffer* pSrc, int iFrame);
+
+  int GetFrameCount() const { return m_iFrameCount; }
+  /* frames per second the generator alone can sustain */
+  double GetGenerationRate() const;
+
+private:
+  void GenerateCanvas(TFourCC tFourCC);
+  void BuildLine(std::vector<uint16_t> const& canvas, int iCanvasWidth, int iCanvasHeight, int iOffsetX, int iOffsetY, int iLine, uint16_t* pLine);
+  uint32_t NextRandom();
+  void GenerateNoise();
+  void AddNoise(uint16_t* pLine, int iNumSamples);
+  void WritePlane(uint8_t* pPlane, int iPitch, int iNumLines, bool bLuma, int iFrame);
+
+  TSyntheticParam const m_tParam;
+  int const m_iWidth;
+  int const m_iHeight;
+
+  TFourCC m_tFourCC = 0;
+  int m_iBitDepth = 8;
+  int m_iSubX = 2;
+  int m_iSubY = 2;
+  std::vector<uint16_t> m_CanvasY; /* m_iWidth x m_iHeight */
+  std::vector<uint16_t> m_CanvasUV; /* interleaved UV, m_iWidth x m_iHeight / m_iSubY */
+  std::vector<uint16_t> m_Lines; /* 4 lines, enough for one row of tiles */
+  static int const NOISE_PERIOD = 1 << 16;
+  std::vector<int16_t> m_Noise; /* NOISE_PERIOD + m_iWidth samples */
+  uint32_t m_uSeed = 0x12345678;
+
+  int m_iFrameCount = 0;
+  uint64_t m_uTotalCost = 0;
+};
+
@@ -0,0 +1,608 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "TranscodeSource.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "lib_app/timing.h"
+#include "lib_app/utils.h"
+
+extern "C"
+{
+#include "lib_common/Utils.h"
+#include "lib_common_dec/DecBuffers.h"
+#include "lib_common_dec/IpDecFourCC.h"
+}
+
+using namespace std;
+
+/* The alias buffers don't own any memory: their handle is the decoder frame they alias */
+static AL_HANDLE AliasAlloc(AL_TAllocator*, size_t)
+{
+  return nullptr;
+}
+
+static AL_HANDLE AliasAllocNamed(AL_TAllocator*, size_t, char const*)
+{
+  return nullptr;
+}
+
+static bool AliasFree(AL_TAllocator*, AL_HANDLE)
+{
+  return true;
+}
+
+static bool AliasDestroy(AL_TAllocator*)
+{
+  return true;
+}
+
+static AL_VADDR AliasGetVirtualAddr(AL_TAllocator*, AL_HANDLE hBuf)
+{
+  return AL_Buffer_GetData((AL_TBuffer*)hBuf);
+}
+
+static AL_PADDR AliasGetPhysicalAddr(AL_TAllocator*, AL_HANDLE hBuf)
+{
+  auto pFrame = (AL_TBuffer*)hBuf;
+  return AL_Allocator_GetPhysicalAddr(pFrame->pAllocator, pFrame->hBuf);
+}
+
+static AL_AllocatorVtable const AliasAllocatorVtable =
+{
+  &AliasDestroy,
+  &AliasAlloc,
+  &AliasFree,
+  &AliasGetVirtualAddr,
+  &AliasGetPhysicalAddr,
+  &AliasAllocNamed,
+};
+
+static AL_TAllocator AliasAllocator =
+{
+  &AliasAllocatorVtable
+};
+
+/*****************************************************************************/
+FrameBridge::FrameBridge(function<void(AL_TBuffer*)> release, function<void(AL_TBuffer const*)> queued, function<void(AL_TBuffer const*)> dropped) :
+  m_release(release),
+  m_frameQueued(queued),
+  m_frameDropped(dropped)
+{
+}
+
+FrameBridge::~FrameBridge()
+{
+  for(auto& alias : m_aliases)
+    AL_Buffer_Destroy(alias.second);
+}
+
+void FrameBridge::OnAliasReleased(AL_TBuffer* pAlias)
+{
+  auto pThis = (FrameBridge*)AL_Buffer_GetUserData(pAlias);
+  auto pFrame = (AL_TBuffer*)pAlias->hBuf;
+
+  pThis->m_release(pFrame);
+  AL_Buffer_Unref(pFrame);
+}
+
+AL_TBuffer* FrameBridge::GetAlias(AL_TBuffer* pFrame)
+{
+  auto it = m_aliases.find(pFrame);
+
+  if(it != m_aliases.end())
+    return it->second;
+
+  auto pFrameMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pFrame, AL_META_TYPE_SOURCE);
+
+  if(!pFrameMeta)
+    return nullptr;
+
+  auto pAlias = AL_Buffer_Create(&AliasAllocator, (AL_HANDLE)pFrame, pFrame->zSize, &OnAliasReleased);
+
+  if(!pAlias)
+    return nullptr;
+
+  auto pMeta = AL_SrcMetaData_Create(pFrameMeta->tDim, pFrameMeta->tPitches, pFrameMeta->tOffsetYC, pFrameMeta->tFourCC);
+
+  if(!pMeta || !AL_Buffer_AddMetaData(pAlias, (AL_TMetaData*)pMeta))
+  {
+    if(pMeta)
+      pMeta->tMeta.MetaDestroy((AL_TMetaData*)pMeta);
+    AL_Buffer_Destroy(pAlias);
+    return nullptr;
+  }
+
+  AL_Buffer_SetUserData(pAlias, this);
+  m_aliases[pFrame] = pAlias;
+  return pAlias;
+}
+
+void FrameBridge::Push(AL_TBuffer* pFrame, AL_TDimension tDim)
+{
+  unique_lock<mutex> lock(m_mutex);
+
+  AL_TBuffer* pAlias = nullptr;
+
+  if(!m_bClosed && !m_bEndOfStream)
+    pAlias = GetAlias(pFrame);
+
+  if(!pAlias)
+  {
+    /* nobody will use it: give it back right away */
+    lock.unlock();
+    m_release(pFrame);
+    return;
+  }
+
+  /* the alias is only pushed again once its previous use is over */
+  auto pFrameMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pFrame, AL_META_TYPE_SOURCE);
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pAlias, AL_META_TYPE_SOURCE);
+  pMeta->tDim = tDim;
+  pMeta->tPitches = pFrameMeta->tPitches;
+  pMeta->tOffsetYC = pFrameMeta->tOffsetYC;
+  pMeta->tFourCC = pFrameMeta->tFourCC;
+
+  AL_Buffer_Ref(pFrame);
+  AL_Buffer_Ref(pAlias);
+  m_queue.push_back(pAlias);
+  m_iMaxQueued = max(m_iMaxQueued, (int)m_queue.size());
+
+  if(m_frameQueued)
+    m_frameQueued(pAlias);
+
+  m_queueChanged.notify_one();
+}
+
+void FrameBridge::PushEndOfStream()
+{
+  lock_guard<mutex> lock(m_mutex);
+  m_bEndOfStream = true;
+  m_queueChanged.notify_one();
+}
+
+void FrameBridge::Close()
+{
+  deque<AL_TBuffer*> queue;
+  {
+    lock_guard<mutex> lock(m_mutex);
+    m_bClosed = true;
+    queue.swap(m_queue);
+    m_queueChanged.notify_one();
+  }
+
+  /* outside of the lock: releasing a frame can make the decoder display the next one */
+  for(auto pAlias : queue)
+  {
+    if(m_frameDropped)
+      m_frameDropped(pAlias);
+    AL_Buffer_Unref(pAlias);
+  }
+}
+
+AL_TBuffer* FrameBridge::Pop()
+{
+  unique_lock<mutex> lock(m_mutex);
+  m_queueChanged.wait(lock, [&]() {
+    return !m_queue.empty() || m_bEndOfStream || m_bClosed;
+  });
+
+  if(m_queue.empty())
+    return nullptr;
+
+  auto pAlias = m_queue.front();
+  m_queue.pop_front();
+  return pAlias;
+}
+
+void FrameBridge::Run(IFrameSink* sink, int iMaxPict, int iInFrameRate, int iOutFrameRate)
+{
+  assert(iInFrameRate > 0 && iOutFrameRate > 0);
+
+  int iInput = 0;
+  int iOutput = 0;
+  bool bLimitReached = iMaxPict == 0;
+
+  if(bLimitReached && m_limitReached)
+    m_limitReached();
+
+  while(auto pAlias = Pop())
+  {
+    bool bSent = false;
+
+    /* output picture n shows input picture n * in / out */
+    while(!bLimitReached && (int64_t)iOutput * iInFrameRate / iOutFrameRate == iInput)
+    {
+      if(bSent)
+      {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_iRepeated;
+      }
+
+      sink->ProcessFrame(pAlias);
+      bSent = true;
+      ++iOutput;
+
+      if(iMaxPict != -1 && iOutput >= iMaxPict)
+      {
+        bLimitReached = true;
+
+        if(m_limitReached)
+          m_limitReached();
+      }
+    }
+
+    if(!bSent)
+    {
+      /* the frames coming after the last picture aren't counted */
+      if(!bLimitReached)
+      {
+        lock_guard<mutex> lock(m_mutex);
+        ++m_iDropped;
+      }
+
+      if(m_frameDropped)
+        m_frameDropped(pAlias);
+    }
+
+    ++iInput;
+    AL_Buffer_Unref(pAlias);
+  }
+
+  sink->ProcessFrame(EndOfStream);
+}
+
+int FrameBridge::GetDroppedCount() const
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_iDropped;
+}
+
+int FrameBridge::GetRepeatedCount() const
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_iRepeated;
+}
+
+int FrameBridge::GetMaxQueued() const
+{
+  lock_guard<mutex> lock(m_mutex);
+  return m_iMaxQueued;
+}
+
+/*****************************************************************************/
+static int const zInputBufferSize = 32 * 1024;
+static int const iNumInputBuffers = 2;
+
+static AL_TDecSettings GetTranscodeDecSettings(AL_ECodec eCodec, AL_EFbStorageMode eStorageMode)
+{
+  AL_TDecSettings settings {};
+
+  settings.iStackSize = 2;
+  settings.iBitDepth = HW_IP_BIT_DEPTH;
+  settings.uNumCore = NUMCORE_AUTO;
+  settings.uFrameRate = 60000;
+  settings.uClkRatio = 1000;
+  settings.uDDRWidth = 32;
+  settings.eDecUnit = AL_AU_UNIT;
+  settings.eDpbMode = AL_DPB_NORMAL;
+  settings.eFBStorageMode = eStorageMode;
+  settings.tStream.tDim = { -1, -1 };
+  settings.tStream.eChroma = CHROMA_MAX_ENUM;
+  settings.tStream.iBitDepth = -1;
+  settings.tStream.iProfileIdc = -1;
+  settings.tStream.eSequenceMode = AL_SM_MAX_ENUM;
+  settings.eCodec = eCodec;
+  settings.eBufferOutputMode = AL_OUTPUT_INTERNAL;
+  settings.bUseIFramesAsSyncPoint = false;
+
+  return settings;
+}
+
+DecoderSource::DecoderSource(string const& sFileName, AL_ECodec eCodec, AL_EFbStorageMode eStorageMode, AL_TIDecChannel* pDecChannel, AL_TAllocator* pAllocator, int iNumHeldFrames, function<void(AL_TBuffer const*)> frameQueued, function<void(AL_TBuffer const*)> frameDropped) :
+  bridge([this](AL_TBuffer* pFrame) {
+    AL_Decoder_PutDisplayPicture(m_hDec, pFrame);
+  }, frameQueued, frameDropped),
+  m_eStorageMode(eStorageMode),
+  m_pAllocator(pAllocator),
+  m_iNumHeldFrames(iNumHeldFrames)
+{
+  m_iDecoded = 0;
+  m_bStopInput = false;
+
+  m_file.open(sFileName, ios::binary);
+
+  if(!m_file)
+    throw runtime_error("Can't open transcode input file (" + sFileName + ")");
+
+  AL_TBufPoolConfig poolConfig {};
+  poolConfig.zBufSize = zInputBufferSize;
+  poolConfig.uNumBuf = iNumInputBuffers;
+  poolConfig.debugName = "transcode-stream";
+
+  if(!m_streamPool.Init(AL_GetDefaultAllocator(), poolConfig))
+    throw runtime_error("Can't allocate the transcode input buffers");
+
+  AL_TDecCallBacks CB {};
+  CB.endDecodingCB = { &OnFrameDecoded, this };
+  CB.displayCB = { &OnFrameDisplay, this };
+  CB.resolutionFoundCB = { &OnResolutionFound, this };
+
+  auto settings = GetTranscodeDecSettings(eCodec, eStorageMode);
+  auto eErr = AL_Decoder_Create(&m_hDec, pDecChannel, pAllocator, &settings, &CB);
+
+  if(eErr != AL_SUCCESS)
+    throw runtime_error("Can't create the transcode decoder (error " + to_string(eErr) + ")");
+
+  m_input = thread(&DecoderSource::ReadInput, this);
+}
+
+DecoderSource::~DecoderSource()
+{
+  StopInput();
+  /* from now on, the frames are given back as soon as they are displayed
+   * so that the decoder doesn't stall on them */
+  bridge.Close();
+
+  if(m_input.joinable())
+    m_input.join();
+
+  AL_Decoder_Destroy(m_hDec);
+}
+
+AL_ERR DecoderSource::OnResolutionFound(int iBufferNumber, int iBufferSize, AL_TStreamSettings const* pSettings, AL_TCropInfo const* pCropInfo, void* pUserParam)
+{
+  (void)iBufferSize;
+  auto pThis = (DecoderSource*)pUserParam;
+  return pThis->InitFramePool(iBufferNumber, *pSettings, *pCropInfo);
+}
+
+AL_ERR DecoderSource::InitFramePool(int iBufferNumber, AL_TStreamSettings const& tSettings, AL_TCropInfo const& tCrop)
+{
+  unique_lock<mutex> lock(m_mutex);
+
+  /* We do not support in stream resolution change */
+  if(m_bPoolIsInit)
+    return AL_ERR_RESOLUTION_CHANGE;
+
+  /* the encoder sources can only be cropped on the right and bottom */
+  if(tCrop.bCropping && (tCrop.uCropOffsetLeft || tCrop.uCropOffsetTop))
+  {
+    m_sFailure = "Cropping on the left or top of the transcode input isn't supported";
+    m_settingsFound.notify_all();
+    return AL_ERROR;
+  }
+
+  auto tPicFormat = AL_GetDecPicFormat(tSettings.eChroma, tSettings.iBitDepth, m_eStorageMode, false);
+  auto tFourCC = AL_GetDecFourCC(tPicFormat);
+
+  int iMinPitch = AL_Decoder_GetMinPitch(tSettings.tDim.iWidth, tSettings.iBitDepth, m_eStorageMode);
+
+  AL_TBufPoolConfig poolConfig {};
+  poolConfig.zBufSize = AL_DecGetAllocSize_Frame(tSettings.tDim, iMinPitch, tSettings.eChroma, false, m_eStorageMode);
+  poolConfig.uNumBuf = iBufferNumber + m_iNumHeldFrames;
+  poolConfig.debugName = "transcode-yuv";
+
+  AL_TPitches tPitches { iMinPitch, iMinPitch };
+  AL_TOffsetYC tOffsetYC {};
+  tOffsetYC.iChroma = AL_GetAllocSize_DecReference(tSettings.tDim, iMinPitch, CHROMA_MONO, m_eStorageMode);
+  poolConfig.pMetaData = (AL_TMetaData*)AL_SrcMetaData_Create(tSettings.tDim, tPitches, tOffsetYC, tFourCC);
+
+  if(!m_framePool.Init(m_pAllocator, poolConfig))
+    return AL_ERR_NO_MEMORY;
+
+  for(int i = 0; i < (int)poolConfig.uNumBuf; ++i)
+  {
+    auto pFrame = m_framePool.GetBuffer(AL_BUF_MODE_NONBLOCK);
+    assert(pFrame);
+    AL_Decoder_PutDisplayPicture(m_hDec, pFrame);
+    AL_Buffer_Unref(pFrame);
+  }
+
+  m_tSettings = tSettings;
+  m_tCrop = tCrop;
+  m_tFourCC = tFourCC;
+  m_bPoolIsInit = true;
+  m_settingsFound.notify_all();
+
+  return AL_SUCCESS;
+}
+
+void DecoderSource::OnFrameDecoded(AL_TBuffer* pFrame, void* pUserParam)
+{
+  auto pThis = (DecoderSource*)pUserParam;
+
+  if(!pFrame)
+    return;
+
+  auto const uNow = GetPerfTime();
+
+  if(pThis->m_iDecoded++ == 0)
+    pThis->m_uFirstDecoded = uNow;
+  pThis->m_uLastDecoded = uNow;
+}
+
+void DecoderSource::OnFrameDisplay(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo, void* pUserParam)
+{
+  auto pThis = (DecoderSource*)pUserParam;
+
+  if(!pFrame && !pInfo)
+  {
+    pThis->EndOfStream(AL_SUCCESS);
+    return;
+  }
+
+  AL_ERR eErr = AL_Decoder_GetFrameError(pThis->m_hDec, pFrame);
+
+  if(eErr != AL_SUCCESS && eErr != AL_WARN_CONCEAL_DETECT)
+  {
+    pThis->EndOfStream(eErr);
+    return;
+  }
+
+  /* release only */
+  if(!pInfo)
+    return;
+
+  /* the decoder rewrites the frame dimension, keep its chroma offset coherent */
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pFrame, AL_META_TYPE_SOURCE);
+  pMeta->tOffsetYC.iLuma = 0;
+  pMeta->tOffsetYC.iChroma = AL_GetAllocSize_DecReference(pMeta->tDim, pMeta->tPitches.iLuma, CHROMA_MONO, pThis->m_eStorageMode);
+
+  pThis->bridge.Push(pFrame, pThis->GetDisplayDim());
+}
+
+void DecoderSource::EndOfStream(AL_ERR eErr)
+{
+  {
+    lock_guard<mutex> lock(m_mutex);
+
+    if(m_bEnded)
+      return;
+
+    m_bEnded = true;
+    m_eError = eErr;
+    m_settingsFound.notify_all();
+  }
+
+  bridge.PushEndOfStream();
+}
+
+void DecoderSource::ReadInput()
+{
+  while(!m_bStopInput)
+  {
+    shared_ptr<AL_TBuffer> pBufStream;
+    try
+    {
+      pBufStream = shared_ptr<AL_TBuffer>(m_streamPool.GetBuffer(), &AL_Buffer_Unref);
+    }
+    catch(bufpool_decommited_error &)
+    {
+      continue;
+    }
+
+    m_file.read((char*)AL_Buffer_GetData(pBufStream.get()), pBufStream->zSize);
+    auto uAvailSize = (uint32_t)m_file.gcount();
+
+    if(!uAvailSize)
+      break;
+
+    /* a failure is reported by the decoder itself */
+    if(!AL_Decoder_PushBuffer(m_hDec, pBufStream.get(), uAvailSize))
+      break;
+  }
+
+  // end of input
+  AL_Decoder_Flush(m_hDec);
+}
+
+void DecoderSource::StopInput()
+{
+  /* doesn't wait for the input thread: it can be stuck on the decoder until
+   * the frames queued after the stopping point are consumed */
+  m_bStopInput = true;
+  m_streamPool.Decommit();
+}
+
+AL_TStreamSettings DecoderSource::WaitStreamSettings()
+{
+  unique_lock<mutex> lock(m_mutex);
+  m_settingsFound.wait(lock, [&]() {
+    return m_bPoolIsInit || m_bEnded || !m_sFailure.empty();
+  });
+
+  if(!m_sFailure.empty())
+    throw runtime_error(m_sFailure);
+
+  if(!m_bPoolIsInit)
+    throw runtime_error("No picture could be decoded from the transcode input (error " + to_string(m_eError) + ")");
+
+  return m_tSettings;
+}
+
+TFourCC DecoderSource::GetFourCC() const
+{
+  return m_tFourCC;
+}
+
+AL_TDimension DecoderSource::GetDisplayDim() const
+{
+  AL_TDimension tDim = m_tSettings.tDim;
+
+  if(m_tCrop.bCropping)
+  {
+    tDim.iWidth -= m_tCrop.uCropOffsetRight;
+    tDim.iHeight -= m_tCrop.uCropOffsetBottom;
+  }
+
+  return tDim;
+}
+
+void DecoderSource::Run(IFrameSink* sink, int iMaxPict, int iInFrameRate, int iOutFrameRate)
+{
+  bridge.m_limitReached = [&]() {
+    StopInput();
+  };
+
+  bridge.Run(sink, iMaxPict, iInFrameRate, iOutFrameRate);
+}
+
+AL_ERR DecoderSource::GetLastError()
+{
+  lock_guard<mutex> lock(m_mutex);
+
+  if(m_eError != AL_SUCCESS)
+    return m_eError;
+
+  auto eErr = AL_Decoder_GetLastError(m_hDec);
+  return eErr == AL_WARN_CONCEAL_DETECT ? static_cast<AL_ERR>(AL_SUCCESS) : eErr;
+}
+
+int DecoderSource::GetDecodedCount() const
+{
+  return m_iDecoded;
+}
+
+double DecoderSource::GetDecodingRate() const
+{
+  if(m_iDecoded < 2 || m_uLastDecoded == m_uFirstDecoded)
+    return 0.0;
+  return (m_iDecoded - 1) * 1000.0 / (m_uLastDecoded - m_uFirstDecoded);
+}
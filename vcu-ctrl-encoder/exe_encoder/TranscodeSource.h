@@ -0,0 +1,171 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "lib_app/BufPool.h"
+#include "sink.h"
+
+extern "C"
+{
+#include "lib_common/BufferSrcMeta.h"
+#include "lib_decode/lib_decode.h"
+}
+
+/*
+** Hands the decoded frame buffers to the encoder source pipeline without copying them.
+** Each decoder frame gets an alias buffer sharing its memory and described the way
+** the encoder expects its sources (cropped dimension). The encoder references the
+** alias like any other source, the frame is given back to the decoder with the
+** release hook once the last reference on its alias is dropped.
+*/
+class FrameBridge
+{
+public:
+  /* queued and dropped are called with the frames entering the queue and with the
+   * ones leaving it without being sent, they can be empty */
+  FrameBridge(std::function<void(AL_TBuffer*)> release, std::function<void(AL_TBuffer const*)> queued, std::function<void(AL_TBuffer const*)> dropped);
+  ~FrameBridge();
+
+  /* decoder side, never blocks. pFrame is kept until its alias is released */
+  void Push(AL_TBuffer* pFrame, AL_TDimension tDim);
+  void PushEndOfStream();
+  /* releases the frames still queued and ignores the following ones */
+  void Close();
+
+  /* sends the frames to sink until the end of stream or iMaxPict pictures (-1: all),
+   * then flushes sink. The frames are dropped or repeated to go from iInFrameRate to
+   * iOutFrameRate, like YuvFileInput does */
+  void Run(IFrameSink* sink, int iMaxPict, int iInFrameRate, int iOutFrameRate);
+
+  std::function<void(void)> m_limitReached; /* iMaxPict pictures were sent */
+
+  int GetDroppedCount() const;
+  int GetRepeatedCount() const;
+  int GetMaxQueued() const;
+
+private:
+  static void OnAliasReleased(AL_TBuffer* pAlias);
+  AL_TBuffer* GetAlias(AL_TBuffer* pFrame);
+  AL_TBuffer* Pop();
+
+  std::function<void(AL_TBuffer*)> const m_release;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_queueChanged;
+  std::deque<AL_TBuffer*> m_queue;
+  std::function<void(AL_TBuffer const*)> const m_frameQueued;
+  std::function<void(AL_TBuffer const*)> const m_frameDropped;
+  std::map<AL_TBuffer*, AL_TBuffer*> m_aliases; /* decoder frame -> alias */
+  bool m_bEndOfStream = false;
+  bool m_bClosed = false;
+  int m_iDropped = 0;
+  int m_iRepeated = 0;
+  int m_iMaxQueued = 0;
+};
+
+/*
+** Decodes a bitstream file and feeds the encoder with the decoded frame buffers.
+** The decoder frame buffers are allocated when the stream resolution is found, with
+** iNumHeldFrames more than the decoder needs for the ones the encoder pipeline keeps.
+** The frame hooks are the ones of FrameBridge, they are called from the first frame.
+*/
+class DecoderSource
+{
+public:
+  DecoderSource(std::string const& sFileName, AL_ECodec eCodec, AL_EFbStorageMode eStorageMode, AL_TIDecChannel* pDecChannel, AL_TAllocator* pAllocator, int iNumHeldFrames, std::function<void(AL_TBuffer const*)> frameQueued, std::function<void(AL_TBuffer const*)> frameDropped);
+  ~DecoderSource();
+
+  /* waits until the decoder found the stream resolution, throws if it never does */
+  AL_TStreamSettings WaitStreamSettings();
+  /* fourcc and display dimension of the decoded frames, valid after WaitStreamSettings */
+  TFourCC GetFourCC() const;
+  AL_TDimension GetDisplayDim() const;
+
+  /* see FrameBridge::Run. The input stops being decoded once iMaxPict pictures are sent */
+  void Run(IFrameSink* sink, int iMaxPict, int iInFrameRate, int iOutFrameRate);
+
+  AL_ERR GetLastError();
+  int GetDecodedCount() const;
+  double GetDecodingRate() const; // fps
+
+  FrameBridge bridge;
+
+private:
+  static AL_ERR OnResolutionFound(int iBufferNumber, int iBufferSize, AL_TStreamSettings const* pSettings, AL_TCropInfo const* pCropInfo, void* pUserParam);
+  static void OnFrameDecoded(AL_TBuffer* pFrame, void* pUserParam);
+  static void OnFrameDisplay(AL_TBuffer* pFrame, AL_TInfoDecode* pInfo, void* pUserParam);
+  AL_ERR InitFramePool(int iBufferNumber, AL_TStreamSettings const& tSettings, AL_TCropInfo const& tCrop);
+  void EndOfStream(AL_ERR eErr);
+  void ReadInput();
+  void StopInput();
+
+  AL_EFbStorageMode const m_eStorageMode;
+  AL_TAllocator* const m_pAllocator;
+  int const m_iNumHeldFrames;
+
+  std::ifstream m_file;
+  BufPool m_streamPool;
+  BufPool m_framePool;
+  AL_HDecoder m_hDec = nullptr;
+
+  std::mutex m_mutex;
+  std::condition_variable m_settingsFound;
+  bool m_bPoolIsInit = false;
+  bool m_bEnded = false;
+  AL_ERR m_eError = AL_SUCCESS;
+  std::string m_sFailure;
+  AL_TStreamSettings m_tSettings {};
+  AL_TCropInfo m_tCrop {};
+  TFourCC m_tFourCC = 0;
+
+  std::atomic<int> m_iDecoded;
+  uint64_t m_uFirstDecoded = 0;
+  uint64_t m_uLastDecoded = 0;
+
+  std::atomic<bool> m_bStopInput;
+  std::thread m_input;
+};
@@ -0,0 +1,135 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "YuvFileInput.h"
+#include "CodecUtils.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/****************************************************************************/
+YuvFileInput::YuvFileInput(std::string const& sFileName, TYUVFileInfo const& tFileInfo, int iFirstPict, int iPictStride, int iEncFrameRate) :
+  m_tFileInfo(tFileInfo),
+  m_iFirstPict(iFirstPict),
+  m_iPictStride(iPictStride),
+  m_iEncFrameRate(iEncFrameRate)
+{
+  if(iFirstPict < 0 || iPictStride < 1)
+    throw std::runtime_error("Invalid input picture selection, the first picture must be positive and the stride at least 1");
+
+  m_iFrameSize = GetFileFrameSize(tFileInfo);
+
+  if(m_iFrameSize <= 0)
+    throw std::runtime_error("Invalid YUV input dimensions or format");
+
+  m_iFd = open(sFileName.c_str(), O_RDONLY);
+
+  if(m_iFd < 0)
+    throw std::runtime_error("Can't open file for reading: '" + sFileName + "'");
+
+  struct stat tStat;
+
+  if(fstat(m_iFd, &tStat) != 0)
+  {
+    close(m_iFd);
+    throw std::runtime_error("Can't get the size of '" + sFileName + "'");
+  }
+
+  m_iNumFrames = tStat.st_size / m_iFrameSize;
+  m_iNextFrame = 0;
+}
+
+/****************************************************************************/
+YuvFileInput::~YuvFileInput()
+{
+  close(m_iFd);
+}
+
+/****************************************************************************/
+int64_t YuvFileInput::GetFrameIndex(int iPict) const
+{
+  int64_t iFilePict = iPict * m_iPictStride;
+
+  // the source frame rate differs from the encoding one: drop or repeat frames
+  if(m_tFileInfo.FrameRate && m_iEncFrameRate && (int64_t)m_tFileInfo.FrameRate != m_iEncFrameRate)
+    iFilePict = (iFilePict * m_tFileInfo.FrameRate) / m_iEncFrameRate;
+
+  return m_iFirstPict + iFilePict;
+}
+
+/****************************************************************************/
+bool YuvFileInput::ReadPicture(int iPict, AL_TBuffer* pBuf, bool bLoop)
+{
+  int64_t iFrame = GetFrameIndex(iPict);
+
+  if(iFrame >= m_iNumFrames)
+  {
+    if(!bLoop || m_iNumFrames == 0)
+      return false;
+
+    iFrame %= m_iNumFrames;
+  }
+
+  auto const tStart = std::chrono::steady_clock::now();
+
+  if(m_iReadCount && iFrame > m_iNextFrame)
+    m_iSkipCount += iFrame - m_iNextFrame;
+
+  bool const bRead = ReadOneFrameYuv(m_iFd, iFrame * m_iFrameSize, pBuf, m_FrameData);
+  m_iNextFrame = bRead ? iFrame + 1 : -1;
+
+  auto const tEnd = std::chrono::steady_clock::now();
+  m_uReadTime += std::chrono::duration_cast<std::chrono::microseconds>(tEnd - tStart).count();
+
+  if(bRead)
+    ++m_iReadCount;
+
+  return bRead;
+}
+
+/****************************************************************************/
+double YuvFileInput::GetReadRate() const
+{
+  if(m_uReadTime == 0)
+    return 0.0;
+  return (double)m_iReadCount * m_iFrameSize / m_uReadTime;
+}
+
@@ -0,0 +1,96 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lib_app/InputFiles.h"
+
+extern "C"
+{
+#include "lib_common/BufferAPI.h"
+}
+
+/*
+** Frame addressed access to a raw YUV input file.
+** The file frame used by each encoded picture is computed from the first
+** frame, the stride and the source / encoding frame rate ratio, and only
+** that frame is read with pread at its offset: dropped frames are never
+** fetched from the disk and the reads don't depend on a file position.
+*/
+class YuvFileInput
+{
+public:
+  YuvFileInput(std::string const& sFileName, TYUVFileInfo const& tFileInfo, int iFirstPict, int iPictStride, int iEncFrameRate);
+  ~YuvFileInput();
+
+  YuvFileInput(YuvFileInput const&) = delete;
+  YuvFileInput & operator = (YuvFileInput const&) = delete;
+
+  /* reads the source of the iPict-th encoded picture in pBuf. Returns false past the end of the file when bLoop isn't set */
+  bool ReadPicture(int iPict, AL_TBuffer* pBuf, bool bLoop);
+
+  /* index in the file of the frame used by the iPict-th encoded picture (before looping) */
+  int64_t GetFrameIndex(int iPict) const;
+
+  int64_t GetFrameSize() const { return m_iFrameSize; }
+  int64_t GetNumFrames() const { return m_iNumFrames; }
+  int GetReadCount() const { return m_iReadCount; }
+  /* number of file frames never fetched between the first and the last read frame */
+  int64_t GetSkipCount() const { return m_iSkipCount; }
+  /* read throughput in MB/s */
+  double GetReadRate() const;
+
+private:
+  int m_iFd = -1;
+  std::vector<char> m_FrameData; /* frame read at once when the buffer rows are padded */
+  TYUVFileInfo const m_tFileInfo;
+  int64_t const m_iFirstPict;
+  int64_t const m_iPictStride;
+  int64_t const m_iEncFrameRate;
+  int64_t m_iFrameSize;
+  int64_t m_iNumFrames;
+  int64_t m_iNextFrame = -1; /* frame following the last one read */
+
+  int m_iReadCount = 0;
+  int64_t m_iSkipCount = 0;
+  uint64_t m_uReadTime = 0;
+};
+
@@ -35,6 +35,8 @@
 *
 ******************************************************************************/
 
+#include <algorithm>
+#include <cctype>
 #include <climits>
 #include <cassert>
 #include <fstream>
@@ -50,19 +52,24 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "lib_app/BufPool.h"
 #include "lib_app/console.h"
 #include "lib_app/utils.h"
+#include "lib_app/AllocatorTracker.h"
 
 #include "CodecUtils.h"
+#include "YuvFileInput.h"
+#include "TranscodeSource.h"
 #include "sink.h"
 #include "IpDevice.h"
 
 #include "resource.h"
 
 #include "CfgParser.h"
+#include "CapacityPlan.h"
 
 extern "C"
 {
@@ -89,6 +96,8 @@ extern "C"
 #include "sink_frame_writer.h"
 #include "sink_md5.h"
 #include "sink_repeater.h"
+#include "sink_scene_change.h"
+#include "sink_latency.h"
 #include "QPGenerator.h"
 
 
@@ -231,13 +240,37 @@ void introspect(ConfigFile& cfg)
 }
 
 /*****************************************************************************/
-void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
+/* applies the input description and the command line bitdepth to the channel parameters */
+static void SetSourceParams(ConfigFile& cfg, int ipbitdepth)
+{
+  if(cfg.FileInfo.PictWidth > UINT16_MAX)
+    throw runtime_error("Unsupported picture width value");
+
+  if(cfg.FileInfo.PictHeight > UINT16_MAX)
+    throw runtime_error("Unsupported picture height value");
+
+  AL_SetSrcWidth(&cfg.Settings.tChParam[0], cfg.FileInfo.PictWidth);
+  AL_SetSrcHeight(&cfg.Settings.tChParam[0], cfg.FileInfo.PictHeight);
+
+  if(ipbitdepth != -1)
+  {
+    AL_SET_BITDEPTH(cfg.Settings.tChParam[0].ePicFormat, ipbitdepth);
+  }
+
+  cfg.Settings.tChParam[0].uSrcBitDepth = AL_GET_BITDEPTH(cfg.Settings.tChParam[0].ePicFormat);
+
+  if(AL_IS_STILL_PROFILE(cfg.Settings.tChParam[0].eProfile))
+    cfg.RunInfo.iMaxPict = 1;
+}
+
+void ParseCommandLine(int argc, char** argv, ConfigFile& cfg, vector<ConfigFile>& channelCfgs)
 {
   bool DoNotAcceptCfg = false;
   bool help = false;
   bool help_cfg = false;
   bool version = false;
   bool dumpCfg = false;
+  vector<TPlanRequest> planRequests;
   stringstream warning;
   auto opt = CommandLineParser([&](string word)
   {
@@ -267,9 +300,32 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
   opt.addFlag("--help,-h", &help, "Show this help");
   opt.addFlag("--version", &version, "Show version");
   opt.addString("--input,-i", &cfg.YUVFileName, "YUV input file");
+  opt.addOption("--synthetic", [&]()
+  {
+    ParseConfig("[INPUT]\nSynthetic=" + opt.popWord(), cfg);
+  }, "Generate a moving test pattern in memory instead of reading a YUV input file (BARS, TILES, GRADIENT, PLAIN)");
+  opt.addInt("--synthetic-motion-x", &cfg.tSynthetic.iMotionX, "Horizontal motion of the synthetic pattern in pixels per frame");
+  opt.addInt("--synthetic-motion-y", &cfg.tSynthetic.iMotionY, "Vertical motion of the synthetic pattern in pixels per frame");
+  opt.addInt("--synthetic-noise", &cfg.tSynthetic.iNoise, "Amplitude of the random noise added to the synthetic luma (0 .. 255)");
+  opt.addString("--transcode", &cfg.TranscodeFileName, "Decode this AVC or HEVC bitstream and encode its frames, without copy, instead of reading a YUV input file. The input frame rate is given by the [INPUT] FrameRate");
+  opt.addOption("--transcode-codec", [&]()
+  {
+    ParseConfig("[INPUT]\nTranscodeCodec=" + opt.popWord(), cfg);
+  }, "Codec of the --transcode bitstream (AVC, HEVC). Guessed from the file extension by default");
 
   opt.addString("--output,-o", &cfg.BitstreamFileName, "Compressed output file");
   opt.addString("--md5", &cfg.RunInfo.sMd5Path, "Path to the output MD5 textfile");
+  opt.addOption("--md5-algo", [&]()
+  {
+    auto const sAlgo = opt.popWord();
+
+    if(sAlgo == "MD5")
+      cfg.RunInfo.eRecHash = REC_HASH_MD5;
+    else if(sAlgo == "HASH64")
+      cfg.RunInfo.eRecHash = REC_HASH_64;
+    else
+      throw runtime_error("Unknown reconstructed frames hash: " + sAlgo);
+  }, "Hash of the reconstructed frames written in the --md5 file: MD5 of the whole sequence (default) or HASH64, a fast 64 bits hash of each plane of each frame");
   opt.addString("--output-rec,-r", &cfg.RecFileName, "Output reconstructed YUV file");
   opt.addOption("--color", [&]() {
     SetEnableColor(true);
@@ -314,16 +370,37 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
   opt.addInt("--gop-numB", &cfg.Settings.tChParam[0].tGopParam.uNumB, "Number of consecutive B frame (0 .. 4)");
   opt.addCustom("--gop-mode", &cfg.Settings.tChParam[0].tGopParam.eMode, createParseGopMode(), "Specifies gop control mode (DEFAULT_GOP, PYRAMIDAL_GOP)");
   opt.addInt("--first-picture", &cfg.RunInfo.iFirstPict, "First picture encoded (skip those before)");
+  opt.addInt("--picture-stride", &cfg.RunInfo.iPictStride, "Number of input pictures to advance between two encoded pictures (1 by default)");
   opt.addInt("--max-picture", &cfg.RunInfo.iMaxPict, "Maximum number of pictures encoded (1,2 .. -1 for ALL)");
   opt.addInt("--num-slices", &cfg.Settings.tChParam[0].uNumSlices, "Specifies the number of slices to use");
   opt.addInt("--num-core", &cfg.Settings.tChParam[0].uNumCore, "Specifies the number of cores to use (resolution needs to be sufficient)");
   opt.addString("--log", &cfg.RunInfo.logsFile, "A file where log event will be dumped");
+  opt.addFlag("--track-dma", &cfg.RunInfo.trackDma, "Account the dma allocations and print where the memory went and how many dmabufs were imported on exit");
+  opt.addOption("--track-dma-csv", [&]()
+  {
+    cfg.RunInfo.sDmaTimeline = opt.popWord();
+    cfg.RunInfo.trackDma = true;
+  }, "Track the dma allocations and dump the usage per category in a csv file every 100ms");
+  opt.addInt("--status-workers", &cfg.RunInfo.iStatusWorkers, "Collect the channel statuses on a pool of n threads shared by all the channels instead of one thread per channel (0 by default)");
+  opt.addOption("--thread-cfg", [&]()
+  {
+    SetThreadConfig(opt.popWord());
+  }, "Pin and prioritize a named thread: 'name:cpus[:policy[:priority[:stacksize]]]', e.g. 'al_dec_feeder:2,3:fifo:50'. Can be repeated");
+  opt.addOption("--rtos-pool", [&]()
+  {
+    EnableRtosMallocPool();
+  }, "Serve the small control allocations from per-thread pools and print the pool statistics on exit");
   opt.addFlag("--loop", &cfg.RunInfo.bLoop, "Loop at the end of the yuv file");
   opt.addFlag("--slicelat", &cfg.Settings.tChParam[0].bSubframeLatency, "Enable subframe latency");
   opt.addFlag("--framelat", &cfg.Settings.tChParam[0].bSubframeLatency, "Disable subframe latency", false);
 
   opt.addInt("--prefetch", &g_numFrameToRepeat, "Prefetch n frames and loop between these frames for max picture count");
   opt.addFlag("--print-picture-type", &cfg.RunInfo.printPictureType, "Write picture type for each frame in the file", true);
+  opt.addFlag("--scene-change-detection", &cfg.RunInfo.bSceneChangeDetection, "Detect scene changes on the source frames and notify the encoder ahead of time");
+  opt.addInt("--scd-sad-threshold", &cfg.RunInfo.tScdParam.iSadThreshold, "Mean absolute luma difference above which a scene change can be detected (0 .. 255)");
+  opt.addInt("--scd-hist-threshold", &cfg.RunInfo.tScdParam.iHistThreshold, "Luma histogram distance above which a scene change can be detected (0 .. 1000)");
+  opt.addInt("--scd-decimation", &cfg.RunInfo.tScdParam.iDecimation, "Luma decimation factor used by the scene change detection (4, 8, 16 or 32)");
+  opt.addInt("--scd-min-interval", &cfg.RunInfo.tScdParam.iMinInterval, "Minimum number of frames between two detected scene changes");
 
 
 
@@ -333,6 +410,30 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
   opt.addString("--twopass-logfile", &cfg.sTwoPassFileName, "File for video statistics used in twopass");
 #endif
 
+  opt.addOption("--plan-cfg", [&]()
+  {
+    auto const cfgPath = opt.popWord();
+    ConfigFile planCfg;
+    SetDefaults(planCfg);
+    planCfg.strict_mode = true;
+    ParseConfigFile(cfgPath, planCfg, warning);
+    planRequests.push_back(CreateEncoderPlanRequest(cfgPath, planCfg));
+  }, "Add the encoder channel of a configuration file to the capacity plan (no encoding is done)");
+  opt.addOption("--plan-dec", [&]()
+  {
+    planRequests.push_back(CreateDecoderPlanRequest(opt.popWord()));
+  }, "Add a decoder channel, WIDTHxHEIGHT@FPS, to the capacity plan (no encoding is done)");
+
+  opt.addOption("--channel", [&]()
+  {
+    auto const cfgPath = opt.popWord();
+    ConfigFile chanCfg;
+    SetDefaults(chanCfg);
+    chanCfg.strict_mode = true;
+    ParseConfigFile(cfgPath, chanCfg, warning);
+    channelCfgs.push_back(chanCfg);
+  }, "Add an encoder channel described by a configuration file. The channels are encoded concurrently, sharing the device, and a per-channel summary is printed. The other options then only apply to the device and the process");
+
   opt.addOption("--set", [&]()
   {
     ParseConfig(opt.popWord(), cfg);
@@ -358,38 +459,63 @@ void ParseCommandLine(int argc, char** argv, ConfigFile& cfg)
     exit(0);
   }
 
+  if(!planRequests.empty())
+    exit(RunCapacityPlan(planRequests, cout) ? 0 : 1);
+
 
   if(g_Verbosity)
     cerr << warning.str();
 
-  if(cfg.FileInfo.PictWidth > UINT16_MAX)
-    throw runtime_error("Unsupported picture width value");
-
-  if(cfg.FileInfo.PictHeight > UINT16_MAX)
-    throw runtime_error("Unsupported picture height value");
+  if(!cfg.TranscodeFileName.empty() && g_numFrameToRepeat > 0)
+    throw runtime_error("--prefetch can't be used with a transcode input");
 
-  AL_SetSrcWidth(&cfg.Settings.tChParam[0], cfg.FileInfo.PictWidth);
-  AL_SetSrcHeight(&cfg.Settings.tChParam[0], cfg.FileInfo.PictHeight);
-
-  if(ipbitdepth != -1)
+  if(channelCfgs.empty())
   {
-    AL_SET_BITDEPTH(cfg.Settings.tChParam[0].ePicFormat, ipbitdepth);
+    SetSourceParams(cfg, ipbitdepth);
+    return;
   }
 
-  cfg.Settings.tChParam[0].uSrcBitDepth = AL_GET_BITDEPTH(cfg.Settings.tChParam[0].ePicFormat);
+  for(size_t i = 0; i < channelCfgs.size(); ++i)
+  {
+    auto& chanCfg = channelCfgs[i];
 
-  if(AL_IS_STILL_PROFILE(cfg.Settings.tChParam[0].eProfile))
-    cfg.RunInfo.iMaxPict = 1;
+    if(!cfg.TranscodeFileName.empty() || !chanCfg.TranscodeFileName.empty())
+      throw runtime_error("A transcode input can't be used with --channel");
+
+    SetSourceParams(chanCfg, -1);
+
+    /* don't let the channels overwrite the same default output */
+    if(chanCfg.BitstreamFileName == "Stream.bin")
+      chanCfg.BitstreamFileName = "Stream_" + to_string(i) + ".bin";
+  }
 
+  /* the per-channel memory is measured by the allocator tracker */
+  cfg.RunInfo.trackDma = true;
 }
 
 void ValidateConfig(ConfigFile& cfg)
 {
   string invalid_settings("Invalid settings, check the [SETTINGS] section of your configuration file or check your commandline (use -h to get help)");
 
-  if(cfg.YUVFileName.empty())
+  bool const bTranscode = !cfg.TranscodeFileName.empty();
+
+  if(bTranscode && cfg.tSynthetic.ePattern != SYNTHETIC_NONE)
+    throw runtime_error("A transcode input can't be used with a synthetic input");
+
+  if(cfg.tSynthetic.ePattern != SYNTHETIC_NONE)
+  {
+    if(cfg.RunInfo.iMaxPict == INT_MAX || cfg.RunInfo.iMaxPict == -1)
+      throw runtime_error("A synthetic input has no end, specify the number of pictures to encode with MaxPicture or --max-picture");
+
+    if(cfg.tSynthetic.iNoise < 0 || cfg.tSynthetic.iNoise > 255)
+      throw runtime_error("SyntheticNoise must be in the range 0 .. 255");
+  }
+  else if(cfg.YUVFileName.empty() && !bTranscode)
     throw runtime_error("No YUV input was given, specify it in the [INPUT] section of your configuration file or in your commandline (use -h to get help)");
 
+  if(cfg.RunInfo.bSceneChangeDetection && cfg.RunInfo.iScnChgLookAhead > SceneChangeSink::MAX_LOOKAHEAD)
+    throw runtime_error("ScnChgLookAhead must be in the range 0 .. 31 with the scene change detection");
+
   if(!cfg.sQPTablesFolder.empty() && cfg.Settings.eQpCtrlMode != LOAD_QP)
     throw runtime_error("QPTablesFolder can only be specified with Load QP control mode");
 
@@ -453,57 +579,12 @@ void SetMoreDefaults(ConfigFile& cfg)
   }
 }
 
-static AL_TOffsetYC GetOffsetYC(int iPitchY, int iHeight, TFourCC fourCC)
-{
-  AL_TOffsetYC tOffsetYC;
-  tOffsetYC.iLuma = 0;
-  auto const iNumLinesInPitch = AL_GetNumLinesInPitch(AL_GetStorageMode(fourCC));
-  tOffsetYC.iChroma = (int)(iPitchY * iHeight / iNumLinesInPitch);
-  return tOffsetYC;
-}
-
-/*****************************************************************************/
-static
-shared_ptr<AL_TBuffer> AllocateConversionBuffer(vector<uint8_t>& YuvBuffer, int iWidth, int iHeight, TFourCC tFourCC)
-{
-  /* we want to read from /write to a file, so no alignement is necessary */
-  int const iWidthInBytes = GetIOLumaRowSize(tFourCC, static_cast<uint32_t>(iWidth));
-  AL_TPitches tPitches {
-    iWidthInBytes, AL_IsSemiPlanar(tFourCC) ? iWidthInBytes : iWidthInBytes / 2
-  };
-  uint32_t uSize = tPitches.iLuma * iHeight;
-  switch(AL_GetChromaMode(tFourCC))
-  {
-  case CHROMA_4_2_0:
-    uSize += uSize / 2;
-    break;
-  case CHROMA_4_2_2:
-    uSize += uSize;
-    break;
-  default:
-    break;
-  }
-
-  YuvBuffer.resize(uSize);
-  AL_TBuffer* Yuv = AL_Buffer_WrapData(YuvBuffer.data(), uSize, NULL);
-
-  AL_TOffsetYC tOffsetYC = GetOffsetYC(tPitches.iLuma, iHeight, tFourCC);
-  AL_TDimension tDimension = { iWidth, iHeight };
-  AL_TMetaData* pMeta = (AL_TMetaData*)AL_SrcMetaData_Create(tDimension, tPitches, tOffsetYC, tFourCC);
-
-  if(!pMeta)
-    throw runtime_error("Couldn't allocate conversion buffer");
-  AL_Buffer_AddMetaData(Yuv, pMeta);
-
-  return shared_ptr<AL_TBuffer>(Yuv, &AL_Buffer_Destroy);
-}
-
-shared_ptr<AL_TBuffer> ReadSourceFrame(BufPool* pBufPool, AL_TBuffer* conversionBuffer, ifstream& YuvFile, AL_TEncChanParam const& tChParam, ConfigFile const& cfg, IConvSrc* hConv)
+shared_ptr<AL_TBuffer> ReadSourceFrame(BufPool* pBufPool, AL_TBuffer* conversionBuffer, YuvFileInput& YuvFile, int iPictCount, AL_TEncChanParam const& tChParam, ConfigFile const& cfg, IConvSrc* hConv)
 {
   shared_ptr<AL_TBuffer> sourceBuffer(pBufPool->GetBuffer(), &AL_Buffer_Unref);
   assert(sourceBuffer);
 
-  if(!ReadOneFrameYuv(YuvFile, hConv ? conversionBuffer : sourceBuffer.get(), cfg.RunInfo.bLoop))
+  if(!YuvFile.ReadPicture(iPictCount, hConv ? conversionBuffer : sourceBuffer.get(), cfg.RunInfo.bLoop))
     return nullptr;
 
   if(hConv)
@@ -543,28 +624,21 @@ static bool isLastPict(int iPictCount, int iMaxPict)
   return (iPictCount >= iMaxPict) && (iMaxPict != -1);
 }
 
-static void PrepareInput(ifstream& YuvFile, string& YUVFileName, TYUVFileInfo& FileInfo, ConfigFile const& cfg)
+static unique_ptr<YuvFileInput> PrepareInput(string const& YUVFileName, TYUVFileInfo const& FileInfo, ConfigFile const& cfg)
 {
-  OpenInput(YuvFile, YUVFileName);
-  GotoFirstPicture(FileInfo, YuvFile, cfg.RunInfo.iFirstPict);
+  return unique_ptr<YuvFileInput>(new YuvFileInput(YUVFileName, FileInfo, cfg.RunInfo.iFirstPict, cfg.RunInfo.iPictStride, cfg.Settings.tChParam[0].tRCParam.uFrameRate));
 }
 
-static void GetSrcFrame(shared_ptr<AL_TBuffer>& frame, int& iReadCount, int iPictCount, ifstream& YuvFile, const TYUVFileInfo& FileInfo, BufPool& SrcBufPool, AL_TBuffer* Yuv, AL_TEncChanParam const& tChParam, ConfigFile const& cfg, IConvSrc* pSrcConv)
+static void GetSrcFrame(shared_ptr<AL_TBuffer>& frame, int iPictCount, YuvFileInput& YuvFile, BufPool& SrcBufPool, AL_TBuffer* Yuv, AL_TEncChanParam const& tChParam, ConfigFile const& cfg, IConvSrc* pSrcConv)
 {
   if(!isLastPict(iPictCount, cfg.RunInfo.iMaxPict))
-  {
-    if(cfg.FileInfo.FrameRate != tChParam.tRCParam.uFrameRate)
-      iReadCount += GotoNextPicture(FileInfo, YuvFile, tChParam.tRCParam.uFrameRate, iPictCount, iReadCount);
-
-    frame = ReadSourceFrame(&SrcBufPool, Yuv, YuvFile, tChParam, cfg, pSrcConv);
-    iReadCount++;
-  }
+    frame = ReadSourceFrame(&SrcBufPool, Yuv, YuvFile, iPictCount, tChParam, cfg, pSrcConv);
 }
 
-static bool sendInputFileTo(ifstream& YuvFile, BufPool& SrcBufPool, AL_TBuffer* Yuv, ConfigFile const& cfg, IConvSrc* pSrcConv, IFrameSink* sink, int& iPictCount, int& iReadCount)
+static bool sendInputFileTo(YuvFileInput& YuvFile, BufPool& SrcBufPool, AL_TBuffer* Yuv, ConfigFile const& cfg, IConvSrc* pSrcConv, IFrameSink* sink, int& iPictCount)
 {
   shared_ptr<AL_TBuffer> frame;
-  GetSrcFrame(frame, iReadCount, iPictCount, YuvFile, cfg.FileInfo, SrcBufPool, Yuv, cfg.Settings.tChParam[0], cfg, pSrcConv);
+  GetSrcFrame(frame, iPictCount, YuvFile, SrcBufPool, Yuv, cfg.Settings.tChParam[0], cfg, pSrcConv);
   sink->ProcessFrame(frame.get());
 
   if(!frame)
@@ -574,6 +648,23 @@ static bool sendInputFileTo(ifstream& YuvFile, BufPool& SrcBufPool, AL_TBuffer*
   return true;
 }
 
+static bool sendSyntheticTo(SyntheticSource& source, BufPool& SrcBufPool, ConfigFile const& cfg, IFrameSink* sink, int& iPictCount)
+{
+  if(isLastPict(iPictCount, cfg.RunInfo.iMaxPict))
+  {
+    sink->ProcessFrame(nullptr);
+    return false;
+  }
+
+  shared_ptr<AL_TBuffer> frame(SrcBufPool.GetBuffer(), &AL_Buffer_Unref);
+  assert(frame);
+  source.Fill(frame.get(), iPictCount);
+  sink->ProcessFrame(frame.get());
+
+  iPictCount++;
+  return true;
+}
+
 
 unique_ptr<IConvSrc> CreateSrcConverter(TFrameInfo const& FrameInfo, AL_ESrcMode eSrcMode, AL_TEncChanParam& tChParam)
 {
@@ -702,55 +793,51 @@ static void InitSrcBufPool(AL_TAllocator* pAllocator, bool shouldConvert, unique
 }
 
 /*****************************************************************************/
-void SafeMain(int argc, char** argv)
+/* One encoder with its source and sink pipelines. Several of them can share the device */
+struct EncoderChannel
 {
-  ConfigFile cfg;
-  SetDefaults(cfg);
+  EncoderChannel(ConfigFile const& cfg_, CIpDevice& device, bool bShowStatus);
 
+  /* sends the source frames and waits until they are all encoded */
+  void Run();
+  void PrintInputStatistics();
+
+  ConfigFile cfg;
+  shared_ptr<void> hFinished;
+  LatencySink latency; /* signaled by the encoder */
+  BufPool StreamBufPool;
+  /* instantiation has to be before the Encoder instantiation to get the destroying order right */
+  BufPool SrcBufPool;
+  BufPool QpBufPool;
+  unique_ptr<EncoderSink> enc;
+  unique_ptr<SceneChangeSink> sceneChange;
+#if AL_ENABLE_TWOPASS
+  unique_ptr<EncoderLookAheadSink> encFirstPassLA;
+#endif
+  // Input/Output Format conversion
+  shared_ptr<AL_TBuffer> SrcYuv;
+  vector<uint8_t> YuvBuffer;
+  shared_ptr<AL_TBuffer> RecYuv;
+  vector<uint8_t> RecYuvBuffer;
+  unique_ptr<RepeaterSink> prefetch;
+  unique_ptr<IConvSrc> pSrcConv;
+  unique_ptr<YuvFileInput> YuvFile;
+  unique_ptr<SyntheticSource> synthetic;
+  IFrameSink* firstSink = nullptr;
+};
+
+EncoderChannel::EncoderChannel(ConfigFile const& cfg_, CIpDevice& device, bool bShowStatus) :
+  cfg(cfg_), hFinished(Rtos_CreateEvent(false), &Rtos_DeleteEvent)
+{
   auto& FileInfo = cfg.FileInfo;
   auto& Settings = cfg.Settings;
-  auto& StreamFileName = cfg.BitstreamFileName;
-  auto& RecFileName = cfg.RecFileName;
   auto& RunInfo = cfg.RunInfo;
 
-  ParseCommandLine(argc, argv, cfg);
-
-  DisplayVersionInfo();
-
-  AL_Settings_SetDefaultParam(&Settings);
-  SetMoreDefaults(cfg);
-
-  if(!RecFileName.empty() || !cfg.RunInfo.sMd5Path.empty())
-    Settings.tChParam[0].eOptions = (AL_EChEncOption)(Settings.tChParam[0].eOptions | AL_OPT_FORCE_REC);
-
-
-
-  ValidateConfig(cfg);
-
-
-
-  function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl = GetIpCtrlWrapper(RunInfo);
-
-  auto pIpDevice = CreateIpDevice(!RunInfo.bUseBoard, RunInfo.iSchedulerType, Settings, wrapIpCtrl, RunInfo.trackDma, RunInfo.eVQDescr);
-
-  if(!pIpDevice)
-    throw runtime_error("Can't create IpDevice");
-
-
-  auto hFinished = Rtos_CreateEvent(false);
-  auto scopeMutex = scopeExit([&]() {
-    Rtos_DeleteEvent(hFinished);
-  });
-
-  // --------------------------------------------------------------------------------
-  // Create Encoder
-  auto pAllocator = pIpDevice->m_pAllocator.get();
-  auto pScheduler = pIpDevice->m_pScheduler;
+  auto pAllocator = device.m_pAllocator.get();
+  auto pScheduler = device.m_pScheduler;
 
   AL_TBufPoolConfig StreamBufPoolConfig = GetStreamBufPoolConfig(Settings, FileInfo);
-  BufPool StreamBufPool(pAllocator, StreamBufPoolConfig);
-  /* instantiation has to be before the Encoder instantiation to get the destroying order right */
-  BufPool SrcBufPool;
+  StreamBufPool.Init(pAllocator, StreamBufPoolConfig);
 
   int frameBuffersCount = 2 + Settings.tChParam[0].tGopParam.uNumB;
 #if AL_ENABLE_TWOPASS
@@ -760,23 +847,35 @@ void SafeMain(int argc, char** argv)
     frameBuffersCount += cfg.Settings.LookAhead;
 #endif
   auto QpBufPoolConfig = GetQpBufPoolConfig(Settings, Settings.tChParam[0], frameBuffersCount);
-  BufPool QpBufPool(pAllocator, QpBufPoolConfig);
+  QpBufPool.Init(pAllocator, QpBufPoolConfig);
 
 
-  unique_ptr<EncoderSink> enc;
   enc.reset(new EncoderSink(cfg, pScheduler, pAllocator, QpBufPool
                             ));
 
 
-  enc->BitstreamOutput = createBitstreamWriter(StreamFileName, cfg);
+  enc->BitstreamOutput = createBitstreamWriter(cfg.BitstreamFileName, cfg);
   enc->m_done = ([&]() {
-    Rtos_SetEvent(hFinished);
+    Rtos_SetEvent(hFinished.get());
+  });
+  enc->m_frameEncoded = ([&](AL_TBuffer const* pSrc, bool bEndOfFrame) {
+    latency.EndFrame(pSrc, bEndOfFrame);
   });
+  enc->bShowStatus = bShowStatus;
 
-  IFrameSink* firstSink = enc.get();
+  firstSink = enc.get();
+
+  if(RunInfo.bSceneChangeDetection)
+  {
+    // the detection delays the source by ScnChgLookAhead frames
+    sceneChange.reset(new SceneChangeSink(RunInfo.tScdParam, RunInfo.iScnChgLookAhead));
+    sceneChange->hEnc = enc->hEnc;
+    sceneChange->next = firstSink;
+    firstSink = sceneChange.get();
+    frameBuffersCount += RunInfo.iScnChgLookAhead;
+  }
 
 #if AL_ENABLE_TWOPASS
-  unique_ptr<EncoderLookAheadSink> encFirstPassLA;
 
   if(AL_TwoPassMngr_HasLookAhead(cfg.Settings))
   {
@@ -787,19 +886,16 @@ void SafeMain(int argc, char** argv)
   }
 #endif
 
-  // Input/Output Format conversion
-  shared_ptr<AL_TBuffer> SrcYuv;
-  vector<uint8_t> YuvBuffer;
-  bool shouldConvert = ConvertSrcBuffer(Settings.tChParam[0], FileInfo, YuvBuffer, SrcYuv);
-
+  bool const bSynthetic = cfg.tSynthetic.ePattern != SYNTHETIC_NONE;
+  bool const bTranscode = !cfg.TranscodeFileName.empty();
+  /* the synthetic source is generated directly in the encoder source format */
+  bool shouldConvert = !bSynthetic && !bTranscode && ConvertSrcBuffer(Settings.tChParam[0], FileInfo, YuvBuffer, SrcYuv);
 
-  shared_ptr<AL_TBuffer> RecYuv;
-  vector<uint8_t> RecYuvBuffer;
 
-  if(!RecFileName.empty())
+  if(!cfg.RecFileName.empty())
   {
     RecYuv = AllocateConversionBuffer(RecYuvBuffer, Settings.tChParam[0].uWidth, Settings.tChParam[0].uHeight, cfg.RecFourCC);
-    enc->RecOutput = createFrameWriter(RecFileName, cfg, RecYuv.get(), 0);
+    enc->RecOutput = createFrameWriter(cfg.RecFileName, cfg, RecYuv.get(), 0);
   }
 
 
@@ -807,7 +903,7 @@ void SafeMain(int argc, char** argv)
   {
     auto multisink = unique_ptr<MultiSink>(new MultiSink);
     multisink->sinks.push_back(move(enc->RecOutput));
-    multisink->sinks.push_back(createMd5Calculator(cfg.RunInfo.sMd5Path, cfg, RecYuv.get()));
+    multisink->sinks.push_back(createMd5Calculator(cfg.RunInfo.sMd5Path, cfg));
     enc->RecOutput = move(multisink);
   }
 
@@ -839,7 +935,8 @@ void SafeMain(int argc, char** argv)
   }
 
 
-  unique_ptr<RepeaterSink> prefetch;
+  latency.next = firstSink;
+  firstSink = &latency;
 
   if(g_numFrameToRepeat > 0)
   {
@@ -850,24 +947,37 @@ void SafeMain(int argc, char** argv)
     frameBuffersCount = max(frameBuffersCount, g_numFrameToRepeat);
   }
 
+  /* the decoded frames are used as sources: there is nothing to read nor to allocate */
+  if(bTranscode)
+    return;
+
   TFrameInfo FrameInfo = GetFrameInfo(cfg.FileInfo, Settings.tChParam[0]);
   auto const eSrcMode = Settings.tChParam[0].eSrcMode;
 
   /* source compression case */
-  auto pSrcConv = CreateSrcConverter(FrameInfo, eSrcMode, Settings.tChParam[0]);
+  pSrcConv = CreateSrcConverter(FrameInfo, eSrcMode, Settings.tChParam[0]);
 
   InitSrcBufPool(pAllocator, shouldConvert, pSrcConv, FrameInfo, eSrcMode, frameBuffersCount, SrcBufPool);
-  ifstream YuvFile;
-  PrepareInput(YuvFile, cfg.YUVFileName, cfg.FileInfo, cfg);
 
+  if(bSynthetic)
+    synthetic.reset(new SyntheticSource(cfg.tSynthetic, FileInfo.PictWidth, FileInfo.PictHeight));
+  else
+    YuvFile = PrepareInput(cfg.YUVFileName, cfg.FileInfo, cfg);
+}
+
+void EncoderChannel::Run()
+{
   int iPictCount = 0;
-  int iReadCount = 0;
   bool bRet = true;
 
   while(bRet)
   {
     AL_64U uBeforeTime = Rtos_GetTime();
-    bRet = sendInputFileTo(YuvFile, SrcBufPool, SrcYuv.get(), cfg, pSrcConv.get(), firstSink, iPictCount, iReadCount);
+
+    if(synthetic)
+      bRet = sendSyntheticTo(*synthetic, SrcBufPool, cfg, firstSink, iPictCount);
+    else
+      bRet = sendInputFileTo(*YuvFile, SrcBufPool, SrcYuv.get(), cfg, pSrcConv.get(), firstSink, iPictCount);
 
     AL_64U uAfterTime = Rtos_GetTime();
 
@@ -875,7 +985,266 @@ void SafeMain(int argc, char** argv)
       Rtos_Sleep(cfg.RunInfo.uInputSleepInMilliseconds - (uAfterTime - uBeforeTime));
   }
 
-  Rtos_WaitEvent(hFinished, AL_WAIT_FOREVER);
+  Rtos_WaitEvent(hFinished.get(), AL_WAIT_FOREVER);
+}
+
+void EncoderChannel::PrintInputStatistics()
+{
+  if(synthetic)
+    Message(CC_DEFAULT, "\nSynthetic source: %d frames generated at %.2f fps\n", synthetic->GetFrameCount(), synthetic->GetGenerationRate());
+
+  if(YuvFile)
+    Message(CC_DEFAULT, "\nYUV input: %d frames read, %lld skipped, %.1f MB/s\n", YuvFile->GetReadCount(), (long long)YuvFile->GetSkipCount(), YuvFile->GetReadRate());
+}
+
+/*****************************************************************************/
+static void PrepareConfig(ConfigFile& cfg)
+{
+  AL_Settings_SetDefaultParam(&cfg.Settings);
+  SetMoreDefaults(cfg);
+
+  if(!cfg.RecFileName.empty() || !cfg.RunInfo.sMd5Path.empty())
+    cfg.Settings.tChParam[0].eOptions = (AL_EChEncOption)(cfg.Settings.tChParam[0].eOptions | AL_OPT_FORCE_REC);
+
+  ValidateConfig(cfg);
+}
+
+/*****************************************************************************/
+static void RunChannels(vector<ConfigFile> const& channelCfgs, CIpDevice& device)
+{
+  auto pAllocator = device.m_pAllocator.get();
+
+  /* the channels are created one by one to know the dma memory each one takes */
+  vector<unique_ptr<EncoderChannel>> channels;
+  vector<size_t> channelBytes;
+
+  for(auto& chanCfg : channelCfgs)
+  {
+    auto const zBefore = GetAllocatorTrackerTotal(pAllocator).currentBytes;
+    channels.emplace_back(new EncoderChannel(chanCfg, device, false));
+    channelBytes.push_back(GetAllocatorTrackerTotal(pAllocator).currentBytes - zBefore);
+  }
+
+  Message(CC_DEFAULT, "Encoding %d channels\n", (int)channels.size());
+
+  vector<string> errors(channels.size());
+  vector<thread> threads;
+  auto const uBegin = GetPerfTime();
+
+  for(size_t i = 0; i < channels.size(); ++i)
+  {
+    threads.emplace_back([&, i]()
+    {
+      try
+      {
+        channels[i]->Run();
+      }
+      catch(runtime_error const& error)
+      {
+        errors[i] = error.what();
+      }
+      catch(exception const& error)
+      {
+        /* an exception escaping the thread would terminate the process */
+        errors[i] = string("unexpected error: ") + error.what();
+      }
+    });
+  }
+
+  for(auto& t : threads)
+    t.join();
+
+  auto const duration = max<uint64_t>(GetPerfTime() - uBegin, 1) / 1000.0;
+
+  int iTotalPictures = 0;
+  double fTotalRealTime = 0;
+  size_t zTotalBytes = 0;
+  bool bFailed = false;
+
+  Message(CC_DEFAULT, "\n%-3s %-32s %8s %9s %9s %10s %10s %10s  %s\n", "ch", "cfg input", "pictures", "fps", "realtime", "lat avg ms", "lat max ms", "dma MB", "status");
+
+  for(size_t i = 0; i < channels.size(); ++i)
+  {
+    auto& chan = *channels[i];
+    auto const& tRCParam = chan.cfg.Settings.tChParam[0].tRCParam;
+    auto const fTargetFps = tRCParam.uFrameRate * 1000.0 / tRCParam.uClkRatio;
+    auto const fFps = chan.enc->GetPictureCount() ? chan.enc->GetFrameRate() : 0.0;
+    auto const eErr = AL_Encoder_GetLastError(chan.enc->hEnc);
+
+    string sStatus = errors[i].empty() ? EncoderErrorToString(eErr) : errors[i];
+    string sInput = chan.cfg.tSynthetic.ePattern != SYNTHETIC_NONE ? "synthetic" : chan.cfg.YUVFileName;
+
+    if(sInput.size() > 32)
+      sInput = "..." + sInput.substr(sInput.size() - 29);
+
+    Message(errors[i].empty() ? CC_DEFAULT : CC_RED, "%-3d %-32s %8d %9.2f %8.2fx %10.2f %10.2f %10.1f  %s\n", (int)i, sInput.c_str(),
+            chan.enc->GetPictureCount(), fFps, fFps / fTargetFps,
+            chan.latency.GetAverageLatency(), chan.latency.GetMaxLatency(), channelBytes[i] / (1024.0 * 1024.0), sStatus.c_str());
+
+    iTotalPictures += chan.enc->GetPictureCount();
+    fTotalRealTime += fFps / fTargetFps;
+    zTotalBytes += channelBytes[i];
+    bFailed = bFailed || !errors[i].empty();
+  }
+
+  auto const total = GetAllocatorTrackerTotal(pAllocator);
+  Message(CC_DEFAULT, "\nAggregate: %d pictures in %.2f s, %.2f fps, %.2fx realtime in total\n", iTotalPictures, duration, iTotalPictures / duration, fTotalRealTime);
+  Message(CC_DEFAULT, "DMA memory: %.1f MB for the channels, %.1f MB peak\n", zTotalBytes / (1024.0 * 1024.0), total.peakBytes / (1024.0 * 1024.0));
+
+  if(bFailed)
+    throw runtime_error("Some channels failed");
+
+  if(auto err = GetEncoderLastError())
+    throw codec_error(EncoderErrorToString(err), err);
+}
+
+/*****************************************************************************/
+static shared_ptr<CIpDevice> CreateEncoderIpDevice(AL_TEncSettings& Settings, TCfgRunInfo& RunInfo)
+{
+  function<AL_TIpCtrl* (AL_TIpCtrl*)> wrapIpCtrl = GetIpCtrlWrapper(RunInfo);
+
+  auto pIpDevice = CreateIpDevice(!RunInfo.bUseBoard, RunInfo.iSchedulerType, Settings, wrapIpCtrl, RunInfo.trackDma, RunInfo.eVQDescr, RunInfo.iStatusWorkers);
+
+  if(!pIpDevice)
+    throw runtime_error("Can't create IpDevice");
+
+  if(!RunInfo.sDmaTimeline.empty())
+    StartAllocatorTrackerTimeline(pIpDevice->m_pAllocator.get(), RunInfo.sDmaTimeline);
+
+  return pIpDevice;
+}
+
+/*****************************************************************************/
+static AL_ECodec GetTranscodeCodec(ConfigFile const& cfg)
+{
+  if(cfg.eTranscodeCodec != AL_CODEC_INVALID)
+    return cfg.eTranscodeCodec;
+
+  auto const& sFile = cfg.TranscodeFileName;
+  auto const iDot = sFile.rfind('.');
+  string sExt = iDot == string::npos ? "" : sFile.substr(iDot + 1);
+  transform(sExt.begin(), sExt.end(), sExt.begin(), ::tolower);
+
+  if(sExt == "264" || sExt == "h264" || sExt == "avc")
+    return AL_CODEC_AVC;
+  return AL_CODEC_HEVC;
+}
+
+/* The decoder is created first: the encoder source description comes from the stream.
+ * It also outlives the encoder, which gives the frames back to the decoder when it is destroyed */
+static void RunTranscode(ConfigFile& cfg)
+{
+  auto& Settings = cfg.Settings;
+  auto& RunInfo = cfg.RunInfo;
+  auto& tChParam = Settings.tChParam[0];
+
+  auto pDecDevice = CreateDecIpDevice(RunInfo.iSchedulerType, RunInfo.trackDma, RunInfo.iStatusWorkers);
+
+  /* the encoder pipeline keeps as many frames as its own source pool would hold,
+   * plus the one waiting to be sent */
+  int iNumHeldFrames = 2 + tChParam.tGopParam.uNumB + 1;
+#if AL_ENABLE_TWOPASS
+
+  if(AL_TwoPassMngr_HasLookAhead(Settings))
+    iNumHeldFrames += Settings.LookAhead;
+#endif
+
+  if(RunInfo.bSceneChangeDetection)
+    iNumHeldFrames += RunInfo.iScnChgLookAhead;
+
+  /* the latency is measured from the decoder output. The frames are stamped from the
+   * first one, before the encoder channel exists: its latency sink takes them over */
+  auto stamps = make_shared<FrameStamps>();
+  DecoderSource source(cfg.TranscodeFileName, GetTranscodeCodec(cfg), AL_GetSrcStorageMode(tChParam.eSrcMode), pDecDevice->m_pDecChannel, pDecDevice->m_pAllocator.get(), iNumHeldFrames, [stamps](AL_TBuffer const* pFrame) {
+    stamps->Begin(pFrame);
+  }, [stamps](AL_TBuffer const* pFrame) {
+    stamps->Cancel(pFrame);
+  });
+
+  auto const tStream = source.WaitStreamSettings();
+  auto const tDim = source.GetDisplayDim();
+
+  cfg.FileInfo.PictWidth = tDim.iWidth;
+  cfg.FileInfo.PictHeight = tDim.iHeight;
+  AL_SET_CHROMA_MODE(tChParam.ePicFormat, tStream.eChroma);
+  SetSourceParams(cfg, -1);
+  /* the encoded bitdepth can still be changed with --ip-bitdepth or the cfg */
+  tChParam.uSrcBitDepth = tStream.iBitDepth;
+
+  PrepareConfig(cfg);
+
+  auto const tSrcPicFormat = AL_EncGetSrcPicFormat(AL_GET_CHROMA_MODE(tChParam.ePicFormat), tChParam.uSrcBitDepth, AL_GetSrcStorageMode(tChParam.eSrcMode), AL_IsSrcCompressed(tChParam.eSrcMode));
+
+  if(source.GetFourCC() != AL_GetFourCC(tSrcPicFormat))
+    throw runtime_error("The decoded frames can't be used as encoder sources, check the SrcFormat of the [SETTINGS] section");
+
+  auto pIpDevice = CreateEncoderIpDevice(Settings, RunInfo);
+  EncoderChannel channel(cfg, *pIpDevice, true);
+  channel.latency.stamps = stamps;
+
+  auto const uBegin = GetPerfTime();
+  source.Run(channel.firstSink, channel.cfg.RunInfo.iMaxPict, channel.cfg.FileInfo.FrameRate, tChParam.tRCParam.uFrameRate);
+  Rtos_WaitEvent(channel.hFinished.get(), AL_WAIT_FOREVER);
+  auto const duration = max<uint64_t>(GetPerfTime() - uBegin, 1) / 1000.0;
+
+  auto const iPictures = channel.enc->GetPictureCount();
+  Message(CC_DEFAULT, "\nTranscode: %d frames decoded at %.2f fps, %d pictures encoded at %.2f fps, %.2f fps end to end\n",
+          source.GetDecodedCount(), source.GetDecodingRate(), iPictures, iPictures ? channel.enc->GetFrameRate() : 0.0, iPictures / duration);
+  Message(CC_DEFAULT, "Latency from the decoder output: %.2f ms average, %.2f ms max\n", channel.latency.GetAverageLatency(), channel.latency.GetMaxLatency());
+  Message(CC_DEFAULT, "%d frames dropped, %d repeated, %d decoded frames waiting at most\n", source.bridge.GetDroppedCount(), source.bridge.GetRepeatedCount(), source.bridge.GetMaxQueued());
+
+  if(auto eErr = source.GetLastError())
+    throw codec_error("Transcode input decoding failed (error " + to_string(eErr) + ")", eErr);
+
+  if(auto err = GetEncoderLastError())
+    throw codec_error(EncoderErrorToString(err), err);
+}
+
+/*****************************************************************************/
+void SafeMain(int argc, char** argv)
+{
+  ConfigFile cfg;
+  SetDefaults(cfg);
+
+  auto& Settings = cfg.Settings;
+  auto& RunInfo = cfg.RunInfo;
+
+  vector<ConfigFile> channelCfgs;
+  ParseCommandLine(argc, argv, cfg, channelCfgs);
+
+  DisplayVersionInfo();
+
+  auto scopeMallocStats = scopeExit([]() {
+    PrintRtosMallocStats();
+  });
+
+  /* the source description is only known once the stream is decoded */
+  if(!cfg.TranscodeFileName.empty())
+  {
+    RunTranscode(cfg);
+    return;
+  }
+
+  if(channelCfgs.empty())
+    PrepareConfig(cfg);
+
+  for(auto& chanCfg : channelCfgs)
+    PrepareConfig(chanCfg);
+
+  auto pIpDevice = CreateEncoderIpDevice(Settings, RunInfo);
+
+  if(!channelCfgs.empty())
+  {
+    RunChannels(channelCfgs, *pIpDevice);
+    return;
+  }
+
+  // --------------------------------------------------------------------------------
+  // Create Encoder
+  EncoderChannel channel(cfg, *pIpDevice, true);
+
+  channel.Run();
+  channel.PrintInputStatistics();
 
   if(auto err = GetEncoderLastError())
     throw codec_error(EncoderErrorToString(err), err);
@@ -48,6 +48,7 @@
 
 #include "FileUtils.h"
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <fstream>
@@ -151,7 +152,8 @@ private:
 
 
 
-static AL_ERR g_EncoderLastError = AL_SUCCESS;
+/* shared by the channels of the process */
+static std::atomic<AL_ERR> g_EncoderLastError(AL_SUCCESS);
 
 AL_ERR GetEncoderLastError()
 {
@@ -241,24 +243,41 @@ struct EncoderSink : IFrameSink
 
   ~EncoderSink()
   {
-    Message(CC_DEFAULT, "\n\n%d pictures encoded. Average FrameRate = %.4f Fps\n",
-            m_picCount, (m_picCount * 1000.0) / (m_EndTime - m_StartTime));
+    if(bShowStatus)
+      Message(CC_DEFAULT, "\n\n%d pictures encoded. Average FrameRate = %.4f Fps\n",
+              m_picCount, GetFrameRate());
 
     AL_Encoder_Destroy(hEnc);
   }
 
+  int GetPictureCount() const
+  {
+    return m_picCount;
+  }
+
+  double GetFrameRate() const
+  {
+    return (m_picCount * 1000.0) / (m_EndTime - m_StartTime);
+  }
 
   std::function<void(void)> m_done;
+  /* called with the source of each stream buffer coming out of the encoder */
+  /* called for each stream buffer, with whether it ends the frame */
+  std::function<void(AL_TBuffer const*, bool)> m_frameEncoded;
+  bool bShowStatus = true;
 
   void ProcessFrame(AL_TBuffer* Src) override
   {
     if(m_picCount == 0)
       m_StartTime = GetPerfTime();
 
-    if(Src)
-      DisplayFrameStatus(m_picCount);
-    else
-      Message(CC_DEFAULT, "Flushing...");
+    if(bShowStatus)
+    {
+      if(Src)
+        DisplayFrameStatus(m_picCount);
+      else
+        Message(CC_DEFAULT, "Flushing...");
+    }
 
     AL_TBuffer* QpBuf = nullptr;
 
@@ -319,6 +338,19 @@ private:
     return !pStream && pSrc;
   }
 
+  static bool isEndOfFrame(AL_TBuffer const* pStream)
+  {
+    auto pStreamMeta = (AL_TStreamMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_STREAM);
+
+    for(int i = 0; pStreamMeta && i < pStreamMeta->uNumSection; ++i)
+    {
+      if(pStreamMeta->pSections[i].uFlags & SECTION_END_FRAME_FLAG)
+        return true;
+    }
+
+    return false;
+  }
+
   static void EndEncoding(void* userParam, AL_TBuffer* pStream, AL_TBuffer const* pSrc, int)
   {
     auto pThis = (EncoderSink*)userParam;
@@ -340,6 +372,9 @@ private:
     }
 #endif
 
+    if(pStream && pSrc && pThis->m_frameEncoded)
+      pThis->m_frameEncoded(pSrc, isEndOfFrame(pStream));
+
     pThis->processOutput(pStream);
   }
 
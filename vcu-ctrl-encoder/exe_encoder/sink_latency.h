@@ -0,0 +1,184 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/*
+** Times at which a source stamped its frames before they enter the pipeline,
+** e.g. when they are decoded. The source can stamp its first frames before the
+** LatencySink exists: the sink takes the stamps over when the frames reach it.
+*/
+struct FrameStamps
+{
+  void Begin(AL_TBuffer const* Src)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stamps[Src] = Now();
+  }
+
+  /* the frame stamped by Begin won't be encoded */
+  void Cancel(AL_TBuffer const* Src)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stamps.erase(Src);
+  }
+
+  /* false if the frame wasn't stamped. The stamp is only used once */
+  bool Take(AL_TBuffer const* Src, uint64_t& uStamp)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_stamps.find(Src);
+
+    if(it == m_stamps.end())
+      return false;
+
+    uStamp = it->second;
+    m_stamps.erase(it);
+    return true;
+  }
+
+  static uint64_t Now() // us
+  {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+  }
+
+private:
+  std::mutex m_mutex;
+  std::map<AL_TBuffer const*, uint64_t> m_stamps;
+};
+
+/*
+** Source pipeline stage measuring the end to end latency of the frames:
+** a frame is stamped when it enters the pipeline and the encoder calls
+** EndFrame for each stream buffer of the frame, the first one giving the
+** latency. The frames already stamped in stamps keep their earlier stamp.
+** The stamps are kept by frame index: a buffer sent again before its
+** previous frame is encoded (--prefetch) queues a new frame behind it.
+*/
+struct LatencySink : IFrameSink
+{
+  void ProcessFrame(AL_TBuffer* Src) override
+  {
+    if(Src)
+    {
+      uint64_t uStamp;
+
+      if(!stamps || !stamps->Take(Src, uStamp))
+        uStamp = FrameStamps::Now();
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stamps[m_frameIndex] = uStamp;
+      m_pending[Src].push_back(m_frameIndex);
+      ++m_frameIndex;
+    }
+
+    next->ProcessFrame(Src);
+  }
+
+  /* bEndOfFrame: the stream buffer holds the end of the frame encoded from
+  ** Src. A buffer encodes its frames in the order it was sent */
+  void EndFrame(AL_TBuffer const* Src, bool bEndOfFrame)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pending.find(Src);
+
+    if(it == m_pending.end())
+      return;
+
+    auto const iFrame = it->second.front();
+    auto stamp = m_stamps.find(iFrame);
+
+    /* the following slices of a frame aren't stamped anymore */
+    if(stamp != m_stamps.end())
+    {
+      auto const latency = FrameStamps::Now() - stamp->second;
+      m_stamps.erase(stamp);
+
+      m_frameCount++;
+      m_totalLatency += latency;
+      m_maxLatency = std::max(m_maxLatency, latency);
+    }
+
+    if(!bEndOfFrame)
+      return;
+
+    it->second.pop_front();
+
+    if(it->second.empty())
+      m_pending.erase(it);
+  }
+
+  uint64_t GetFrameCount()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frameCount;
+  }
+
+  double GetAverageLatency() // ms
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_frameCount ? m_totalLatency / 1000.0 / m_frameCount : 0.0;
+  }
+
+  double GetMaxLatency() // ms
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxLatency / 1000.0;
+  }
+
+  IFrameSink* next;
+  std::shared_ptr<FrameStamps> stamps;
+
+private:
+  std::mutex m_mutex;
+  std::map<uint64_t, uint64_t> m_stamps; /* by frame index */
+  std::map<AL_TBuffer const*, std::deque<uint64_t>> m_pending; /* frame indices sent with each buffer */
+  uint64_t m_frameIndex = 0;
+  uint64_t m_frameCount = 0;
+  uint64_t m_totalLatency = 0;
+  uint64_t m_maxLatency = 0;
+};
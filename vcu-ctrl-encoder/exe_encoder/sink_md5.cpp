@@ -35,59 +35,262 @@
 *
 ******************************************************************************/
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 #include "lib_app/utils.h"
 #include "sink_md5.h"
 #include "MD5.h"
+#include "Hash64.h"
 #include "CodecUtils.h"
 
 extern "C"
 {
 #include "lib_common/BufferSrcMeta.h"
+#include "lib_rtos/lib_rtos.h"
 }
 
 void RecToYuv(AL_TBuffer const* pRec, AL_TBuffer* pYuv, TFourCC tFourCC);
 
-class Md5Calculator : public IFrameSink
+static std::shared_ptr<AL_TBuffer> CreateBufferLike(AL_TBuffer const* pModel, std::vector<uint8_t>& data)
+{
+  data.resize(pModel->zSize);
+  AL_TBuffer* pBuf = AL_Buffer_WrapData(data.data(), data.size(), NULL);
+  auto pMeta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pModel, AL_META_TYPE_SOURCE);
+  AL_Buffer_AddMetaData(pBuf, (AL_TMetaData*)AL_SrcMetaData_Clone(pMeta));
+  return std::shared_ptr<AL_TBuffer>(pBuf, &AL_Buffer_Destroy);
+}
+
+static AL_TSrcMetaData* GetSrcMeta(AL_TBuffer const* pBuf)
+{
+  return (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
+}
+
+/* the resolution can change between two frames, the buffer size with it */
+static bool HasSameLayout(AL_TBuffer const* pBuf, AL_TBuffer const* pModel)
+{
+  auto pMeta = GetSrcMeta(pBuf);
+  auto pModelMeta = GetSrcMeta(pModel);
+  return pBuf->zSize == pModel->zSize
+         && pMeta->tFourCC == pModelMeta->tFourCC
+         && pMeta->tDim.iWidth == pModelMeta->tDim.iWidth
+         && pMeta->tDim.iHeight == pModelMeta->tDim.iHeight
+         && pMeta->tPitches.iLuma == pModelMeta->tPitches.iLuma
+         && pMeta->tPitches.iChroma == pModelMeta->tPitches.iChroma;
+}
+
+/*
+** Hashes the reconstructed frames on a worker thread: the encoder thread only
+** copies the frame in a free slot, the conversion to the output format and the
+** hash are done in the background, in the frames order.
+*/
+class RecHashCalculator : public IFrameSink
 {
 public:
-  Md5Calculator(std::string path, ConfigFile& cfg_, AL_TBuffer* Yuv_) :
-    Yuv(Yuv_),
-    fourcc(cfg_.RecFourCC)
+  RecHashCalculator(std::string path, ConfigFile& cfg_) :
+    fourcc(cfg_.RecFourCC),
+    eHash(cfg_.RunInfo.eRecHash),
+    m_Slots(NUM_SLOTS)
   {
     OpenOutput(m_Md5File, path);
+
+    for(int i = 0; i < NUM_SLOTS; ++i)
+      m_FreeSlots.push_back(i);
+
+    m_Worker = std::thread(&RecHashCalculator::Process, this);
+  }
+
+  ~RecHashCalculator()
+  {
+    if(m_Worker.joinable())
+    {
+      Push(EOS_SLOT);
+      m_Worker.join();
+    }
   }
 
   void ProcessFrame(AL_TBuffer* pBuf)
   {
     if(pBuf == EndOfStream)
     {
-      auto const sMD5 = m_MD5.GetMD5();
-      m_Md5File << sMD5;
+      /* the end of the stream may be signaled more than once */
+      if(!m_Worker.joinable())
+        return;
+
+      Push(EOS_SLOT);
+      m_Worker.join();
+
+      if(eHash == REC_HASH_MD5)
+        m_Md5File << m_MD5.GetMD5();
       return;
     }
 
+    int iSlot;
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_Cond.wait(lock, [&]() { return !m_FreeSlots.empty(); });
+      iSlot = m_FreeSlots.front();
+      m_FreeSlots.pop_front();
+    }
+
+    auto& slot = m_Slots[iSlot];
+
+    if(!slot.pRec || !HasSameLayout(pBuf, slot.pRec.get()))
+      slot.pRec = CreateBufferLike(pBuf, slot.RecData);
+
+    memcpy(AL_Buffer_GetData(slot.pRec.get()), AL_Buffer_GetData(pBuf), pBuf->zSize);
+
+    auto meta = GetSrcMeta(pBuf);
+
+    /* the conversion gives the frame its dimensions: they size the buffer */
+    if(meta->tFourCC != fourcc && (!slot.pYuv || slot.tYuvDim.iWidth != meta->tDim.iWidth || slot.tYuvDim.iHeight != meta->tDim.iHeight))
+    {
+      slot.pYuv = AllocateConversionBuffer(slot.YuvData, meta->tDim.iWidth, meta->tDim.iHeight, fourcc);
+      slot.tYuvDim = meta->tDim;
+    }
+
+    Push(iSlot);
+  }
+
+private:
+  static int const NUM_SLOTS = 3;
+  static int const EOS_SLOT = -1;
+
+  struct TSlot
+  {
+    std::vector<uint8_t> RecData;
+    std::shared_ptr<AL_TBuffer> pRec;
+    std::vector<uint8_t> YuvData;
+    std::shared_ptr<AL_TBuffer> pYuv;
+    AL_TDimension tYuvDim;
+  };
+
+  void Push(int iSlot)
+  {
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Pending.push_back(iSlot);
+    m_Cond.notify_all();
+  }
+
+  void Process()
+  {
+    Rtos_ApplyThreadConfig("app_rec_hash");
+
+    while(true)
+    {
+      int iSlot;
+      {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Cond.wait(lock, [&]() { return !m_Pending.empty(); });
+        iSlot = m_Pending.front();
+        m_Pending.pop_front();
+      }
+
+      if(iSlot == EOS_SLOT)
+        return;
+
+      Hash(m_Slots[iSlot]);
+
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_FreeSlots.push_back(iSlot);
+      m_Cond.notify_all();
+    }
+  }
+
+  void Hash(TSlot& slot)
+  {
+    AL_TBuffer* pBuf = slot.pRec.get();
     auto meta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
 
     if(meta->tFourCC != fourcc)
     {
-      RecToYuv(pBuf, Yuv, fourcc);
-      pBuf = Yuv;
+      RecToYuv(pBuf, slot.pYuv.get(), fourcc);
+      pBuf = slot.pYuv.get();
     }
 
-    m_MD5.Update(AL_Buffer_GetData(pBuf), pBuf->zSize);
+    if(eHash == REC_HASH_MD5)
+    {
+      m_MD5.Update(AL_Buffer_GetData(pBuf), pBuf->zSize);
+      return;
+    }
+
+    HashPlanes(pBuf);
   }
 
+  /* one line per frame: the hash of each plane, padding excluded */
+  void HashPlanes(AL_TBuffer* pBuf)
+  {
+    auto meta = (AL_TSrcMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_SOURCE);
+    uint8_t* pData = AL_Buffer_GetData(pBuf);
+    TFourCC const tFourCC = meta->tFourCC;
+
+    if(AL_IsTiled(tFourCC))
+    {
+      m_Md5File << HashRows(pData + meta->tOffsetYC.iLuma, meta->tPitches.iLuma, meta->tPitches.iLuma, (meta->tDim.iHeight + 3) / 4);
+
+      if(AL_GetChromaMode(tFourCC) != CHROMA_MONO)
+      {
+        int const iHeightC = (AL_GetChromaMode(tFourCC) == CHROMA_4_2_0) ? meta->tDim.iHeight / 2 : meta->tDim.iHeight;
+        m_Md5File << " " << HashRows(pData + meta->tOffsetYC.iChroma, meta->tPitches.iChroma, meta->tPitches.iChroma, (iHeightC + 3) / 4);
+      }
+      m_Md5File << std::endl;
+      return;
+    }
+
+    int const iRowSize = GetIOLumaRowSize(tFourCC, meta->tDim.iWidth);
+    m_Md5File << HashRows(pData + meta->tOffsetYC.iLuma, meta->tPitches.iLuma, iRowSize, meta->tDim.iHeight);
+
+    if(AL_GetChromaMode(tFourCC) != CHROMA_MONO)
+    {
+      int const iNumRowC = (AL_GetChromaMode(tFourCC) == CHROMA_4_2_0) ? meta->tDim.iHeight / 2 : meta->tDim.iHeight;
+      uint8_t* pChroma = pData + meta->tOffsetYC.iChroma;
+
+      if(AL_IsSemiPlanar(tFourCC))
+        m_Md5File << " " << HashRows(pChroma, meta->tPitches.iChroma, iRowSize, iNumRowC);
+      else
+      {
+        m_Md5File << " " << HashRows(pChroma, meta->tPitches.iChroma, iRowSize / 2, iNumRowC);
+        m_Md5File << " " << HashRows(pChroma + meta->tPitches.iChroma * iNumRowC, meta->tPitches.iChroma, iRowSize / 2, iNumRowC);
+      }
+    }
+
+    m_Md5File << std::endl;
+  }
+
+  static std::string HashRows(uint8_t const* pPlane, int iPitch, int iRowSize, int iNumRows)
+  {
+    CHash64 hash;
+
+    if(iPitch == iRowSize)
+      hash.Update(pPlane, (size_t)iRowSize * iNumRows);
+    else
+    {
+      for(int iRow = 0; iRow < iNumRows; ++iRow)
+        hash.Update(pPlane + (size_t)iRow * iPitch, iRowSize);
+    }
+
+    return hash.GetHashString();
+  }
 
-private:
   std::ofstream m_Md5File;
   CMD5 m_MD5;
-  AL_TBuffer* const Yuv;
   TFourCC const fourcc;
+  ERecHash const eHash;
+
+  std::vector<TSlot> m_Slots;
+  std::deque<int> m_FreeSlots;
+  std::deque<int> m_Pending;
+  std::mutex m_Mutex;
+  std::condition_variable m_Cond;
+  std::thread m_Worker;
 };
 
-std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_, AL_TBuffer* Yuv_)
+std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_)
 {
-  return std::unique_ptr<IFrameSink>(new Md5Calculator(path, cfg_, Yuv_));
+  return std::unique_ptr<IFrameSink>(new RecHashCalculator(path, cfg_));
 }
 
@@ -40,5 +40,5 @@
 #include "sink.h"
 #include "CfgParser.h"
 
-std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_, AL_TBuffer* Yuv_);
+std::unique_ptr<IFrameSink> createMd5Calculator(std::string path, ConfigFile& cfg_);
 
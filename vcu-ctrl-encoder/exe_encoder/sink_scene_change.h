@@ -0,0 +1,143 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "sink.h"
+#include "SceneChangeDetector.h"
+#include "lib_app/utils.h"
+
+#include <algorithm>
+#include <deque>
+
+extern "C"
+{
+#include "lib_encode/lib_encoder.h"
+}
+
+/*
+** Source pipeline stage running the host side scene change detector
+** Frames are delayed by iLookAhead pictures so the encoder can be notified
+** (AL_Encoder_NotifySceneChange) before the first picture of the new scene
+** is submitted, the same way scene changes from the command file are.
+*/
+struct SceneChangeSink : IFrameSink
+{
+  /* the encoder can't be notified of a scene change more than 31 pictures ahead */
+  static int const MAX_LOOKAHEAD = 31;
+
+  SceneChangeSink(TSceneChangeParam const& tParam, int iLookAhead) :
+    detector(tParam),
+    m_iLookAhead(std::max(iLookAhead, 0))
+  {
+  }
+
+  ~SceneChangeSink()
+  {
+    for(auto& frame : m_fifo)
+      AL_Buffer_Unref(frame.pSrc);
+
+    Message(CC_DEFAULT, "\nScene change detection: %d changes in %d frames, average cost = %.1f us/frame\n",
+            detector.GetSceneChangeCount(), detector.GetFrameCount(), detector.GetAverageCost());
+  }
+
+  void ProcessFrame(AL_TBuffer* Src) override
+  {
+    if(!Src)
+    {
+      while(!m_fifo.empty())
+        SendFront();
+
+      next->ProcessFrame(EndOfStream);
+      return;
+    }
+
+    AL_Buffer_Ref(Src);
+    m_fifo.push_back({ Src, m_iInCount, detector.Process(Src) });
+    ++m_iInCount;
+
+    if((int)m_fifo.size() > m_iLookAhead)
+      SendFront();
+  }
+
+  AL_HEncoder hEnc;
+  IFrameSink* next;
+  SceneChangeDetector detector;
+
+private:
+  struct TPendingFrame
+  {
+    AL_TBuffer* pSrc;
+    int iFrame;
+    bool bSceneChange;
+  };
+
+  void SendFront()
+  {
+    TPendingFrame front = m_fifo.front();
+    m_fifo.pop_front();
+
+    if(front.bSceneChange && front.iFrame > m_iLastNotified)
+      Notify(front.iFrame, 0);
+    else
+    {
+      for(auto& frame : m_fifo)
+      {
+        if(frame.bSceneChange && frame.iFrame > m_iLastNotified)
+        {
+          Notify(frame.iFrame, frame.iFrame - front.iFrame);
+          break;
+        }
+      }
+    }
+
+    next->ProcessFrame(front.pSrc);
+    AL_Buffer_Unref(front.pSrc);
+  }
+
+  void Notify(int iFrame, int iAhead)
+  {
+    AL_Encoder_NotifySceneChange(hEnc, iAhead);
+    m_iLastNotified = iFrame;
+  }
+
+  int const m_iLookAhead;
+  int m_iInCount = 0;
+  int m_iLastNotified = -1;
+  std::deque<TPendingFrame> m_fifo;
+};
+
@@ -35,56 +35,147 @@
 *
 ******************************************************************************/
 
-#include "lib_common/Allocator.h"
+#include "AllocatorTracker.h"
+#include "utils.h"
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <string>
 #include <map>
 #include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include <assert.h>
 
+extern "C"
+{
+#include "lib_fpga/DmaAllocLinux.h"
+}
+
 using namespace std;
 
 constexpr int summaryMode = 0;
 constexpr int detailedMode = 1;
 
+static const vector<string> categories =
+{
+  "frame", "mv", "stream", "circular", "ep", "work", "other"
+};
+
+/* buffer names given by the libraries and the applications */
+static string const& categoryOf(string const& name)
+{
+  static const map<string, string> nameToCategory =
+  {
+    { "src", "frame" }, { "yuv", "frame" }, { "rec", "frame" }, { "ref", "frame" },
+    { "mv", "mv" }, { "poc", "mv" },
+    { "stream", "stream" },
+    { "circular stream", "circular" },
+    { "ep1", "ep" }, { "ep2", "ep" }, { "ep3", "ep" }, { "qp-ext", "ep" },
+    { "wp", "work" }, { "sp", "work" }, { "comp data", "work" }, { "comp map", "work" },
+    { "scd", "work" }, { "sctable", "work" }, { "reflist", "work" }, { "scllst", "work" },
+  };
+
+  auto it = nameToCategory.find(name);
+
+  if(it == nameToCategory.end())
+    return categories.back();
+
+  return it->second;
+}
+
+struct Allocation
+{
+  size_t size;
+  AllocatorTrackerStats* byName;
+  AllocatorTrackerStats* byCategory;
+};
+
 struct AllocatorTracker
 {
   const AL_AllocatorVtable* vtable;
   AL_TAllocator* realAllocator;
-  map<string, vector<size_t>> allocs;
-  int size = 0;
+  bool linuxDma = false;
   int mode = summaryMode;
+
+  mutex lock;
+  AllocatorTrackerStats total;
+  map<string, AllocatorTrackerStats> byName;
+  map<string, AllocatorTrackerStats> byCategory;
+  unordered_map<AL_HANDLE, Allocation> live;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  thread timeline;
+  condition_variable timelineWakeUp;
+  bool stopTimeline = false;
 };
 
-static int bytes_to_megabytes(int bytes)
+static void onAlloc(AllocatorTrackerStats& stats, size_t size)
+{
+  stats.currentBytes += size;
+  stats.peakBytes = max(stats.peakBytes, stats.currentBytes);
+  ++stats.currentCount;
+  ++stats.allocCount;
+  stats.allocatedBytes += size;
+}
+
+static void onFree(AllocatorTrackerStats& stats, size_t size)
+{
+  assert(stats.currentBytes >= size);
+  stats.currentBytes -= size;
+  --stats.currentCount;
+  ++stats.freeCount;
+}
+
+static int bytes_to_megabytes(size_t bytes)
 {
   return bytes / (1024 * 1024);
 }
 
+static void printStats(string const& name, AllocatorTrackerStats const& stats)
+{
+  cout << setfill(' ') << setw(24) << left << name
+       << "peak: " << setw(5) << bytes_to_megabytes(stats.peakBytes) << "MB "
+       << "allocs: " << stats.allocCount << " (leaked: " << stats.currentCount << ")" << endl;
+}
+
 static bool destroy(AL_TAllocator* handle)
 {
   auto self = (AllocatorTracker*)handle;
-  bool success = AL_Allocator_Destroy(self->realAllocator);
-  cout << "total dma used : " << bytes_to_megabytes(self->size) << "MB" << endl;
 
-  if(self->mode == detailedMode)
+  if(self->timeline.joinable())
   {
-    for(auto& alloc : self->allocs)
     {
-      auto sizes = alloc.second;
-      auto firstSize = sizes.at(0);
-      auto totalSize = 0;
+      lock_guard<mutex> guard(self->lock);
+      self->stopTimeline = true;
+    }
+    self->timelineWakeUp.notify_one();
+    self->timeline.join();
+  }
 
-      /* buffer with the same name should have the same size */
-      for(auto& size : sizes)
-        assert(size == firstSize);
+  AL_TDmaImportStats importStats {};
+  bool hasImportStats = self->linuxDma && AL_LinuxDmaAllocator_GetImportStats((AL_TLinuxDmaAllocator*)self->realAllocator, &importStats);
 
-      totalSize = firstSize * sizes.size();
+  bool success = AL_Allocator_Destroy(self->realAllocator);
+  cout << "total dma used : " << bytes_to_megabytes(self->total.allocatedBytes) << "MB (peak: " << bytes_to_megabytes(self->total.peakBytes) << "MB)" << endl;
 
-      cout << setfill(' ') << setw(24) << left << alloc.first << sizes.size() << " * " << firstSize << " (total: ~" << bytes_to_megabytes(totalSize) << "MB" << ")" << endl;
+  if(hasImportStats)
+    cout << "dma imports : " << importStats.uHits + importStats.uMisses << " (found in the cache: " << importStats.uHits << ", evicted: " << importStats.uEvictions << ")" << endl;
+
+  if(self->mode == detailedMode)
+  {
+    for(auto& category : self->byCategory)
+    {
+      if(category.second.allocCount)
+        printStats("[" + category.first + "]", category.second);
     }
+
+    for(auto& name : self->byName)
+      printStats(name.first, name.second);
   }
 
   delete self;
@@ -94,9 +185,20 @@ static bool destroy(AL_TAllocator* handle)
 static AL_HANDLE allocNamed(AL_TAllocator* handle, size_t size, char const* name)
 {
   auto self = (AllocatorTracker*)handle;
-  self->size += size;
-  self->allocs[string(name)].push_back(size);
-  return AL_Allocator_Alloc(self->realAllocator, size);
+  AL_HANDLE hBuf = AL_Allocator_Alloc(self->realAllocator, size);
+
+  if(!hBuf)
+    return hBuf;
+
+  string sName(name);
+  lock_guard<mutex> guard(self->lock);
+  auto& byName = self->byName[sName];
+  auto& byCategory = self->byCategory[categoryOf(sName)];
+  onAlloc(byName, size);
+  onAlloc(byCategory, size);
+  onAlloc(self->total, size);
+  self->live[hBuf] = Allocation { size, &byName, &byCategory };
+  return hBuf;
 }
 
 static AL_HANDLE alloc(AL_TAllocator* handle, size_t size)
@@ -107,6 +209,20 @@ static AL_HANDLE alloc(AL_TAllocator* handle, size_t size)
 static bool free(AL_TAllocator* handle, AL_HANDLE buf)
 {
   auto self = (AllocatorTracker*)handle;
+  {
+    lock_guard<mutex> guard(self->lock);
+    auto it = self->live.find(buf);
+
+    /* imported buffers weren't allocated by us */
+    if(it != self->live.end())
+    {
+      auto& allocation = it->second;
+      onFree(*allocation.byName, allocation.size);
+      onFree(*allocation.byCategory, allocation.size);
+      onFree(self->total, allocation.size);
+      self->live.erase(it);
+    }
+  }
   return AL_Allocator_Free(self->realAllocator, buf);
 }
 
@@ -122,6 +238,32 @@ static AL_PADDR getPhysicalAddr(AL_TAllocator* handle, AL_HANDLE buf)
   return AL_Allocator_GetPhysicalAddr(self->realAllocator, buf);
 }
 
+static int getFd(AL_TLinuxDmaAllocator* handle, AL_HANDLE buf)
+{
+  auto self = (AllocatorTracker*)handle;
+  return AL_LinuxDmaAllocator_GetFd((AL_TLinuxDmaAllocator*)self->realAllocator, buf);
+}
+
+static AL_HANDLE importFromFd(AL_TLinuxDmaAllocator* handle, int fd)
+{
+  auto self = (AllocatorTracker*)handle;
+  return AL_LinuxDmaAllocator_ImportFromFd((AL_TLinuxDmaAllocator*)self->realAllocator, fd);
+}
+
+static void getImportStats(AL_TLinuxDmaAllocator* handle, AL_TDmaImportStats* pStats)
+{
+  auto self = (AllocatorTracker*)handle;
+
+  if(!AL_LinuxDmaAllocator_GetImportStats((AL_TLinuxDmaAllocator*)self->realAllocator, pStats))
+    *pStats = AL_TDmaImportStats {};
+}
+
+static void forgetFd(AL_TLinuxDmaAllocator* handle, int fd)
+{
+  auto self = (AllocatorTracker*)handle;
+  AL_LinuxDmaAllocator_ForgetFd((AL_TLinuxDmaAllocator*)self->realAllocator, fd);
+}
+
 const AL_AllocatorVtable trackerVtable =
 {
   destroy,
@@ -132,12 +274,115 @@ const AL_AllocatorVtable trackerVtable =
   allocNamed,
 };
 
-AL_TAllocator* createAllocatorTracker(AL_TAllocator* pAllocator)
+const AL_DmaAllocLinuxVtable trackerLinuxDmaVtable =
+{
+  trackerVtable,
+  getFd,
+  importFromFd,
+  getImportStats,
+  forgetFd,
+};
+
+AL_TAllocator* createAllocatorTracker(AL_TAllocator* pAllocator, bool bLinuxDma)
 {
   auto tracker = new AllocatorTracker;
-  tracker->vtable = &trackerVtable;
+  tracker->vtable = bLinuxDma ? &trackerLinuxDmaVtable.base : &trackerVtable;
   tracker->realAllocator = pAllocator;
+  tracker->linuxDma = bLinuxDma;
   tracker->mode = detailedMode;
+
+  for(auto& category : categories)
+    tracker->byCategory[category] = AllocatorTrackerStats {};
+
   return (AL_TAllocator*)tracker;
 }
 
+AllocatorTrackerStats GetAllocatorTrackerTotal(AL_TAllocator* pTracker)
+{
+  auto self = (AllocatorTracker*)pTracker;
+  lock_guard<mutex> guard(self->lock);
+  return self->total;
+}
+
+map<string, AllocatorTrackerStats> GetAllocatorTrackerStatsByName(AL_TAllocator* pTracker)
+{
+  auto self = (AllocatorTracker*)pTracker;
+  lock_guard<mutex> guard(self->lock);
+  return self->byName;
+}
+
+map<string, AllocatorTrackerStats> GetAllocatorTrackerStatsByCategory(AL_TAllocator* pTracker)
+{
+  auto self = (AllocatorTracker*)pTracker;
+  lock_guard<mutex> guard(self->lock);
+  return self->byCategory;
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+double GetAllocatorTrackerAllocRate(AL_TAllocator* pTracker)
+{
+  auto self = (AllocatorTracker*)pTracker;
+  lock_guard<mutex> guard(self->lock);
+  double seconds = secondsSince(self->start);
+  return seconds > 0 ? self->total.allocCount / seconds : 0;
+}
+
+static void writeTimeline(AllocatorTracker* self, ofstream csv, int iPeriodMs)
+{
+  csv << "time_ms,total_bytes";
+
+  for(auto& category : categories)
+    csv << "," << category << "_bytes";
+
+  csv << ",allocs_per_s,frees_per_s\n";
+
+  vector<size_t> categoryBytes(categories.size());
+  unique_lock<mutex> guard(self->lock);
+  auto prev = self->total;
+  auto prevTime = chrono::steady_clock::now();
+
+  while(!self->stopTimeline)
+  {
+    self->timelineWakeUp.wait_for(guard, chrono::milliseconds(iPeriodMs));
+
+    /* snapshot under the lock, the allocations don't wait for the file */
+    auto total = self->total;
+    auto now = chrono::steady_clock::now();
+
+    for(size_t i = 0; i < categories.size(); ++i)
+      categoryBytes[i] = self->byCategory[categories[i]].currentBytes;
+
+    guard.unlock();
+
+    /* the wait can return early (stop) or late (scheduling) */
+    double interval = chrono::duration<double>(now - prevTime).count();
+    csv << (uint64_t)(secondsSince(self->start) * 1000) << "," << total.currentBytes;
+
+    for(auto bytes : categoryBytes)
+      csv << "," << bytes;
+
+    if(interval > 0)
+      csv << "," << (total.allocCount - prev.allocCount) / interval << "," << (total.freeCount - prev.freeCount) / interval << "\n";
+    else
+      csv << ",0,0\n";
+
+    prev = total;
+    prevTime = now;
+    guard.lock();
+  }
+}
+
+void StartAllocatorTrackerTimeline(AL_TAllocator* pTracker, string const& sCsvFile, int iPeriodMs)
+{
+  auto self = (AllocatorTracker*)pTracker;
+  assert(!self->timeline.joinable());
+  assert(iPeriodMs > 0);
+
+  ofstream csv;
+  OpenOutput(csv, sCsvFile, false);
+  self->timeline = thread(&writeTimeline, self, move(csv), iPeriodMs);
+}
@@ -0,0 +1,75 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+extern "C"
+{
+#include "lib_common/Allocator.h"
+}
+
+struct AllocatorTrackerStats
+{
+  size_t currentBytes = 0;
+  size_t peakBytes = 0;
+  int currentCount = 0;
+  uint64_t allocCount = 0; /* since the tracker creation */
+  uint64_t freeCount = 0;
+  uint64_t allocatedBytes = 0; /* cumulated size of all the allocations */
+};
+
+/* Wraps pAllocator and accounts its allocations by buffer name and by
+ * category (frame, mv, stream, circular, ep, work, other).
+ * bLinuxDma: pAllocator is a linux dma allocator, the tracker then forwards
+ * the AL_TLinuxDmaAllocator interface too. */
+AL_TAllocator* createAllocatorTracker(AL_TAllocator* pAllocator, bool bLinuxDma = false);
+
+/* Query API. pTracker must have been created by createAllocatorTracker */
+AllocatorTrackerStats GetAllocatorTrackerTotal(AL_TAllocator* pTracker);
+std::map<std::string, AllocatorTrackerStats> GetAllocatorTrackerStatsByName(AL_TAllocator* pTracker);
+std::map<std::string, AllocatorTrackerStats> GetAllocatorTrackerStatsByCategory(AL_TAllocator* pTracker);
+/* allocations per second since the tracker creation */
+double GetAllocatorTrackerAllocRate(AL_TAllocator* pTracker);
+
+/* Appends a csv line with the current usage of each category every
+ * iPeriodMs, until the tracker is destroyed */
+void StartAllocatorTrackerTimeline(AL_TAllocator* pTracker, std::string const& sCsvFile, int iPeriodMs = 100);
+
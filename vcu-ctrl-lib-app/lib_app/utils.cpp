@@ -39,8 +39,15 @@
 #include <stdexcept>
 #include <cstdlib>
 #include <cstdarg>
+#include <sstream>
+#include <vector>
 #include "utils.h"
 
+extern "C"
+{
+#include "lib_rtos/lib_rtos.h"
+}
+
 using namespace std;
 
 int g_Verbosity = 10;
@@ -92,3 +99,103 @@ void OpenOutput(std::ofstream& fp, std::string filename, bool binary)
     throw std::runtime_error("Can't open file for writing: '" + filename + "'");
 }
 
+static std::vector<std::string> Split(std::string const& sIn, char cSep)
+{
+  std::vector<std::string> tokens;
+  std::istringstream ss(sIn);
+  std::string sToken;
+
+  while(std::getline(ss, sToken, cSep))
+    tokens.push_back(sToken);
+
+  return tokens;
+}
+
+static AL_64U ParseCpus(std::string const& sCpus)
+{
+  if(sCpus == "all")
+    return 0;
+
+  AL_64U uMask = 0;
+
+  for(auto& sRange : Split(sCpus, ','))
+  {
+    auto bounds = Split(sRange, '-');
+
+    if(bounds.empty() || bounds.size() > 2)
+      throw std::runtime_error("Invalid cpu list: '" + sCpus + "'");
+
+    int iFirst = std::stoi(bounds[0]);
+    int iLast = bounds.size() == 2 ? std::stoi(bounds[1]) : iFirst;
+
+    if(iFirst < 0 || iLast < iFirst || iLast >= 64)
+      throw std::runtime_error("Invalid cpu list: '" + sCpus + "'");
+
+    for(int iCpu = iFirst; iCpu <= iLast; ++iCpu)
+      uMask |= 1ULL << iCpu;
+  }
+
+  return uMask;
+}
+
+static AL_ESchedPolicy ParsePolicy(std::string const& sPolicy)
+{
+  if(sPolicy == "default")
+    return AL_SCHED_DEFAULT;
+
+  if(sPolicy == "other")
+    return AL_SCHED_OTHER;
+
+  if(sPolicy == "fifo")
+    return AL_SCHED_FIFO;
+
+  if(sPolicy == "rr")
+    return AL_SCHED_RR;
+
+  throw std::runtime_error("Invalid scheduling policy: '" + sPolicy + "'");
+}
+
+void SetThreadConfig(std::string const& sCfg)
+{
+  auto fields = Split(sCfg, ':');
+
+  if(fields.size() < 2 || fields.size() > 5 || fields[0].empty())
+    throw std::runtime_error("Invalid thread configuration: '" + sCfg + "'");
+
+  AL_TThreadAttr tAttr;
+  Rtos_InitThreadAttr(&tAttr);
+  tAttr.uAffinityMask = ParseCpus(fields[1]);
+
+  if(fields.size() > 2)
+    tAttr.ePolicy = ParsePolicy(fields[2]);
+
+  if(fields.size() > 3)
+    tAttr.iPriority = std::stoi(fields[3]);
+
+  if(fields.size() > 4)
+    tAttr.zStackSize = std::stoul(fields[4]);
+
+  if(!Rtos_SetThreadConfig(fields[0].c_str(), &tAttr))
+    throw std::runtime_error("Too many thread configurations");
+}
+
+void EnableRtosMallocPool()
+{
+  if(!Rtos_EnableMallocPool(true))
+    throw std::runtime_error("The rtos malloc pool isn't available in this build");
+}
+
+void PrintRtosMallocStats()
+{
+  AL_TRtosMallocStats tStats;
+
+  if(!Rtos_GetMallocStats(&tStats) || !tStats.uAllocs)
+    return;
+
+  Message("rtos malloc: %llu allocs, %llu frees, %llu%% from the thread caches, %llu large\n",
+          (unsigned long long)tStats.uAllocs, (unsigned long long)tStats.uFrees,
+          (unsigned long long)(tStats.uCacheHits * 100 / tStats.uAllocs), (unsigned long long)tStats.uLargeAllocs);
+  Message("rtos malloc: %llu batch fetches, %llu batch returns, %llu KB reserved\n",
+          (unsigned long long)tStats.uDepotFetches, (unsigned long long)tStats.uDepotReturns,
+          (unsigned long long)(tStats.zChunkBytes / 1024));
+}
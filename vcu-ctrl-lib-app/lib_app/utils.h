@@ -48,6 +48,16 @@ void Message(EConColor Color, const char* sMsg, ...);
 void OpenInput(std::ifstream& fp, std::string filename, bool binary = true);
 void OpenOutput(std::ofstream& fp, std::string filename, bool binary = true);
 
+/* Registers the attributes of the threads named sName (see Rtos_SetThreadConfig).
+ * sCfg: "name:cpus[:policy[:priority[:stacksize]]]", e.g. "al_dec_feeder:2,3:fifo:50"
+ * cpus: comma-separated cpus or ranges ("0,2-3"), "all" keeps the default affinity
+ * policy: default, other, fifo or rr */
+void SetThreadConfig(std::string const& sCfg);
+
+/* Serves the small Rtos_Malloc allocations from the lib_rtos pool (see Rtos_EnableMallocPool) */
+void EnableRtosMallocPool();
+void PrintRtosMallocStats();
+
 /*****************************************************************************/
 
 template<typename Lambda>
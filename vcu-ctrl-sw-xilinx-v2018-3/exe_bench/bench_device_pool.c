@@ -0,0 +1,289 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* Threads open and close a set of files through the device pool, with
+ * several references on the same file at once. Each open must return a
+ * descriptor of the requested file and every file must be closed once all
+ * its references are released. Then the cost of an open and close pair of an
+ * already opened device is measured, which takes no lock. */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#if __linux__
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "lib_fpga/DevicePool.h"
+
+/* more than the initial tables of the pool, so that they grow under use */
+#define NUM_FILES 48
+#define MAX_THREADS 8
+
+typedef struct
+{
+  char sNames[NUM_FILES][32];
+  ino_t pInodes[NUM_FILES];
+  int iIterations;
+  int32_t iFailures;
+}TPoolBench;
+
+typedef struct
+{
+  TPoolBench* pBench;
+  unsigned int uSeed;
+  int iIterations;
+}TPoolWorker;
+
+/****************************************************************************/
+static int CountOpenFds(void)
+{
+  DIR* pDir = opendir("/proc/self/fd");
+  int iCount = 0;
+
+  if(!pDir)
+    return -1;
+
+  while(readdir(pDir))
+    ++iCount;
+
+  closedir(pDir);
+  return iCount;
+}
+
+/****************************************************************************/
+static bool OpenChecked(TPoolBench* pBench, int iFile, int* pFd)
+{
+  *pFd = AL_DevicePool_Open(pBench->sNames[iFile]);
+  struct stat st;
+
+  if(*pFd >= 0 && fstat(*pFd, &st) == 0 && st.st_ino == pBench->pInodes[iFile])
+    return true;
+
+  Rtos_AtomicIncrement(&pBench->iFailures);
+  return false;
+}
+
+/****************************************************************************/
+static void CloseChecked(TPoolBench* pBench, int fd)
+{
+  if(AL_DevicePool_Close(fd) != 0)
+    Rtos_AtomicIncrement(&pBench->iFailures);
+}
+
+/* takes one or two references on random files and releases them */
+/****************************************************************************/
+static void* StressThread(void* pParam)
+{
+  TPoolWorker* pWorker = (TPoolWorker*)pParam;
+  TPoolBench* pBench = pWorker->pBench;
+
+  for(int i = 0; i < pWorker->iIterations; ++i)
+  {
+    int const iFile = rand_r(&pWorker->uSeed) % NUM_FILES;
+    int fd, fd2;
+
+    if(!OpenChecked(pBench, iFile, &fd))
+      continue;
+
+    if(i % 2 && OpenChecked(pBench, iFile, &fd2))
+    {
+      if(fd2 != fd)
+        Rtos_AtomicIncrement(&pBench->iFailures);
+      CloseChecked(pBench, fd2);
+    }
+
+    CloseChecked(pBench, fd);
+  }
+
+  return NULL;
+}
+
+/* the file stays opened by the main thread: only the fast paths run */
+/****************************************************************************/
+static void* FastPathThread(void* pParam)
+{
+  TPoolWorker* pWorker = (TPoolWorker*)pParam;
+  TPoolBench* pBench = pWorker->pBench;
+
+  for(int i = 0; i < pWorker->iIterations; ++i)
+  {
+    int const fd = AL_DevicePool_Open(pBench->sNames[0]);
+
+    if(fd < 0 || AL_DevicePool_Close(fd) != 0)
+      Rtos_AtomicIncrement(&pBench->iFailures);
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+static bool RunThreads(TPoolBench* pBench, void* (*pFunc)(void*), TPoolWorker* pWorkers, int iNumThreads, int iIterations)
+{
+  AL_THREAD pThreads[MAX_THREADS];
+  bool bCreated = true;
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    pWorkers[i].pBench = pBench;
+    pWorkers[i].uSeed = i + 1;
+    pWorkers[i].iIterations = iIterations;
+    pThreads[i] = Rtos_CreateThread(pFunc, &pWorkers[i]);
+    bCreated = bCreated && pThreads[i];
+  }
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    if(!pThreads[i])
+      continue;
+    Rtos_JoinThread(pThreads[i]);
+    Rtos_DeleteThread(pThreads[i]);
+  }
+
+  return bCreated;
+}
+
+/****************************************************************************/
+static bool CreateFiles(TPoolBench* pBench)
+{
+  for(int i = 0; i < NUM_FILES; ++i)
+  {
+    snprintf(pBench->sNames[i], sizeof(pBench->sNames[i]), "/tmp/al_pool_XXXXXX");
+    int fd = mkstemp(pBench->sNames[i]);
+    struct stat st;
+
+    if(fd < 0)
+      return false;
+
+    bool bStat = fstat(fd, &st) == 0;
+    close(fd);
+
+    if(!bStat)
+      return false;
+
+    pBench->pInodes[i] = st.st_ino;
+  }
+
+  return true;
+}
+
+/****************************************************************************/
+int Bench_DevicePool(int iIterations)
+{
+  static TPoolBench bench;
+  TPoolWorker workers[MAX_THREADS];
+  int iFailures = 0;
+
+  Rtos_Memset(&bench, 0, sizeof(bench));
+
+  if(!CreateFiles(&bench))
+  {
+    printf("FAILED: can't create the files of the device pool benchmark\n");
+    return 1;
+  }
+
+  int const iOpenedBefore = CountOpenFds();
+
+  if(!RunThreads(&bench, &StressThread, workers, MAX_THREADS, iIterations * 100))
+  {
+    printf("FAILED stress: can't create the threads\n");
+    ++iFailures;
+  }
+
+  if(bench.iFailures)
+  {
+    printf("FAILED stress: %d opens or closes failed or returned another file\n", bench.iFailures);
+    ++iFailures;
+  }
+
+  if(CountOpenFds() != iOpenedBefore)
+  {
+    printf("FAILED stress: the files weren't all closed after their last reference\n");
+    ++iFailures;
+  }
+
+  int fd = AL_DevicePool_Open(bench.sNames[0]);
+
+  printf("open and close of an opened device:\n");
+
+  for(int iNumThreads = 1; fd >= 0 && iNumThreads <= MAX_THREADS; iNumThreads *= 2)
+  {
+    int const iPairs = iNumThreads * iIterations * 1000;
+    bench.iFailures = 0;
+
+    AL_64U const uStart = Rtos_GetTimeNs();
+    RunThreads(&bench, &FastPathThread, workers, iNumThreads, iIterations * 1000);
+    AL_64U const uElapsed = Rtos_GetTimeNs() - uStart;
+
+    printf("%d threads %8.2f M pairs/s\n", iNumThreads, iPairs * 1000.0 / uElapsed);
+
+    if(bench.iFailures)
+    {
+      printf("FAILED fast path: %d opens or closes failed\n", bench.iFailures);
+      ++iFailures;
+    }
+  }
+
+  if(fd < 0 || AL_DevicePool_Close(fd) != 0)
+  {
+    printf("FAILED fast path: can't open the device\n");
+    ++iFailures;
+  }
+
+  for(int i = 0; i < NUM_FILES; ++i)
+    unlink(bench.sNames[i]);
+
+  printf("%s\n", iFailures ? "device pool checks FAILED" : "device pool checks passed");
+  return iFailures ? 1 : 0;
+}
+
+#else
+
+/****************************************************************************/
+int Bench_DevicePool(int iIterations)
+{
+  (void)iIterations;
+  printf("FAILED: the device pool is only available on linux\n");
+  return 1;
+}
+
+#endif
@@ -0,0 +1,363 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* The statuses of the mcu channels are collected either by one thread per
+ * channel or by the workers of a status dispatcher. The real mcu scheduler runs
+ * on a fake driver: each channel is a pipe, and a fake mcu thread writes in
+ * every pipe the time at which a status is posted. The latency is measured from
+ * that time to the end encoding callback. */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#if __linux__
+
+#include <unistd.h>
+
+#include "lib_common/IDriver.h"
+#include "lib_common/StatusDispatcher.h"
+#include "lib_encode/IScheduler.h"
+#include "lib_encode/SchedulerMcu.h"
+#include "allegro_ioctl_mcu_enc.h"
+
+#define MAX_CHANNELS 32
+#define MAX_FDS 1024
+#define NUM_WORKERS 2
+/* every FAILURE_PERIOD fetch fails without consuming the status, as an
+ * interrupted ioctl would: the status has to be fetched again */
+#define FAILURE_PERIOD 7
+/* posted by the channel destruction, the fetch fails as on a closed channel */
+#define END_OF_CHANNEL 0xFFFFFFFFFFFFFFFFULL
+
+typedef struct
+{
+  AL_TDriver base;
+  /* write end of the pipe, indexed by the read end */
+  int pWriteFds[MAX_FDS];
+  int iLastOpened;
+  int32_t iFetches;
+}TFakeDriver;
+
+typedef struct
+{
+  AL_HANDLE hChannel;
+  int fd;
+  AL_64S* pLatency;
+  int iIterations;
+  int32_t iReceived;
+}TBenchChannel;
+
+/****************************************************************************/
+static int FakeOpen(AL_TDriver* pDriver, const char* pDevice)
+{
+  (void)pDevice;
+  TFakeDriver* pFake = (TFakeDriver*)pDriver;
+  int fds[2];
+
+  if(pipe(fds) < 0)
+    return -1;
+
+  if(fds[0] >= MAX_FDS || fds[1] >= MAX_FDS)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+
+  pFake->pWriteFds[fds[0]] = fds[1];
+  pFake->iLastOpened = fds[0];
+  return fds[0];
+}
+
+/****************************************************************************/
+static void FakeClose(AL_TDriver* pDriver, int fd)
+{
+  TFakeDriver* pFake = (TFakeDriver*)pDriver;
+  close(pFake->pWriteFds[fd]);
+  close(fd);
+}
+
+/****************************************************************************/
+static bool PostTime(TFakeDriver* pFake, int fd, AL_64U uTime)
+{
+  return write(pFake->pWriteFds[fd], &uTime, sizeof(uTime)) == sizeof(uTime);
+}
+
+/****************************************************************************/
+static AL_EDriverError FetchStatus(TFakeDriver* pFake, int fd, struct al5_params* pMsg)
+{
+  if(Rtos_AtomicIncrement(&pFake->iFetches) % FAILURE_PERIOD == 0)
+    return DRIVER_ERROR_UNKNOWN;
+
+  AL_64U uTime;
+
+  if(read(fd, &uTime, sizeof(uTime)) != sizeof(uTime) || uTime == END_OF_CHANNEL)
+    return DRIVER_ERROR_CHANNEL;
+
+  pMsg->size = sizeof(AL_PTR64);
+  Rtos_Memcpy(pMsg->opaque_params, &uTime, sizeof(uTime));
+  return DRIVER_SUCCESS;
+}
+
+/****************************************************************************/
+static AL_EDriverError FakePostMessage(AL_TDriver* pDriver, int fd, long unsigned int messageId, void* pData)
+{
+  TFakeDriver* pFake = (TFakeDriver*)pDriver;
+
+  switch(messageId)
+  {
+  case AL_MCU_CONFIG_CHANNEL:
+    return DRIVER_SUCCESS;
+  case AL_MCU_WAIT_FOR_STATUS:
+    return FetchStatus(pFake, fd, (struct al5_params*)pData);
+  case AL_MCU_DESTROY_CHANNEL:
+    return PostTime(pFake, fd, END_OF_CHANNEL) ? DRIVER_SUCCESS : DRIVER_ERROR_CHANNEL;
+  default:
+    return DRIVER_ERROR_UNKNOWN;
+  }
+}
+
+static const AL_DriverVtable FakeDriverVtable =
+{
+  &FakeOpen,
+  &FakeClose,
+  &FakePostMessage,
+};
+
+/****************************************************************************/
+static void EndEncoding(void* pUserParam, AL_TEncPicStatus* pPicStatus, AL_64U streamUserPtr)
+{
+  (void)pPicStatus;
+  AL_64S const iLatency = (AL_64S)(Rtos_GetTimeNs() - streamUserPtr);
+  TBenchChannel* pChan = (TBenchChannel*)pUserParam;
+  int const iIdx = Rtos_AtomicIncrement(&pChan->iReceived) - 1;
+
+  if(iIdx < pChan->iIterations)
+    pChan->pLatency[iIdx] = iLatency;
+}
+
+typedef struct
+{
+  TFakeDriver* pFake;
+  TBenchChannel* pChannels;
+  int iNumChannels;
+  int iIterations;
+  bool bFailed;
+}TFakeMcu;
+
+/* posts a status on every channel each millisecond */
+/****************************************************************************/
+static void* FakeMcuThread(void* pParam)
+{
+  TFakeMcu* pMcu = (TFakeMcu*)pParam;
+
+  for(int i = 0; i < pMcu->iIterations; ++i)
+  {
+    Rtos_SleepUs(1000);
+
+    for(int iChan = 0; iChan < pMcu->iNumChannels; ++iChan)
+    {
+      if(!PostTime(pMcu->pFake, pMcu->pChannels[iChan].fd, Rtos_GetTimeNs()))
+        pMcu->bFailed = true;
+    }
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+static bool WaitAllReceived(TBenchChannel* pChannels, int iNumChannels, int iIterations)
+{
+  AL_64U const uDeadline = Rtos_GetTime() + 2000;
+
+  for(int iChan = 0; iChan < iNumChannels; ++iChan)
+  {
+    while(__atomic_load_n(&pChannels[iChan].iReceived, __ATOMIC_ACQUIRE) < iIterations)
+    {
+      if(Rtos_GetTime() > uDeadline)
+        return false;
+      Rtos_Sleep(1);
+    }
+  }
+
+  return true;
+}
+
+/* returns 1 when statuses were lost or duplicated */
+/****************************************************************************/
+static int RunCase(int iNumChannels, int iNumWorkers, AL_64S* pSamples, int iIterations)
+{
+  char name[64];
+
+  if(iNumWorkers)
+    snprintf(name, sizeof(name), "%2d channels, %d workers", iNumChannels, iNumWorkers);
+  else
+    snprintf(name, sizeof(name), "%2d channels, threads", iNumChannels);
+
+  static TFakeDriver fake;
+  Rtos_Memset(&fake, 0, sizeof(fake));
+  fake.base.vtable = &FakeDriverVtable;
+
+  AL_TStatusDispatcher* pDispatcher = NULL;
+
+  if(iNumWorkers)
+  {
+    pDispatcher = AL_StatusDispatcher_Create(iNumWorkers);
+
+    if(!pDispatcher)
+    {
+      printf("FAILED %s: can't create the dispatcher\n", name);
+      return 1;
+    }
+  }
+
+  TScheduler* pScheduler = AL_SchedulerMcu_CreateWithDispatcher(&fake.base, NULL, pDispatcher);
+  TBenchChannel channels[MAX_CHANNELS];
+  int iCreated = 0;
+  int iFailures = 0;
+
+  for(; pScheduler && iCreated < iNumChannels; ++iCreated)
+  {
+    TBenchChannel* pChan = &channels[iCreated];
+    pChan->pLatency = &pSamples[iCreated * iIterations];
+    pChan->iIterations = iIterations;
+    pChan->iReceived = 0;
+
+    AL_TEncChanParam chParam;
+    Rtos_Memset(&chParam, 0, sizeof(chParam));
+    chParam.uWidth = 1920;
+    chParam.uHeight = 1080;
+    chParam.ePicFormat = AL_420_8BITS;
+
+    AL_TISchedulerCallBacks CBs;
+    CBs.pfnEndEncodingCallBack = &EndEncoding;
+    CBs.pEndEncodingCBParam = pChan;
+
+    if(AL_ISchedulerEnc_CreateChannel(&pChan->hChannel, pScheduler, &chParam, NULL, &CBs) != AL_SUCCESS)
+      break;
+    pChan->fd = fake.iLastOpened;
+  }
+
+  if(iCreated < iNumChannels)
+  {
+    printf("FAILED %s: can't create the channels\n", name);
+    ++iFailures;
+  }
+  else
+  {
+    TFakeMcu mcu = { &fake, channels, iNumChannels, iIterations, false };
+    AL_THREAD hMcu = Rtos_CreateThread(&FakeMcuThread, &mcu);
+
+    if(hMcu)
+    {
+      Rtos_JoinThread(hMcu);
+      Rtos_DeleteThread(hMcu);
+    }
+
+    if(!hMcu || mcu.bFailed)
+    {
+      printf("FAILED %s: the fake mcu couldn't post the statuses\n", name);
+      ++iFailures;
+    }
+    else if(!WaitAllReceived(channels, iNumChannels, iIterations))
+    {
+      printf("FAILED %s: statuses were lost\n", name);
+      ++iFailures;
+    }
+  }
+
+  for(int i = 0; i < iCreated; ++i)
+  {
+    AL_ISchedulerEnc_DestroyChannel(pScheduler, channels[i].hChannel);
+
+    if(channels[i].iReceived != iIterations)
+    {
+      printf("FAILED %s: channel %d got %d statuses instead of %d\n", name, i, channels[i].iReceived, iIterations);
+      ++iFailures;
+    }
+  }
+
+  if(pScheduler)
+    AL_ISchedulerEnc_Destroy(pScheduler);
+  AL_StatusDispatcher_Destroy(pDispatcher);
+
+  if(!iFailures)
+    Bench_PrintDistribution(name, pSamples, iNumChannels * iIterations);
+
+  return iFailures ? 1 : 0;
+}
+
+/****************************************************************************/
+int Bench_Dispatcher(int iIterations)
+{
+  AL_64S* pSamples = (AL_64S*)Rtos_Malloc(MAX_CHANNELS * iIterations * sizeof(AL_64S));
+
+  if(!pSamples)
+  {
+    printf("FAILED: can't allocate the dispatcher benchmark\n");
+    return 1;
+  }
+
+  int iFailures = 0;
+
+  printf("latency from the posted status to the end encoding callback:\n");
+
+  for(int iNumChannels = 1; iNumChannels <= MAX_CHANNELS; iNumChannels *= 2)
+  {
+    iFailures += RunCase(iNumChannels, 0, pSamples, iIterations);
+    iFailures += RunCase(iNumChannels, NUM_WORKERS, pSamples, iIterations);
+  }
+
+  Rtos_Free(pSamples);
+
+  printf("%s\n", iFailures ? "dispatcher checks FAILED" : "dispatcher checks passed");
+  return iFailures ? 1 : 0;
+}
+
+#else
+
+/****************************************************************************/
+int Bench_Dispatcher(int iIterations)
+{
+  (void)iIterations;
+  printf("FAILED: the mcu scheduler is only available on linux\n");
+  return 1;
+}
+
+#endif
@@ -0,0 +1,437 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* The dmabufs a client hands to the OMX components are imported for each
+ * frame and freed once the frame is done (DecModule::CreateInputBuffer,
+ * CreateOutputBuffer and EncModule::UseDMA). The same sequence runs here on
+ * the import cache of the linux dma allocator, with memfds standing for the
+ * dmabufs of the client since the driver isn't needed to identify them: each
+ * frame imports the descriptor of the next buffer of the pool, maps it,
+ * touches each page of it and frees it. The hit rate of the cache is checked
+ * for pools smaller than the idle bound, and the cost of a frame is compared
+ * with an import that queries the size and maps the buffer every time.
+ * The descriptors that identify the same buffer, the forget of the owner and
+ * the idle bound are checked against the descriptors left open. */
+
+#if defined __linux__ && !defined _GNU_SOURCE
+#define _GNU_SOURCE // memfd_create
+#endif
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#if __linux__
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+#include "lib_fpga/DmaImportCache.h"
+
+/* a nv12 1080p frame, page aligned as the imports are */
+#define FRAME_SIZE (1920 * 1088 * 3 / 2)
+#define PAGE_SIZE 4096
+#define MAX_POOL 40
+
+typedef struct
+{
+  int pFds[MAX_POOL];
+  int iNumBuffers;
+  int iFailures;
+}TImportBench;
+
+/****************************************************************************/
+static int CountOpenFds(void)
+{
+  DIR* pDir = opendir("/proc/self/fd");
+  int iCount = 0;
+
+  if(!pDir)
+    return -1;
+
+  while(readdir(pDir))
+    ++iCount;
+
+  closedir(pDir);
+  return iCount;
+}
+
+/****************************************************************************/
+static bool CreatePool(TImportBench* pBench, int iNumBuffers)
+{
+  pBench->iNumBuffers = 0;
+
+  for(int i = 0; i < iNumBuffers; ++i)
+  {
+    int fd = memfd_create("al_dmabuf", MFD_CLOEXEC);
+
+    if(fd < 0)
+      return false;
+
+    pBench->pFds[pBench->iNumBuffers++] = fd;
+
+    if(ftruncate(fd, FRAME_SIZE) != 0)
+      return false;
+  }
+
+  return true;
+}
+
+/****************************************************************************/
+static void DestroyPool(TImportBench* pBench)
+{
+  for(int i = 0; i < pBench->iNumBuffers; ++i)
+    close(pBench->pFds[i]);
+
+  pBench->iNumBuffers = 0;
+}
+
+/****************************************************************************/
+static void TouchFrame(AL_VADDR pFrame, int iFrame)
+{
+  for(int i = 0; i < FRAME_SIZE; i += PAGE_SIZE)
+    pFrame[i] = (uint8_t)iFrame;
+}
+
+/* what LinuxDma_ImportFromFd, GetVirtualAddr and Free do for a frame, but
+ * the query of the bus address */
+/****************************************************************************/
+static struct DmaImport* ImportCached(struct DmaImportCache* pCache, int fd)
+{
+  struct stat st;
+
+  if(!DmaImportCache_GetIdentity(pCache, fd, &st))
+    return NULL;
+
+  struct DmaImport* pImport = DmaImportCache_Acquire(pCache, &st);
+
+  if(pImport)
+    return pImport;
+
+  off_t zSize = lseek(fd, 0, SEEK_END);
+  lseek(fd, 0, SEEK_SET);
+
+  return DmaImportCache_Add(pCache, &st, fd, 0, (uint32_t)zSize);
+}
+
+/****************************************************************************/
+static bool RunCachedFrame(TImportBench* pBench, struct DmaImportCache* pCache, int iFrame)
+{
+  struct DmaImport* pImport = ImportCached(pCache, pBench->pFds[iFrame % pBench->iNumBuffers]);
+
+  if(!pImport)
+    return false;
+
+  AL_VADDR pFrame = DmaImportCache_Map(pCache, pImport);
+
+  if(pFrame)
+    TouchFrame(pFrame, iFrame);
+
+  DmaImportCache_Release(pCache, pImport);
+  return pFrame != NULL;
+}
+
+/* the import without the cache: the size is queried and the buffer is mapped
+ * for each frame */
+/****************************************************************************/
+static bool RunUncachedFrame(TImportBench* pBench, int iFrame)
+{
+  int fd = pBench->pFds[iFrame % pBench->iNumBuffers];
+  off_t zSize = lseek(fd, 0, SEEK_END);
+  lseek(fd, 0, SEEK_SET);
+
+  AL_VADDR pFrame = (AL_VADDR)mmap(0, zSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if(pFrame == MAP_FAILED)
+    return false;
+
+  TouchFrame(pFrame, iFrame);
+  munmap(pFrame, zSize);
+  return true;
+}
+
+/****************************************************************************/
+static void Fail(TImportBench* pBench, char const* pCase, char const* pWhat)
+{
+  printf("FAILED %s: %s\n", pCase, pWhat);
+  ++pBench->iFailures;
+}
+
+/****************************************************************************/
+static void BenchPool(TImportBench* pBench, int iNumBuffers, int iFrames)
+{
+  char sCase[32];
+  snprintf(sCase, sizeof(sCase), "pool of %d", iNumBuffers);
+
+  if(!CreatePool(pBench, iNumBuffers))
+  {
+    Fail(pBench, sCase, "can't create the buffers");
+    DestroyPool(pBench);
+    return;
+  }
+
+  struct DmaImportCache cache;
+  DmaImportCache_Init(&cache);
+
+  if(!cache.bEnabled)
+    Fail(pBench, sCase, "the cache is disabled");
+
+  AL_64U uStart = Rtos_GetTimeNs();
+
+  for(int i = 0; i < iFrames; ++i)
+  {
+    if(!RunCachedFrame(pBench, &cache, i))
+    {
+      Fail(pBench, sCase, "a cached import failed");
+      break;
+    }
+  }
+
+  AL_64U const uCached = Rtos_GetTimeNs() - uStart;
+  uStart = Rtos_GetTimeNs();
+
+  for(int i = 0; i < iFrames; ++i)
+  {
+    if(!RunUncachedFrame(pBench, i))
+    {
+      Fail(pBench, sCase, "an uncached import failed");
+      break;
+    }
+  }
+
+  AL_64U const uUncached = Rtos_GetTimeNs() - uStart;
+  AL_TDmaImportStats tStats = cache.tStats;
+  AL_64U const uImports = tStats.uHits + tStats.uMisses;
+
+  printf("%-12s hits %6.2f%% (%llu/%llu) evictions %4llu   cached %7.1f us/frame   uncached %7.1f us/frame\n",
+         sCase, uImports ? 100.0 * tStats.uHits / uImports : 0.0,
+         (unsigned long long)tStats.uHits, (unsigned long long)uImports,
+         (unsigned long long)tStats.uEvictions,
+         uCached / 1000.0 / iFrames, uUncached / 1000.0 / iFrames);
+
+  /* a pool within the idle bound is only imported once */
+  if(iNumBuffers <= MAX_IDLE_IMPORTS && tStats.uMisses != (AL_64U)iNumBuffers)
+    Fail(pBench, sCase, "the buffers were imported more than once");
+
+  DmaImportCache_Deinit(&cache);
+  DestroyPool(pBench);
+}
+
+/****************************************************************************/
+static void CheckIdentity(TImportBench* pBench)
+{
+  char const* pCase = "identity";
+  int const iOpenedBefore = CountOpenFds();
+
+  if(!CreatePool(pBench, 2))
+  {
+    Fail(pBench, pCase, "can't create the buffers");
+    DestroyPool(pBench);
+    return;
+  }
+
+  struct DmaImportCache cache;
+  DmaImportCache_Init(&cache);
+
+  /* another descriptor of the same buffer shares its entry */
+  int fdDup = dup(pBench->pFds[0]);
+  struct DmaImport* pFirst = ImportCached(&cache, pBench->pFds[0]);
+  struct DmaImport* pDup = ImportCached(&cache, fdDup);
+  struct DmaImport* pOther = ImportCached(&cache, pBench->pFds[1]);
+
+  if(!pFirst || pFirst != pDup || cache.tStats.uHits != 1)
+    Fail(pBench, pCase, "a duplicated descriptor wasn't found in the cache");
+
+  if(pOther == pFirst)
+    Fail(pBench, pCase, "two buffers share an entry");
+
+  /* the dmabufs of old kernels live on the anonymous inode, as eventfds do */
+  struct DmaImportCache uncachable;
+  DmaImportCache_Init(&uncachable);
+  int fdEvent = eventfd(0, EFD_CLOEXEC);
+  struct stat st;
+
+  if(fdEvent >= 0 && DmaImportCache_GetIdentity(&uncachable, fdEvent, &st))
+    Fail(pBench, pCase, "the anonymous inode was taken as an identity");
+
+  if(fdEvent >= 0)
+    close(fdEvent);
+  DmaImportCache_Deinit(&uncachable);
+
+  if(pFirst)
+    DmaImportCache_Release(&cache, pFirst);
+
+  if(pDup)
+    DmaImportCache_Release(&cache, pDup);
+
+  if(pOther)
+    DmaImportCache_Release(&cache, pOther);
+
+  close(fdDup);
+  DmaImportCache_Deinit(&cache);
+  DestroyPool(pBench);
+
+  if(CountOpenFds() != iOpenedBefore)
+    Fail(pBench, pCase, "the cache leaked descriptors");
+}
+
+/* the cache holds a descriptor per entry: the number of descriptors left open
+ * tells which entries are alive */
+/****************************************************************************/
+static void CheckForget(TImportBench* pBench)
+{
+  char const* pCase = "forget";
+
+  if(!CreatePool(pBench, 2))
+  {
+    Fail(pBench, pCase, "can't create the buffers");
+    DestroyPool(pBench);
+    return;
+  }
+
+  struct DmaImportCache cache;
+  DmaImportCache_Init(&cache);
+  int const iOpenedBefore = CountOpenFds();
+
+  /* an idle entry goes with the forget */
+  struct DmaImport* pImport = ImportCached(&cache, pBench->pFds[0]);
+
+  if(pImport)
+    DmaImportCache_Release(&cache, pImport);
+
+  if(CountOpenFds() != iOpenedBefore + 1)
+    Fail(pBench, pCase, "a freed import wasn't kept idle");
+
+  DmaImportCache_Forget(&cache, pBench->pFds[0]);
+
+  if(CountOpenFds() != iOpenedBefore)
+    Fail(pBench, pCase, "an idle entry outlived the forget");
+
+  /* an entry in use goes with its last user */
+  pImport = ImportCached(&cache, pBench->pFds[1]);
+  DmaImportCache_Forget(&cache, pBench->pFds[1]);
+
+  if(CountOpenFds() != iOpenedBefore + 1)
+    Fail(pBench, pCase, "an entry was deleted while in use");
+
+  if(pImport)
+    DmaImportCache_Release(&cache, pImport);
+
+  if(CountOpenFds() != iOpenedBefore)
+    Fail(pBench, pCase, "a forgotten entry outlived its last user");
+
+  if(cache.tStats.uHits != 0 || cache.tStats.uMisses != 2)
+    Fail(pBench, pCase, "a forgotten entry was found in the cache");
+
+  DmaImportCache_Deinit(&cache);
+  DestroyPool(pBench);
+}
+
+/****************************************************************************/
+static void CheckIdleBound(TImportBench* pBench)
+{
+  char const* pCase = "idle bound";
+
+  if(!CreatePool(pBench, MAX_POOL))
+  {
+    Fail(pBench, pCase, "can't create the buffers");
+    DestroyPool(pBench);
+    return;
+  }
+
+  struct DmaImportCache cache;
+  DmaImportCache_Init(&cache);
+  int const iOpenedBefore = CountOpenFds();
+
+  for(int i = 0; i < MAX_POOL; ++i)
+    RunCachedFrame(pBench, &cache, i);
+
+  if(CountOpenFds() != iOpenedBefore + MAX_IDLE_IMPORTS || cache.tStats.uEvictions != MAX_POOL - MAX_IDLE_IMPORTS)
+    Fail(pBench, pCase, "the idle entries aren't bounded");
+
+  /* the most recently used entries are kept */
+  RunCachedFrame(pBench, &cache, MAX_POOL - 1);
+  RunCachedFrame(pBench, &cache, 0);
+
+  if(cache.tStats.uHits != 1)
+    Fail(pBench, pCase, "the least recently used entries weren't the evicted ones");
+
+  DmaImportCache_Deinit(&cache);
+
+  if(CountOpenFds() != iOpenedBefore)
+    Fail(pBench, pCase, "the entries outlived the cache");
+
+  DestroyPool(pBench);
+}
+
+/****************************************************************************/
+int Bench_DmaImport(int iIterations)
+{
+  static TImportBench bench;
+  int const iFrames = iIterations * 10;
+  int const pPools[] = { 8, 16, MAX_POOL };
+
+  Rtos_Memset(&bench, 0, sizeof(bench));
+
+  CheckIdentity(&bench);
+  CheckForget(&bench);
+  CheckIdleBound(&bench);
+
+  printf("import, map, touch and free of %d frames of %d bytes:\n", iFrames, FRAME_SIZE);
+
+  for(size_t i = 0; i < sizeof(pPools) / sizeof(pPools[0]); ++i)
+    BenchPool(&bench, pPools[i], iFrames);
+
+  printf("%s\n", bench.iFailures ? "dma import checks FAILED" : "dma import checks passed");
+  return bench.iFailures ? 1 : 0;
+}
+
+#else
+
+/****************************************************************************/
+int Bench_DmaImport(int iIterations)
+{
+  (void)iIterations;
+  printf("FAILED: the dmabuf imports are only available on linux\n");
+  return 1;
+}
+
+#endif
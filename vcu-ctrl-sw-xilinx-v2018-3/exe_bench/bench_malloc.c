@@ -0,0 +1,221 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* Threads replace the blocks of their working set with new blocks of random
+ * sizes, and swap some of them with the other threads, so that blocks are
+ * also freed by another thread than the one that allocated them. The same
+ * load runs on the system allocator and on the Rtos_Malloc pool, when the
+ * library is built with it. Every block is filled and checked before it is
+ * freed. */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#define MAX_THREADS 8
+#define WORKING_SET 64
+#define SHARED_SLOTS 256
+#define LARGE_SIZE 4096
+
+typedef struct
+{
+  void* pShared[SHARED_SLOTS];
+  int32_t iCorruptions;
+}TMallocBench;
+
+typedef struct
+{
+  TMallocBench* pBench;
+  AL_64U uSeed;
+  int iIterations;
+}TMallocWorker;
+
+/****************************************************************************/
+static AL_64U NextRandom(AL_64U* pSeed)
+{
+  /* xorshift64 */
+  *pSeed ^= *pSeed << 13;
+  *pSeed ^= *pSeed >> 7;
+  *pSeed ^= *pSeed << 17;
+  return *pSeed;
+}
+
+/* the first bytes hold the size and a pattern derived from it */
+/****************************************************************************/
+static void* AllocFilled(AL_64U* pSeed)
+{
+  AL_64U const uRand = NextRandom(pSeed);
+  /* mostly small control structures, some too large for the pool */
+  size_t zSize = (uRand % 16 == 0) ? LARGE_SIZE : 16 + (uRand >> 8) % 497;
+  uint32_t* pBlock = (uint32_t*)Rtos_Malloc(zSize);
+
+  if(!pBlock)
+    return NULL;
+
+  pBlock[0] = (uint32_t)zSize;
+  pBlock[1] = (uint32_t)zSize * 2654435761U;
+  ((uint8_t*)pBlock)[zSize - 1] = (uint8_t)zSize;
+  return pBlock;
+}
+
+/****************************************************************************/
+static void FreeChecked(TMallocBench* pBench, void* pMem)
+{
+  uint32_t* pBlock = (uint32_t*)pMem;
+
+  if(!pBlock)
+    return;
+
+  size_t const zSize = pBlock[0];
+
+  if(zSize < 16 || zSize > LARGE_SIZE || pBlock[1] != (uint32_t)zSize * 2654435761U || ((uint8_t*)pBlock)[zSize - 1] != (uint8_t)zSize)
+    Rtos_AtomicIncrement(&pBench->iCorruptions);
+
+  Rtos_Free(pBlock);
+}
+
+/****************************************************************************/
+static void* MallocThread(void* pParam)
+{
+  TMallocWorker* pWorker = (TMallocWorker*)pParam;
+  TMallocBench* pBench = pWorker->pBench;
+  void* pSet[WORKING_SET] = { NULL };
+
+  for(int i = 0; i < pWorker->iIterations; ++i)
+  {
+    AL_64U const uRand = NextRandom(&pWorker->uSeed);
+    void** ppSlot = &pSet[uRand % WORKING_SET];
+
+    FreeChecked(pBench, *ppSlot);
+    *ppSlot = AllocFilled(&pWorker->uSeed);
+
+    /* one block out of 8 goes to the other threads */
+    if((uRand >> 16) % 8 == 0)
+      *ppSlot = __atomic_exchange_n(&pBench->pShared[(uRand >> 24) % SHARED_SLOTS], *ppSlot, __ATOMIC_ACQ_REL);
+  }
+
+  for(int i = 0; i < WORKING_SET; ++i)
+    FreeChecked(pBench, pSet[i]);
+
+  return NULL;
+}
+
+/* returns the number of operations per second */
+/****************************************************************************/
+static double RunThreads(TMallocBench* pBench, int iNumThreads, int iIterations)
+{
+  TMallocWorker workers[MAX_THREADS];
+  AL_THREAD pThreads[MAX_THREADS];
+  AL_64U const uStart = Rtos_GetTimeNs();
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    workers[i].pBench = pBench;
+    workers[i].uSeed = 0x9E3779B97F4A7C15ULL * (i + 1);
+    workers[i].iIterations = iIterations;
+    pThreads[i] = Rtos_CreateThread(&MallocThread, &workers[i]);
+
+    if(!pThreads[i])
+      MallocThread(&workers[i]);
+  }
+
+  for(int i = 0; i < iNumThreads; ++i)
+  {
+    if(!pThreads[i])
+      continue;
+    Rtos_JoinThread(pThreads[i]);
+    Rtos_DeleteThread(pThreads[i]);
+  }
+
+  AL_64U const uElapsed = Rtos_GetTimeNs() - uStart;
+
+  for(int i = 0; i < SHARED_SLOTS; ++i)
+  {
+    FreeChecked(pBench, pBench->pShared[i]);
+    pBench->pShared[i] = NULL;
+  }
+
+  return iNumThreads * (double)iIterations * 1e9 / uElapsed;
+}
+
+/****************************************************************************/
+int Bench_Malloc(int iIterations)
+{
+  static TMallocBench bench;
+  int const iOps = iIterations * 1000;
+  int iFailures = 0;
+
+  Rtos_Memset(&bench, 0, sizeof(bench));
+
+  printf("free and malloc pairs per second, blocks swapped between threads:\n");
+
+  for(int iNumThreads = 1; iNumThreads <= MAX_THREADS; iNumThreads *= 2)
+  {
+    double const fMalloc = RunThreads(&bench, iNumThreads, iOps);
+
+    if(!Rtos_EnableMallocPool(true))
+    {
+      printf("%d threads malloc %8.2f M/s, pool not built (ENABLE_RTOS_POOL)\n", iNumThreads, fMalloc / 1e6);
+      continue;
+    }
+
+    AL_TRtosMallocStats tBefore, tAfter;
+    Rtos_GetMallocStats(&tBefore);
+    double const fPool = RunThreads(&bench, iNumThreads, iOps);
+    Rtos_GetMallocStats(&tAfter);
+    Rtos_EnableMallocPool(false);
+
+    printf("%d threads malloc %8.2f M/s, pool %8.2f M/s\n", iNumThreads, fMalloc / 1e6, fPool / 1e6);
+
+    if(tAfter.uAllocs - tBefore.uAllocs != tAfter.uFrees - tBefore.uFrees)
+    {
+      printf("FAILED %d threads: %llu allocations for %llu frees in the pool\n", iNumThreads,
+             (unsigned long long)(tAfter.uAllocs - tBefore.uAllocs), (unsigned long long)(tAfter.uFrees - tBefore.uFrees));
+      ++iFailures;
+    }
+  }
+
+  if(bench.iCorruptions)
+  {
+    printf("FAILED: %d blocks were corrupted\n", bench.iCorruptions);
+    ++iFailures;
+  }
+
+  printf("%s\n", iFailures ? "malloc checks FAILED" : "malloc checks passed");
+  return iFailures ? 1 : 0;
+}
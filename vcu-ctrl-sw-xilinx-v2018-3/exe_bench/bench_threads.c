@@ -0,0 +1,204 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* A periodic thread wakes up on absolute 1 ms deadlines while every cpu is
+ * kept busy by spinning threads. Its lateness is measured with the default
+ * scheduling and with a real-time policy, which is what the thread
+ * configuration of the apps (--thread-cfg) gives to the latency-critical
+ * threads. */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#if __linux__
+#include <unistd.h>
+#endif
+
+#define NS_PER_MS 1000000LL
+#define RT_PRIORITY 50
+
+typedef struct
+{
+  AL_64S* pLateness;
+  int iIterations;
+  AL_ESchedPolicy ePolicy;
+  bool bPolicyRefused;
+}TPeriodic;
+
+/****************************************************************************/
+static int GetNumCpus(void)
+{
+#if __linux__
+  long iNumCpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if(iNumCpus > 0)
+    return (int)iNumCpus;
+#endif
+  return 4;
+}
+
+/****************************************************************************/
+static void* LoadThread(void* pParam)
+{
+  int32_t* pStop = (int32_t*)pParam;
+  volatile AL_64U uSink = 0;
+
+  while(!__atomic_load_n(pStop, __ATOMIC_RELAXED))
+  {
+    for(int i = 0; i < 1000; ++i)
+      uSink = uSink * 6364136223846793005ULL + 1442695040888963407ULL;
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+static void* PeriodicThread(void* pParam)
+{
+  TPeriodic* pPeriodic = (TPeriodic*)pParam;
+
+  if(pPeriodic->ePolicy != AL_SCHED_DEFAULT)
+  {
+    AL_TThreadAttr attr;
+    Rtos_InitThreadAttr(&attr);
+    attr.ePolicy = pPeriodic->ePolicy;
+    attr.iPriority = RT_PRIORITY;
+
+    if(!Rtos_SetCurrentThreadAttr(&attr))
+    {
+      pPeriodic->bPolicyRefused = true;
+      return NULL;
+    }
+  }
+
+  AL_EVENT hNeverSet = Rtos_CreateEvent(false);
+  AL_64U const uStart = Rtos_GetTimeNs();
+
+  for(int i = 0; i < pPeriodic->iIterations; ++i)
+  {
+    AL_64U const uDeadline = uStart + (i + 1) * NS_PER_MS;
+    Rtos_WaitEventUntil(hNeverSet, uDeadline);
+    pPeriodic->pLateness[i] = (AL_64S)(Rtos_GetTimeNs() - uDeadline);
+  }
+
+  Rtos_DeleteEvent(hNeverSet);
+  return NULL;
+}
+
+/* returns 1 when the periodic thread woke up before a deadline */
+/****************************************************************************/
+static int MeasureUnderLoad(char const* pName, int iNumLoads, AL_ESchedPolicy ePolicy, AL_64S* pLateness, int iIterations)
+{
+  int32_t iStop = 0;
+  AL_THREAD* pLoads = (AL_THREAD*)Rtos_Malloc((iNumLoads + 1) * sizeof(AL_THREAD));
+  int iStarted = 0;
+
+  for(; pLoads && iStarted < iNumLoads; ++iStarted)
+  {
+    pLoads[iStarted] = Rtos_CreateThread(&LoadThread, &iStop);
+
+    if(!pLoads[iStarted])
+      break;
+  }
+
+  TPeriodic periodic = { pLateness, iIterations, ePolicy, false };
+  AL_THREAD hPeriodic = Rtos_CreateThread(&PeriodicThread, &periodic);
+
+  if(hPeriodic)
+  {
+    Rtos_JoinThread(hPeriodic);
+    Rtos_DeleteThread(hPeriodic);
+  }
+
+  __atomic_store_n(&iStop, 1, __ATOMIC_RELAXED);
+
+  for(int i = 0; i < iStarted; ++i)
+  {
+    Rtos_JoinThread(pLoads[i]);
+    Rtos_DeleteThread(pLoads[i]);
+  }
+
+  Rtos_Free(pLoads);
+
+  if(!hPeriodic || iStarted < iNumLoads)
+  {
+    printf("FAILED %s: can't create the threads\n", pName);
+    return 1;
+  }
+
+  if(periodic.bPolicyRefused)
+  {
+    printf("%-28s skipped: the real-time policy needs CAP_SYS_NICE\n", pName);
+    return 0;
+  }
+
+  if(Bench_PrintDistribution(pName, pLateness, iIterations))
+  {
+    printf("FAILED %s: woke up before the deadline\n", pName);
+    return 1;
+  }
+
+  return 0;
+}
+
+/****************************************************************************/
+int Bench_Threads(int iIterations)
+{
+  AL_64S* pSamples = (AL_64S*)Rtos_Malloc(iIterations * sizeof(AL_64S));
+
+  if(!pSamples)
+  {
+    printf("FAILED: can't allocate the threads benchmark\n");
+    return 1;
+  }
+
+  int const iNumLoads = GetNumCpus();
+  int iFailures = 0;
+
+  printf("lateness of a 1 ms periodic thread, loaded with one spinning thread per cpu (%d):\n", iNumLoads);
+  iFailures += MeasureUnderLoad("idle, default policy", 0, AL_SCHED_DEFAULT, pSamples, iIterations);
+  iFailures += MeasureUnderLoad("loaded, default policy", iNumLoads, AL_SCHED_DEFAULT, pSamples, iIterations);
+  iFailures += MeasureUnderLoad("loaded, fifo", iNumLoads, AL_SCHED_FIFO, pSamples, iIterations);
+  iFailures += MeasureUnderLoad("loaded, round-robin", iNumLoads, AL_SCHED_RR, pSamples, iIterations);
+
+  Rtos_Free(pSamples);
+
+  printf("%s\n", iFailures ? "threads checks FAILED" : "threads checks passed");
+  return iFailures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* The timed waits are checked against the monotonic clock they are built on:
+ * a wait returning before its deadline is an error, how late it returns is
+ * what is measured. */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "lib_rtos/lib_rtos.h"
+
+#define NS_PER_US 1000LL
+#define NS_PER_MS 1000000LL
+
+typedef enum
+{
+  WAIT_SLEEP_US,
+  WAIT_SLEEP_MS,
+  WAIT_SEMAPHORE,
+  WAIT_SEMAPHORE_UNTIL,
+  WAIT_EVENT,
+  WAIT_EVENT_UNTIL,
+}EWait;
+
+typedef struct
+{
+  AL_SEMAPHORE hSem;
+  AL_EVENT hEvt;
+  int iFailures;
+}TTimerBench;
+
+/****************************************************************************/
+static bool Wait(TTimerBench* pBench, EWait eWait, AL_64U uDeadline, AL_64S iDuration)
+{
+  switch(eWait)
+  {
+  case WAIT_SLEEP_US:
+    Rtos_SleepUs(iDuration / NS_PER_US);
+    return false;
+  case WAIT_SLEEP_MS:
+    Rtos_Sleep(iDuration / NS_PER_MS);
+    return false;
+  case WAIT_SEMAPHORE:
+    return Rtos_GetSemaphore(pBench->hSem, iDuration / NS_PER_MS);
+  case WAIT_SEMAPHORE_UNTIL:
+    return Rtos_GetSemaphoreUntil(pBench->hSem, uDeadline);
+  case WAIT_EVENT:
+    return Rtos_WaitEvent(pBench->hEvt, iDuration / NS_PER_MS);
+  case WAIT_EVENT_UNTIL:
+    return Rtos_WaitEventUntil(pBench->hEvt, uDeadline);
+  }
+
+  return false;
+}
+
+/****************************************************************************/
+static void Fail(TTimerBench* pBench, char const* pName, char const* pWhat)
+{
+  printf("FAILED %s: %s\n", pName, pWhat);
+  ++pBench->iFailures;
+}
+
+/****************************************************************************/
+static void MeasureWait(TTimerBench* pBench, char const* pName, EWait eWait, AL_64S iDuration, AL_64S* pLateness, int iIterations)
+{
+  for(int i = 0; i < iIterations; ++i)
+  {
+    AL_64U const uDeadline = Rtos_GetTimeNs() + iDuration;
+
+    if(Wait(pBench, eWait, uDeadline, iDuration))
+    {
+      Fail(pBench, pName, "the wait succeeded while nothing was signaled");
+      return;
+    }
+
+    pLateness[i] = (AL_64S)(Rtos_GetTimeNs() - uDeadline);
+  }
+
+  if(Bench_PrintDistribution(pName, pLateness, iIterations))
+    Fail(pBench, pName, "woke up before the deadline");
+}
+
+/****************************************************************************/
+static void CheckExpiredDeadlines(TTimerBench* pBench)
+{
+  AL_64U const uPast = Rtos_GetTimeNs() - NS_PER_MS;
+
+  if(Rtos_GetSemaphoreUntil(pBench->hSem, uPast) || Rtos_WaitEventUntil(pBench->hEvt, uPast))
+    Fail(pBench, "expired deadline", "the wait succeeded while nothing was signaled");
+
+  Rtos_ReleaseSemaphore(pBench->hSem);
+  Rtos_SetEvent(pBench->hEvt);
+
+  if(!Rtos_GetSemaphoreUntil(pBench->hSem, uPast) || !Rtos_WaitEventUntil(pBench->hEvt, uPast))
+    Fail(pBench, "expired deadline", "a signaled object wasn't taken");
+
+  if(Rtos_GetSemaphore(pBench->hSem, AL_NO_WAIT))
+    Fail(pBench, "expired deadline", "the semaphore was taken twice");
+}
+
+/* periodic task: each wait has its own absolute deadline, so the lateness of
+ * one wait doesn't shift the next ones */
+/****************************************************************************/
+static void MeasurePeriodic(TTimerBench* pBench, char const* pName, AL_64S iPeriod, AL_64S* pLateness, int iIterations)
+{
+  AL_64U const uStart = Rtos_GetTimeNs();
+
+  for(int i = 0; i < iIterations; ++i)
+  {
+    AL_64U const uDeadline = uStart + (i + 1) * iPeriod;
+    Rtos_WaitEventUntil(pBench->hEvt, uDeadline);
+    pLateness[i] = (AL_64S)(Rtos_GetTimeNs() - uDeadline);
+  }
+
+  if(Bench_PrintDistribution(pName, pLateness, iIterations))
+    Fail(pBench, pName, "woke up before the deadline");
+}
+
+typedef struct
+{
+  AL_SEMAPHORE hWake;
+  AL_SEMAPHORE hAck;
+  AL_64U uPostedAt;
+  int iIterations;
+}TWaker;
+
+/****************************************************************************/
+static void* WakerThread(void* pParam)
+{
+  TWaker* pWaker = (TWaker*)pParam;
+
+  for(int i = 0; i < pWaker->iIterations; ++i)
+  {
+    /* let the waiter go back to sleep first */
+    Rtos_SleepUs(200);
+    pWaker->uPostedAt = Rtos_GetTimeNs();
+    Rtos_ReleaseSemaphore(pWaker->hWake);
+    Rtos_GetSemaphore(pWaker->hAck, AL_WAIT_FOREVER);
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+static void MeasureWakeUp(TTimerBench* pBench, char const* pName, AL_64S* pLatency, int iIterations)
+{
+  TWaker waker;
+  waker.hWake = Rtos_CreateSemaphore(0);
+  waker.hAck = Rtos_CreateSemaphore(0);
+  waker.iIterations = iIterations;
+
+  AL_THREAD hThread = Rtos_CreateThread(WakerThread, &waker);
+
+  if(!hThread)
+  {
+    Fail(pBench, pName, "can't create the waking thread");
+    iIterations = 0;
+  }
+
+  for(int i = 0; i < iIterations; ++i)
+  {
+    Rtos_GetSemaphore(waker.hWake, AL_WAIT_FOREVER);
+    pLatency[i] = (AL_64S)(Rtos_GetTimeNs() - waker.uPostedAt);
+    Rtos_ReleaseSemaphore(waker.hAck);
+  }
+
+  if(hThread)
+  {
+    Rtos_JoinThread(hThread);
+    Rtos_DeleteThread(hThread);
+  }
+
+  Rtos_DeleteSemaphore(waker.hAck);
+  Rtos_DeleteSemaphore(waker.hWake);
+
+  Bench_PrintDistribution(pName, pLatency, iIterations);
+}
+
+/****************************************************************************/
+int Bench_Timer(int iIterations)
+{
+  TTimerBench bench;
+  bench.hSem = Rtos_CreateSemaphore(0);
+  bench.hEvt = Rtos_CreateEvent(false);
+  bench.iFailures = 0;
+
+  AL_64S* pSamples = (AL_64S*)Rtos_Malloc(iIterations * sizeof(AL_64S));
+
+  if(!bench.hSem || !bench.hEvt || !pSamples)
+  {
+    printf("FAILED: can't allocate the timer benchmark\n");
+    return 1;
+  }
+
+  printf("lateness after the deadline:\n");
+  MeasureWait(&bench, "sleep 100 us", WAIT_SLEEP_US, 100 * NS_PER_US, pSamples, iIterations);
+  MeasureWait(&bench, "sleep 1 ms", WAIT_SLEEP_MS, NS_PER_MS, pSamples, iIterations);
+  MeasureWait(&bench, "semaphore timeout 2 ms", WAIT_SEMAPHORE, 2 * NS_PER_MS, pSamples, iIterations);
+  MeasureWait(&bench, "semaphore deadline +500 us", WAIT_SEMAPHORE_UNTIL, 500 * NS_PER_US, pSamples, iIterations);
+  MeasureWait(&bench, "event timeout 2 ms", WAIT_EVENT, 2 * NS_PER_MS, pSamples, iIterations);
+  MeasureWait(&bench, "event deadline +500 us", WAIT_EVENT_UNTIL, 500 * NS_PER_US, pSamples, iIterations);
+  MeasurePeriodic(&bench, "periodic deadlines 1 ms", NS_PER_MS, pSamples, iIterations);
+  CheckExpiredDeadlines(&bench);
+
+  printf("latency from the release to the wake-up:\n");
+  MeasureWakeUp(&bench, "semaphore released", pSamples, iIterations);
+
+  Rtos_Free(pSamples);
+  Rtos_DeleteEvent(bench.hEvt);
+  Rtos_DeleteSemaphore(bench.hSem);
+
+  printf("%s\n", bench.iFailures ? "timer checks FAILED" : "timer checks passed");
+  return bench.iFailures ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* Checks of the library services the latency of the stack depends on, and
+ * measures of what they cost. Each mode runs on its own:
+ *
+ * --timer checks that the timed waits of lib_rtos never return before their
+ * deadline and measures how late they wake up (accuracy) and how much that
+ * varies from one wait to the next (jitter).
+ *
+ * --dispatcher runs the mcu encode scheduler on a fake driver and compares the
+ * status latency of one thread per channel with a status dispatcher, from 1 to
+ * 32 channels. It checks that no status is lost when fetches fail.
+ *
+ * --threads measures the wake-up jitter of a periodic thread while every cpu
+ * is busy, with the default and with the real-time scheduling policies.
+ *
+ * --device-pool stresses the opens and closes of the device pool from several
+ * threads and measures the open and close of an already opened device.
+ *
+ * --malloc compares the system allocator and the Rtos_Malloc pool under
+ * contention, with blocks freed by other threads. The pool is only compared
+ * when the library is built with ENABLE_RTOS_POOL=1.
+ *
+ * --dma-import runs the per-frame dmabuf imports of the OMX components on the
+ * import cache of the linux dma allocator, with memfds for dmabufs. It
+ * reports the hit rate and the cost of a frame with and without the cache,
+ * and checks the identity of the buffers, the forget and the idle bound.
+ *
+ * The process exits with 1 as soon as a check of the selected mode failed.
+ * The benchmark isn't part of the library: the exe_bench sources are built with
+ * the library include paths (and extra/include for the driver
+ * interface) and linked against it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+/****************************************************************************/
+static int CompareSamples(void const* pA, void const* pB)
+{
+  AL_64S const iA = *(AL_64S const*)pA;
+  AL_64S const iB = *(AL_64S const*)pB;
+  return (iA > iB) - (iA < iB);
+}
+
+/****************************************************************************/
+static double Percentile(AL_64S const* pSorted, int iCount, int iPercent)
+{
+  int iIdx = iCount * iPercent / 100;
+
+  if(iIdx >= iCount)
+    iIdx = iCount - 1;
+  return pSorted[iIdx] / 1000.0;
+}
+
+/****************************************************************************/
+int Bench_PrintDistribution(char const* pName, AL_64S* pSamples, int iCount)
+{
+  if(iCount <= 0)
+    return 0;
+
+  qsort(pSamples, iCount, sizeof(*pSamples), CompareSamples);
+
+  int iNegatives = 0;
+
+  while(iNegatives < iCount && pSamples[iNegatives] < 0)
+    ++iNegatives;
+
+  printf("%-28s min %8.1f p50 %8.1f p99 %8.1f max %8.1f us\n", pName,
+         Percentile(pSamples, iCount, 0), Percentile(pSamples, iCount, 50),
+         Percentile(pSamples, iCount, 99), Percentile(pSamples, iCount, 100));
+
+  return iNegatives;
+}
+
+/****************************************************************************/
+static void Usage(char const* pExe)
+{
+  fprintf(stderr, "Usage: %s <mode> [options]\n", pExe);
+  fprintf(stderr, "Modes:\n");
+  fprintf(stderr, "  --timer               Check the timed waits and measure their wake-up accuracy and jitter\n");
+  fprintf(stderr, "  --dispatcher          Compare the status latency of the status threads and of a status dispatcher\n");
+  fprintf(stderr, "  --threads             Measure the jitter of a periodic thread under cpu load, with and without real-time policy\n");
+  fprintf(stderr, "  --device-pool         Stress the device pool and measure its lock-free open and close\n");
+  fprintf(stderr, "  --malloc              Compare the system allocator and the Rtos_Malloc pool under contention\n");
+  fprintf(stderr, "  --dma-import          Measure the dmabuf import cache on the per-frame imports of the OMX components\n");
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --iterations <n>      Number of measures per case ('200')\n");
+}
+
+/****************************************************************************/
+int main(int argc, char** argv)
+{
+  char const* pMode = NULL;
+  int iIterations = 200;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(!strcmp(argv[i], "--iterations") && i + 1 < argc)
+      iIterations = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "--timer") || !strcmp(argv[i], "--dispatcher") || !strcmp(argv[i], "--threads") || !strcmp(argv[i], "--device-pool") || !strcmp(argv[i], "--malloc") || !strcmp(argv[i], "--dma-import"))
+      pMode = argv[i];
+    else
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(!pMode || iIterations <= 0)
+  {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if(!strcmp(pMode, "--dispatcher"))
+    return Bench_Dispatcher(iIterations);
+
+  if(!strcmp(pMode, "--threads"))
+    return Bench_Threads(iIterations);
+
+  if(!strcmp(pMode, "--device-pool"))
+    return Bench_DevicePool(iIterations);
+
+  if(!strcmp(pMode, "--malloc"))
+    return Bench_Malloc(iIterations);
+
+  if(!strcmp(pMode, "--dma-import"))
+    return Bench_DmaImport(iIterations);
+
+  return Bench_Timer(iIterations);
+}
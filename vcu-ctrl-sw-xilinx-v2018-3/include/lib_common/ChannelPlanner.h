@@ -0,0 +1,178 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup ChannelPlanner
+   @{
+   \file
+ **************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+#define AL_PLANNER_MAX_CHANNELS 32
+#define AL_PLANNER_MAX_CORES 8
+
+/*************************************************************************//*!
+   \brief Kind of hardware a channel runs on
+*****************************************************************************/
+typedef enum AL_e_PlannerCodec
+{
+  AL_PLANNER_ENCODER,
+  AL_PLANNER_DECODER,
+  AL_PLANNER_MAX_ENUM, /* sentinel */
+}AL_EPlannerCodec;
+
+/*************************************************************************//*!
+   \brief Description of a prospective channel
+*****************************************************************************/
+typedef struct AL_t_PlannedChannel
+{
+  AL_EPlannerCodec eCodec;
+  int iWidth;
+  int iHeight;
+  int iFrameRate; /*!< Frames per second, multiplied by 1000 / iClkRatio */
+  int iClkRatio; /*!< 1000 or 1001 */
+  int iNumCore; /*!< Number of cores to use, 0 to let the planner choose like NUMCORE_AUTO */
+}AL_TPlannedChannel;
+
+/*************************************************************************//*!
+   \brief Processing power of one set of identical cores
+*****************************************************************************/
+typedef struct AL_t_PlannerCores
+{
+  int iNumCores;
+  int iResourcesByCore; /*!< 32x32 blocks per second one core can process */
+  int iMaxWidth; /*!< Maximum width one core can process */
+  int iLoad[AL_PLANNER_MAX_CORES]; /*!< Blocks per second currently assigned to each core */
+}AL_TPlannerCores;
+
+/*************************************************************************//*!
+   \brief Placement of an admitted channel
+*****************************************************************************/
+typedef struct AL_t_PlannerSlot
+{
+  bool bUsed;
+  AL_TPlannedChannel tChannel;
+  int iResources; /*!< Blocks per second needed by the channel */
+  int iNumCore; /*!< Number of cores the channel is spread on */
+  uint32_t uCoreMask; /*!< Cores the channel is spread on */
+}AL_TPlannerSlot;
+
+/*************************************************************************//*!
+   \brief Capacity model of one device
+*****************************************************************************/
+typedef struct AL_t_ChannelPlanner
+{
+  AL_TPlannerCores tCores[AL_PLANNER_MAX_ENUM];
+  AL_TPlannerSlot tSlots[AL_PLANNER_MAX_CHANNELS];
+}AL_TChannelPlanner;
+
+/*************************************************************************//*!
+   \brief Load summary of one set of cores
+*****************************************************************************/
+typedef struct AL_t_PlannerReport
+{
+  int iNumCores;
+  int iNumChannels;
+  int iCapacity; /*!< Blocks per second all the cores can process */
+  int iLoad; /*!< Blocks per second currently assigned */
+  int iHeadroom; /*!< iCapacity - iLoad */
+  int iCoreLoadPercent[AL_PLANNER_MAX_CORES]; /*!< Load of each core in percent of its capacity */
+}AL_TPlannerReport;
+
+/*************************************************************************//*!
+   \brief Initializes the planner with the cores of the device this library
+   was configured for (ENCODER_CORE_FREQUENCY, AL_ENC_NUM_CORES, ...)
+   \param[out] pPlanner Pointer to the planner
+*****************************************************************************/
+void AL_ChannelPlanner_Init(AL_TChannelPlanner* pPlanner);
+
+/*************************************************************************//*!
+   \brief Overrides the cores description of one hardware kind
+   \param[in] pPlanner Pointer to the planner
+   \param[in] eCodec Hardware kind
+   \param[in] iNumCores Number of cores (at most AL_PLANNER_MAX_CORES)
+   \param[in] iCoreFrequency Core clock frequency in Hz
+   \param[in] iMargin Percentage of the clock kept as a safety margin
+   \param[in] iCyclesFor32x32 Cycles needed by one core to process a 32x32 block
+   \param[in] iMaxWidth Maximum width one core can process
+   \return false if the parameters are invalid or channels are already admitted
+*****************************************************************************/
+bool AL_ChannelPlanner_SetCores(AL_TChannelPlanner* pPlanner, AL_EPlannerCodec eCodec, int iNumCores, int iCoreFrequency, int iMargin, int iCyclesFor32x32, int iMaxWidth);
+
+/*************************************************************************//*!
+   \brief Checks if a channel would fit in real time next to the admitted ones
+   \param[in] pPlanner Pointer to the planner
+   \param[in] pChannel Channel description
+   \return true if the channel can be admitted
+*****************************************************************************/
+bool AL_ChannelPlanner_CanFit(AL_TChannelPlanner const* pPlanner, AL_TPlannedChannel const* pChannel);
+
+/*************************************************************************//*!
+   \brief Admits a channel and reserves its resources
+   \param[in] pPlanner Pointer to the planner
+   \param[in] pChannel Channel description
+   \return the channel identifier, -1 if the channel doesn't fit
+*****************************************************************************/
+int AL_ChannelPlanner_AddChannel(AL_TChannelPlanner* pPlanner, AL_TPlannedChannel const* pChannel);
+
+/*************************************************************************//*!
+   \brief Releases the resources of an admitted channel
+   \param[in] pPlanner Pointer to the planner
+   \param[in] iChannelId Identifier returned by AL_ChannelPlanner_AddChannel
+*****************************************************************************/
+void AL_ChannelPlanner_RemoveChannel(AL_TChannelPlanner* pPlanner, int iChannelId);
+
+/*************************************************************************//*!
+   \brief Retrieves the placement of an admitted channel
+   \param[in] pPlanner Pointer to the planner
+   \param[in] iChannelId Identifier returned by AL_ChannelPlanner_AddChannel
+   \return NULL if the identifier is not used
+*****************************************************************************/
+AL_TPlannerSlot const* AL_ChannelPlanner_GetChannel(AL_TChannelPlanner const* pPlanner, int iChannelId);
+
+/*************************************************************************//*!
+   \brief Reports the current load of one hardware kind
+   \param[in] pPlanner Pointer to the planner
+   \param[in] eCodec Hardware kind
+   \param[out] pReport Load summary
+*****************************************************************************/
+void AL_ChannelPlanner_GetReport(AL_TChannelPlanner const* pPlanner, AL_EPlannerCodec eCodec, AL_TPlannerReport* pReport);
+
+/*@}*/
+
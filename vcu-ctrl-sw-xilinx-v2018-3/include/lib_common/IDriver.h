@@ -48,6 +48,8 @@ typedef enum
 }AL_EDriverError;
 
 #define AL_POLL_MSG 0xfffffffc
+/* interrupts the AL_POLL_MSG pending on the same fd, which then returns DRIVER_TIMEOUT */
+#define AL_WAKE_MSG 0xfffffffb
 
 typedef struct AL_t_driver AL_TDriver;
 typedef struct
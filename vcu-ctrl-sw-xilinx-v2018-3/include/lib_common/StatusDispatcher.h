@@ -0,0 +1,100 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/**************************************************************************//*!
+   \addtogroup StatusDispatcher
+
+   The status dispatcher multiplexes the status file descriptors of several mcu
+   channels on a small pool of worker threads, instead of one blocking thread
+   per channel. The file descriptors must be pollable (see Rtos_CreatePollSet):
+   the driver signals them readable when a status can be fetched without
+   blocking. A single dispatcher can serve all the channels of a process.
+
+   @{
+   \file
+ *****************************************************************************/
+#pragma once
+
+#include "lib_rtos/types.h"
+
+typedef struct AL_t_StatusDispatcher AL_TStatusDispatcher;
+
+/*************************************************************************//*!
+   \brief Called from a worker thread when the registered fd is ready.
+   \param[in] pParam User parameter given at registration
+   \return true to keep watching the fd, false to drop the registration.
+*****************************************************************************/
+typedef bool (* AL_FCN_StatusReady)(void* pParam);
+
+/*************************************************************************//*!
+   \brief Called once the registration of an fd has been dropped because its
+   AL_FCN_StatusReady returned false. The fd can safely be closed from there.
+*****************************************************************************/
+typedef void (* AL_FCN_StatusDone)(void* pParam);
+
+/*************************************************************************//*!
+   \brief Creates a dispatcher
+   \param[in] iNumWorkers Number of worker threads running the callbacks
+   \return the dispatcher, NULL on failure or if the platform doesn't support it
+*****************************************************************************/
+AL_TStatusDispatcher* AL_StatusDispatcher_Create(int iNumWorkers);
+
+/*************************************************************************//*!
+   \brief Stops the workers and destroys the dispatcher. All the fds must have
+   been unregistered.
+*****************************************************************************/
+void AL_StatusDispatcher_Destroy(AL_TStatusDispatcher* pDispatcher);
+
+/*************************************************************************//*!
+   \brief Starts watching fd. pfnReady is called each time the fd becomes
+   ready, never concurrently with itself for the same fd.
+   \param[in] pfnDone optional, see AL_FCN_StatusDone
+   \return true on success
+*****************************************************************************/
+bool AL_StatusDispatcher_Register(AL_TStatusDispatcher* pDispatcher, int fd, AL_FCN_StatusReady pfnReady, AL_FCN_StatusDone pfnDone, void* pParam);
+
+/*************************************************************************//*!
+   \brief Stops watching fd. Waits for a callback in progress on this fd to
+   return, so it must not be called from the callback of the same fd, nor
+   from anything that callback calls: it would wait for itself forever. A
+   callback that wants to stop watching its fd returns false instead and
+   releases the fd from pfnDone. pfnDone is not called.
+*****************************************************************************/
+void AL_StatusDispatcher_Unregister(AL_TStatusDispatcher* pDispatcher, int fd);
+
+/*@}*/
+
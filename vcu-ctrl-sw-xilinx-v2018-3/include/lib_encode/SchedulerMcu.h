@@ -38,9 +38,16 @@
 #pragma once
 
 #include "lib_common/Allocator.h"
+#include "lib_common/StatusDispatcher.h"
 
 typedef struct AL_t_driver AL_TDriver;
 typedef struct t_Scheduler TScheduler;
 
 TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator);
 
+/* Same as AL_SchedulerMcu_Create, but the channel statuses are collected by
+ * pDispatcher instead of one thread per channel. NULL falls back to threads.
+ * As with the threads, a channel can't be destroyed from its own callbacks:
+ * the destruction waits for the status callback in progress. */
+TScheduler* AL_SchedulerMcu_CreateWithDispatcher(AL_TDriver* driver, AL_TAllocator* pDmaAllocator, AL_TStatusDispatcher* pDispatcher);
+
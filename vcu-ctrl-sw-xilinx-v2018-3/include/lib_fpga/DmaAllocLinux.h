@@ -45,12 +45,25 @@
 #include "lib_common/Allocator.h"
 
 typedef struct AL_t_LinuxDmaAllocator AL_TLinuxDmaAllocator;
+
+/*************************************************************************//*!
+   \brief Counters of the dmabuf import cache
+*****************************************************************************/
+typedef struct
+{
+  AL_64U uHits; /*!< imports of a dmabuf found in the cache */
+  AL_64U uMisses; /*!< imports that queried the driver */
+  AL_64U uEvictions; /*!< unused entries dropped to bound the cache */
+}AL_TDmaImportStats;
+
 /*! \cond ********************************************************************/
 typedef struct
 {
   AL_AllocatorVtable base;
   int (* pfnGetFd)(AL_TLinuxDmaAllocator* pAllocator, AL_HANDLE hBuf);
   AL_HANDLE (* pfnImportFromFd)(AL_TLinuxDmaAllocator* pAllocator, int fd);
+  void (* pfnGetImportStats)(AL_TLinuxDmaAllocator* pAllocator, AL_TDmaImportStats* pStats);
+  void (* pfnForgetFd)(AL_TLinuxDmaAllocator* pAllocator, int fd);
 }AL_DmaAllocLinuxVtable;
 
 typedef struct AL_t_LinuxDmaAllocator
@@ -83,5 +96,35 @@ AL_HANDLE AL_LinuxDmaAllocator_ImportFromFd(AL_TLinuxDmaAllocator* pAllocator, i
   return pAllocator->vtable->pfnImportFromFd(pAllocator, fd);
 }
 
+/**************************************************************************//*!
+   \brief Get the counters of the import cache
+   \param[in] pAllocator a linux dma allocator
+   \param[out] pStats the counters
+   \return false if the allocator has no import cache
+ *****************************************************************************/
+static inline
+bool AL_LinuxDmaAllocator_GetImportStats(AL_TLinuxDmaAllocator* pAllocator, AL_TDmaImportStats* pStats)
+{
+  if(!pAllocator->vtable->pfnGetImportStats)
+    return false;
+  pAllocator->vtable->pfnGetImportStats(pAllocator, pStats);
+  return true;
+}
+
+/**************************************************************************//*!
+   \brief Tell the import cache that a dmabuf is about to be freed by its owner
+   The cache keeps the imports of recently freed buffers to serve the next
+   import of the same dmabuf. The owner of the dmabuf calls this before
+   closing it so that the cache doesn't keep the memory alive.
+   \param[in] pAllocator a linux dma allocator
+   \param[in] fd a linux dmabuf file descriptor
+ *****************************************************************************/
+static inline
+void AL_LinuxDmaAllocator_ForgetFd(AL_TLinuxDmaAllocator* pAllocator, int fd)
+{
+  if(pAllocator->vtable->pfnForgetFd)
+    pAllocator->vtable->pfnForgetFd(pAllocator, fd);
+}
+
 /*@}*/
 
@@ -54,6 +54,7 @@ typedef void* AL_MUTEX;
 typedef void* AL_SEMAPHORE;
 typedef void* AL_EVENT;
 typedef void* AL_THREAD;
+typedef void* AL_POLLSET;
 
 /****************************************************************************/
 #define AL_NO_WAIT 0
@@ -72,11 +73,36 @@ void* Rtos_Memmove(void* pDst, void const* pSrc, size_t zSize);
 void* Rtos_Memset(void* pDst, int iVal, size_t zSize);
 int Rtos_Memcmp(void const* pBuf1, void const* pBuf2, size_t zSize);
 
+/* The small allocations (up to 2KB) can be served by size class pools with a
+ * cache per thread, to avoid the contention on the system allocator when
+ * several channels run. The pool is only available on linux, when built with
+ * ENABLE_RTOS_POOL=1: every allocation then carries a 16 bytes header, pool
+ * enabled or not. It is disabled at startup and can be toggled at any time:
+ * the blocks always go back where they come from. */
+bool Rtos_EnableMallocPool(bool bEnable);
+
+typedef struct
+{
+  AL_64U uAllocs;
+  AL_64U uFrees;
+  AL_64U uCacheHits; /* allocations served by the cache of the thread */
+  AL_64U uDepotFetches; /* batches taken from the shared pool of a size class */
+  AL_64U uDepotReturns; /* batches given back to the shared pool of a size class */
+  AL_64U uLargeAllocs; /* allocations too large for the pool */
+  AL_64U zChunkBytes; /* memory reserved by the pool, never given back to the system */
+}AL_TRtosMallocStats;
+
+/* only counts the calls made while the pool is enabled */
+bool Rtos_GetMallocStats(AL_TRtosMallocStats* pStats);
+
 /****************************************************************************/
 /*  Clock */
 /****************************************************************************/
-AL_64U Rtos_GetTime();
+/* monotonic clock: unaffected by wall-clock changes, only meaningful as a difference */
+AL_64U Rtos_GetTime(); /* milliseconds */
+AL_64U Rtos_GetTimeNs(); /* nanoseconds */
 void Rtos_Sleep(uint32_t uMillisecond);
+void Rtos_SleepUs(uint32_t uMicrosecond);
 
 /****************************************************************************/
 /*  Mutex */
@@ -92,6 +118,8 @@ bool Rtos_ReleaseMutex(AL_MUTEX Mutex);
 AL_SEMAPHORE Rtos_CreateSemaphore(int iInitialCount);
 void Rtos_DeleteSemaphore(AL_SEMAPHORE Semaphore);
 bool Rtos_GetSemaphore(AL_SEMAPHORE Semaphore, uint32_t Wait);
+/* waits until the absolute deadline uDeadlineNs, expressed with the Rtos_GetTimeNs clock */
+bool Rtos_GetSemaphoreUntil(AL_SEMAPHORE Semaphore, AL_64U uDeadlineNs);
 bool Rtos_ReleaseSemaphore(AL_SEMAPHORE Semaphore);
 
 /****************************************************************************/
@@ -100,6 +128,8 @@ bool Rtos_ReleaseSemaphore(AL_SEMAPHORE Semaphore);
 AL_EVENT Rtos_CreateEvent(bool iInitialState);
 void Rtos_DeleteEvent(AL_EVENT Event);
 bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait);
+/* waits until the absolute deadline uDeadlineNs, expressed with the Rtos_GetTimeNs clock */
+bool Rtos_WaitEventUntil(AL_EVENT Event, AL_64U uDeadlineNs);
 bool Rtos_SetEvent(AL_EVENT Event);
 
 /****************************************************************************/
@@ -109,13 +139,61 @@ AL_THREAD Rtos_CreateThread(void* (*pFunc)(void* pParam), void* pParam);
 bool Rtos_JoinThread(AL_THREAD Thread);
 void Rtos_DeleteThread(AL_THREAD Thread);
 
+typedef enum
+{
+  AL_SCHED_DEFAULT, /* inherited from the creating thread */
+  AL_SCHED_OTHER,
+  AL_SCHED_FIFO,
+  AL_SCHED_RR,
+}AL_ESchedPolicy;
+
+typedef struct
+{
+  char const* pName; /* truncated to 15 characters on linux, NULL keeps the default */
+  AL_64U uAffinityMask; /* bit i allows cpu i, 0 keeps the default */
+  AL_ESchedPolicy ePolicy;
+  int iPriority; /* real-time priority, used by AL_SCHED_FIFO and AL_SCHED_RR */
+  size_t zStackSize; /* 0 keeps the default */
+}AL_TThreadAttr;
+
+void Rtos_InitThreadAttr(AL_TThreadAttr* pAttr);
+/* when the caller isn't allowed to use the requested real-time policy,
+ * the thread is still created, with the default policy */
+AL_THREAD Rtos_CreateThreadWithAttr(void* (*pFunc)(void* pParam), void* pParam, AL_TThreadAttr const* pAttr);
+/* applies pAttr, except the stack size, to the calling thread */
+bool Rtos_SetCurrentThreadAttr(AL_TThreadAttr const* pAttr);
+
+/* The threads created by the library are named ("al_dec_feeder", "al_enc_status", ...).
+ * Rtos_SetThreadConfig registers the attributes to use for the threads named pName.
+ * It isn't thread-safe: configure the threads before creating any channel. */
+bool Rtos_SetThreadConfig(char const* pName, AL_TThreadAttr const* pAttr);
+AL_THREAD Rtos_CreateNamedThread(void* (*pFunc)(void* pParam), void* pParam, char const* pName);
+/* for the threads not created by Rtos: applies the configuration of pName to the calling thread */
+bool Rtos_ApplyThreadConfig(char const* pName);
+
 /****************************************************************************/
 /*  Driver */
 /****************************************************************************/
 void* Rtos_DriverOpen(char const* name);
 void Rtos_DriverClose(void* drv);
 int Rtos_DriverIoctl(void* drv, unsigned long int req, void* data);
+/* timeout in ms, -1 waits forever. returns 0 on timeout or when woken by Rtos_DriverWake */
 int Rtos_DriverPoll(void* drv, int timeout);
+/* interrupts the Rtos_DriverPoll pending on drv, or the next one */
+bool Rtos_DriverWake(void* drv);
+
+/* A poll set waits for any of several drivers at once. Several threads can
+ * wait on the same set: each ready driver is reported to only one of them. */
+AL_POLLSET Rtos_CreatePollSet();
+void Rtos_DeletePollSet(AL_POLLSET PollSet);
+/* drv is reported once with uData, then it has to be added again to be watched */
+bool Rtos_AddToPollSet(AL_POLLSET PollSet, void* drv, AL_64U uData);
+bool Rtos_RemoveFromPollSet(AL_POLLSET PollSet, void* drv);
+/* timeout in ms, -1 waits forever. returns 1 and the uData of a ready driver,
+ * 0 on timeout or once the set is stopped, -1 on error */
+int Rtos_WaitPollSet(AL_POLLSET PollSet, int timeout, AL_64U* pData);
+/* the pending and all the following Rtos_WaitPollSet return 0 right away */
+bool Rtos_StopPollSet(AL_POLLSET PollSet);
 
 /****************************************************************************/
 /*  Atomics */
@@ -46,6 +46,7 @@ typedef struct al_t_BufferImpl
 
   AL_TMetaData** pMeta;
   int iMetaCount;
+  int iMetaCapacity; /*!< number of slots in pMeta, never shrinks so that a reused buffer doesn't reallocate it */
 
   void* pUserData; /*!< user private data */
   PFN_RefCount_CallBack pCallBack; /*!< user callback. called when the buffer refcount reaches 0 */
@@ -79,6 +80,7 @@ static bool AL_Buffer_InitData(AL_TBufferImpl* pBuf, AL_TAllocator* pAllocator,
   pBuf->pData = NULL;
   pBuf->pMeta = NULL;
   pBuf->iMetaCount = 0;
+  pBuf->iMetaCapacity = 0;
 
   pBuf->iRefCount = 0;
   pBuf->pLock = Rtos_CreateMutex();
@@ -228,17 +230,23 @@ bool AL_Buffer_AddMetaData(AL_TBuffer* hBuf, AL_TMetaData* pMeta)
 
   Rtos_GetMutex(pBuf->pLock);
 
-  size_t const zOldSize = sizeof(AL_TMetaData*) * pBuf->iMetaCount;
-  size_t const zNewSize = sizeof(AL_TMetaData*) * (pBuf->iMetaCount + 1);
-  AL_TMetaData** pNewBuffer = Realloc(pBuf->pMeta, zOldSize, zNewSize);
-
-  if(!pNewBuffer)
+  if(pBuf->iMetaCount == pBuf->iMetaCapacity)
   {
-    Rtos_ReleaseMutex(pBuf->pLock);
-    return false;
+    int const iNewCapacity = pBuf->iMetaCapacity ? 2 * pBuf->iMetaCapacity : 2;
+    size_t const zOldSize = sizeof(AL_TMetaData*) * pBuf->iMetaCount;
+    size_t const zNewSize = sizeof(AL_TMetaData*) * iNewCapacity;
+    AL_TMetaData** pNewBuffer = Realloc(pBuf->pMeta, zOldSize, zNewSize);
+
+    if(!pNewBuffer)
+    {
+      Rtos_ReleaseMutex(pBuf->pLock);
+      return false;
+    }
+
+    pBuf->pMeta = pNewBuffer;
+    pBuf->iMetaCapacity = iNewCapacity;
   }
 
-  pBuf->pMeta = pNewBuffer;
   pBuf->pMeta[pBuf->iMetaCount] = pMeta;
   pBuf->iMetaCount++;
 
@@ -258,13 +266,8 @@ bool AL_Buffer_RemoveMetaData(AL_TBuffer* hBuf, AL_TMetaData* pMeta)
   {
     if(pBuf->pMeta[i] == pMeta)
     {
+      /* keep the slot: the next AddMetaData on this buffer reuses it */
       pBuf->pMeta[i] = pBuf->pMeta[pBuf->iMetaCount - 1];
-      AL_TMetaData** pTmp = Realloc(pBuf->pMeta, sizeof(void*) * pBuf->iMetaCount, sizeof(void*) * (pBuf->iMetaCount - 1));
-
-      /* if we can't realloc, keep the old bigger buffer */
-      if(pTmp)
-        pBuf->pMeta = pTmp;
-
       pBuf->iMetaCount--;
       Rtos_ReleaseMutex(pBuf->pLock);
       return true;
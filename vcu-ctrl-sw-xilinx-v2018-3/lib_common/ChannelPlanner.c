@@ -0,0 +1,277 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "lib_common/ChannelPlanner.h"
+#include "ChannelResources.h"
+#include "Utils.h"
+#include "lib_rtos/lib_rtos.h"
+
+/* The decoder cores are not described by the configure script, these are
+ * the values of the reference design */
+#ifndef DECODER_CORE_FREQUENCY
+#define DECODER_CORE_FREQUENCY 666666666
+#endif
+#ifndef DECODER_CORE_FREQUENCY_MARGIN
+#define DECODER_CORE_FREQUENCY_MARGIN 10
+#endif
+#ifndef DECODER_CYCLES_FOR_BLK_32X32
+#define DECODER_CYCLES_FOR_BLK_32X32 2450
+#endif
+#ifndef AL_DEC_CORE_MAX_WIDTH
+#define AL_DEC_CORE_MAX_WIDTH 4096
+#endif
+
+static int divideRoundUp(int dividende, int divisor)
+{
+  return (dividende + divisor - 1) / divisor;
+}
+
+static bool isValidCodec(AL_EPlannerCodec eCodec)
+{
+  return eCodec >= AL_PLANNER_ENCODER && eCodec < AL_PLANNER_MAX_ENUM;
+}
+
+static bool hasChannels(AL_TChannelPlanner const* pPlanner)
+{
+  for(int i = 0; i < AL_PLANNER_MAX_CHANNELS; ++i)
+  {
+    if(pPlanner->tSlots[i].bUsed)
+      return true;
+  }
+
+  return false;
+}
+
+/****************************************************************************/
+bool AL_ChannelPlanner_SetCores(AL_TChannelPlanner* pPlanner, AL_EPlannerCodec eCodec, int iNumCores, int iCoreFrequency, int iMargin, int iCyclesFor32x32, int iMaxWidth)
+{
+  if(!isValidCodec(eCodec) || hasChannels(pPlanner))
+    return false;
+
+  if(iNumCores < 0 || iNumCores > AL_PLANNER_MAX_CORES || iCyclesFor32x32 <= 0 || iMaxWidth <= 0)
+    return false;
+
+  AL_CoreConstraint constraint;
+  AL_CoreConstraint_Init(&constraint, iCoreFrequency, iMargin, iCyclesFor32x32, 0, iMaxWidth);
+
+  AL_TPlannerCores* pCores = &pPlanner->tCores[eCodec];
+  Rtos_Memset(pCores, 0, sizeof(*pCores));
+  pCores->iNumCores = iNumCores;
+  pCores->iResourcesByCore = constraint.resources;
+  pCores->iMaxWidth = iMaxWidth;
+  return true;
+}
+
+/****************************************************************************/
+void AL_ChannelPlanner_Init(AL_TChannelPlanner* pPlanner)
+{
+  Rtos_Memset(pPlanner, 0, sizeof(*pPlanner));
+  AL_ChannelPlanner_SetCores(pPlanner, AL_PLANNER_ENCODER, AL_ENC_NUM_CORES, ENCODER_CORE_FREQUENCY, ENCODER_CORE_FREQUENCY_MARGIN, ENCODER_CYCLES_FOR_BLK_32X32, AL_ENC_CORE_MAX_WIDTH);
+  AL_ChannelPlanner_SetCores(pPlanner, AL_PLANNER_DECODER, AL_DEC_NUM_CORES, DECODER_CORE_FREQUENCY, DECODER_CORE_FREQUENCY_MARGIN, DECODER_CYCLES_FOR_BLK_32X32, AL_DEC_CORE_MAX_WIDTH);
+}
+
+/****************************************************************************/
+static int getNumCore(AL_TPlannerCores const* pCores, AL_TPlannedChannel const* pChannel, int iResources)
+{
+  int iMinCores = divideRoundUp(pChannel->iWidth, pCores->iMaxWidth);
+
+  if(pChannel->iNumCore > 0)
+    return Max(pChannel->iNumCore, iMinCores);
+
+  return Max(iMinCores, divideRoundUp(iResources, pCores->iResourcesByCore));
+}
+
+/****************************************************************************/
+/* Spreads the channel evenly on the iNumCore least loaded cores, like the
+ * mcu does. Returns the mask of the chosen cores, 0 if they can't take it */
+static uint32_t placeChannel(AL_TPlannerCores const* pCores, int iResources, int iNumCore)
+{
+  if(iNumCore <= 0 || iNumCore > pCores->iNumCores)
+    return 0;
+
+  int iShare = divideRoundUp(iResources, iNumCore);
+  uint32_t uMask = 0;
+
+  for(int iChosen = 0; iChosen < iNumCore; ++iChosen)
+  {
+    int iBest = -1;
+
+    for(int iCore = 0; iCore < pCores->iNumCores; ++iCore)
+    {
+      if(uMask & (1u << iCore))
+        continue;
+
+      if(iBest == -1 || pCores->iLoad[iCore] < pCores->iLoad[iBest])
+        iBest = iCore;
+    }
+
+    if(pCores->iLoad[iBest] + iShare > pCores->iResourcesByCore)
+      return 0;
+
+    uMask |= 1u << iBest;
+  }
+
+  return uMask;
+}
+
+/****************************************************************************/
+static bool computePlacement(AL_TChannelPlanner const* pPlanner, AL_TPlannedChannel const* pChannel, AL_TPlannerSlot* pSlot)
+{
+  if(!pChannel || !isValidCodec(pChannel->eCodec))
+    return false;
+
+  if(pChannel->iWidth <= 0 || pChannel->iHeight <= 0 || pChannel->iFrameRate <= 0)
+    return false;
+
+  AL_TPlannerCores const* pCores = &pPlanner->tCores[pChannel->eCodec];
+
+  if(pCores->iNumCores == 0 || pCores->iResourcesByCore <= 0)
+    return false;
+
+  int iClkRatio = pChannel->iClkRatio ? pChannel->iClkRatio : 1000;
+
+  pSlot->tChannel = *pChannel;
+  pSlot->iResources = AL_GetResources(pChannel->iWidth, pChannel->iHeight, pChannel->iFrameRate * 1000, iClkRatio);
+  pSlot->iNumCore = getNumCore(pCores, pChannel, pSlot->iResources);
+  pSlot->uCoreMask = placeChannel(pCores, pSlot->iResources, pSlot->iNumCore);
+
+  return pSlot->uCoreMask != 0;
+}
+
+/****************************************************************************/
+bool AL_ChannelPlanner_CanFit(AL_TChannelPlanner const* pPlanner, AL_TPlannedChannel const* pChannel)
+{
+  AL_TPlannerSlot tSlot;
+  return computePlacement(pPlanner, pChannel, &tSlot);
+}
+
+/****************************************************************************/
+int AL_ChannelPlanner_AddChannel(AL_TChannelPlanner* pPlanner, AL_TPlannedChannel const* pChannel)
+{
+  int iChannelId = -1;
+
+  for(int i = 0; i < AL_PLANNER_MAX_CHANNELS; ++i)
+  {
+    if(!pPlanner->tSlots[i].bUsed)
+    {
+      iChannelId = i;
+      break;
+    }
+  }
+
+  if(iChannelId == -1)
+    return -1;
+
+  AL_TPlannerSlot* pSlot = &pPlanner->tSlots[iChannelId];
+
+  if(!computePlacement(pPlanner, pChannel, pSlot))
+    return -1;
+
+  AL_TPlannerCores* pCores = &pPlanner->tCores[pChannel->eCodec];
+  int iShare = divideRoundUp(pSlot->iResources, pSlot->iNumCore);
+
+  for(int iCore = 0; iCore < pCores->iNumCores; ++iCore)
+  {
+    if(pSlot->uCoreMask & (1u << iCore))
+      pCores->iLoad[iCore] += iShare;
+  }
+
+  pSlot->bUsed = true;
+  return iChannelId;
+}
+
+/****************************************************************************/
+void AL_ChannelPlanner_RemoveChannel(AL_TChannelPlanner* pPlanner, int iChannelId)
+{
+  if(iChannelId < 0 || iChannelId >= AL_PLANNER_MAX_CHANNELS)
+    return;
+
+  AL_TPlannerSlot* pSlot = &pPlanner->tSlots[iChannelId];
+
+  if(!pSlot->bUsed)
+    return;
+
+  AL_TPlannerCores* pCores = &pPlanner->tCores[pSlot->tChannel.eCodec];
+  int iShare = divideRoundUp(pSlot->iResources, pSlot->iNumCore);
+
+  for(int iCore = 0; iCore < pCores->iNumCores; ++iCore)
+  {
+    if(pSlot->uCoreMask & (1u << iCore))
+      pCores->iLoad[iCore] -= iShare;
+  }
+
+  pSlot->bUsed = false;
+}
+
+/****************************************************************************/
+AL_TPlannerSlot const* AL_ChannelPlanner_GetChannel(AL_TChannelPlanner const* pPlanner, int iChannelId)
+{
+  if(iChannelId < 0 || iChannelId >= AL_PLANNER_MAX_CHANNELS || !pPlanner->tSlots[iChannelId].bUsed)
+    return NULL;
+
+  return &pPlanner->tSlots[iChannelId];
+}
+
+/****************************************************************************/
+void AL_ChannelPlanner_GetReport(AL_TChannelPlanner const* pPlanner, AL_EPlannerCodec eCodec, AL_TPlannerReport* pReport)
+{
+  Rtos_Memset(pReport, 0, sizeof(*pReport));
+
+  if(!isValidCodec(eCodec))
+    return;
+
+  AL_TPlannerCores const* pCores = &pPlanner->tCores[eCodec];
+  pReport->iNumCores = pCores->iNumCores;
+  pReport->iCapacity = pCores->iNumCores * pCores->iResourcesByCore;
+
+  for(int iCore = 0; iCore < pCores->iNumCores; ++iCore)
+  {
+    pReport->iLoad += pCores->iLoad[iCore];
+
+    if(pCores->iResourcesByCore > 0)
+      pReport->iCoreLoadPercent[iCore] = (int)((int64_t)pCores->iLoad[iCore] * 100 / pCores->iResourcesByCore);
+  }
+
+  pReport->iHeadroom = pReport->iCapacity - pReport->iLoad;
+
+  for(int i = 0; i < AL_PLANNER_MAX_CHANNELS; ++i)
+  {
+    if(pPlanner->tSlots[i].bUsed && pPlanner->tSlots[i].tChannel.eCodec == eCodec)
+      ++pReport->iNumChannels;
+  }
+}
+
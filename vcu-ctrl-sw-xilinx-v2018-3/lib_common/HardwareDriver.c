@@ -70,6 +70,9 @@ static AL_EDriverError PostMessage(AL_TDriver* driver, int fd, long unsigned int
 {
   (void)driver;
 
+  if(messageId == AL_WAKE_MSG)
+    return Rtos_DriverWake((void*)(intptr_t)fd) ? DRIVER_SUCCESS : DRIVER_ERROR_UNKNOWN;
+
   while(true)
   {
     int iRet;
@@ -0,0 +1,328 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "lib_common/StatusDispatcher.h"
+#include "lib_rtos/lib_rtos.h"
+
+typedef struct
+{
+  AL_FCN_StatusReady pfnReady;
+  AL_FCN_StatusDone pfnDone;
+  void* pParam;
+  uint32_t uGen;
+  bool bRunning;
+  bool bRemoved;
+  /* set when the callback returns while an unregistration waits for it */
+  AL_EVENT hIdle;
+}Registration;
+
+struct AL_t_StatusDispatcher
+{
+  AL_POLLSET hPollSet;
+  AL_MUTEX hLock;
+
+  /* indexed by fd */
+  Registration** pRegs;
+  int iMaxRegs;
+  /* tags the poll events so that an event of a dropped registration is not
+   * delivered to a new registration reusing the same fd */
+  uint32_t uGen;
+
+  AL_THREAD* pWorkers;
+  int iNumWorkers;
+};
+
+static void* toDriver(int fd)
+{
+  return (void*)(intptr_t)fd;
+}
+
+static AL_64U toEventData(int fd, uint32_t uGen)
+{
+  return ((AL_64U)uGen << 32) | (uint32_t)fd;
+}
+
+static Registration* getRegistration(AL_TStatusDispatcher* pDisp, int fd)
+{
+  if(fd < 0 || fd >= pDisp->iMaxRegs)
+    return NULL;
+  return pDisp->pRegs[fd];
+}
+
+static void destroyRegistration(Registration* pReg)
+{
+  Rtos_DeleteEvent(pReg->hIdle);
+  Rtos_Free(pReg);
+}
+
+static void runReady(AL_TStatusDispatcher* pDisp, int fd, uint32_t uGen)
+{
+  Rtos_GetMutex(pDisp->hLock);
+  Registration* pReg = getRegistration(pDisp, fd);
+
+  if(!pReg || pReg->uGen != uGen || pReg->bRemoved)
+  {
+    Rtos_ReleaseMutex(pDisp->hLock);
+    return;
+  }
+
+  pReg->bRunning = true;
+  Rtos_ReleaseMutex(pDisp->hLock);
+
+  bool bKeep = pReg->pfnReady(pReg->pParam);
+
+  Rtos_GetMutex(pDisp->hLock);
+  pReg->bRunning = false;
+
+  if(pReg->bRemoved)
+  {
+    /* AL_StatusDispatcher_Unregister is waiting and owns pReg now */
+    Rtos_SetEvent(pReg->hIdle);
+    Rtos_ReleaseMutex(pDisp->hLock);
+    return;
+  }
+
+  if(bKeep && Rtos_AddToPollSet(pDisp->hPollSet, toDriver(fd), toEventData(fd, pReg->uGen)))
+  {
+    Rtos_ReleaseMutex(pDisp->hLock);
+    return;
+  }
+
+  Rtos_RemoveFromPollSet(pDisp->hPollSet, toDriver(fd));
+  pDisp->pRegs[fd] = NULL;
+  Rtos_ReleaseMutex(pDisp->hLock);
+
+  if(pReg->pfnDone)
+    pReg->pfnDone(pReg->pParam);
+  destroyRegistration(pReg);
+}
+
+static void* Worker(void* p)
+{
+  AL_TStatusDispatcher* pDisp = p;
+  AL_64U uData;
+
+  /* returns 0 once the dispatcher is stopped */
+  while(Rtos_WaitPollSet(pDisp->hPollSet, -1, &uData) > 0)
+    runReady(pDisp, (int)(uData & 0xFFFFFFFF), (uint32_t)(uData >> 32));
+
+  return NULL;
+}
+
+static void stopWorkers(AL_TStatusDispatcher* pDisp)
+{
+  if(!Rtos_StopPollSet(pDisp->hPollSet))
+    return;
+
+  for(int i = 0; i < pDisp->iNumWorkers; ++i)
+  {
+    Rtos_JoinThread(pDisp->pWorkers[i]);
+    Rtos_DeleteThread(pDisp->pWorkers[i]);
+  }
+
+  pDisp->iNumWorkers = 0;
+}
+
+AL_TStatusDispatcher* AL_StatusDispatcher_Create(int iNumWorkers)
+{
+  if(iNumWorkers <= 0)
+    return NULL;
+
+  AL_TStatusDispatcher* pDisp = Rtos_Malloc(sizeof(*pDisp));
+
+  if(!pDisp)
+    return NULL;
+
+  Rtos_Memset(pDisp, 0, sizeof(*pDisp));
+  pDisp->hPollSet = Rtos_CreatePollSet();
+
+  if(!pDisp->hPollSet)
+    goto fail_pollset;
+
+  pDisp->hLock = Rtos_CreateMutex();
+
+  if(!pDisp->hLock)
+    goto fail_lock;
+
+  pDisp->pWorkers = Rtos_Malloc(iNumWorkers * sizeof(AL_THREAD));
+
+  if(!pDisp->pWorkers)
+    goto fail_alloc;
+
+  for(int i = 0; i < iNumWorkers; ++i)
+  {
+    pDisp->pWorkers[i] = Rtos_CreateNamedThread(&Worker, pDisp, "al_status_disp");
+
+    if(!pDisp->pWorkers[i])
+      goto fail_thread;
+
+    ++pDisp->iNumWorkers;
+  }
+
+  return pDisp;
+
+  fail_thread:
+  stopWorkers(pDisp);
+  Rtos_Free(pDisp->pWorkers);
+  fail_alloc:
+  Rtos_DeleteMutex(pDisp->hLock);
+  fail_lock:
+  Rtos_DeletePollSet(pDisp->hPollSet);
+  fail_pollset:
+  Rtos_Free(pDisp);
+  return NULL;
+}
+
+void AL_StatusDispatcher_Destroy(AL_TStatusDispatcher* pDisp)
+{
+  if(!pDisp)
+    return;
+
+  stopWorkers(pDisp);
+
+  for(int fd = 0; fd < pDisp->iMaxRegs; ++fd)
+  {
+    if(pDisp->pRegs[fd])
+      destroyRegistration(pDisp->pRegs[fd]);
+  }
+
+  Rtos_Free(pDisp->pRegs);
+  Rtos_Free(pDisp->pWorkers);
+  Rtos_DeleteMutex(pDisp->hLock);
+  Rtos_DeletePollSet(pDisp->hPollSet);
+  Rtos_Free(pDisp);
+}
+
+static bool reserve(AL_TStatusDispatcher* pDisp, int fd)
+{
+  if(fd < pDisp->iMaxRegs)
+    return true;
+
+  int iMaxRegs = pDisp->iMaxRegs ? pDisp->iMaxRegs : 64;
+
+  while(iMaxRegs <= fd)
+    iMaxRegs *= 2;
+
+  Registration** pRegs = Rtos_Malloc(iMaxRegs * sizeof(*pRegs));
+
+  if(!pRegs)
+    return false;
+
+  Rtos_Memset(pRegs, 0, iMaxRegs * sizeof(*pRegs));
+
+  if(pDisp->pRegs)
+    Rtos_Memcpy(pRegs, pDisp->pRegs, pDisp->iMaxRegs * sizeof(*pRegs));
+
+  Rtos_Free(pDisp->pRegs);
+  pDisp->pRegs = pRegs;
+  pDisp->iMaxRegs = iMaxRegs;
+  return true;
+}
+
+bool AL_StatusDispatcher_Register(AL_TStatusDispatcher* pDisp, int fd, AL_FCN_StatusReady pfnReady, AL_FCN_StatusDone pfnDone, void* pParam)
+{
+  if(!pDisp || fd < 0 || !pfnReady)
+    return false;
+
+  Registration* pReg = Rtos_Malloc(sizeof(*pReg));
+
+  if(!pReg)
+    return false;
+
+  pReg->pfnReady = pfnReady;
+  pReg->pfnDone = pfnDone;
+  pReg->pParam = pParam;
+  pReg->bRunning = false;
+  pReg->bRemoved = false;
+  pReg->hIdle = Rtos_CreateEvent(false);
+
+  if(!pReg->hIdle)
+  {
+    Rtos_Free(pReg);
+    return false;
+  }
+
+  Rtos_GetMutex(pDisp->hLock);
+
+  if(!reserve(pDisp, fd) || pDisp->pRegs[fd])
+    goto fail;
+
+  if(++pDisp->uGen == 0)
+    ++pDisp->uGen;
+  pReg->uGen = pDisp->uGen;
+  pDisp->pRegs[fd] = pReg;
+
+  if(!Rtos_AddToPollSet(pDisp->hPollSet, toDriver(fd), toEventData(fd, pReg->uGen)))
+  {
+    pDisp->pRegs[fd] = NULL;
+    goto fail;
+  }
+
+  Rtos_ReleaseMutex(pDisp->hLock);
+  return true;
+
+  fail:
+  Rtos_ReleaseMutex(pDisp->hLock);
+  destroyRegistration(pReg);
+  return false;
+}
+
+void AL_StatusDispatcher_Unregister(AL_TStatusDispatcher* pDisp, int fd)
+{
+  if(!pDisp)
+    return;
+
+  Rtos_GetMutex(pDisp->hLock);
+  Registration* pReg = getRegistration(pDisp, fd);
+
+  if(!pReg)
+  {
+    Rtos_ReleaseMutex(pDisp->hLock);
+    return;
+  }
+
+  pReg->bRemoved = true;
+  Rtos_RemoveFromPollSet(pDisp->hPollSet, toDriver(fd));
+  pDisp->pRegs[fd] = NULL;
+  bool bRunning = pReg->bRunning;
+  Rtos_ReleaseMutex(pDisp->hLock);
+
+  if(bRunning)
+    Rtos_WaitEvent(pReg->hIdle, AL_WAIT_FOREVER);
+
+  destroyRegistration(pReg);
+}
@@ -37,6 +37,7 @@
 
 #include "BufferFeeder.h"
 #include "lib_rtos/lib_rtos.h"
+#include "lib_common/BufferCircMeta.h"
 
 static void notifyDecoder(AL_TBufferFeeder* this)
 {
@@ -57,15 +58,27 @@ static bool enqueueBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf)
 
 bool AL_BufferFeeder_PushBuffer(AL_TBufferFeeder* this, AL_TBuffer* pBuf, size_t uSize, bool bLastBuffer)
 {
-  AL_TMetaData* pMetaCirc = (AL_TMetaData*)AL_CircMetaData_Create(0, uSize, bLastBuffer);
+  AL_TCircMetaData* pMetaCirc = (AL_TCircMetaData*)AL_Buffer_GetMetaData(pBuf, AL_META_TYPE_CIRCULAR);
 
-  if(!pMetaCirc)
-    return false;
-
-  if(!AL_Buffer_AddMetaData(pBuf, pMetaCirc))
+  /* the patchworker leaves a consumed meta on the buffer: reuse it */
+  if(pMetaCirc && pMetaCirc->iAvailSize == 0)
   {
-    Rtos_Free(pMetaCirc);
-    return false;
+    pMetaCirc->iOffset = 0;
+    pMetaCirc->iAvailSize = uSize;
+    pMetaCirc->bLastBuffer = bLastBuffer;
+  }
+  else
+  {
+    pMetaCirc = AL_CircMetaData_Create(0, uSize, bLastBuffer);
+
+    if(!pMetaCirc)
+      return false;
+
+    if(!AL_Buffer_AddMetaData(pBuf, (AL_TMetaData*)pMetaCirc))
+    {
+      Rtos_Free(pMetaCirc);
+      return false;
+    }
   }
 
   if(!enqueueBuffer(this, pBuf))
@@ -37,6 +37,7 @@
 
 #include "lib_decode/I_DecChannel.h"
 #include "lib_common/IDriver.h"
+#include "lib_common/StatusDispatcher.h"
 
 #if  __linux__
 
@@ -96,16 +97,20 @@ typedef struct
   AL_THREAD thread;
   bool bBeingDestroyed;
   AL_TDriver* driver;
+  AL_TStatusDispatcher* dispatcher;
 
   AL_CB_EndFrameDecoding endFrameDecodingCB;
 }Channel;
 
+struct DecChanMcuCtx;
+
 typedef struct
 {
   int fd;
   AL_CB_EndStartCode endStartCodeCB;
   bool bEnded;
   AL_TDriver* driver;
+  struct DecChanMcuCtx* decChanMcu;
 }SCMsg;
 
 typedef struct AL_t_Event
@@ -134,6 +139,11 @@ struct DecChanMcuCtx
   Channel chan;
   bool chanIsConfigured;
   AL_TDriver* driver;
+
+  /* when set, replaces the notification threads */
+  AL_TStatusDispatcher* dispatcher;
+  int32_t iPendingSC;
+  AL_WaitQueue SCDone;
 };
 
 static void AL_EventQueue_Init(AL_EventQueue* pEventQueue)
@@ -232,6 +242,20 @@ static void* NotificationThread(void* p)
   return NULL;
 }
 
+/* a failed fetch only ends the notifications once the channel is destroyed:
+ * before that, the fd is watched again and the fetch retried */
+static bool OnStatusReady(void* p)
+{
+  Channel* chan = p;
+  struct al5_params msg = { 0 };
+
+  if(!getStatusMsg(chan, &msg))
+    return !chan->bBeingDestroyed;
+
+  processStatusMsg(chan, &msg);
+  return true;
+}
+
 static void setScStatus(AL_TScStatus* status, struct al5_scstatus* msg)
 {
   status->uNumSC = msg->num_sc;
@@ -282,6 +306,36 @@ static void* ScNotificationThread(void* p)
   return NULL;
 }
 
+static bool OnScStatusReady(void* p)
+{
+  SCMsg* pMsg = p;
+  struct al5_scstatus StatusMsg = { 0 };
+
+  if(getScStatusMsg(pMsg, &StatusMsg))
+    processScStatusMsg(pMsg, &StatusMsg);
+
+  /* one status per search */
+  return false;
+}
+
+static bool isSCDone(void* p)
+{
+  struct DecChanMcuCtx* decChanMcu = p;
+  return decChanMcu->iPendingSC == 0;
+}
+
+static void OnScStatusDone(void* p)
+{
+  SCMsg* pMsg = p;
+  struct DecChanMcuCtx* decChanMcu = pMsg->decChanMcu;
+
+  AL_Driver_Close(pMsg->driver, pMsg->fd);
+  Rtos_Free(pMsg);
+
+  if(Rtos_AtomicDecrement(&decChanMcu->iPendingSC) == 0)
+    AL_WakeUp(&decChanMcu->SCDone);
+}
+
 /* Update some values of pChParam set by MCU */
 static void getParamUpdateByMcu(const struct al5_channel_status* msg, AL_TDecChanParam* pChParam)
 {
@@ -297,10 +351,17 @@ static bool DecChannelMcu_Init(struct DecChanMcuCtx* decChanMcu)
 {
   StartCodeEventQueue* SCQueue = &decChanMcu->SCQueue;
   decChanMcu->chanIsConfigured = false;
+  decChanMcu->iPendingSC = 0;
+
+  if(decChanMcu->dispatcher)
+  {
+    AL_WaitQueue_Init(&decChanMcu->SCDone);
+    return true;
+  }
 
   AL_EventQueue_Init(&SCQueue->EventQueue);
 
-  decChanMcu->pSCThread = Rtos_CreateThread(&ScNotificationThread, SCQueue);
+  decChanMcu->pSCThread = Rtos_CreateNamedThread(&ScNotificationThread, SCQueue, "al_dec_sc");
 
   if(!decChanMcu->pSCThread)
   {
@@ -318,11 +379,18 @@ static void DecChannelMcu_DestroyChannel(Channel* chan)
   if(AL_Driver_PostMessage(chan->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL) != DRIVER_SUCCESS)
   {
     perror("Failed to destroy channel");
-    goto exit;
+
+    if(!chan->dispatcher)
+      goto exit;
   }
 
-  Rtos_JoinThread(chan->thread);
-  Rtos_DeleteThread(chan->thread);
+  if(chan->dispatcher)
+    AL_StatusDispatcher_Unregister(chan->dispatcher, chan->fd);
+  else
+  {
+    Rtos_JoinThread(chan->thread);
+    Rtos_DeleteThread(chan->thread);
+  }
 
   exit:
   AL_Driver_Close(chan->driver, chan->fd);
@@ -333,6 +401,18 @@ static void DecChannelMcu_Destroy(AL_TIDecChannel* pDecChannel)
   struct DecChanMcuCtx* decChanMcu = (struct DecChanMcuCtx*)pDecChannel;
   StartCodeEventQueue* SCQueue = &decChanMcu->SCQueue;
 
+  if(decChanMcu->dispatcher)
+  {
+    if(decChanMcu->chanIsConfigured)
+      DecChannelMcu_DestroyChannel(&decChanMcu->chan);
+
+    /* the start code callbacks reference the decoder: wait for the last one */
+    AL_WaitEvent(&decChanMcu->SCDone, isSCDone, decChanMcu);
+    AL_WaitQueue_Deinit(&decChanMcu->SCDone);
+    Rtos_Free(decChanMcu);
+    return;
+  }
+
   AL_Event* pEvent = Rtos_Malloc(sizeof(*pEvent));
 
   if(!pEvent)
@@ -379,6 +459,7 @@ static AL_ERR DecChannelMcu_ConfigChannel(AL_TIDecChannel* pDecChannel, AL_TDecC
   chan->bBeingDestroyed = false;
   chan->endFrameDecodingCB = callback;
   chan->driver = decChanMcu->driver;
+  chan->dispatcher = decChanMcu->dispatcher;
   chan->fd = AL_Driver_Open(chan->driver, deviceFile);
 
   if(chan->fd < 0)
@@ -408,10 +489,18 @@ static AL_ERR DecChannelMcu_ConfigChannel(AL_TIDecChannel* pDecChannel, AL_TDecC
 
   getParamUpdateByMcu(&msg.status, pChParam);
 
-  chan->thread = Rtos_CreateThread(&NotificationThread, chan);
+  if(chan->dispatcher)
+  {
+    if(!AL_StatusDispatcher_Register(chan->dispatcher, chan->fd, &OnStatusReady, NULL, chan))
+      goto fail_open;
+  }
+  else
+  {
+    chan->thread = Rtos_CreateNamedThread(&NotificationThread, chan, "al_dec_status");
 
-  if(!chan->thread)
-    goto fail_open;
+    if(!chan->thread)
+      goto fail_open;
+  }
 
   decChanMcu->chanIsConfigured = true;
   return AL_SUCCESS;
@@ -460,6 +549,7 @@ static void DecChannelMcu_SearchSC(AL_TIDecChannel* pDecChannel, AL_TScParam* pS
   pMsg->bEnded = false;
   pMsg->endStartCodeCB = endStartCodeCB;
   pMsg->driver = decChanMcu->driver;
+  pMsg->decChanMcu = decChanMcu;
   pMsg->fd = AL_Driver_Open(pMsg->driver, deviceFile);
 
   if(pMsg->fd < 0)
@@ -477,6 +567,21 @@ static void DecChannelMcu_SearchSC(AL_TIDecChannel* pDecChannel, AL_TScParam* pS
     goto fail_open;
   }
 
+  if(decChanMcu->dispatcher)
+  {
+    Rtos_AtomicIncrement(&decChanMcu->iPendingSC);
+
+    if(!AL_StatusDispatcher_Register(decChanMcu->dispatcher, pMsg->fd, &OnScStatusReady, &OnScStatusDone, pMsg))
+    {
+      fprintf(stderr, "Cannot watch start code status\n");
+      Rtos_AtomicDecrement(&decChanMcu->iPendingSC);
+      goto fail_open;
+    }
+
+    Rtos_Free(pEvent);
+    return;
+  }
+
   pEvent->pPriv = pMsg;
   AL_EventQueue_Push(pEventQueue, pEvent);
 
@@ -542,13 +647,14 @@ static const AL_TIDecChannelVtable DecChannelMcu =
   DecChannelMcu_DecodeOneSlice,
 };
 
-AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
+AL_TIDecChannel* AL_DecChannelMcu_CreateWithDispatcher(AL_TDriver* driver, AL_TStatusDispatcher* pDispatcher)
 {
   struct DecChanMcuCtx* decChannel = Rtos_Malloc(sizeof(*decChannel));
 
   if(!decChannel)
     return NULL;
   decChannel->vtable = &DecChannelMcu;
+  decChannel->dispatcher = pDispatcher;
 
   if(!DecChannelMcu_Init(decChannel))
   {
@@ -561,8 +667,19 @@ AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
   return (AL_TIDecChannel*)decChannel;
 }
 
+AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
+{
+  return AL_DecChannelMcu_CreateWithDispatcher(driver, NULL);
+}
+
 #else
 
+AL_TIDecChannel* AL_DecChannelMcu_CreateWithDispatcher(AL_TDriver* driver, AL_TStatusDispatcher* pDispatcher)
+{
+  (void)driver, (void)pDispatcher;
+  return NULL;
+}
+
 AL_TIDecChannel* AL_DecChannelMcu_Create(AL_TDriver* driver)
 {
   (void)driver;
@@ -166,7 +166,7 @@ static void Slave_EntryPoint(AL_TDecoderFeeder* slave)
 
 static bool CreateSlave(AL_TDecoderFeeder* this)
 {
-  this->slave = Rtos_CreateThread((void*)&Slave_EntryPoint, this);
+  this->slave = Rtos_CreateNamedThread((void*)&Slave_EntryPoint, this, "al_dec_feeder");
 
   if(!this->slave)
     return false;
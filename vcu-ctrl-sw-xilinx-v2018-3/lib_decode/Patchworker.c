@@ -137,9 +137,10 @@ size_t AL_Patchworker_CopyBuffer(AL_TPatchworker* this, AL_TBuffer* pBuf, size_t
   {
     if(pMeta->bLastBuffer)
       this->endOfOutput = true;
-    AL_TMetaData* m = (AL_TMetaData*)pMeta;
-    AL_Buffer_RemoveMetaData(pBuf, m);
-    m->MetaDestroy(m);
+    /* keep the consumed meta attached, the next push of this buffer reuses it */
+    pMeta->iOffset = 0;
+    pMeta->iAvailSize = 0;
+    pMeta->bLastBuffer = false;
   }
 
   *pCopiedSize = zCopiedSize;
@@ -39,6 +39,7 @@
 #include "lib_encode/SchedulerMcu.h"
 #include "lib_encode/ISchedulerCommon.h"
 #include "lib_common/IDriver.h"
+#include "lib_common/StatusDispatcher.h"
 
 #include "lib_rtos/lib_rtos.h"
 #include "lib_fpga/DmaAlloc.h"
@@ -49,6 +50,7 @@ typedef struct al_t_SchedulerMcu
   const TSchedulerVtable* vtable;
   AL_TAllocator* allocator;
   AL_TDriver* driver;
+  AL_TStatusDispatcher* dispatcher;
 }AL_TSchedulerMcu;
 
 typedef struct
@@ -56,6 +58,7 @@ typedef struct
   AL_TISchedulerCallBacks CBs;
   AL_TCommonChannelInfo info;
   AL_TDriver* driver;
+  AL_TStatusDispatcher* dispatcher;
   int fd;
   AL_THREAD thread;
   int32_t shouldContinue;
@@ -76,6 +79,7 @@ typedef struct
 
 static const char* deviceFile = "/dev/allegroIP";
 static void* WaitForStatus(void* p);
+static bool OnStatusReady(void* p);
 
 static void setChannelFeedback(AL_TEncChanParam* pChParam, struct al5_channel_status* msg)
 {
@@ -106,6 +110,7 @@ static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEnc
   Rtos_Memset(chan, 0, sizeof(*chan));
 
   chan->driver = schedulerMcu->driver;
+  chan->dispatcher = schedulerMcu->dispatcher;
   chan->fd = AL_Driver_Open(chan->driver, deviceFile);
 
   if(chan->fd < 0)
@@ -138,10 +143,19 @@ static AL_ERR createChannel(AL_HANDLE* hChannel, TScheduler* pScheduler, AL_TEnc
   setChannelFeedback(pChParam, &msg.status);
   setCallbacks(chan, pCBs);
   chan->shouldContinue = 1;
-  chan->thread = Rtos_CreateThread(&WaitForStatus, chan);
 
-  if(!chan->thread)
-    goto fail;
+  if(chan->dispatcher)
+  {
+    if(!AL_StatusDispatcher_Register(chan->dispatcher, chan->fd, &OnStatusReady, NULL, chan))
+      goto fail;
+  }
+  else
+  {
+    chan->thread = Rtos_CreateNamedThread(&WaitForStatus, chan, "al_enc_status");
+
+    if(!chan->thread)
+      goto fail;
+  }
 
   SetChannelInfo(&chan->info, pChParam);
   *hChannel = (AL_HANDLE)chan;
@@ -194,9 +208,14 @@ static bool destroyChannel(TScheduler* pScheduler, AL_HANDLE hChannel)
 
   AL_Driver_PostMessage(schedulerMcu->driver, chan->fd, AL_MCU_DESTROY_CHANNEL, NULL);
 
-  if(!Rtos_JoinThread(chan->thread))
-    return false;
-  Rtos_DeleteThread(chan->thread);
+  if(chan->dispatcher)
+    AL_StatusDispatcher_Unregister(chan->dispatcher, chan->fd);
+  else
+  {
+    if(!Rtos_JoinThread(chan->thread))
+      return false;
+    Rtos_DeleteThread(chan->thread);
+  }
 
   AL_Driver_Close(schedulerMcu->driver, chan->fd);
 
@@ -295,6 +314,23 @@ static void* WaitForStatus(void* p)
   return 0;
 }
 
+/* the fd is readable: the status can be fetched without blocking.
+ * As WaitForStatus, a failed fetch is retried until the channel is destroyed */
+static bool OnStatusReady(void* p)
+{
+  Channel* chan = p;
+  struct al5_params msg = { 0 };
+
+  if(Rtos_AtomicDecrement(&chan->shouldContinue) < 0)
+    return false;
+  Rtos_AtomicIncrement(&chan->shouldContinue);
+
+  if(getStatusMsg(chan, &msg))
+    processStatusMsg(chan, &msg);
+
+  return true;
+}
+
 static void destroy(TScheduler* pScheduler)
 {
   Rtos_Free((AL_TSchedulerMcu*)pScheduler);
@@ -337,7 +373,7 @@ static const TSchedulerVtable McuSchedulerVtable =
   &releaseRecPicture,
 };
 
-TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator)
+TScheduler* AL_SchedulerMcu_CreateWithDispatcher(AL_TDriver* driver, AL_TAllocator* pDmaAllocator, AL_TStatusDispatcher* pDispatcher)
 {
   AL_TSchedulerMcu* scheduler = Rtos_Malloc(sizeof(*scheduler));
 
@@ -346,11 +382,23 @@ TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAlloca
   scheduler->vtable = &McuSchedulerVtable;
   scheduler->driver = driver;
   scheduler->allocator = pDmaAllocator;
+  scheduler->dispatcher = pDispatcher;
   return (TScheduler*)scheduler;
 }
 
+TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator)
+{
+  return AL_SchedulerMcu_CreateWithDispatcher(driver, pDmaAllocator, NULL);
+}
+
 #else
 
+TScheduler* AL_SchedulerMcu_CreateWithDispatcher(AL_TDriver* driver, AL_TAllocator* pDmaAllocator, AL_TStatusDispatcher* pDispatcher)
+{
+  (void)driver, (void)pDmaAllocator, (void)pDispatcher;
+  return NULL;
+}
+
 TScheduler* AL_SchedulerMcu_Create(AL_TDriver* driver, AL_TAllocator* pDmaAllocator)
 {
   (void)driver, (void)pDmaAllocator;
@@ -40,6 +40,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include "lib_rtos/types.h"
 #include <assert.h>
 #include "lib_rtos/lib_rtos.h"
@@ -49,148 +50,369 @@
 struct FileDesc
 {
   char* filename;
-  int iRefCount;
+  uint32_t uNameHash;
+  /* 0 once the device is closed: the fast path can't take a reference anymore
+   * and leaves the reopening to the slow path */
+  int32_t iRefCount;
   int fd;
 };
 
-#define POOL_SIZE 32
+#define POOL_MIN_BUCKETS 32
+#define POOL_MIN_FDS 64
 
+/* open addressing on the name hash. The entries are never removed */
+struct NameTable
+{
+  size_t zNumBuckets; /* power of 2 */
+  struct NameTable* pRetired; /* the smaller table it replaced */
+  struct FileDesc* pBuckets[];
+};
+
+/* indexed by fd */
+struct FdTable
+{
+  int iNumFds;
+  struct FdTable* pRetired;
+  struct FileDesc* pByFd[];
+};
+
+/* Open and Close take no lock when the device is already opened: they look
+ * the entry up in the published tables and take or release a reference with
+ * a compare and swap. The lock serializes the first open and the last close
+ * of a device and the growth of the tables.
+ * An entry is only freed at exit: a closed device keeps its entry, without
+ * reference, and is reopened in it. A grown table is published whole, the
+ * table it replaces stays valid for the lookups still reading it. */
 struct DevicePool
 {
-  struct FileDesc pPool[POOL_SIZE];
-  AL_MUTEX pLock;
+  struct NameTable* pNames;
+  struct FdTable* pFds;
+  size_t zNumEntries;
+  pthread_mutex_t Lock;
 };
 
+static uint32_t HashName(const char* filename)
+{
+  /* FNV-1a */
+  uint32_t uHash = 2166136261U;
+
+  for(; *filename; ++filename)
+  {
+    uHash ^= (uint8_t)*filename;
+    uHash *= 16777619U;
+  }
+
+  return uHash;
+}
+
+static struct NameTable* DevicePool_AllocNames(size_t zNumBuckets)
+{
+  size_t zSize = sizeof(struct NameTable) + zNumBuckets * sizeof(struct FileDesc*);
+  struct NameTable* pNames = malloc(zSize);
+
+  if(pNames)
+  {
+    memset(pNames, 0, zSize);
+    pNames->zNumBuckets = zNumBuckets;
+  }
+
+  return pNames;
+}
+
+static struct FdTable* DevicePool_AllocFds(int iNumFds)
+{
+  size_t zSize = sizeof(struct FdTable) + iNumFds * sizeof(struct FileDesc*);
+  struct FdTable* pFds = malloc(zSize);
+
+  if(pFds)
+  {
+    memset(pFds, 0, zSize);
+    pFds->iNumFds = iNumFds;
+  }
+
+  return pFds;
+}
+
 static bool DevicePool_Init(struct DevicePool* pDP)
 {
-  pDP->pLock = Rtos_CreateMutex();
+  pDP->zNumEntries = 0;
+  pDP->pNames = DevicePool_AllocNames(POOL_MIN_BUCKETS);
+  pDP->pFds = DevicePool_AllocFds(POOL_MIN_FDS);
 
-  if(!pDP->pLock)
+  if(!pDP->pNames || !pDP->pFds || pthread_mutex_init(&pDP->Lock, NULL) != 0)
+  {
+    free(pDP->pNames);
+    free(pDP->pFds);
+    pDP->pNames = NULL;
+    pDP->pFds = NULL;
     return false;
+  }
 
   return true;
 }
 
 static void DevicePool_Deinit(struct DevicePool* pDP)
 {
-  if(pDP->pLock)
-    Rtos_DeleteMutex(pDP->pLock);
-  pDP->pLock = NULL;
+  if(!pDP->pNames)
+    return;
+
+  for(size_t i = 0; i < pDP->pNames->zNumBuckets; ++i)
+  {
+    struct FileDesc* pCur = pDP->pNames->pBuckets[i];
+
+    if(!pCur)
+      continue;
+
+    if(pCur->iRefCount > 0)
+      close(pCur->fd);
+    free(pCur->filename);
+    free(pCur);
+  }
+
+  while(pDP->pNames)
+  {
+    struct NameTable* pRetired = pDP->pNames->pRetired;
+    free(pDP->pNames);
+    pDP->pNames = pRetired;
+  }
+
+  while(pDP->pFds)
+  {
+    struct FdTable* pRetired = pDP->pFds->pRetired;
+    free(pDP->pFds);
+    pDP->pFds = pRetired;
+  }
+
+  pthread_mutex_destroy(&pDP->Lock);
+}
+
+/* takes a reference, unless the device is closed */
+static bool DevicePool_TryRef(struct FileDesc* pEntry)
+{
+  int32_t iRefCount = __atomic_load_n(&pEntry->iRefCount, __ATOMIC_RELAXED);
+
+  while(iRefCount > 0)
+  {
+    if(__atomic_compare_exchange_n(&pEntry->iRefCount, &iRefCount, iRefCount + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return true;
+  }
+
+  return false;
+}
+
+/* releases a reference, unless it is the last one */
+static bool DevicePool_TryUnref(struct FileDesc* pEntry)
+{
+  int32_t iRefCount = __atomic_load_n(&pEntry->iRefCount, __ATOMIC_RELAXED);
+
+  while(iRefCount > 1)
+  {
+    if(__atomic_compare_exchange_n(&pEntry->iRefCount, &iRefCount, iRefCount - 1, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+      return true;
+  }
+
+  return false;
+}
+
+/* releases a reference, returns the count before the release */
+static int32_t DevicePool_Unref(struct FileDesc* pEntry)
+{
+  int32_t iRefCount = __atomic_load_n(&pEntry->iRefCount, __ATOMIC_RELAXED);
+
+  while(iRefCount > 0)
+  {
+    if(__atomic_compare_exchange_n(&pEntry->iRefCount, &iRefCount, iRefCount - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      break;
+  }
+
+  return iRefCount;
 }
 
 static struct FileDesc* DevicePool_FindEntryByFd(struct DevicePool* pDP, int fd)
 {
-  size_t i;
-  struct FileDesc* pCur;
+  struct FdTable* pFds = __atomic_load_n(&pDP->pFds, __ATOMIC_ACQUIRE);
 
-  for(i = 0; i < POOL_SIZE; ++i)
+  if(fd < 0 || fd >= pFds->iNumFds)
+    return NULL;
+
+  return __atomic_load_n(&pFds->pByFd[fd], __ATOMIC_ACQUIRE);
+}
+
+static struct FileDesc* DevicePool_FindEntryByName(struct DevicePool* pDP, const char* filename, uint32_t uNameHash)
+{
+  struct NameTable* pNames = __atomic_load_n(&pDP->pNames, __ATOMIC_ACQUIRE);
+  size_t zMask = pNames->zNumBuckets - 1;
+
+  for(size_t i = uNameHash & zMask;; i = (i + 1) & zMask)
   {
-    pCur = &pDP->pPool[i];
+    struct FileDesc* pCur = __atomic_load_n(&pNames->pBuckets[i], __ATOMIC_ACQUIRE);
+
+    if(!pCur)
+      return NULL;
 
-    if(pCur->iRefCount && fd == pCur->fd)
+    if(pCur->uNameHash == uNameHash && strcmp(filename, pCur->filename) == 0)
       return pCur;
   }
+}
+
+/* the following functions are called with the lock taken */
+
+static void DevicePool_LinkName(struct NameTable* pNames, struct FileDesc* pEntry)
+{
+  size_t zMask = pNames->zNumBuckets - 1;
+  size_t i = pEntry->uNameHash & zMask;
 
-  return NULL;
+  while(pNames->pBuckets[i])
+    i = (i + 1) & zMask;
+
+  __atomic_store_n(&pNames->pBuckets[i], pEntry, __ATOMIC_RELEASE);
 }
 
-static struct FileDesc* DevicePool_FindEntryByName(struct DevicePool* pDP, const char* filename)
+static bool DevicePool_AddEntry(struct DevicePool* pDP, struct FileDesc* pEntry)
 {
-  size_t i;
-  struct FileDesc* pCur;
+  struct NameTable* pNames = pDP->pNames;
 
-  for(i = 0; i < POOL_SIZE; ++i)
+  if(pDP->zNumEntries + 1 > pNames->zNumBuckets * 3 / 4)
   {
-    pCur = &pDP->pPool[i];
+    struct NameTable* pGrown = DevicePool_AllocNames(pNames->zNumBuckets * 2);
 
-    if(pCur->iRefCount > 0 && strcmp(filename, pCur->filename) == 0)
-      return pCur;
+    if(!pGrown)
+      return false;
+
+    for(size_t i = 0; i < pNames->zNumBuckets; ++i)
+    {
+      if(pNames->pBuckets[i])
+        DevicePool_LinkName(pGrown, pNames->pBuckets[i]);
+    }
+
+    pGrown->pRetired = pNames;
+    __atomic_store_n(&pDP->pNames, pGrown, __ATOMIC_RELEASE);
+    pNames = pGrown;
   }
 
-  return NULL;
+  DevicePool_LinkName(pNames, pEntry);
+  ++pDP->zNumEntries;
+  return true;
 }
 
-static struct FileDesc* DevicePool_FindFreeEntry(struct DevicePool* pDP)
+static bool DevicePool_SetFdEntry(struct DevicePool* pDP, int fd, struct FileDesc* pEntry)
 {
-  size_t i;
-  struct FileDesc* pCur;
+  struct FdTable* pFds = pDP->pFds;
 
-  for(i = 0; i < POOL_SIZE; ++i)
+  if(fd >= pFds->iNumFds)
   {
-    pCur = &pDP->pPool[i];
+    int iNumFds = pFds->iNumFds * 2;
 
-    if(pCur->iRefCount == 0)
-      return pCur;
+    while(iNumFds <= fd)
+      iNumFds *= 2;
+
+    struct FdTable* pGrown = DevicePool_AllocFds(iNumFds);
+
+    if(!pGrown)
+      return false;
+
+    memcpy(pGrown->pByFd, pFds->pByFd, pFds->iNumFds * sizeof(struct FileDesc*));
+    pGrown->pRetired = pFds;
+    __atomic_store_n(&pDP->pFds, pGrown, __ATOMIC_RELEASE);
+    pFds = pGrown;
   }
 
-  return NULL;
+  __atomic_store_n(&pFds->pByFd[fd], pEntry, __ATOMIC_RELEASE);
+  return true;
 }
 
 static int DevicePool_Open(struct DevicePool* pDP, const char* filename)
 {
-  int iRet = 0;
-  struct FileDesc* pCur;
+  uint32_t uNameHash = HashName(filename);
+
+  /* fast path: the device is already opened */
+  struct FileDesc* pCur = DevicePool_FindEntryByName(pDP, filename, uNameHash);
+
+  if(pCur && DevicePool_TryRef(pCur))
+    return __atomic_load_n(&pCur->fd, __ATOMIC_RELAXED);
 
-  Rtos_GetMutex(pDP->pLock);
+  int iRet = -1;
+  pthread_mutex_lock(&pDP->Lock);
 
-  pCur = DevicePool_FindEntryByName(pDP, filename);
+  /* someone else might have opened it in the meantime */
+  pCur = DevicePool_FindEntryByName(pDP, filename, uNameHash);
+
+  if(pCur && DevicePool_TryRef(pCur))
+  {
+    iRet = __atomic_load_n(&pCur->fd, __ATOMIC_RELAXED);
+    goto exit;
+  }
 
   if(!pCur)
   {
-    pCur = DevicePool_FindFreeEntry(pDP);
+    pCur = malloc(sizeof(*pCur));
 
     if(!pCur)
-    {
-      iRet = -1;
       goto exit;
-    }
 
     pCur->filename = strdup(filename);
-    pCur->fd = open(filename, O_RDWR);
+    pCur->uNameHash = uNameHash;
+    pCur->iRefCount = 0;
+    pCur->fd = -1;
 
-    if(pCur->fd < 0)
+    if(!pCur->filename || !DevicePool_AddEntry(pDP, pCur))
     {
-      iRet = -1;
       free(pCur->filename);
+      free(pCur);
       goto exit;
     }
   }
 
-  pCur->iRefCount++;
-  iRet = pCur->fd;
+  /* the entry has no reference: (re)open the device in it */
+  int fd = open(filename, O_RDWR);
+
+  if(fd < 0)
+    goto exit;
+
+  if(!DevicePool_SetFdEntry(pDP, fd, pCur))
+  {
+    close(fd);
+    goto exit;
+  }
+
+  __atomic_store_n(&pCur->fd, fd, __ATOMIC_RELAXED);
+  __atomic_store_n(&pCur->iRefCount, 1, __ATOMIC_RELEASE);
+  iRet = fd;
 
   exit:
-  Rtos_ReleaseMutex(pDP->pLock);
+  pthread_mutex_unlock(&pDP->Lock);
   return iRet;
 }
 
 static int DevicePool_Close(struct DevicePool* pDP, int fd)
 {
-  struct FileDesc* pEntry;
-  int iRet = 0;
-  Rtos_GetMutex(pDP->pLock);
-
-  pEntry = DevicePool_FindEntryByFd(pDP, fd);
+  struct FileDesc* pEntry = DevicePool_FindEntryByFd(pDP, fd);
 
+  /* We don't have this file descriptor */
   if(!pEntry)
-  {
-    /* We don't have this file descriptor */
-    iRet = -1;
-    goto exit;
-  }
+    return -1;
 
-  assert(pEntry->iRefCount > 0);
+  /* fast path: not the last reference */
+  if(DevicePool_TryUnref(pEntry))
+    return 0;
 
-  pEntry->iRefCount -= 1;
+  int iRet = 0;
+  pthread_mutex_lock(&pDP->Lock);
+
+  /* the lock doesn't stop the fast path of Open: the count can still go up */
+  int32_t iRefCount = DevicePool_Unref(pEntry);
+  assert(iRefCount > 0);
 
-  if(pEntry->iRefCount == 0)
+  if(iRefCount == 1)
   {
-    free(pEntry->filename);
-    iRet = close(pEntry->fd);
+    DevicePool_SetFdEntry(pDP, fd, NULL);
+    __atomic_store_n(&pEntry->fd, -1, __ATOMIC_RELAXED);
+    iRet = close(fd);
   }
+  else if(iRefCount <= 0)
+    iRet = -1;
 
-  exit:
-  Rtos_ReleaseMutex(pDP->pLock);
+  pthread_mutex_unlock(&pDP->Lock);
 
   return iRet;
 }
@@ -199,6 +421,7 @@ static int DevicePool_Close(struct DevicePool* pDP, int fd)
 
 #include <stdlib.h>
 
+static pthread_once_t g_DevicePoolOnce = PTHREAD_ONCE_INIT;
 static bool g_DevicePoolInit;
 static struct DevicePool g_DevicePool;
 
@@ -209,25 +432,29 @@ void AL_DevicePool_Deinit()
 }
 
 static
-bool AL_DevicePool_Init()
+void AL_DevicePool_Init()
 {
-  atexit(&AL_DevicePool_Deinit);
-  return DevicePool_Init(&g_DevicePool);
+  g_DevicePoolInit = DevicePool_Init(&g_DevicePool);
+
+  if(g_DevicePoolInit)
+    atexit(&AL_DevicePool_Deinit);
 }
 
 int AL_DevicePool_Open(const char* filename)
 {
+  pthread_once(&g_DevicePoolOnce, &AL_DevicePool_Init);
+
   if(!g_DevicePoolInit)
-  {
-    AL_DevicePool_Init();
-    g_DevicePoolInit = true;
-  }
+    return -1;
 
   return DevicePool_Open(&g_DevicePool, filename);
 }
 
 int AL_DevicePool_Close(int fd)
 {
+  if(!g_DevicePoolInit)
+    return -1;
+
   return DevicePool_Close(&g_DevicePool, fd);
 }
 
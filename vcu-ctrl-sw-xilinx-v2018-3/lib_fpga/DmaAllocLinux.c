@@ -49,6 +49,7 @@
 #include "lib_rtos/types.h"
 #include "allegro_ioctl_reg.h"
 #include "DevicePool.h"
+#include "DmaImportCache.h"
 
 #if 0
 static void LogAllocation(struct DmaBuffer* p)
@@ -70,6 +71,7 @@ struct DmaBuffer
   size_t offset;
   size_t mmap_offset; /* used by non-dmabuf */
   bool shouldCloseFd;
+  struct DmaImport* pImport;
 };
 
 #define MAX_DEVICE_FILE_NAME 30
@@ -78,18 +80,25 @@ struct LinuxDmaCtx
   AL_TLinuxDmaAllocator base;
   char deviceFile[MAX_DEVICE_FILE_NAME];
   int fd;
+  struct DmaImportCache importCache;
 };
 
 /******************************************************************************/
 static bool LinuxDma_Free(AL_TAllocator* pAllocator, AL_HANDLE hBuf)
 {
-  (void)pAllocator;
   struct DmaBuffer* pDmaBuffer = (struct DmaBuffer*)hBuf;
   bool bRet = true;
 
   if(!pDmaBuffer)
     return true;
 
+  if(pDmaBuffer->pImport)
+  {
+    DmaImportCache_Release(&((struct LinuxDmaCtx*)pAllocator)->importCache, pDmaBuffer->pImport);
+    free(pDmaBuffer);
+    return true;
+  }
+
   if(pDmaBuffer->vaddr && (munmap(pDmaBuffer->vaddr - pDmaBuffer->offset, pDmaBuffer->info.size) == -1))
   {
     bRet = false;
@@ -119,12 +128,17 @@ static AL_VADDR LinuxDma_Map(int fd, size_t zSize, size_t offset)
 /******************************************************************************/
 static AL_VADDR LinuxDma_GetVirtualAddr(AL_TAllocator* pAllocator, AL_HANDLE hBuf)
 {
-  (void)pAllocator;
   struct DmaBuffer* pDmaBuffer = (struct DmaBuffer*)hBuf;
 
   if(!pDmaBuffer)
     return NULL;
 
+  if(!pDmaBuffer->vaddr && pDmaBuffer->pImport)
+  {
+    /* the mapping is shared by all the imports of the dmabuf */
+    pDmaBuffer->vaddr = DmaImportCache_Map(&((struct LinuxDmaCtx*)pAllocator)->importCache, pDmaBuffer->pImport);
+  }
+
   if(!pDmaBuffer->vaddr)
     pDmaBuffer->vaddr = LinuxDma_Map(pDmaBuffer->info.fd, pDmaBuffer->info.size, pDmaBuffer->mmap_offset);
 
@@ -147,6 +161,9 @@ static AL_PADDR LinuxDma_GetPhysicalAddr(AL_TAllocator* pAllocator, AL_HANDLE hB
 static bool LinuxDma_Destroy(AL_TAllocator* pAllocator)
 {
   struct LinuxDmaCtx* pCtx = (struct LinuxDmaCtx*)pAllocator;
+
+  /* the imported buffers must have been freed */
+  DmaImportCache_Deinit(&pCtx->importCache);
   AL_DevicePool_Close(pCtx->fd);
   free(pCtx);
   return true;
@@ -171,6 +188,8 @@ static AL_TAllocator* create(const char* deviceFile, void const* vtable)
   if(pCtx->fd < 0)
     goto fail_open;
 
+  DmaImportCache_Init(&pCtx->importCache);
+
   return (AL_TAllocator*)pCtx;
 
   fail_open:
@@ -313,8 +332,16 @@ static size_t LinuxDma_GetDmabufSize(int fd)
   return zSize;
 }
 
+static void LinuxDma_UseImport(struct DmaImport* pImport, struct DmaBuffer* pDmaBuffer)
+{
+  pDmaBuffer->pImport = pImport;
+  pDmaBuffer->info.phy_addr = pImport->phy_addr;
+  pDmaBuffer->info.size = pImport->size;
+}
+
 static AL_HANDLE LinuxDma_ImportFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd)
 {
+  struct DmaImportCache* pCache = &((struct LinuxDmaCtx*)pAllocator)->importCache;
   struct DmaBuffer* pDmaBuffer = (struct DmaBuffer*)calloc(1, sizeof(*pDmaBuffer));
 
   if(!pDmaBuffer)
@@ -322,6 +349,16 @@ static AL_HANDLE LinuxDma_ImportFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd
 
   pDmaBuffer->info.fd = fd;
 
+  struct stat st;
+  bool bCacheable = DmaImportCache_GetIdentity(pCache, fd, &st);
+  struct DmaImport* pImport = bCacheable ? DmaImportCache_Acquire(pCache, &st) : NULL;
+
+  if(pImport)
+  {
+    LinuxDma_UseImport(pImport, pDmaBuffer);
+    return pDmaBuffer;
+  }
+
   if(!LinuxDma_GetBusAddrFromFd(pAllocator, &pDmaBuffer->info))
     goto fail;
 
@@ -333,6 +370,12 @@ static AL_HANDLE LinuxDma_ImportFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd
   pDmaBuffer->info.size = zMapSize;
   pDmaBuffer->vaddr = NULL;
 
+  if(bCacheable)
+    pImport = DmaImportCache_Add(pCache, &st, fd, pDmaBuffer->info.phy_addr, pDmaBuffer->info.size);
+
+  if(pImport)
+    LinuxDma_UseImport(pImport, pDmaBuffer);
+
   return pDmaBuffer;
 
   fail:
@@ -340,6 +383,19 @@ static AL_HANDLE LinuxDma_ImportFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd
   return NULL;
 }
 
+static void LinuxDma_GetImportStats(AL_TLinuxDmaAllocator* pAllocator, AL_TDmaImportStats* pStats)
+{
+  struct DmaImportCache* pCache = &((struct LinuxDmaCtx*)pAllocator)->importCache;
+  pthread_mutex_lock(&pCache->Lock);
+  *pStats = pCache->tStats;
+  pthread_mutex_unlock(&pCache->Lock);
+}
+
+static void LinuxDma_ForgetFd(AL_TLinuxDmaAllocator* pAllocator, int fd)
+{
+  DmaImportCache_Forget(&((struct LinuxDmaCtx*)pAllocator)->importCache, fd);
+}
+
 static const AL_DmaAllocLinuxVtable DmaAllocLinuxVtable =
 {
   {
@@ -352,6 +408,8 @@ static const AL_DmaAllocLinuxVtable DmaAllocLinuxVtable =
   },
   &LinuxDma_GetFd,
   &LinuxDma_ImportFromFd,
+  &LinuxDma_GetImportStats,
+  &LinuxDma_ForgetFd,
 };
 
 AL_TAllocator* AL_DmaAlloc_Create(const char* deviceFile)
@@ -0,0 +1,292 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "DmaImportCache.h"
+
+/******************************************************************************/
+static void DeleteImport(struct DmaImport* pImport)
+{
+  if(pImport->vaddr)
+    munmap(pImport->vaddr, pImport->size);
+  close(pImport->fd);
+  free(pImport);
+}
+
+static void Unlink(struct DmaImportCache* pCache, struct DmaImport* pImport)
+{
+  struct DmaImport** ppCur = &pCache->pHead;
+
+  while(*ppCur != pImport)
+    ppCur = &(*ppCur)->pNext;
+
+  *ppCur = pImport->pNext;
+}
+
+/* drops the least recently used idle entries beyond MAX_IDLE_IMPORTS */
+static void TrimImports(struct DmaImportCache* pCache)
+{
+  int iNumIdle = 0;
+  struct DmaImport** ppCur = &pCache->pHead;
+
+  while(*ppCur)
+  {
+    struct DmaImport* pCur = *ppCur;
+
+    if(pCur->iRefCount == 0 && ++iNumIdle > MAX_IDLE_IMPORTS)
+    {
+      *ppCur = pCur->pNext;
+      DeleteImport(pCur);
+      --pCache->iNumIdle;
+      ++pCache->tStats.uEvictions;
+      continue;
+    }
+
+    ppCur = &pCur->pNext;
+  }
+}
+
+static struct DmaImport* FindImport(struct DmaImportCache* pCache, struct stat const* pStat)
+{
+  struct DmaImport** ppCur = &pCache->pHead;
+
+  for(; *ppCur; ppCur = &(*ppCur)->pNext)
+  {
+    struct DmaImport* pCur = *ppCur;
+
+    if(pCur->ino == pStat->st_ino && pCur->dev == pStat->st_dev)
+    {
+      /* move to front */
+      *ppCur = pCur->pNext;
+      pCur->pNext = pCache->pHead;
+      pCache->pHead = pCur;
+      return pCur;
+    }
+  }
+
+  return NULL;
+}
+
+static void UseImport(struct DmaImportCache* pCache, struct DmaImport* pImport)
+{
+  if(pImport->iRefCount++ == 0)
+    --pCache->iNumIdle;
+}
+
+/******************************************************************************/
+void DmaImportCache_Init(struct DmaImportCache* pCache)
+{
+  pthread_mutex_init(&pCache->Lock, NULL);
+  pCache->pHead = NULL;
+  pCache->iNumIdle = 0;
+  pCache->bEnabled = false;
+  pCache->tStats.uHits = 0;
+  pCache->tStats.uMisses = 0;
+  pCache->tStats.uEvictions = 0;
+
+  /* eventfds live on the anonymous inode */
+  int fd = eventfd(0, EFD_CLOEXEC);
+  struct stat st;
+
+  if(fd < 0)
+    return;
+
+  if(fstat(fd, &st) == 0)
+  {
+    pCache->anonDev = st.st_dev;
+    pCache->anonIno = st.st_ino;
+    pCache->bEnabled = true;
+  }
+
+  close(fd);
+}
+
+void DmaImportCache_Deinit(struct DmaImportCache* pCache)
+{
+  while(pCache->pHead)
+  {
+    struct DmaImport* pNext = pCache->pHead->pNext;
+    DeleteImport(pCache->pHead);
+    pCache->pHead = pNext;
+  }
+
+  pthread_mutex_destroy(&pCache->Lock);
+}
+
+/******************************************************************************/
+bool DmaImportCache_GetIdentity(struct DmaImportCache* pCache, int fd, struct stat* pStat)
+{
+  if(!pCache->bEnabled || fstat(fd, pStat) != 0)
+    return false;
+
+  return !(pStat->st_ino == pCache->anonIno && pStat->st_dev == pCache->anonDev);
+}
+
+struct DmaImport* DmaImportCache_Acquire(struct DmaImportCache* pCache, struct stat const* pStat)
+{
+  pthread_mutex_lock(&pCache->Lock);
+  struct DmaImport* pImport = FindImport(pCache, pStat);
+
+  if(pImport)
+  {
+    UseImport(pCache, pImport);
+    ++pCache->tStats.uHits;
+  }
+  else
+    ++pCache->tStats.uMisses;
+
+  pthread_mutex_unlock(&pCache->Lock);
+  return pImport;
+}
+
+struct DmaImport* DmaImportCache_Add(struct DmaImportCache* pCache, struct stat const* pStat, int fd, uint32_t uPhyAddr, uint32_t uSize)
+{
+  struct DmaImport* pImport = calloc(1, sizeof(*pImport));
+
+  if(!pImport)
+    return NULL;
+
+  pImport->fd = dup(fd);
+
+  if(pImport->fd < 0)
+  {
+    free(pImport);
+    return NULL;
+  }
+
+  pImport->dev = pStat->st_dev;
+  pImport->ino = pStat->st_ino;
+  pImport->phy_addr = uPhyAddr;
+  pImport->size = uSize;
+
+  pthread_mutex_lock(&pCache->Lock);
+
+  /* another thread might have imported the same dmabuf in the meantime */
+  struct DmaImport* pExisting = FindImport(pCache, pStat);
+
+  if(pExisting)
+    UseImport(pCache, pExisting);
+  else
+  {
+    pImport->iRefCount = 1;
+    pImport->pNext = pCache->pHead;
+    pCache->pHead = pImport;
+  }
+
+  pthread_mutex_unlock(&pCache->Lock);
+
+  if(!pExisting)
+    return pImport;
+
+  DeleteImport(pImport);
+  return pExisting;
+}
+
+void DmaImportCache_Release(struct DmaImportCache* pCache, struct DmaImport* pImport)
+{
+  pthread_mutex_lock(&pCache->Lock);
+
+  if(--pImport->iRefCount > 0)
+  {
+    pthread_mutex_unlock(&pCache->Lock);
+    return;
+  }
+
+  if(pImport->bForgotten)
+  {
+    Unlink(pCache, pImport);
+    pthread_mutex_unlock(&pCache->Lock);
+    DeleteImport(pImport);
+    return;
+  }
+
+  if(++pCache->iNumIdle > MAX_IDLE_IMPORTS)
+    TrimImports(pCache);
+
+  pthread_mutex_unlock(&pCache->Lock);
+}
+
+AL_VADDR DmaImportCache_Map(struct DmaImportCache* pCache, struct DmaImport* pImport)
+{
+  pthread_mutex_lock(&pCache->Lock);
+
+  if(!pImport->vaddr)
+  {
+    AL_VADDR vaddr = (AL_VADDR)mmap(0, pImport->size, PROT_READ | PROT_WRITE, MAP_SHARED, pImport->fd, 0);
+
+    if(vaddr == MAP_FAILED)
+      perror("MAP_FAILED");
+    else
+      pImport->vaddr = vaddr;
+  }
+
+  AL_VADDR vaddr = pImport->vaddr;
+  pthread_mutex_unlock(&pCache->Lock);
+  return vaddr;
+}
+
+void DmaImportCache_Forget(struct DmaImportCache* pCache, int fd)
+{
+  struct stat st;
+
+  if(!DmaImportCache_GetIdentity(pCache, fd, &st))
+    return;
+
+  pthread_mutex_lock(&pCache->Lock);
+  struct DmaImport* pImport = FindImport(pCache, &st);
+  bool bIdle = pImport && pImport->iRefCount == 0;
+
+  if(bIdle)
+  {
+    Unlink(pCache, pImport);
+    --pCache->iNumIdle;
+  }
+  else if(pImport)
+    pImport->bForgotten = true;
+
+  pthread_mutex_unlock(&pCache->Lock);
+
+  if(bIdle)
+    DeleteImport(pImport);
+}
+
@@ -0,0 +1,101 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "lib_rtos/types.h"
+#include "lib_fpga/DmaAllocLinux.h"
+
+/* An imported dmabuf, identified by its inode. The entry keeps its own
+ * reference on the dmabuf so that the identity can't be reused while the
+ * entry lives. */
+struct DmaImport
+{
+  dev_t dev;
+  ino_t ino;
+  int fd;
+  uint32_t phy_addr;
+  uint32_t size;
+  AL_VADDR vaddr;
+  int iRefCount; /* number of buffers using the entry */
+  bool bForgotten; /* deleted with its last buffer instead of kept idle */
+  struct DmaImport* pNext;
+};
+
+/* entries not used by any buffer are released beyond this number */
+#define MAX_IDLE_IMPORTS 32
+
+struct DmaImportCache
+{
+  pthread_mutex_t Lock;
+  struct DmaImport* pHead; /* most recently used first */
+  int iNumIdle;
+  /* dmabufs of old kernels share the anonymous inode: no identity then */
+  bool bEnabled;
+  dev_t anonDev;
+  ino_t anonIno;
+  AL_TDmaImportStats tStats;
+};
+
+void DmaImportCache_Init(struct DmaImportCache* pCache);
+/* the imported buffers must have been freed */
+void DmaImportCache_Deinit(struct DmaImportCache* pCache);
+
+/* false when the dmabuf of fd has no identity the cache can use */
+bool DmaImportCache_GetIdentity(struct DmaImportCache* pCache, int fd, struct stat* pStat);
+
+/* Returns the entry of the dmabuf with one more user, or NULL on a miss */
+struct DmaImport* DmaImportCache_Acquire(struct DmaImportCache* pCache, struct stat const* pStat);
+
+/* Adds the dmabuf queried from fd and returns its entry with one user.
+ * Returns the entry of another thread if it added the same dmabuf meanwhile,
+ * NULL if the entry couldn't be created */
+struct DmaImport* DmaImportCache_Add(struct DmaImportCache* pCache, struct stat const* pStat, int fd, uint32_t uPhyAddr, uint32_t uSize);
+
+/* One user less: the entry is kept idle, up to MAX_IDLE_IMPORTS of them */
+void DmaImportCache_Release(struct DmaImportCache* pCache, struct DmaImport* pImport);
+
+/* Maps the entry once for all its users */
+AL_VADDR DmaImportCache_Map(struct DmaImportCache* pCache, struct DmaImport* pImport);
+
+/* The dmabuf of fd is about to be freed by its owner: its entry doesn't
+ * outlive its last user */
+void DmaImportCache_Forget(struct DmaImportCache* pCache, int fd);
+
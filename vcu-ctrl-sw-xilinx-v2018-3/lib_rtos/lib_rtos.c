@@ -35,20 +35,416 @@
 *
 ******************************************************************************/
 
+#if defined __linux__ && !defined _GNU_SOURCE
+#define _GNU_SOURCE // thread names and affinities
+#endif
+
 #include "lib_rtos/lib_rtos.h"
 
 #ifndef ENABLE_RTOS_SYNC
 #define ENABLE_RTOS_SYNC 1
 #endif
 
+/* pooled small allocations behind Rtos_Malloc, enabled with Rtos_EnableMallocPool.
+ * Not built by default: once built, every block carries a header, even while
+ * the pool is disabled. Linux only */
+#ifndef ENABLE_RTOS_POOL
+#define ENABLE_RTOS_POOL 0
+#endif
+
 /****************************************************************************/
 /*** W i n 3 2  &  L i n u x c o m m o n ***/
 /****************************************************************************/
 #if defined _WIN32 || defined __linux__
 
 #include <string.h>
+#include <stdlib.h>
 #include <malloc.h>
 
+/****************************************************************************/
+/*** P o o l e d  m a l l o c ***/
+/****************************************************************************/
+#if ENABLE_RTOS_POOL
+
+#include <pthread.h>
+#include <assert.h>
+
+/* The small blocks are recycled through a cache owned by each thread, which
+ * only goes to the shared depot of the size class, by batches, when it is
+ * empty or holds too many blocks. The chunks the blocks are carved from are
+ * kept for the process lifetime.
+ *
+ * Every block, pooled or not, starts with a header giving its size class, so
+ * that Rtos_Free doesn't depend on the pool state at allocation time. The
+ * header size keeps the alignment malloc gives. */
+#define POOL_HEADER_SIZE 16
+#define POOL_NUM_CLASSES 12
+#define POOL_LARGE ((uint32_t)-1)
+#define POOL_CHUNK_SIZE (64 * 1024)
+#define POOL_CACHE_MAX 64 /* blocks of a class a thread keeps */
+#define POOL_BATCH 32 /* blocks moved at once between a cache and the depot */
+
+static size_t const poolClassSizes[POOL_NUM_CLASSES] =
+{
+  16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 1024, 2048
+};
+
+typedef struct PoolBlock
+{
+  struct PoolBlock* pNext; /* only meaningful while the block is free */
+  uint32_t uClass;
+}PoolBlock;
+
+typedef struct
+{
+  PoolBlock* pHead;
+  int iCount;
+}PoolList;
+
+typedef struct
+{
+  pthread_mutex_t Lock;
+  PoolList tFree;
+}PoolDepot;
+
+typedef struct PoolCache
+{
+  PoolList lists[POOL_NUM_CLASSES];
+  AL_TRtosMallocStats tStats; /* only written by the owner thread */
+  struct PoolCache* pPrev;
+  struct PoolCache* pNext;
+}PoolCache;
+
+enum
+{
+  POOL_THREAD_NEW,
+  POOL_THREAD_LIVE,
+  POOL_THREAD_EXITED, /* the cache is gone: use the depots directly */
+};
+
+static bool bPoolEnabled;
+static PoolDepot poolDepots[POOL_NUM_CLASSES];
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t poolKey;
+static pthread_mutex_t poolStatsLock = PTHREAD_MUTEX_INITIALIZER;
+static PoolCache* pPoolCaches; /* live thread caches, for the statistics */
+static AL_TRtosMallocStats poolExitedStats; /* accumulated from the exited threads */
+static AL_TRtosMallocStats poolSharedStats; /* counted under a depot lock */
+
+static __thread PoolCache* pThreadCache;
+static __thread int iThreadState;
+
+#define POOL_MAX_SIZE 2048
+#define POOL_GRANULE 16
+static uint8_t poolClassOf[POOL_MAX_SIZE / POOL_GRANULE + 1]; /* by size rounded up to the granule */
+
+/****************************************************************************/
+static uint32_t PoolGetClass(size_t zSize)
+{
+  if(zSize > POOL_MAX_SIZE)
+    return POOL_LARGE;
+
+  return poolClassOf[(zSize + POOL_GRANULE - 1) / POOL_GRANULE];
+}
+
+/****************************************************************************/
+static void PoolCount(AL_64U* pCounter, AL_64U uInc)
+{
+  /* the owner is the only writer, readers may be on other threads */
+  __atomic_store_n(pCounter, *pCounter + uInc, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************/
+static void PoolAddStats(AL_TRtosMallocStats* pTotal, AL_TRtosMallocStats* pStats)
+{
+  pTotal->uAllocs += __atomic_load_n(&pStats->uAllocs, __ATOMIC_RELAXED);
+  pTotal->uFrees += __atomic_load_n(&pStats->uFrees, __ATOMIC_RELAXED);
+  pTotal->uCacheHits += __atomic_load_n(&pStats->uCacheHits, __ATOMIC_RELAXED);
+  pTotal->uDepotFetches += __atomic_load_n(&pStats->uDepotFetches, __ATOMIC_RELAXED);
+  pTotal->uDepotReturns += __atomic_load_n(&pStats->uDepotReturns, __ATOMIC_RELAXED);
+  pTotal->uLargeAllocs += __atomic_load_n(&pStats->uLargeAllocs, __ATOMIC_RELAXED);
+  pTotal->zChunkBytes += __atomic_load_n(&pStats->zChunkBytes, __ATOMIC_RELAXED);
+}
+
+/****************************************************************************/
+/* moves up to iMax blocks from the head of pSrc to the head of pDst */
+static int PoolMoveBlocks(PoolList* pDst, PoolList* pSrc, int iMax)
+{
+  if(!pSrc->pHead || iMax <= 0)
+    return 0;
+
+  PoolBlock* pFirst = pSrc->pHead;
+  PoolBlock* pLast = pFirst;
+  int iMoved = 1;
+
+  while(iMoved < iMax && pLast->pNext)
+  {
+    pLast = pLast->pNext;
+    ++iMoved;
+  }
+
+  pSrc->pHead = pLast->pNext;
+  pSrc->iCount -= iMoved;
+  pLast->pNext = pDst->pHead;
+  pDst->pHead = pFirst;
+  pDst->iCount += iMoved;
+  return iMoved;
+}
+
+/****************************************************************************/
+/* called with the depot lock held */
+static bool PoolAddChunk(PoolDepot* pDepot, uint32_t uClass)
+{
+  size_t zBlockSize = POOL_HEADER_SIZE + poolClassSizes[uClass];
+  uint8_t* pChunk = (uint8_t*)malloc(POOL_CHUNK_SIZE);
+
+  if(!pChunk)
+    return false;
+
+  for(size_t zOffset = 0; zOffset + zBlockSize <= POOL_CHUNK_SIZE; zOffset += zBlockSize)
+  {
+    PoolBlock* pBlock = (PoolBlock*)(pChunk + zOffset);
+    pBlock->uClass = uClass;
+    pBlock->pNext = pDepot->tFree.pHead;
+    pDepot->tFree.pHead = pBlock;
+    ++pDepot->tFree.iCount;
+  }
+
+  __atomic_add_fetch(&poolSharedStats.zChunkBytes, POOL_CHUNK_SIZE, __ATOMIC_RELAXED);
+  return true;
+}
+
+/****************************************************************************/
+static int PoolFetch(PoolList* pList, uint32_t uClass, int iMax)
+{
+  PoolDepot* pDepot = &poolDepots[uClass];
+  pthread_mutex_lock(&pDepot->Lock);
+
+  if(!pDepot->tFree.pHead)
+    PoolAddChunk(pDepot, uClass);
+
+  int iMoved = PoolMoveBlocks(pList, &pDepot->tFree, iMax);
+  pthread_mutex_unlock(&pDepot->Lock);
+  return iMoved;
+}
+
+/****************************************************************************/
+static void PoolReturn(PoolList* pList, uint32_t uClass, int iMax)
+{
+  PoolDepot* pDepot = &poolDepots[uClass];
+  pthread_mutex_lock(&pDepot->Lock);
+  PoolMoveBlocks(&pDepot->tFree, pList, iMax);
+  pthread_mutex_unlock(&pDepot->Lock);
+}
+
+/****************************************************************************/
+static void PoolDestroyCache(void* pParam)
+{
+  PoolCache* pCache = (PoolCache*)pParam;
+
+  for(uint32_t uClass = 0; uClass < POOL_NUM_CLASSES; ++uClass)
+    PoolReturn(&pCache->lists[uClass], uClass, pCache->lists[uClass].iCount);
+
+  pthread_mutex_lock(&poolStatsLock);
+  PoolAddStats(&poolExitedStats, &pCache->tStats);
+
+  if(pCache->pPrev)
+    pCache->pPrev->pNext = pCache->pNext;
+  else
+    pPoolCaches = pCache->pNext;
+
+  if(pCache->pNext)
+    pCache->pNext->pPrev = pCache->pPrev;
+  pthread_mutex_unlock(&poolStatsLock);
+
+  free(pCache);
+  pThreadCache = NULL;
+  iThreadState = POOL_THREAD_EXITED;
+}
+
+/****************************************************************************/
+static void PoolInit(void)
+{
+  uint32_t uClass = 0;
+
+  for(size_t i = 0; i < sizeof(poolClassOf); ++i)
+  {
+    while(i * POOL_GRANULE > poolClassSizes[uClass])
+      ++uClass;
+
+    poolClassOf[i] = (uint8_t)uClass;
+  }
+
+  for(int i = 0; i < POOL_NUM_CLASSES; ++i)
+    pthread_mutex_init(&poolDepots[i].Lock, NULL);
+
+  pthread_key_create(&poolKey, PoolDestroyCache);
+}
+
+/****************************************************************************/
+static PoolCache* PoolGetCache(void)
+{
+  if(pThreadCache || iThreadState != POOL_THREAD_NEW)
+    return pThreadCache;
+
+  pthread_once(&poolOnce, PoolInit);
+  PoolCache* pCache = (PoolCache*)calloc(1, sizeof(PoolCache));
+
+  if(!pCache)
+    return NULL;
+
+  pthread_mutex_lock(&poolStatsLock);
+  pCache->pNext = pPoolCaches;
+
+  if(pPoolCaches)
+    pPoolCaches->pPrev = pCache;
+  pPoolCaches = pCache;
+  pthread_mutex_unlock(&poolStatsLock);
+
+  /* the key destructor gives the blocks back when the thread exits */
+  pthread_setspecific(poolKey, pCache);
+  pThreadCache = pCache;
+  iThreadState = POOL_THREAD_LIVE;
+  return pCache;
+}
+
+/****************************************************************************/
+static void* PoolMallocLarge(size_t zSize)
+{
+  if(zSize > SIZE_MAX - POOL_HEADER_SIZE)
+    return NULL;
+
+  PoolBlock* pBlock = (PoolBlock*)malloc(POOL_HEADER_SIZE + zSize);
+
+  if(!pBlock)
+    return NULL;
+
+  pBlock->uClass = POOL_LARGE;
+  return (uint8_t*)pBlock + POOL_HEADER_SIZE;
+}
+
+/****************************************************************************/
+void* Rtos_Malloc(size_t zSize)
+{
+  if(!__atomic_load_n(&bPoolEnabled, __ATOMIC_RELAXED))
+    return PoolMallocLarge(zSize);
+
+  PoolCache* pCache = PoolGetCache();
+  uint32_t uClass = PoolGetClass(zSize);
+
+  if(pCache)
+    PoolCount(&pCache->tStats.uAllocs, 1);
+
+  if(uClass == POOL_LARGE)
+  {
+    if(pCache)
+      PoolCount(&pCache->tStats.uLargeAllocs, 1);
+    return PoolMallocLarge(zSize);
+  }
+
+  PoolBlock* pBlock = NULL;
+
+  if(pCache)
+  {
+    PoolList* pList = &pCache->lists[uClass];
+
+    if(pList->pHead)
+      PoolCount(&pCache->tStats.uCacheHits, 1);
+    else if(PoolFetch(pList, uClass, POOL_BATCH))
+      PoolCount(&pCache->tStats.uDepotFetches, 1);
+
+    if(pList->pHead)
+    {
+      pBlock = pList->pHead;
+      pList->pHead = pBlock->pNext;
+      --pList->iCount;
+    }
+  }
+  else
+  {
+    PoolList tList = { NULL, 0 };
+
+    if(PoolFetch(&tList, uClass, 1))
+      pBlock = tList.pHead;
+  }
+
+  if(!pBlock)
+    return NULL;
+
+  assert(pBlock->uClass == uClass);
+  return (uint8_t*)pBlock + POOL_HEADER_SIZE;
+}
+
+/****************************************************************************/
+void Rtos_Free(void* pMem)
+{
+  if(!pMem)
+    return;
+
+  PoolBlock* pBlock = (PoolBlock*)((uint8_t*)pMem - POOL_HEADER_SIZE);
+  uint32_t uClass = pBlock->uClass;
+
+  /* blocks allocated while the pool was enabled go back to it, whatever its current state */
+  PoolCache* pCache = (uClass != POOL_LARGE || __atomic_load_n(&bPoolEnabled, __ATOMIC_RELAXED)) ? PoolGetCache() : NULL;
+
+  if(pCache)
+    PoolCount(&pCache->tStats.uFrees, 1);
+
+  if(uClass == POOL_LARGE)
+  {
+    free(pBlock);
+    return;
+  }
+
+  assert(uClass < POOL_NUM_CLASSES);
+
+  if(!pCache)
+  {
+    PoolList tList = { pBlock, 1 };
+    pBlock->pNext = NULL;
+    PoolReturn(&tList, uClass, 1);
+    return;
+  }
+
+  PoolList* pList = &pCache->lists[uClass];
+  pBlock->pNext = pList->pHead;
+  pList->pHead = pBlock;
+  ++pList->iCount;
+
+  if(pList->iCount > POOL_CACHE_MAX)
+  {
+    PoolReturn(pList, uClass, POOL_BATCH);
+    PoolCount(&pCache->tStats.uDepotReturns, 1);
+  }
+}
+
+/****************************************************************************/
+bool Rtos_EnableMallocPool(bool bEnable)
+{
+  __atomic_store_n(&bPoolEnabled, bEnable, __ATOMIC_RELAXED);
+  return true;
+}
+
+/****************************************************************************/
+bool Rtos_GetMallocStats(AL_TRtosMallocStats* pStats)
+{
+  AL_TRtosMallocStats tTotal = { 0 };
+
+  pthread_mutex_lock(&poolStatsLock);
+  PoolAddStats(&tTotal, &poolExitedStats);
+  PoolAddStats(&tTotal, &poolSharedStats);
+
+  for(PoolCache* pCache = pPoolCaches; pCache; pCache = pCache->pNext)
+    PoolAddStats(&tTotal, &pCache->tStats);
+
+  pthread_mutex_unlock(&poolStatsLock);
+
+  *pStats = tTotal;
+  return true;
+}
+
+#else
+
 /****************************************************************************/
 void* Rtos_Malloc(size_t zSize)
 {
@@ -61,6 +457,21 @@ void Rtos_Free(void* pMem)
   free(pMem);
 }
 
+/****************************************************************************/
+bool Rtos_EnableMallocPool(bool bEnable)
+{
+  return !bEnable;
+}
+
+/****************************************************************************/
+bool Rtos_GetMallocStats(AL_TRtosMallocStats* pStats)
+{
+  (void)pStats;
+  return false;
+}
+
+#endif
+
 /****************************************************************************/
 void* Rtos_Memcpy(void* pDst, void const* pSrc, size_t zSize)
 {
@@ -123,13 +534,20 @@ void* Rtos_Memset(void* pDst, int iVal, size_t zSize)
 #endif
 
 /****************************************************************************/
-AL_64U Rtos_GetTime()
+AL_64U Rtos_GetTimeNs()
 {
   AL_64U uCount, uFreq;
   QueryPerformanceCounter((LARGE_INTEGER*)&uCount);
   QueryPerformanceFrequency((LARGE_INTEGER*)&uFreq);
 
-  return (uCount * 1000) / uFreq;
+  /* split to avoid the overflow of uCount * 1e9 */
+  return (uCount / uFreq) * 1000000000ULL + ((uCount % uFreq) * 1000000000ULL) / uFreq;
+}
+
+/****************************************************************************/
+AL_64U Rtos_GetTime()
+{
+  return Rtos_GetTimeNs() / 1000000;
 }
 
 /****************************************************************************/
@@ -138,6 +556,24 @@ void Rtos_Sleep(uint32_t uMillisecond)
   Sleep(uMillisecond);
 }
 
+/****************************************************************************/
+void Rtos_SleepUs(uint32_t uMicrosecond)
+{
+  Sleep((uMicrosecond + 999) / 1000);
+}
+
+/****************************************************************************/
+static DWORD GetWaitFromDeadline(AL_64U uDeadlineNs)
+{
+  AL_64U const uNow = Rtos_GetTimeNs();
+
+  if(uDeadlineNs <= uNow)
+    return 0;
+
+  AL_64U const uWait = (uDeadlineNs - uNow + 999999) / 1000000;
+  return uWait >= INFINITE ? INFINITE - 1 : (DWORD)uWait;
+}
+
 /****************************************************************************/
 AL_MUTEX Rtos_CreateMutex()
 {
@@ -180,6 +616,12 @@ bool Rtos_GetSemaphore(AL_SEMAPHORE Semaphore, uint32_t Wait)
   return WaitForSingleObject((HANDLE)Semaphore, Wait) == WAIT_OBJECT_0;
 }
 
+/****************************************************************************/
+bool Rtos_GetSemaphoreUntil(AL_SEMAPHORE Semaphore, AL_64U uDeadlineNs)
+{
+  return WaitForSingleObject((HANDLE)Semaphore, GetWaitFromDeadline(uDeadlineNs)) == WAIT_OBJECT_0;
+}
+
 /****************************************************************************/
 bool Rtos_ReleaseSemaphore(AL_SEMAPHORE Semaphore)
 {
@@ -204,6 +646,12 @@ bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait)
   return WaitForSingleObject((HANDLE)Event, Wait) == WAIT_OBJECT_0;
 }
 
+/****************************************************************************/
+bool Rtos_WaitEventUntil(AL_EVENT Event, AL_64U uDeadlineNs)
+{
+  return WaitForSingleObject((HANDLE)Event, GetWaitFromDeadline(uDeadlineNs)) == WAIT_OBJECT_0;
+}
+
 /****************************************************************************/
 bool Rtos_SetEvent(AL_EVENT Event)
 {
@@ -238,7 +686,52 @@ bool Rtos_JoinThread(AL_THREAD Thread)
 void Rtos_DeleteThread(AL_THREAD Thread)
 {
   CloseHandle(GetNative(Thread));
-  free(Thread);
+  Rtos_Free(Thread);
+}
+
+/****************************************************************************/
+static bool SetThreadAttr(HANDLE hThread, AL_TThreadAttr const* pAttr)
+{
+  bool bRet = true;
+
+  if(pAttr->uAffinityMask)
+    bRet = SetThreadAffinityMask(hThread, (DWORD_PTR)pAttr->uAffinityMask) != 0;
+
+  /* no real-time policies: the priority classes are the closest match */
+  if(pAttr->ePolicy == AL_SCHED_FIFO || pAttr->ePolicy == AL_SCHED_RR)
+    bRet = SetThreadPriority(hThread, pAttr->iPriority >= 50 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST) && bRet;
+  else if(pAttr->ePolicy == AL_SCHED_OTHER)
+    bRet = SetThreadPriority(hThread, THREAD_PRIORITY_NORMAL) && bRet;
+
+  return bRet;
+}
+
+/****************************************************************************/
+AL_THREAD Rtos_CreateThreadWithAttr(void* (*pFunc)(void* pParam), void* pParam, AL_TThreadAttr const* pAttr)
+{
+  HANDLE* pThread = Rtos_Malloc(sizeof(HANDLE));
+  DWORD id;
+
+  if(!pThread)
+    return NULL;
+
+  *pThread = CreateThread(NULL, pAttr->zStackSize, (LPTHREAD_START_ROUTINE)pFunc, pParam, CREATE_SUSPENDED, &id);
+
+  if(!*pThread)
+  {
+    Rtos_Free(pThread);
+    return NULL;
+  }
+
+  SetThreadAttr(*pThread, pAttr);
+  ResumeThread(*pThread);
+  return pThread;
+}
+
+/****************************************************************************/
+bool Rtos_SetCurrentThreadAttr(AL_TThreadAttr const* pAttr)
+{
+  return SetThreadAttr(GetCurrentThread(), pAttr);
 }
 
 void* Rtos_DriverOpen(char const* name)
@@ -267,17 +760,66 @@ int Rtos_DriverPoll(void* drv, int timeout)
   return -1; // not implemented
 }
 
+bool Rtos_DriverWake(void* drv)
+{
+  (void)drv;
+  return false; // not implemented
+}
+
+AL_POLLSET Rtos_CreatePollSet()
+{
+  return NULL; // not implemented
+}
+
+void Rtos_DeletePollSet(AL_POLLSET PollSet)
+{
+  (void)PollSet;
+}
+
+bool Rtos_AddToPollSet(AL_POLLSET PollSet, void* drv, AL_64U uData)
+{
+  (void)PollSet, (void)drv, (void)uData;
+  return false; // not implemented
+}
+
+bool Rtos_RemoveFromPollSet(AL_POLLSET PollSet, void* drv)
+{
+  (void)PollSet, (void)drv;
+  return false; // not implemented
+}
+
+int Rtos_WaitPollSet(AL_POLLSET PollSet, int timeout, AL_64U* pData)
+{
+  (void)PollSet, (void)timeout, (void)pData;
+  return -1; // not implemented
+}
+
+bool Rtos_StopPollSet(AL_POLLSET PollSet)
+{
+  (void)PollSet;
+  return false; // not implemented
+}
+
 /****************************************************************************/
 /*** L i n u x ***/
 /****************************************************************************/
 #elif defined __linux__
 
-#include <sys/time.h>
 #include <errno.h>
+#include <time.h>
 #include <unistd.h>
+#include <limits.h>
 
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/* sem_clockwait is a GNU extension since glibc 2.30 */
+#if defined(__USE_GNU) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 30))
+#define HAS_SEM_CLOCKWAIT 1
+#endif
 
 typedef struct
 {
@@ -286,19 +828,63 @@ typedef struct
   bool bSignaled;
 }evt_t;
 
+#define NS_PER_SEC 1000000000ULL
+
+/****************************************************************************/
+static AL_64U TimespecToNs(struct timespec const* pTs)
+{
+  return (AL_64U)pTs->tv_sec * NS_PER_SEC + pTs->tv_nsec;
+}
+
+/****************************************************************************/
+static struct timespec NsToTimespec(AL_64U uNs)
+{
+  struct timespec Ts;
+  Ts.tv_sec = uNs / NS_PER_SEC;
+  Ts.tv_nsec = uNs % NS_PER_SEC;
+  return Ts;
+}
+
+/****************************************************************************/
+AL_64U Rtos_GetTimeNs()
+{
+  struct timespec Ts;
+  clock_gettime(CLOCK_MONOTONIC, &Ts);
+
+  return TimespecToNs(&Ts);
+}
+
 /****************************************************************************/
 AL_64U Rtos_GetTime()
 {
-  struct timeval Tv;
-  gettimeofday(&Tv, NULL);
+  return Rtos_GetTimeNs() / 1000000;
+}
+
+/****************************************************************************/
+static AL_64U GetDeadline(uint32_t uMillisecond)
+{
+  return Rtos_GetTimeNs() + (AL_64U)uMillisecond * 1000000;
+}
+
+/****************************************************************************/
+static void SleepUntil(AL_64U uDeadlineNs)
+{
+  struct timespec const Ts = NsToTimespec(uDeadlineNs);
 
-  return ((AL_64U)Tv.tv_sec) * 1000 + (Tv.tv_usec / 1000);
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Ts, NULL) == EINTR)
+    ;
 }
 
 /****************************************************************************/
 void Rtos_Sleep(uint32_t uMillisecond)
 {
-  usleep(uMillisecond * 1000);
+  SleepUntil(GetDeadline(uMillisecond));
+}
+
+/****************************************************************************/
+void Rtos_SleepUs(uint32_t uMicrosecond)
+{
+  SleepUntil(Rtos_GetTimeNs() + (AL_64U)uMicrosecond * 1000);
 }
 
 /****************************************************************************/
@@ -405,24 +991,45 @@ bool Rtos_GetSemaphore(AL_SEMAPHORE Semaphore, uint32_t Wait)
     }
     while(ret == -1 && errno == EINTR);
 
-    return ret == 0;
-  }
-  else
+    return ret == 0;
+  }
+
+  return Rtos_GetSemaphoreUntil(Semaphore, GetDeadline(Wait));
+}
+
+/****************************************************************************/
+bool Rtos_GetSemaphoreUntil(AL_SEMAPHORE Semaphore, AL_64U uDeadlineNs)
+{
+  sem_t* pSem = (sem_t*)Semaphore;
+
+  if(!pSem)
+    return false;
+
+  int ret;
+#if HAS_SEM_CLOCKWAIT
+  struct timespec const Ts = NsToTimespec(uDeadlineNs);
+
+  do
   {
-    struct timespec Ts;
-    Ts.tv_sec = Wait / 1000;
-    Ts.tv_nsec = (Wait % 1000) * 1000000;
-
-    do
-    {
-      ret = sem_timedwait(pSem, &Ts);
-    }
-    while(ret == -1 && errno == EINTR);
+    ret = sem_clockwait(pSem, CLOCK_MONOTONIC, &Ts);
+  }
+  while(ret == -1 && errno == EINTR);
+#else
 
-    return ret == 0;
+  /* sem_timedwait only knows the realtime clock: translate the deadline */
+  do
+  {
+    AL_64U const uNow = Rtos_GetTimeNs();
+    AL_64U const uRemaining = uDeadlineNs > uNow ? uDeadlineNs - uNow : 0;
+    struct timespec RealNow;
+    clock_gettime(CLOCK_REALTIME, &RealNow);
+    struct timespec const Ts = NsToTimespec(TimespecToNs(&RealNow) + uRemaining);
+    ret = sem_timedwait(pSem, &Ts);
   }
+  while(ret == -1 && errno == EINTR);
+#endif
 
-  return true;
+  return ret == 0;
 }
 
 /****************************************************************************/
@@ -444,8 +1051,13 @@ AL_EVENT Rtos_CreateEvent(bool bInitialState)
 
   if(pEvt)
   {
+    pthread_condattr_t CondAttr;
+    pthread_condattr_init(&CondAttr);
+    pthread_condattr_setclock(&CondAttr, CLOCK_MONOTONIC);
+
     pthread_mutex_init(&pEvt->Mutex, 0);
-    pthread_cond_init(&pEvt->Cond, 0);
+    pthread_cond_init(&pEvt->Cond, &CondAttr);
+    pthread_condattr_destroy(&CondAttr);
     pEvt->bSignaled = bInitialState;
   }
   return (AL_EVENT)pEvt;
@@ -465,10 +1077,8 @@ void Rtos_DeleteEvent(AL_EVENT Event)
 }
 
 /****************************************************************************/
-bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait)
+static bool WaitEvent(evt_t* pEvt, struct timespec const* pDeadline)
 {
-  evt_t* pEvt = (evt_t*)Event;
-
   if(!pEvt)
     return false;
 
@@ -476,22 +1086,15 @@ bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait)
 
   pthread_mutex_lock(&pEvt->Mutex);
 
-  if(Wait == AL_WAIT_FOREVER)
+  if(!pDeadline)
   {
     while(bRet && !pEvt->bSignaled)
       bRet = (pthread_cond_wait(&pEvt->Cond, &pEvt->Mutex) == 0);
   }
   else
   {
-    struct timeval now;
-    gettimeofday(&now, NULL);
-
-    struct timespec deadline;
-    deadline.tv_sec = now.tv_sec + Wait / 1000;
-    deadline.tv_nsec = (now.tv_usec + 1000UL * (Wait % 1000)) * 1000UL;
-
     while(bRet && !pEvt->bSignaled)
-      bRet = (pthread_cond_timedwait(&pEvt->Cond, &pEvt->Mutex, &deadline) == 0);
+      bRet = (pthread_cond_timedwait(&pEvt->Cond, &pEvt->Mutex, pDeadline) == 0);
   }
 
   if(bRet)
@@ -500,6 +1103,22 @@ bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait)
   return bRet;
 }
 
+/****************************************************************************/
+bool Rtos_WaitEvent(AL_EVENT Event, uint32_t Wait)
+{
+  if(Wait == AL_WAIT_FOREVER)
+    return WaitEvent((evt_t*)Event, NULL);
+
+  return Rtos_WaitEventUntil(Event, GetDeadline(Wait));
+}
+
+/****************************************************************************/
+bool Rtos_WaitEventUntil(AL_EVENT Event, AL_64U uDeadlineNs)
+{
+  struct timespec const Deadline = NsToTimespec(uDeadlineNs);
+  return WaitEvent((evt_t*)Event, &Deadline);
+}
+
 /****************************************************************************/
 bool Rtos_SetEvent(AL_EVENT Event)
 {
@@ -538,7 +1157,170 @@ bool Rtos_JoinThread(AL_THREAD Thread)
 /****************************************************************************/
 void Rtos_DeleteThread(AL_THREAD Thread)
 {
-  free((pthread_t*)Thread);
+  Rtos_Free(Thread);
+}
+
+/****************************************************************************/
+static int ToNativePolicy(AL_ESchedPolicy ePolicy)
+{
+  switch(ePolicy)
+  {
+  case AL_SCHED_FIFO: return SCHED_FIFO;
+  case AL_SCHED_RR: return SCHED_RR;
+  default: return SCHED_OTHER;
+  }
+}
+
+/****************************************************************************/
+static void ToCpuSet(AL_64U uAffinityMask, cpu_set_t* pCpuSet)
+{
+  CPU_ZERO(pCpuSet);
+
+  for(int iCpu = 0; iCpu < 64 && iCpu < CPU_SETSIZE; ++iCpu)
+  {
+    if(uAffinityMask & (1ULL << iCpu))
+      CPU_SET(iCpu, pCpuSet);
+  }
+}
+
+/****************************************************************************/
+static void SetName(pthread_t thread, char const* pName)
+{
+  if(!pName)
+    return;
+
+  /* the kernel limits the names to 16 bytes, terminating zero included */
+  char sName[16];
+  strncpy(sName, pName, sizeof(sName) - 1);
+  sName[sizeof(sName) - 1] = '\0';
+  pthread_setname_np(thread, sName);
+}
+
+typedef struct
+{
+  void* (*pFunc)(void* pParam);
+  void* pParam;
+  char sName[16];
+}ThreadStart;
+
+/* names the thread before running the user function */
+static void* StartThread(void* p)
+{
+  ThreadStart tStart = *(ThreadStart*)p;
+  Rtos_Free(p);
+
+  if(tStart.sName[0])
+    pthread_setname_np(pthread_self(), tStart.sName);
+
+  return tStart.pFunc(tStart.pParam);
+}
+
+/****************************************************************************/
+static bool InitNativeAttr(pthread_attr_t* pNative, AL_TThreadAttr const* pAttr, bool bWithPolicy)
+{
+  if(pthread_attr_init(pNative) != 0)
+    return false;
+
+  if(pAttr->zStackSize)
+  {
+    size_t zStackSize = pAttr->zStackSize < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : pAttr->zStackSize;
+    pthread_attr_setstacksize(pNative, zStackSize);
+  }
+
+  if(pAttr->uAffinityMask)
+  {
+    cpu_set_t cpuSet;
+    ToCpuSet(pAttr->uAffinityMask, &cpuSet);
+    pthread_attr_setaffinity_np(pNative, sizeof(cpuSet), &cpuSet);
+  }
+
+  if(bWithPolicy && pAttr->ePolicy != AL_SCHED_DEFAULT)
+  {
+    int iPolicy = ToNativePolicy(pAttr->ePolicy);
+    struct sched_param param = { 0 };
+
+    if(iPolicy != SCHED_OTHER)
+      param.sched_priority = pAttr->iPriority;
+
+    pthread_attr_setinheritsched(pNative, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(pNative, iPolicy);
+    pthread_attr_setschedparam(pNative, &param);
+  }
+
+  return true;
+}
+
+/****************************************************************************/
+static bool CreateWithAttr(pthread_t* thread, ThreadStart* pStart, AL_TThreadAttr const* pAttr, bool bWithPolicy)
+{
+  pthread_attr_t native;
+
+  if(!InitNativeAttr(&native, pAttr, bWithPolicy))
+    return false;
+
+  int iRet = pthread_create(thread, &native, &StartThread, pStart);
+  pthread_attr_destroy(&native);
+  return iRet == 0;
+}
+
+/****************************************************************************/
+AL_THREAD Rtos_CreateThreadWithAttr(void* (*pFunc)(void* pParam), void* pParam, AL_TThreadAttr const* pAttr)
+{
+  pthread_t* thread = Rtos_Malloc(sizeof(pthread_t));
+  ThreadStart* pStart = Rtos_Malloc(sizeof(ThreadStart));
+
+  if(!thread || !pStart)
+    goto fail;
+
+  pStart->pFunc = pFunc;
+  pStart->pParam = pParam;
+  pStart->sName[0] = '\0';
+
+  if(pAttr->pName)
+  {
+    strncpy(pStart->sName, pAttr->pName, sizeof(pStart->sName) - 1);
+    pStart->sName[sizeof(pStart->sName) - 1] = '\0';
+  }
+
+  /* real-time policies need CAP_SYS_NICE */
+  if(!CreateWithAttr(thread, pStart, pAttr, true) && !CreateWithAttr(thread, pStart, pAttr, false))
+    goto fail;
+
+  return (AL_THREAD)thread;
+
+  fail:
+  Rtos_Free(pStart);
+  Rtos_Free(thread);
+  return NULL;
+}
+
+/****************************************************************************/
+bool Rtos_SetCurrentThreadAttr(AL_TThreadAttr const* pAttr)
+{
+  pthread_t self = pthread_self();
+  bool bRet = true;
+
+  SetName(self, pAttr->pName);
+
+  if(pAttr->uAffinityMask)
+  {
+    cpu_set_t cpuSet;
+    ToCpuSet(pAttr->uAffinityMask, &cpuSet);
+    bRet = pthread_setaffinity_np(self, sizeof(cpuSet), &cpuSet) == 0;
+  }
+
+  if(pAttr->ePolicy != AL_SCHED_DEFAULT)
+  {
+    int iPolicy = ToNativePolicy(pAttr->ePolicy);
+    struct sched_param param = { 0 };
+
+    if(iPolicy != SCHED_OTHER)
+      param.sched_priority = pAttr->iPriority;
+
+    bRet = (pthread_setschedparam(self, iPolicy, &param) == 0) && bRet;
+  }
+
+  return bRet;
 }
 
 #include <sys/ioctl.h>
@@ -553,9 +1335,67 @@ void* Rtos_DriverOpen(char const* name)
   return (void*)(intptr_t)fd;
 }
 
+/* the eventfds which interrupt Rtos_DriverPoll, one per polled driver */
+#define MAX_DRIVER_WAKES 64
+
+typedef struct
+{
+  int iDriverFd;
+  int iWakeFd;
+}AL_TDriverWake;
+
+static pthread_mutex_t s_DriverWakeLock = PTHREAD_MUTEX_INITIALIZER;
+static AL_TDriverWake s_DriverWakes[MAX_DRIVER_WAKES];
+static int s_iNumDriverWakes = 0;
+
+static int GetDriverWakeFd(int fd)
+{
+  int iWakeFd = -1;
+  pthread_mutex_lock(&s_DriverWakeLock);
+
+  for(int i = 0; i < s_iNumDriverWakes; ++i)
+  {
+    if(s_DriverWakes[i].iDriverFd == fd)
+      iWakeFd = s_DriverWakes[i].iWakeFd;
+  }
+
+  if(iWakeFd == -1 && s_iNumDriverWakes < MAX_DRIVER_WAKES)
+  {
+    iWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if(iWakeFd != -1)
+    {
+      s_DriverWakes[s_iNumDriverWakes].iDriverFd = fd;
+      s_DriverWakes[s_iNumDriverWakes].iWakeFd = iWakeFd;
+      ++s_iNumDriverWakes;
+    }
+  }
+
+  pthread_mutex_unlock(&s_DriverWakeLock);
+  return iWakeFd;
+}
+
+static void CloseDriverWakeFd(int fd)
+{
+  pthread_mutex_lock(&s_DriverWakeLock);
+
+  for(int i = 0; i < s_iNumDriverWakes; ++i)
+  {
+    if(s_DriverWakes[i].iDriverFd == fd)
+    {
+      close(s_DriverWakes[i].iWakeFd);
+      s_DriverWakes[i] = s_DriverWakes[--s_iNumDriverWakes];
+      break;
+    }
+  }
+
+  pthread_mutex_unlock(&s_DriverWakeLock);
+}
+
 void Rtos_DriverClose(void* drv)
 {
   int fd = (int)(intptr_t)drv;
+  CloseDriverWakeFd(fd);
   close(fd);
 }
 
@@ -568,10 +1408,146 @@ int Rtos_DriverIoctl(void* drv, unsigned long int req, void* data)
 #include <poll.h>
 int Rtos_DriverPoll(void* drv, int timeout)
 {
-  struct pollfd pollData;
-  pollData.fd = (int)(intptr_t)drv;
-  pollData.events = POLLPRI | POLLIN;
-  return poll(&pollData, 1, timeout);
+  struct pollfd pollData[2];
+  pollData[0].fd = (int)(intptr_t)drv;
+  pollData[0].events = POLLPRI | POLLIN;
+  pollData[0].revents = 0;
+  pollData[1].fd = GetDriverWakeFd(pollData[0].fd);
+  pollData[1].events = POLLIN;
+  pollData[1].revents = 0;
+
+  int iNumFds = pollData[1].fd == -1 ? 1 : 2;
+  int iRet = poll(pollData, iNumFds, timeout);
+
+  if(iRet <= 0)
+    return iRet;
+
+  if(pollData[1].revents & POLLIN)
+  {
+    uint64_t uCount;
+
+    if(read(pollData[1].fd, &uCount, sizeof(uCount)) != sizeof(uCount))
+      uCount = 0;
+  }
+
+  /* a wake up without driver event looks like a timeout */
+  return pollData[0].revents ? 1 : 0;
+}
+
+bool Rtos_DriverWake(void* drv)
+{
+  int iWakeFd = GetDriverWakeFd((int)(intptr_t)drv);
+
+  if(iWakeFd == -1)
+    return false;
+
+  uint64_t const uOne = 1;
+  return write(iWakeFd, &uOne, sizeof(uOne)) == sizeof(uOne);
+}
+
+/* the stop eventfd is watched without one-shot and never read: once written,
+ * it wakes up every waiter */
+typedef struct
+{
+  int iEpollFd;
+  int iStopFd;
+  bool bStopped;
+}pollset_t;
+
+/****************************************************************************/
+AL_POLLSET Rtos_CreatePollSet()
+{
+  pollset_t* pSet = (pollset_t*)Rtos_Malloc(sizeof(pollset_t));
+
+  if(!pSet)
+    return NULL;
+
+  pSet->iEpollFd = epoll_create1(EPOLL_CLOEXEC);
+  pSet->iStopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  pSet->bStopped = false;
+
+  struct epoll_event Event = { 0 };
+  Event.events = EPOLLIN;
+
+  if(pSet->iEpollFd == -1 || pSet->iStopFd == -1 || epoll_ctl(pSet->iEpollFd, EPOLL_CTL_ADD, pSet->iStopFd, &Event) != 0)
+  {
+    Rtos_DeletePollSet(pSet);
+    return NULL;
+  }
+
+  return (AL_POLLSET)pSet;
+}
+
+/****************************************************************************/
+void Rtos_DeletePollSet(AL_POLLSET PollSet)
+{
+  pollset_t* pSet = (pollset_t*)PollSet;
+
+  if(!pSet)
+    return;
+
+  if(pSet->iStopFd != -1)
+    close(pSet->iStopFd);
+
+  if(pSet->iEpollFd != -1)
+    close(pSet->iEpollFd);
+  Rtos_Free(pSet);
+}
+
+/****************************************************************************/
+bool Rtos_AddToPollSet(AL_POLLSET PollSet, void* drv, AL_64U uData)
+{
+  pollset_t* pSet = (pollset_t*)PollSet;
+  int fd = (int)(intptr_t)drv;
+
+  struct epoll_event Event = { 0 };
+  Event.events = EPOLLIN | EPOLLPRI | EPOLLONESHOT;
+  Event.data.u64 = uData;
+
+  /* a driver already reported is still in the set, only disabled */
+  if(epoll_ctl(pSet->iEpollFd, EPOLL_CTL_MOD, fd, &Event) == 0)
+    return true;
+
+  return epoll_ctl(pSet->iEpollFd, EPOLL_CTL_ADD, fd, &Event) == 0;
+}
+
+/****************************************************************************/
+bool Rtos_RemoveFromPollSet(AL_POLLSET PollSet, void* drv)
+{
+  pollset_t* pSet = (pollset_t*)PollSet;
+  return epoll_ctl(pSet->iEpollFd, EPOLL_CTL_DEL, (int)(intptr_t)drv, NULL) == 0;
+}
+
+/****************************************************************************/
+int Rtos_WaitPollSet(AL_POLLSET PollSet, int timeout, AL_64U* pData)
+{
+  pollset_t* pSet = (pollset_t*)PollSet;
+  struct epoll_event Event;
+  int iRet;
+
+  do
+  {
+    iRet = epoll_wait(pSet->iEpollFd, &Event, 1, timeout);
+  }
+  while(iRet == -1 && errno == EINTR);
+
+  if(iRet <= 0)
+    return iRet;
+
+  if(__atomic_load_n(&pSet->bStopped, __ATOMIC_ACQUIRE))
+    return 0;
+
+  *pData = Event.data.u64;
+  return 1;
+}
+
+/****************************************************************************/
+bool Rtos_StopPollSet(AL_POLLSET PollSet)
+{
+  pollset_t* pSet = (pollset_t*)PollSet;
+  uint64_t const uOne = 1;
+  __atomic_store_n(&pSet->bStopped, true, __ATOMIC_RELEASE);
+  return write(pSet->iStopFd, &uOne, sizeof(uOne)) == sizeof(uOne);
 }
 
 /****************************************************************************/
@@ -629,6 +1605,13 @@ bool Rtos_GetSemaphore(AL_SEMAPHORE Semaphore, uint32_t Wait)
   return true;
 }
 
+/****************************************************************************/
+bool Rtos_GetSemaphoreUntil(AL_SEMAPHORE Semaphore, AL_64U uDeadlineNs)
+{
+  (void)Semaphore, (void)uDeadlineNs;
+  return true;
+}
+
 /****************************************************************************/
 bool Rtos_ReleaseSemaphore(AL_SEMAPHORE Semaphore)
 {
@@ -700,6 +1683,13 @@ bool Rtos_GetSemaphore(AL_SEMAPHORE Semaphore, uint32_t Wait)
   return true;
 }
 
+/****************************************************************************/
+bool Rtos_GetSemaphoreUntil(AL_SEMAPHORE Semaphore, AL_64U uDeadlineNs)
+{
+  (void)uDeadlineNs;
+  return Rtos_GetSemaphore(Semaphore, AL_WAIT_FOREVER);
+}
+
 /****************************************************************************/
 bool Rtos_ReleaseSemaphore(AL_SEMAPHORE Semaphore)
 {
@@ -735,3 +1725,87 @@ int32_t Rtos_AtomicDecrement(int32_t* iVal)
 
 #endif
 
+#if ENABLE_RTOS_SYNC && (defined _WIN32 || defined __linux__)
+
+/****************************************************************************/
+void Rtos_InitThreadAttr(AL_TThreadAttr* pAttr)
+{
+  Rtos_Memset(pAttr, 0, sizeof(*pAttr));
+  pAttr->ePolicy = AL_SCHED_DEFAULT;
+}
+
+#define MAX_THREAD_CONFIGS 32
+#define MAX_THREAD_NAME 16
+
+typedef struct
+{
+  char sName[MAX_THREAD_NAME];
+  AL_TThreadAttr tAttr;
+}ThreadConfig;
+
+static ThreadConfig threadConfigs[MAX_THREAD_CONFIGS];
+static int iNumThreadConfigs;
+
+/****************************************************************************/
+static ThreadConfig* FindThreadConfig(char const* pName)
+{
+  for(int i = 0; i < iNumThreadConfigs; ++i)
+  {
+    if(strncmp(threadConfigs[i].sName, pName, MAX_THREAD_NAME - 1) == 0)
+      return &threadConfigs[i];
+  }
+
+  return NULL;
+}
+
+/****************************************************************************/
+bool Rtos_SetThreadConfig(char const* pName, AL_TThreadAttr const* pAttr)
+{
+  ThreadConfig* pCfg = FindThreadConfig(pName);
+
+  if(!pCfg)
+  {
+    if(iNumThreadConfigs >= MAX_THREAD_CONFIGS)
+      return false;
+    pCfg = &threadConfigs[iNumThreadConfigs++];
+  }
+
+  strncpy(pCfg->sName, pName, MAX_THREAD_NAME - 1);
+  pCfg->sName[MAX_THREAD_NAME - 1] = '\0';
+  pCfg->tAttr = *pAttr;
+  pCfg->tAttr.pName = pCfg->sName;
+  return true;
+}
+
+/****************************************************************************/
+static void GetThreadConfig(char const* pName, AL_TThreadAttr* pAttr)
+{
+  ThreadConfig* pCfg = FindThreadConfig(pName);
+
+  if(pCfg)
+  {
+    *pAttr = pCfg->tAttr;
+    return;
+  }
+
+  Rtos_InitThreadAttr(pAttr);
+  pAttr->pName = pName;
+}
+
+/****************************************************************************/
+AL_THREAD Rtos_CreateNamedThread(void* (*pFunc)(void* pParam), void* pParam, char const* pName)
+{
+  AL_TThreadAttr tAttr;
+  GetThreadConfig(pName, &tAttr);
+  return Rtos_CreateThreadWithAttr(pFunc, pParam, &tAttr);
+}
+
+/****************************************************************************/
+bool Rtos_ApplyThreadConfig(char const* pName)
+{
+  AL_TThreadAttr tAttr;
+  GetThreadConfig(pName, &tAttr);
+  return Rtos_SetCurrentThreadAttr(&tAttr);
+}
+
+#endif
@@ -48,7 +48,6 @@
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
-#include <fstream>
 #include <unistd.h>
 
 using namespace std;
@@ -73,6 +72,7 @@ extern "C"
 #include "common/helpers.h"
 #include "common/setters.h"
 #include "common/CommandLineParser.h"
+#include "common/file_io.h"
 
 extern "C"
 {
@@ -235,12 +235,16 @@ struct Application
   EventBus eventBus {};
   bool quit = false;
   bool pipelineEnded = false;
+
+  /* kept between the frames so that they don't allocate */
+  vector<StridedPlane> outputPlanes {};
 };
 
 string input_file;
 string output_file;
-ifstream infile;
-ofstream outfile;
+InputFile infile;
+OutputFile outfile;
+bool mmapInput = false;
 
 static OMX_PARAM_PORTDEFINITIONTYPE paramPort;
 
@@ -362,6 +366,7 @@ void parseCommandLine(int argc, char** argv, Application& app)
     settings.bDMAOut = true;
     settings.eDMAOut = OMX_ALG_BUF_DMA;
   }, "use dmabufs for output port");
+  opt.addFlag("--mmap-in,-mmap-in", &mmapInput, "Map the input file in memory instead of reading it");
   string prealloc_args = "";
   opt.addString("--prealloc-args", &prealloc_args, "Specify the stream dimension: 1920x1080:unkwn:nv12:omx-profile-value:omx-level-value");
 
@@ -707,15 +712,14 @@ OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR pAppDat
       auto height = videoDef.nFrameHeight;
       auto row_size = is10bits(videoDef.eColorFormat) ? (((videoDef.nFrameWidth + 2) / 3) * 4) : videoDef.nFrameWidth;
 
-      /* luma */
-      for(auto h = 0; h < (int)height; h++)
-        outfile.write(&data[h * stride], row_size);
-
-      /* chroma */
-      for(auto h = sliceHeight; h < sliceHeight + height / coef; h++)
-        outfile.write(&data[h * stride], row_size);
+      /* write the rows from their strided place */
+      auto& planes = app->outputPlanes;
+      planes.clear();
+      planes.push_back({ data, row_size, (size_t)stride, (int)height });
+      planes.push_back({ &data[sliceHeight * stride], row_size, (size_t)stride, (int)(height / coef) });
 
-      outfile.flush();
+      if(!outfile.writePlanes(planes))
+        LOGE("Failed to write the output file\n");
     }
     else
       assert(0);
@@ -740,17 +744,13 @@ OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR pAppDat
 static bool readFrame(OMX_BUFFERHEADERTYPE* pInputBuf, Application& app)
 {
   assert(pInputBuf->nAllocLen != 0);
-  vector<uint8_t> frame(pInputBuf->nAllocLen);
 
-  infile.read((char*)frame.data(), frame.size());
   size_t zMapSize = pInputBuf->nAllocLen;
   auto data = Buffer_MapData((char*)(pInputBuf->pBuffer + pInputBuf->nOffset), zMapSize, app.settings.bDMAIn);
-  memcpy(data, frame.data(), frame.size());
+  pInputBuf->nFilledLen = infile.read(data, zMapSize);
   Buffer_UnmapData(data, pInputBuf->nAllocLen, app.settings.bDMAIn);
 
-  pInputBuf->nFilledLen = infile.gcount();
-
-  if(infile.peek() == EOF)
+  if(infile.isEof())
     return true;
 
   return false;
@@ -1093,17 +1093,13 @@ OMX_ERRORTYPE safeMain(int argc, char** argv)
     handleEvent(d->hComponent, d->pAppData, d->eEvent, d->Data1, d->Data2, d->pEventData);
   }, omxEvent);
 
-  infile.open(input_file, ios::binary);
-
-  if(!infile.is_open())
+  if(!infile.open(input_file, mmapInput))
   {
     cerr << "Error in opening input file '" << input_file << "'" << endl;
     return OMX_ErrorUndefined;
   }
 
-  outfile.open(output_file, ios::binary);
-
-  if(!outfile.is_open())
+  if(!outfile.open(output_file))
   {
     cerr << "Error in opening output file '" << output_file << "'" << endl;
     return OMX_ErrorUndefined;
@@ -86,6 +86,7 @@ extern "C"
 #include "common/setters.h"
 #include "common/getters.h"
 #include "common/CommandLineParser.h"
+#include "common/file_io.h"
 
 extern "C"
 {
@@ -123,6 +124,7 @@ struct Settings
   EncCodec codec;
   OMX_COLOR_FORMATTYPE format;
   int lookahead;
+  bool lookaheadEarlyStart;
 };
 
 struct Application
@@ -144,6 +146,9 @@ struct Application
 
   CEncCmdMngr* encCmd;
   CommandsSender* cmdSender;
+
+  /* kept between the frames so that they don't allocate */
+  vector<StridedPlane> inputPlanes;
 };
 
 static inline void SetDefaultSettings(Settings& settings)
@@ -154,6 +159,7 @@ static inline void SetDefaultSettings(Settings& settings)
   settings.codec = HEVC;
   settings.format = OMX_COLOR_FormatYUV420SemiPlanar;
   settings.lookahead = 0;
+  settings.lookaheadEarlyStart = false;
 }
 
 static inline void SetDefaultApplication(Application& app)
@@ -180,8 +186,9 @@ static string input_file;
 static string output_file;
 static string cmd_file;
 
-static ifstream infile;
-static ofstream outfile;
+static InputFile infile;
+static OutputFile outfile;
+static bool mmapInput = false;
 static int user_slice = 0;
 
 static OMX_PARAM_PORTDEFINITIONTYPE paramPort;
@@ -249,6 +256,7 @@ static OMX_ERRORTYPE setPortParameters(Application& app)
     initHeader(la);
     la.nPortIndex = 1;
     la.nLookAhead = app.settings.lookahead;
+    la.bEnableEarlyStart = app.settings.lookaheadEarlyStart ? OMX_TRUE : OMX_FALSE;
     OMX_SetParameter(app.hEncoder, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoLookAhead), &la);
   }
 #endif
@@ -307,8 +315,10 @@ static void parseCommandLine(int argc, char** argv, Application& app)
   opt.addFlag("--dma-out", &app.output.isDMA, "Use dmabufs on output port");
   opt.addInt("--subframe", &user_slice, "<4 || 8 || 16>: activate subframe latency '(0)'");
   opt.addString("--cmd-file", &cmd_file, "File to precise for dynamic cmd");
+  opt.addFlag("--mmap-in", &mmapInput, "Map the input file in memory instead of reading it");
 #if AL_ENABLE_TWOPASS
   opt.addInt("--lookahead", &settings.lookahead, "<0 || above 2>: activate lookahead mode '(0)'");
+  opt.addFlag("--lookahead-early-start", &settings.lookaheadEarlyStart, "Encode the first frames before the lookahead is full");
 #endif
 
   opt.parse(argc, argv);
@@ -382,9 +392,9 @@ static void parseCommandLine(int argc, char** argv, Application& app)
   }
 }
 
-static bool readOneYuvFrame(OMX_BUFFERHEADERTYPE* pBufferHdr, Application const& app)
+static bool readOneYuvFrame(OMX_BUFFERHEADERTYPE* pBufferHdr, Application& app)
 {
-  if(infile.peek() == EOF)
+  if(infile.isEof())
     return false;
 
   auto width = paramPort.format.video.nFrameWidth;
@@ -400,29 +410,32 @@ static bool readOneYuvFrame(OMX_BUFFERHEADERTYPE* pBufferHdr, Application const&
   auto color = app.settings.format;
   auto row_size = is10bits(color) ? (((width + 2) / 3) * 4) : width;
   auto coef = is422(color) ? 1 : 2;
-  auto column_size = is400(color) ? height : height + height / coef;
-  auto size = row_size * column_size;
-  vector<uint8_t> frame(size);
-
-  infile.read((char*)frame.data(), frame.size());
-
   auto dst = Buffer_MapData((char*)(pBufferHdr->pBuffer + pBufferHdr->nOffset), pBufferHdr->nAllocLen, app.input.isDMA);
 
-  /* luma */
-  for(auto h = 0; h < (int)height; h++)
-    memcpy(&dst[h * stride], &frame.data()[h * row_size], row_size);
+  /* read the rows straight at their strided place */
+  auto& planes = app.inputPlanes;
+  planes.clear();
+  planes.push_back({ dst, row_size, (size_t)stride, (int)height });
 
-  /* chroma */
   if(!is400(color))
+    planes.push_back({ &dst[sliceHeight * stride], row_size, (size_t)stride, (int)(height / coef) });
+
+  size_t frameSize = 0;
+
+  for(auto const& plane : planes)
+    frameSize += plane.rowSize * plane.rows;
+
+  /* a truncated last frame ends the stream */
+  if(infile.readPlanes(planes) < frameSize)
   {
-    for(struct { long unsigned int sh; long unsigned int h; } v { sliceHeight, height }; v.sh < sliceHeight + height / coef; v.sh++, v.h++)
-      memcpy(&dst[v.sh * stride], &frame.data()[v.h * row_size], row_size);
+    Buffer_UnmapData(dst, pBufferHdr->nAllocLen, app.input.isDMA);
+    return false;
   }
 
   pBufferHdr->nFilledLen = pBufferHdr->nAllocLen;
   assert(pBufferHdr->nFilledLen <= pBufferHdr->nAllocLen);
 
-  Buffer_UnmapData((char*)pBufferHdr->pBuffer, pBufferHdr->nAllocLen, app.input.isDMA);
+  Buffer_UnmapData(dst, pBufferHdr->nAllocLen, app.input.isDMA);
 
   return true;
 }
@@ -547,11 +560,8 @@ static OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR
   {
     auto data = Buffer_MapData((char*)(pBufferHdr->pBuffer + pBufferHdr->nOffset), zMapSize, app->output.isDMA);
 
-    if(data)
-    {
-      outfile.write((char*)data, pBufferHdr->nFilledLen);
-      outfile.flush();
-    }
+    if(data && !outfile.write(data, pBufferHdr->nFilledLen))
+      LOGE("Failed to write the output file\n");
 
     Buffer_UnmapData(data, zMapSize, app->output.isDMA);
   }
@@ -688,17 +698,13 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
   SetDefaultApplication(app);
   parseCommandLine(argc, argv, app);
 
-  infile.open(input_file, ios::binary);
-
-  if(!infile.is_open())
+  if(!infile.open(input_file, mmapInput))
   {
     cerr << "Error in opening input file '" << input_file.c_str() << "'" << endl;
     return OMX_ErrorUndefined;
   }
 
-  outfile.open(output_file, ios::binary);
-
-  if(!outfile.is_open())
+  if(!outfile.open(output_file))
   {
     cerr << "Error in opening output file '" << output_file.c_str() << "'" << endl;
     return OMX_ErrorUndefined;
@@ -804,6 +810,16 @@ static OMX_ERRORTYPE safeMain(int argc, char** argv)
   app.eof.wait();
   LOGV("EOS received");
 
+  if(user_slice)
+  {
+    OMX_ALG_VIDEO_CONFIG_SUBFRAME_LATENCY latency;
+    initHeader(latency);
+    latency.nPortIndex = 1;
+
+    if(OMX_GetConfig(app.hEncoder, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoSubframeLatency), &latency) == OMX_ErrorNone)
+      LOGI("First slice latency over %u frames: mean %u us, max %u us\n", (unsigned)latency.nFrames, (unsigned)latency.nMeanLatency, (unsigned)latency.nMaxLatency);
+  }
+
   /** send flush in input port */
   app.input.isFlushing = true;
   OMX_CALL(OMX_SendCommand(app.hEncoder, OMX_CommandFlush, app.input.index, nullptr));
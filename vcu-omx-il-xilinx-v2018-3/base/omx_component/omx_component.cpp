@@ -57,24 +57,44 @@ void Component::ReturnEmptiedBuffer(OMX_BUFFERHEADERTYPE* emptied)
     callbacks.EmptyBufferDone(component, app, header);
 }
 
-void nullDeleter(void*)
+/* aliases an empty owner: no control block is allocated for data we don't own */
+static shared_ptr<void> NotOwned(void* data)
 {
+  return shared_ptr<void>(shared_ptr<void>(), data);
 }
 
-static Task* CreateTask(Command cmd, OMX_U32 data, shared_ptr<void> opt)
+Task* Component::CreateTask(Command cmd, OMX_U32 data, shared_ptr<void> opt)
 {
-  auto task = new Task();
+  auto task = taskPool.acquire();
   task->cmd = cmd;
   task->data = reinterpret_cast<uintptr_t*>(data);
-  task->opt = opt;
+  task->opt = move(opt);
   return task;
 }
 
+void Component::ReservePools()
+{
+  /* every buffer of the enabled ports can be in flight, each one with its handle and its task */
+  size_t buffers = 0;
+
+  for(auto i = videoPortParams.nStartPortNumber; i < videoPortParams.nPorts; i++)
+  {
+    auto port = GetPort(i);
+
+    if(port->enable)
+      buffers += port->expected;
+  }
+
+  size_t const commands = 8;
+  handlePool.reserve(buffers);
+  taskPool.reserve(buffers + commands);
+}
+
 void Component::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto emptied = ((OMXBufferHandle*)(handle))->header;
   ReturnEmptiedBuffer(emptied);
-  delete handle;
+  handlePool.release((OMXBufferHandle*)handle);
 }
 
 void Component::AssociateCallBack(BufferHandleInterface* empty, BufferHandleInterface* fill)
@@ -109,14 +129,14 @@ void Component::ReturnFilledBuffer(OMX_BUFFERHEADERTYPE* filled, int offset, int
 void Component::FillThisBufferCallBack(BufferHandleInterface* filled, int offset, int size)
 {
   auto header = ((OMXBufferHandle*)filled)->header;
-  delete filled;
+  handlePool.release((OMXBufferHandle*)filled);
   ReturnFilledBuffer(header, offset, size);
 }
 
 void Component::ReleaseCallBack(bool isInput, BufferHandleInterface* released)
 {
   auto header = ((OMXBufferHandle*)released)->header;
-  delete released;
+  handlePool.release((OMXBufferHandle*)released);
 
   if(isInput)
     ReturnEmptiedBuffer(header);
@@ -151,7 +171,7 @@ void Component::EventCallBack(CallbackEventType type, void* data)
   case CALLBACK_EVENT_ERROR:
   {
     ErrorType errorCode = (ErrorType)(uintptr_t)data;
-    processorMain->queue(CreateTask(SetState, OMX_StateInvalid, shared_ptr<void>((uintptr_t*)ToOmxError(errorCode), nullDeleter)));
+    processorMain->queue(CreateTask(SetState, OMX_StateInvalid, NotOwned((uintptr_t*)ToOmxError(errorCode))));
     break;
   }
   default:
@@ -210,9 +230,9 @@ Component::Component(OMX_HANDLETYPE component, shared_ptr<MediatypeInterface> me
   auto p = bind(&Component::_ProcessMain, this, placeholders::_1);
   auto p2 = bind(&Component::_ProcessFillBuffer, this, placeholders::_1);
   auto p3 = bind(&Component::_ProcessEmptyBuffer, this, placeholders::_1);
-  processorMain.reset(new ProcessorFifo(p, d));
-  processorFill.reset(new ProcessorFifo(p2, d2));
-  processorEmpty.reset(new ProcessorFifo(p3, d2));
+  processorMain.reset(new ProcessorFifo(p, d, "omx_main"));
+  processorFill.reset(new ProcessorFifo(p2, d2, "omx_fill"));
+  processorEmpty.reset(new ProcessorFifo(p3, d2, "omx_empty"));
   pausePromise = nullptr;
 
   transientState = TransientMax;
@@ -291,7 +311,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
     if(param == OMX_ALL)
     {
       for(auto i = videoPortParams.nStartPortNumber; i < videoPortParams.nPorts; i++)
-        processorMain->queue(CreateTask(Flush, i, shared_ptr<void>(data, nullDeleter)));
+        processorMain->queue(CreateTask(Flush, i, NotOwned(data)));
 
       return;
     }
@@ -310,7 +330,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
         GetPort(i)->enable = false;
         GetPort(i)->isTransientToDisable = true;
         isSettingsInit = false;
-        processorMain->queue(CreateTask(DisablePort, i, shared_ptr<void>(data, nullDeleter)));
+        processorMain->queue(CreateTask(DisablePort, i, NotOwned(data)));
       }
 
       return;
@@ -334,7 +354,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
         GetPort(i)->enable = true;
         GetPort(i)->isTransientToEnable = true;
         isSettingsInit = true;
-        processorMain->queue(CreateTask(EnablePort, i, shared_ptr<void>(data, nullDeleter)));
+        processorMain->queue(CreateTask(EnablePort, i, NotOwned(data)));
       }
 
       return;
@@ -361,7 +381,7 @@ void Component::CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR da
     throw OMX_ErrorBadParameter;
   }
 
-  processorMain->queue(CreateTask(taskCommand, param, shared_ptr<void>(data, nullDeleter)));
+  processorMain->queue(CreateTask(taskCommand, param, NotOwned(data)));
 }
 
 OMX_ERRORTYPE Component::SendCommand(OMX_IN OMX_COMMANDTYPE cmd, OMX_IN OMX_U32 param, OMX_IN OMX_PTR data)
@@ -986,7 +1006,7 @@ OMX_ERRORTYPE Component::EmptyThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   OMXChecker::CheckStateOperation(AL_EmptyThisBuffer, state);
   CheckPortIndex(header->nInputPortIndex);
 
-  processorMain->queue(CreateTask(EmptyBuffer, static_cast<OMX_U32>(input.index), shared_ptr<void>(header, nullDeleter)));
+  processorMain->queue(CreateTask(EmptyBuffer, static_cast<OMX_U32>(input.index), NotOwned(header)));
 
   return OMX_ErrorNone;
   OMX_CATCH();
@@ -1004,7 +1024,7 @@ OMX_ERRORTYPE Component::FillThisBuffer(OMX_IN OMX_BUFFERHEADERTYPE* header)
   header->pMarkData = NULL;
   header->nFlags = 0;
 
-  processorMain->queue(CreateTask(FillBuffer, static_cast<OMX_U32>(output.index), shared_ptr<void>(header, nullDeleter)));
+  processorMain->queue(CreateTask(FillBuffer, static_cast<OMX_U32>(output.index), NotOwned(header)));
 
   return OMX_ErrorNone;
   OMX_CATCH();
@@ -1063,6 +1083,20 @@ OMX_ERRORTYPE Component::GetConfig(OMX_IN OMX_INDEXTYPE index, OMX_INOUT OMX_PTR
     gop.nPFrames = ConvertMediaToOMXPFrames(moduleGop);
     return OMX_ErrorNone;
   }
+  case OMX_ALG_IndexConfigVideoSubframeLatency:
+  {
+    SubframeLatency moduleLatency;
+
+    if(module->GetDynamic(DYNAMIC_INDEX_SUBFRAME_LATENCY, &moduleLatency) != SUCCESS)
+      return OMX_ErrorUnsupportedIndex;
+
+    auto& latency = *(static_cast<OMX_ALG_VIDEO_CONFIG_SUBFRAME_LATENCY*>(config));
+    latency.nFrames = moduleLatency.frames;
+    latency.nLastLatency = moduleLatency.last;
+    latency.nMeanLatency = moduleLatency.mean;
+    latency.nMaxLatency = moduleLatency.max;
+    return OMX_ErrorNone;
+  }
   default:
     LOGE("%s is unsupported", ToStringOMXIndex.at(index));
     return OMX_ErrorUnsupportedIndex;
@@ -1258,6 +1292,8 @@ void Component::PopulatingPorts()
       throw OMX_ErrorInsufficientResources;
     }
   }
+
+  ReservePools();
 }
 
 void Component::UnpopulatingPorts()
@@ -1280,8 +1316,8 @@ void Component::FlushFillEmptyBuffers()
   auto d = bind(&Component::_DeleteFillEmpty, this, placeholders::_1);
   auto p = bind(&Component::_ProcessFillBuffer, this, placeholders::_1);
   auto p2 = bind(&Component::_ProcessEmptyBuffer, this, placeholders::_1);
-  processorFill.reset(new ProcessorFifo(p, d));
-  processorEmpty.reset(new ProcessorFifo(p2, d));
+  processorFill.reset(new ProcessorFifo(p, d, "omx_fill"));
+  processorEmpty.reset(new ProcessorFifo(p2, d, "omx_empty"));
 }
 
 void Component::CleanFlushFillEmptyBuffers()
@@ -1449,6 +1485,7 @@ void Component::TreatEnablePortCommand(Task* task)
     if(port->error)
       return;
 
+    ReservePools();
     port->isTransientToEnable = false;
   }
 
@@ -1474,7 +1511,7 @@ void Component::TreatEmptyBufferCommand(Task* task)
   auto header = static_cast<OMX_BUFFERHEADERTYPE*>(task->opt.get());
   assert(header);
   AttachMark(header);
-  auto handle = new OMXBufferHandle(header);
+  auto handle = handlePool.acquire(header);
   auto success = module->Empty(handle);
   assert(success);
 }
@@ -1493,7 +1530,7 @@ void Component::TreatFillBufferCommand(Task* task)
     return;
   }
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = handlePool.acquire(header);
   auto success = module->Fill(handle);
   assert(success);
 }
@@ -1669,13 +1706,13 @@ void Component::_ProcessMain(void* data)
     assert(0 == "bad command");
   }
 
-  delete task;
+  taskPool.release(task);
 }
 
 void Component::_Delete(void* data)
 {
   auto task = static_cast<Task*>(data);
-  delete task;
+  taskPool.release(task);
 }
 
 void Component::_DeleteFillEmpty(void* data)
@@ -1697,7 +1734,7 @@ void Component::_DeleteFillEmpty(void* data)
     assert(header);
     callbacks.EmptyBufferDone(component, app, header);
   }
-  delete task;
+  taskPool.release(task);
 }
 
 void Component::_ProcessFillBuffer(void* data)
@@ -1712,7 +1749,7 @@ void Component::_ProcessFillBuffer(void* data)
     TreatSignalCommand(task);
   else
     assert(0 == "bad command");
-  delete task;
+  taskPool.release(task);
 }
 
 void Component::_ProcessEmptyBuffer(void* data)
@@ -1727,6 +1764,6 @@ void Component::_ProcessEmptyBuffer(void* data)
     TreatSignalCommand(task);
   else
     assert(0 == "bad command");
-  delete task;
+  taskPool.release(task);
 }
 
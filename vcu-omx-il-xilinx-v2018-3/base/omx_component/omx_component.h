@@ -42,6 +42,7 @@
 #include "base/omx_module/omx_module_interface.h"
 #include "base/omx_mediatype/omx_mediatype_interface.h"
 #include "base/omx_utils/processor_fifo.h"
+#include "base/omx_utils/object_pool.h"
 #include "omx_buffer_handle.h"
 #include "omx_convert_omx_media.h"
 #include "omx_component_getset.h"
@@ -52,6 +53,7 @@
 #include <mutex>
 #include <memory>
 #include <future>
+#include <queue>
 
 #define ALLEGRODVT_OMX_VERSION 3
 
@@ -124,6 +126,9 @@ struct Component : public OMXComponentInterface
 
 protected:
   OMX_HANDLETYPE const component;
+  /* declared first so that they outlive the module and the processors */
+  object_pool<Task> taskPool;
+  object_pool<OMXBufferHandle> handlePool;
   std::shared_ptr<MediatypeInterface> media;
   std::unique_ptr<ModuleInterface> module;
   std::unique_ptr<Expertise> expertise;
@@ -161,12 +166,14 @@ protected:
   void CheckPortIndex(int index);
   Port* GetPort(int index);
   void PopulatingPorts();
+  void ReservePools();
   void UnpopulatingPorts();
   void FlushFillEmptyBuffers();
   void CleanFlushFillEmptyBuffers();
   void BlockFillEmptyBuffers();
   void UnblockFillEmptyBuffers();
 
+  Task* CreateTask(Command cmd, OMX_U32 data, std::shared_ptr<void> opt);
   void CreateCommand(OMX_COMMANDTYPE command, OMX_U32 param, OMX_PTR data);
   void TreatSetStateCommand(Task* task);
   void TreatFlushCommand(Task* task);
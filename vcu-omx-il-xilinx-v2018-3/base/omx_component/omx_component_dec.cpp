@@ -66,7 +66,7 @@ DecComponent::~DecComponent() = default;
 void DecComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto header = (OMX_BUFFERHEADERTYPE*)((OMXBufferHandle*)handle)->header;
-  delete handle;
+  handlePool.release((OMXBufferHandle*)handle);
   ClearPropagatedData(header);
 
   if(callbacks.EmptyBufferDone)
@@ -80,13 +80,12 @@ void DecComponent::AssociateCallBack(BufferHandleInterface*, BufferHandleInterfa
   if(transmit.empty())
     return;
 
-  auto emptyHeader = transmit.front();
+  auto emptyHeader = transmit.pop();
   auto fillHeader = (OMX_BUFFERHEADERTYPE*)((OMXBufferHandle*)fill)->header;
   assert(fillHeader);
   fillHeader->hMarkTargetComponent = emptyHeader.hMarkTargetComponent;
   fillHeader->pMarkData = emptyHeader.pMarkData;
   fillHeader->nTimeStamp = emptyHeader.nTimeStamp;
-  transmit.pop_front();
 
   if(IsEOSDetected(emptyHeader.nFlags))
   {
@@ -102,7 +101,7 @@ void DecComponent::FillThisBufferCallBack(BufferHandleInterface* filled, int off
 {
   assert(filled);
   auto header = (OMX_BUFFERHEADERTYPE*)((OMXBufferHandle*)filled)->header;
-  delete filled;
+  handlePool.release((OMXBufferHandle*)filled);
 
   header->nOffset = offset;
   header->nFilledLen = size;
@@ -276,9 +275,9 @@ void DecComponent::TreatEmptyBufferCommand(Task* task)
   AttachMark(header);
 
   if(header->nFlags & OMX_BUFFERFLAG_ENDOFFRAME)
-    transmit.push_back(PropagatedData(header->hMarkTargetComponent, header->pMarkData, header->nTimeStamp, header->nFlags));
+    transmit.push(PropagatedData(header->hMarkTargetComponent, header->pMarkData, header->nTimeStamp, header->nFlags));
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = handlePool.acquire(header);
   auto success = module->Empty(handle);
   assert(success);
 }
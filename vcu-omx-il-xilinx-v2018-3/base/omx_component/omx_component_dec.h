@@ -41,7 +41,7 @@
 
 #include "omx_component.h"
 #include "base/omx_module/omx_module_dec.h"
-#include <list>
+#include "base/omx_utils/ring_queue.h"
 
 struct DecComponent : public Component
 {
@@ -54,14 +54,15 @@ struct DecComponent : public Component
 private:
   struct PropagatedData
   {
+    PropagatedData() = default;
     PropagatedData(OMX_HANDLETYPE hMarkTargetComponent, OMX_PTR pMarkData, OMX_TICKS nTimeStamp, OMX_U32 nFlags) :
       hMarkTargetComponent(hMarkTargetComponent), pMarkData(pMarkData), nTimeStamp(nTimeStamp), nFlags(nFlags)
     {
     };
-    OMX_HANDLETYPE hMarkTargetComponent;
-    OMX_PTR pMarkData;
-    OMX_TICKS nTimeStamp;
-    OMX_U32 nFlags;
+    OMX_HANDLETYPE hMarkTargetComponent {};
+    OMX_PTR pMarkData {};
+    OMX_TICKS nTimeStamp {};
+    OMX_U32 nFlags {};
   };
   void EmptyThisBufferCallBack(BufferHandleInterface* handle) override;
   void AssociateCallBack(BufferHandleInterface* empty, BufferHandleInterface* fill) override;
@@ -69,7 +70,7 @@ private:
   void EventCallBack(CallbackEventType type, void* data) override;
 
   void TreatEmptyBufferCommand(Task* task) override;
-  std::list<PropagatedData> transmit;
+  ring_queue<PropagatedData> transmit;
   std::mutex mutex;
 };
 
@@ -66,7 +66,7 @@ EncComponent::~EncComponent() = default;
 void EncComponent::EmptyThisBufferCallBack(BufferHandleInterface* handle)
 {
   auto header = ((OMXBufferHandle*)(handle))->header;
-  delete handle;
+  handlePool.release((OMXBufferHandle*)handle);
 
   ClearPropagatedData(header);
 
@@ -115,7 +115,7 @@ void EncComponent::FillThisBufferCallBack(BufferHandleInterface* filled, int off
 {
   assert(filled);
   auto header = (OMX_BUFFERHEADERTYPE*)(((OMXBufferHandle*)(filled))->header);
-  delete filled;
+  handlePool.release((OMXBufferHandle*)filled);
 
   header->nOffset = offset;
   header->nFilledLen = size;
@@ -283,12 +283,14 @@ OMX_ERRORTYPE EncComponent::FreeBuffer(OMX_IN OMX_U32 index, OMX_IN OMX_BUFFERHE
   if((transientState != TransientIdleToLoaded) && (!port->isTransientToDisable))
     callbacks.EventHandler(component, app, OMX_EventError, OMX_ErrorPortUnpopulated, 0, nullptr);
 
-  if(isBufferAllocatedByModule(header))
-  {
-    auto bufferHandlePort = IsInputPort(index) ? ToEncModule(*module).GetBufferHandles().input : ToEncModule(*module).GetBufferHandles().output;
-    bool dmaOnPort = (bufferHandlePort == BufferHandleType::BUFFER_HANDLE_FD);
-    dmaOnPort ? ToEncModule(*module).FreeDMA(static_cast<int>((intptr_t)header->pBuffer)) : module->Free(header->pBuffer);
-  }
+  auto bufferHandlePort = IsInputPort(index) ? ToEncModule(*module).GetBufferHandles().input : ToEncModule(*module).GetBufferHandles().output;
+  bool dmaOnPort = (bufferHandlePort == BufferHandleType::BUFFER_HANDLE_FD);
+
+  /* the dmabufs of the client are forgotten by the import cache too */
+  if(dmaOnPort)
+    ToEncModule(*module).FreeDMA(static_cast<int>((intptr_t)header->pBuffer));
+  else if(isBufferAllocatedByModule(header))
+    module->Free(header->pBuffer);
 
   if(IsInputPort(index))
   {
@@ -323,7 +325,7 @@ void EncComponent::TreatEmptyBufferCommand(Task* task)
     roiMap.Add(header, roiBuffer);
   }
 
-  auto handle = new OMXBufferHandle(header);
+  auto handle = handlePool.acquire(header);
   auto success = module->Empty(handle);
 
   shouldClearROI = true;
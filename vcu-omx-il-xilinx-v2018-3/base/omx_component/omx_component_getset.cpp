@@ -53,6 +53,12 @@ using namespace std;
     return OMX_ErrorBadParameter; \
   assert(ret == MediatypeInterface::ERROR_SETTINGS_NONE);
 
+/* a Set translates and checks the whole structure again: reapplying the
+ * current value is left out */
+#define OMX_SKIP_UNCHANGED(current, wanted) \
+  if(wanted == current) \
+    return OMX_ErrorNone;
+
 // Common
 
 OMX_ERRORTYPE ConstructPortSupplier(OMX_PARAM_BUFFERSUPPLIERTYPE& s, Port const& port)
@@ -218,8 +224,10 @@ OMX_ERRORTYPE SetFormat(OMX_COLOR_FORMATTYPE const& color, shared_ptr<MediatypeI
   Format format;
   auto ret = media->Get(SETTINGS_INDEX_FORMAT, &format);
   OMX_CHECK_MEDIA_GET(ret);
+  auto const current = format;
   format.color = ConvertOMXToMediaColor(color);
   format.bitdepth = ConvertOMXToMediaBitdepth(color);
+  OMX_SKIP_UNCHANGED(current, format);
   ret = media->Set(SETTINGS_INDEX_FORMAT, &format);
   OMX_CHECK_MEDIA_SET(ret)
   return OMX_ErrorNone;
@@ -253,10 +261,12 @@ OMX_ERRORTYPE SetResolution(OMX_VIDEO_PORTDEFINITIONTYPE const& definition, shar
   Resolution resolution;
   auto ret = media->Get(SETTINGS_INDEX_RESOLUTION, &resolution);
   OMX_CHECK_MEDIA_GET(ret);
+  auto const current = resolution;
   resolution.width = definition.nFrameWidth;
   resolution.height = definition.nFrameHeight;
   resolution.stride.widthStride = definition.nStride;
   resolution.stride.heightStride = definition.nSliceHeight;
+  OMX_SKIP_UNCHANGED(current, resolution);
   ret = media->Set(SETTINGS_INDEX_RESOLUTION, &resolution);
   OMX_CHECK_MEDIA_SET(ret);
   return OMX_ErrorNone;
@@ -268,6 +278,7 @@ OMX_ERRORTYPE SetClock(OMX_U32 framerateInQ16, shared_ptr<MediatypeInterface> me
   auto ret = media->Get(SETTINGS_INDEX_CLOCK, &curClock);
   OMX_CHECK_MEDIA_GET(ret);
   auto clock = ConvertOMXToMediaClock(framerateInQ16);
+  OMX_SKIP_UNCHANGED(curClock, clock);
   curClock.framerate = clock.framerate;
   curClock.clockratio = clock.clockratio;
   ret = media->Set(SETTINGS_INDEX_CLOCK, &curClock);
@@ -275,18 +286,13 @@ OMX_ERRORTYPE SetClock(OMX_U32 framerateInQ16, shared_ptr<MediatypeInterface> me
   return OMX_ErrorNone;
 }
 
-OMX_ERRORTYPE ConstructPortDefinition(OMX_PARAM_PORTDEFINITIONTYPE& def, Port& port, ModuleInterface const& module, shared_ptr<MediatypeInterface> media)
+static OMX_ERRORTYPE TranslatePortDefinition(OMX_PARAM_PORTDEFINITIONTYPE& def, Port& port, ModuleInterface const& module, shared_ptr<MediatypeInterface> media)
 {
   OMXChecker::SetHeaderVersion(def);
   def.nPortIndex = port.index;
   def.eDir = IsInputPort(def.nPortIndex) ? OMX_DirInput : OMX_DirOutput;
   auto requirements = IsInputPort(def.nPortIndex) ? module.GetBufferRequirements().input : module.GetBufferRequirements().output;
 
-  if(port.expected < (size_t)requirements.min)
-    port.expected = requirements.min;
-  def.nBufferCountActual = port.expected;
-  def.bEnabled = ConvertMediaToOMXBool(port.enable);
-  def.bPopulated = ConvertMediaToOMXBool(port.playable);
   def.nBufferCountMin = requirements.min;
   def.nBufferSize = requirements.size;
   def.bBuffersContiguous = ConvertMediaToOMXBool(requirements.contiguous);
@@ -323,11 +329,28 @@ OMX_ERRORTYPE ConstructPortDefinition(OMX_PARAM_PORTDEFINITIONTYPE& def, Port& p
   v.bFlagErrorConcealment = ConvertMediaToOMXBool(false); // XXX
   v.eCompressionFormat = ConvertMediaToOMXCompression(mime.compression);
   v.eColorFormat = ConvertMediaToOMXColor(format.color, format.bitdepth);
-  v.cMIMEType = const_cast<char*>(mime.mime.c_str());
+  port.mime = mime.mime;
+  v.cMIMEType = const_cast<char*>(port.mime.c_str());
   v.pNativeWindow = 0; // XXX
   return OMX_ErrorNone;
 }
 
+OMX_ERRORTYPE ConstructPortDefinition(OMX_PARAM_PORTDEFINITIONTYPE& def, Port& port, ModuleInterface const& module, shared_ptr<MediatypeInterface> media)
+{
+  /* read the version first: settings changed during the translation are
+   * translated again on the next call */
+  def = port.GetDefinition(media->version, [&](OMX_PARAM_PORTDEFINITIONTYPE& definition) {
+    TranslatePortDefinition(definition, port, module, media);
+  });
+
+  if(port.expected < def.nBufferCountMin)
+    port.expected = def.nBufferCountMin;
+  def.nBufferCountActual = port.expected;
+  def.bEnabled = ConvertMediaToOMXBool(port.enable);
+  def.bPopulated = ConvertMediaToOMXBool(port.playable);
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE SetPortDefinition(OMX_PARAM_PORTDEFINITIONTYPE const& settings, Port& port, ModuleInterface& module, shared_ptr<MediatypeInterface> media)
 {
   OMX_PARAM_PORTDEFINITIONTYPE rollback;
@@ -378,15 +401,17 @@ OMX_ERRORTYPE ConstructVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD& la, Port co
   auto ret = media->Get(SETTINGS_INDEX_LOOKAHEAD, &lookAhead);
   OMX_CHECK_MEDIA_GET(ret);
   la.nLookAhead = lookAhead.nLookAhead;
+  la.bEnableEarlyStart = ConvertMediaToOMXBool(lookAhead.isEarlyStart);
   return OMX_ErrorNone;
 }
 
-OMX_ERRORTYPE SetLookAhead(OMX_U32 nLookAhead, shared_ptr<MediatypeInterface> media)
+OMX_ERRORTYPE SetLookAhead(OMX_U32 nLookAhead, OMX_BOOL enableEarlyStart, shared_ptr<MediatypeInterface> media)
 {
   LookAhead lookAhead;
   auto ret = media->Get(SETTINGS_INDEX_LOOKAHEAD, &lookAhead);
   OMX_CHECK_MEDIA_GET(ret);
   lookAhead.nLookAhead = nLookAhead;
+  lookAhead.isEarlyStart = ConvertOMXToMediaBool(enableEarlyStart);
   ret = media->Set(SETTINGS_INDEX_LOOKAHEAD, &lookAhead);
   OMX_CHECK_MEDIA_SET(ret);
   return OMX_ErrorNone;
@@ -397,7 +422,7 @@ OMX_ERRORTYPE SetVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD const& la, Port co
   OMX_ALG_VIDEO_PARAM_LOOKAHEAD rollback;
   ConstructVideoLookAhead(rollback, port, media);
 
-  auto ret = SetLookAhead(la.nLookAhead, media);
+  auto ret = SetLookAhead(la.nLookAhead, la.bEnableEarlyStart, media);
 
   if(ret != OMX_ErrorNone)
   {
@@ -426,12 +451,14 @@ OMX_ERRORTYPE SetModeBitrate(OMX_U32 target, OMX_VIDEO_CONTROLRATETYPE mode, sha
   Bitrate bitrate;
   auto ret = media->Get(SETTINGS_INDEX_BITRATE, &bitrate);
   OMX_CHECK_MEDIA_GET(ret);
+  auto const current = bitrate;
   bitrate.mode = ConvertOMXToMediaControlRate(mode);
   bitrate.target = target;
 
   if(bitrate.max < bitrate.target)
     bitrate.max = bitrate.target;
 
+  OMX_SKIP_UNCHANGED(current, bitrate);
   ret = media->Set(SETTINGS_INDEX_BITRATE, &bitrate);
   OMX_CHECK_MEDIA_SET(ret);
   return OMX_ErrorNone;
@@ -622,11 +649,13 @@ OMX_ERRORTYPE SetMaxBitrate(OMX_U32 max, shared_ptr<MediatypeInterface> media)
   Bitrate bitrate;
   auto ret = media->Get(SETTINGS_INDEX_BITRATE, &bitrate);
   OMX_CHECK_MEDIA_GET(ret);
+  auto const current = bitrate;
   bitrate.max = max;
 
   if(bitrate.target > bitrate.max)
     bitrate.target = bitrate.max;
 
+  OMX_SKIP_UNCHANGED(current, bitrate);
   ret = media->Set(SETTINGS_INDEX_BITRATE, &bitrate);
   OMX_CHECK_MEDIA_SET(ret);
   return OMX_ErrorNone;
@@ -1072,10 +1101,12 @@ OMX_ERRORTYPE SetTargetBitrate(OMX_U32 bitrate, shared_ptr<MediatypeInterface> m
   if(ret == MediatypeInterface::ERROR_SETTINGS_BAD_INDEX)
     return OMX_ErrorUnsupportedIndex;
   assert(ret == MediatypeInterface::ERROR_SETTINGS_NONE);
+  auto const current = curBitrate;
   curBitrate.target = bitrate;
 
   if(curBitrate.max < curBitrate.target)
     curBitrate.max = curBitrate.target;
+  OMX_SKIP_UNCHANGED(current, curBitrate);
   ret = media->Set(SETTINGS_INDEX_BITRATE, &curBitrate);
   OMX_CHECK_MEDIA_SET(ret);
   return OMX_ErrorNone;
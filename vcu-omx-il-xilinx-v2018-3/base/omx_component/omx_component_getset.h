@@ -147,7 +147,7 @@ OMX_ERRORTYPE SetVideoLongTerm(OMX_ALG_VIDEO_PARAM_LONG_TERM const& longTerm, Po
 OMX_ERRORTYPE SetTargetBitrate(OMX_U32 bitrate, std::shared_ptr<MediatypeInterface> media);
 
 OMX_ERRORTYPE ConstructVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD& la, Port const& port, std::shared_ptr<MediatypeInterface> media);
-OMX_ERRORTYPE SetLookAhead(OMX_U32 nLookAhead, std::shared_ptr<MediatypeInterface> media);
+OMX_ERRORTYPE SetLookAhead(OMX_U32 nLookAhead, OMX_BOOL enableEarlyStart, std::shared_ptr<MediatypeInterface> media);
 OMX_ERRORTYPE SetVideoLookAhead(OMX_ALG_VIDEO_PARAM_LOOKAHEAD const& la, Port const& port, std::shared_ptr<MediatypeInterface> media);
 
 // Decoder
@@ -43,6 +43,12 @@
 #include <algorithm>
 #include <mutex>
 #include <memory>
+#include <string>
+
+extern "C"
+{
+#include <OMX_Component.h>
+}
 
 enum Command
 {
@@ -100,6 +106,24 @@ struct Port
   bool isTransientToDisable = false;
   size_t expected;
 
+  /* cMIMEType of the translated definition points to it */
+  std::string mime;
+
+  /* the definition of the settings of version, refreshed by translate when
+   * they changed since the last call */
+  template<typename Translate>
+  OMX_PARAM_PORTDEFINITIONTYPE GetDefinition(int version, Translate translate)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(definitionVersion != version)
+    {
+      translate(definition);
+      definitionVersion = version;
+    }
+    return definition;
+  }
+
   void ResetError()
   {
     std::lock_guard<std::mutex> lock(mutex);
@@ -157,6 +181,9 @@ struct Port
 private:
   std::mutex mutex;
   std::vector<OMX_BUFFERHEADERTYPE*> buffers;
+  /* the definition as translated from the settings of definitionVersion */
+  OMX_PARAM_PORTDEFINITIONTYPE definition;
+  int definitionVersion = -1;
   std::condition_variable cv_full;
   std::condition_variable cv_empty;
 };
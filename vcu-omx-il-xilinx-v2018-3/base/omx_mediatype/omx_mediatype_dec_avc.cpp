@@ -59,6 +59,7 @@ DecMediatypeAVC::~DecMediatypeAVC() = default;
 
 void DecMediatypeAVC::Reset()
 {
+  version++;
   bufferHandles.input = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
   bufferHandles.output = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
 
@@ -101,7 +102,7 @@ static Mimes CreateMimes()
   return mimes;
 }
 
-static int CreateLatency(AL_TDecSettings settings)
+static int CreateLatency(AL_TDecSettings const& settings)
 {
   auto stream = settings.tStream;
   auto buffers = AL_AVC_GetMinOutputBuffersNeeded(stream, settings.iStackSize);
@@ -118,7 +119,7 @@ static int CreateLatency(AL_TDecSettings settings)
   return ceil(timeInMilliseconds);
 }
 
-static BufferCounts CreateBufferCounts(AL_TDecSettings settings)
+static BufferCounts CreateBufferCounts(AL_TDecSettings const& settings)
 {
   BufferCounts bufferCounts;
   bufferCounts.input = 2;
@@ -127,7 +128,7 @@ static BufferCounts CreateBufferCounts(AL_TDecSettings settings)
   return bufferCounts;
 }
 
-static ProfileLevelType CreateProfileLevel(AL_TDecSettings settings)
+static ProfileLevelType CreateProfileLevel(AL_TDecSettings const& settings)
 {
   auto stream = settings.tStream;
   return CreateAVCProfileLevel(static_cast<AL_EProfile>(stream.iProfileIdc), stream.iLevel);
@@ -272,6 +273,8 @@ MediatypeInterface::ErrorSettingsType DecMediatypeAVC::Set(std::string index, vo
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
+  version++;
+
   if(index == "SETTINGS_INDEX_CLOCK")
   {
     auto clock = *(static_cast<Clock const*>(settings));
@@ -48,7 +48,7 @@ extern "C"
 
 using namespace std;
 
-Clock CreateClock(AL_TDecSettings settings)
+Clock CreateClock(AL_TDecSettings const& settings)
 {
   Clock clock;
 
@@ -70,7 +70,7 @@ bool UpdateClock(AL_TDecSettings& settings, Clock clock)
   return true;
 }
 
-int CreateInternalEntropyBuffer(AL_TDecSettings settings)
+int CreateInternalEntropyBuffer(AL_TDecSettings const& settings)
 {
   return settings.iStackSize;
 }
@@ -85,7 +85,7 @@ bool UpdateInternalEntropyBuffer(AL_TDecSettings& settings, int internalEntropyB
   return true;
 }
 
-SequencePictureModeType CreateSequenceMode(AL_TDecSettings settings)
+SequencePictureModeType CreateSequenceMode(AL_TDecSettings const& settings)
 {
   auto stream = settings.tStream;
   return ConvertSoftToModuleSequenceMode(stream.eSequenceMode);
@@ -101,7 +101,7 @@ bool UpdateSequenceMode(AL_TDecSettings& settings, SequencePictureModeType seque
   return true;
 }
 
-Format CreateFormat(AL_TDecSettings settings)
+Format CreateFormat(AL_TDecSettings const& settings)
 {
   Format format;
   auto stream = settings.tStream;
@@ -127,7 +127,7 @@ bool UpdateFormat(AL_TDecSettings& settings, Format format, vector<ColorType> co
   return true;
 }
 
-Resolution CreateResolution(AL_TDecSettings settings, int widthStride, int heightStride)
+Resolution CreateResolution(AL_TDecSettings const& settings, int widthStride, int heightStride)
 {
   auto streamSettings = settings.tStream;
   Resolution resolution;
@@ -139,7 +139,7 @@ Resolution CreateResolution(AL_TDecSettings settings, int widthStride, int heigh
   return resolution;
 }
 
-DecodedPictureBufferType CreateDecodedPictureBuffer(AL_TDecSettings settings)
+DecodedPictureBufferType CreateDecodedPictureBuffer(AL_TDecSettings const& settings)
 {
   return ConvertSoftToModuleDecodedPictureBuffer(settings.eDpbMode);
 }
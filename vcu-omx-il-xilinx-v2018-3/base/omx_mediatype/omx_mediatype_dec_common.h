@@ -46,22 +46,22 @@ extern "C"
 #include <lib_decode/lib_decode.h>
 }
 
-Clock CreateClock(AL_TDecSettings settings);
+Clock CreateClock(AL_TDecSettings const& settings);
 bool UpdateClock(AL_TDecSettings& settings, Clock clock);
 
-int CreateInternalEntropyBuffer(AL_TDecSettings settings);
+int CreateInternalEntropyBuffer(AL_TDecSettings const& settings);
 bool UpdateInternalEntropyBuffer(AL_TDecSettings& settings, int internalEntropyBuffer);
 
-SequencePictureModeType CreateSequenceMode(AL_TDecSettings settings);
+SequencePictureModeType CreateSequenceMode(AL_TDecSettings const& settings);
 bool UpdateSequenceMode(AL_TDecSettings& settings, SequencePictureModeType sequenceMode, std::vector<SequencePictureModeType> sequenceModes);
 
-Format CreateFormat(AL_TDecSettings settings);
+Format CreateFormat(AL_TDecSettings const& settings);
 bool UpdateFormat(AL_TDecSettings& settings, Format format, std::vector<ColorType> colors, std::vector<int> bitdepths, int& stride, Stride strideAlignment);
 
-Resolution CreateResolution(AL_TDecSettings settings, int widthStride, int heightStride);
+Resolution CreateResolution(AL_TDecSettings const& settings, int widthStride, int heightStride);
 bool UpdateResolution(AL_TDecSettings& settings, int& stride, int& sliceHeight, Stride strideAlignment, Resolution resolution);
 
-DecodedPictureBufferType CreateDecodedPictureBuffer(AL_TDecSettings settings);
+DecodedPictureBufferType CreateDecodedPictureBuffer(AL_TDecSettings const& settings);
 
 bool UpdateIsEnabledSubFrame(AL_TDecSettings& settings, bool isEnabledSubFrame);
 
@@ -59,6 +59,7 @@ DecMediatypeHEVC::~DecMediatypeHEVC() = default;
 
 void DecMediatypeHEVC::Reset()
 {
+  version++;
   bufferHandles.input = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
   bufferHandles.output = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
 
@@ -107,7 +108,7 @@ static Mimes CreateMimes()
   return mimes;
 }
 
-static int CreateLatency(AL_TDecSettings settings)
+static int CreateLatency(AL_TDecSettings const& settings)
 {
   auto stream = settings.tStream;
   auto buffers = AL_HEVC_GetMinOutputBuffersNeeded(stream, settings.iStackSize);
@@ -124,7 +125,7 @@ static int CreateLatency(AL_TDecSettings settings)
   return ceil(timeInMilliseconds);
 }
 
-static BufferCounts CreateBufferCounts(AL_TDecSettings settings)
+static BufferCounts CreateBufferCounts(AL_TDecSettings const& settings)
 {
   BufferCounts bufferCounts;
   bufferCounts.input = 2;
@@ -133,7 +134,7 @@ static BufferCounts CreateBufferCounts(AL_TDecSettings settings)
   return bufferCounts;
 }
 
-static ProfileLevelType CreateProfileLevel(AL_TDecSettings settings, int tier)
+static ProfileLevelType CreateProfileLevel(AL_TDecSettings const& settings, int tier)
 {
   auto stream = settings.tStream;
   return IsHighTier(tier) ? CreateHEVCHighTierProfileLevel(static_cast<AL_EProfile>(stream.iProfileIdc), stream.iLevel) : CreateHEVCMainTierProfileLevel(static_cast<AL_EProfile>(stream.iProfileIdc), stream.iLevel);
@@ -280,6 +281,8 @@ MediatypeInterface::ErrorSettingsType DecMediatypeHEVC::Set(std::string index, v
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
+  version++;
+
   if(index == "SETTINGS_INDEX_CLOCK")
   {
     auto clock = *(static_cast<Clock const*>(settings));
@@ -66,6 +66,7 @@ EncMediatypeAVC::~EncMediatypeAVC() = default;
 
 void EncMediatypeAVC::Reset()
 {
+  version++;
   bufferHandles.input = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
   bufferHandles.output = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
 
@@ -93,6 +94,7 @@ void EncMediatypeAVC::Reset()
 #if AL_ENABLE_TWOPASS
   settings.LookAhead = 0;
 #endif
+  isLookAheadEarlyStart = false;
 
   stride = RoundUp(AL_EncGetMinPitch(channel.uWidth, AL_GET_BITDEPTH(channel.ePicFormat), AL_FB_RASTER), strideAlignment.widthStride);
   sliceHeight = RoundUp(channel.uHeight, strideAlignment.heightStride);
@@ -114,7 +116,7 @@ static Mimes CreateMimes()
   return mimes;
 }
 
-static int CreateLatency(AL_TEncSettings settings)
+static int CreateLatency(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   auto rateControl = channel.tRCParam;
@@ -139,19 +141,19 @@ static int CreateLatency(AL_TEncSettings settings)
   return ceil(timeInMilliseconds);
 }
 
-static bool CreateLowBandwidth(AL_TEncSettings settings)
+static bool CreateLowBandwidth(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return channel.pMeRange[SLICE_P][1] == 8;
 }
 
-static EntropyCodingType CreateEntropyCoding(AL_TEncSettings settings)
+static EntropyCodingType CreateEntropyCoding(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return ConvertSoftToModuleEntropyCoding(channel.eEntropyMode);
 }
 
-static BufferCounts CreateBufferCounts(AL_TEncSettings settings)
+static BufferCounts CreateBufferCounts(AL_TEncSettings const& settings)
 {
   BufferCounts bufferCounts;
   auto channel = settings.tChParam[0];
@@ -178,13 +180,13 @@ static BufferCounts CreateBufferCounts(AL_TEncSettings settings)
   return bufferCounts;
 }
 
-static LoopFilterType CreateLoopFilter(AL_TEncSettings settings)
+static LoopFilterType CreateLoopFilter(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return ConvertSoftToModuleLoopFilter(channel.eOptions);
 }
 
-static ProfileLevelType CreateProfileLevel(AL_TEncSettings settings)
+static ProfileLevelType CreateProfileLevel(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return CreateAVCProfileLevel(channel.eProfile, channel.uLevel);
@@ -358,7 +360,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Get(std::string index, vo
 
   if(index == "SETTINGS_INDEX_LOOKAHEAD")
   {
-    *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings);
+    *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings, isLookAheadEarlyStart);
     return ERROR_SETTINGS_NONE;
   }
 #endif
@@ -446,6 +448,8 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
+  version++;
+
   if(index == "SETTINGS_INDEX_CLOCK")
   {
     auto clock = *(static_cast<Clock const*>(settings));
@@ -625,7 +629,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeAVC::Set(std::string index, vo
   {
     auto la = *(static_cast<LookAhead const*>(settings));
 
-    if(!UpdateLookAhead(this->settings, la))
+    if(!UpdateLookAhead(this->settings, this->isLookAheadEarlyStart, la))
       return ERROR_SETTINGS_BAD_PARAMETER;
 
     return ERROR_SETTINGS_NONE;
@@ -48,7 +48,7 @@ extern "C"
 
 using namespace std;
 
-Clock CreateClock(AL_TEncSettings settings)
+Clock CreateClock(AL_TEncSettings const& settings)
 {
   Clock clock;
   auto rateCtrl = settings.tChParam[0].tRCParam;
@@ -70,7 +70,7 @@ bool UpdateClock(AL_TEncSettings& settings, Clock clock)
   return true;
 }
 
-Gop CreateGroupOfPictures(AL_TEncSettings settings)
+Gop CreateGroupOfPictures(AL_TEncSettings const& settings)
 {
   Gop gop;
   auto gopParam = settings.tChParam[0].tGopParam;
@@ -112,7 +112,7 @@ bool UpdateGroupOfPictures(AL_TEncSettings& settings, Gop gop)
   return true;
 }
 
-bool CreateConstrainedIntraPrediction(AL_TEncSettings settings)
+bool CreateConstrainedIntraPrediction(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return channel.eOptions & AL_OPT_CONST_INTRA_PRED;
@@ -128,7 +128,7 @@ bool UpdateConstrainedIntraPrediction(AL_TEncSettings& settings, bool isConstrai
   return true;
 }
 
-VideoModeType CreateVideoMode(AL_TEncSettings settings)
+VideoModeType CreateVideoMode(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return ConvertSoftToModuleVideoMode(channel.eVideoMode);
@@ -144,7 +144,7 @@ bool UpdateVideoMode(AL_TEncSettings& settings, VideoModeType videoMode)
   return true;
 }
 
-Bitrate CreateBitrate(AL_TEncSettings settings)
+Bitrate CreateBitrate(AL_TEncSettings const& settings)
 {
   Bitrate bitrate;
   auto rateCtrl = settings.tChParam[0].tRCParam;
@@ -176,7 +176,7 @@ bool UpdateBitrate(AL_TEncSettings& settings, Bitrate bitrate)
   return true;
 }
 
-bool CreateCacheLevel2(AL_TEncSettings settings)
+bool CreateCacheLevel2(AL_TEncSettings const& settings)
 {
   return settings.iPrefetchLevel2 != 0;
 }
@@ -187,7 +187,7 @@ bool UpdateCacheLevel2(AL_TEncSettings& settings, bool isCacheLevel2Enabled)
   return true;
 }
 
-bool CreateFillerData(AL_TEncSettings settings)
+bool CreateFillerData(AL_TEncSettings const& settings)
 {
   return settings.bEnableFillerData;
 }
@@ -198,7 +198,7 @@ bool UpdateFillerData(AL_TEncSettings& settings, bool isFillerDataEnabled)
   return true;
 }
 
-AspectRatioType CreateAspectRatio(AL_TEncSettings settings)
+AspectRatioType CreateAspectRatio(AL_TEncSettings const& settings)
 {
   return ConvertSoftToModuleAspectRatio(settings.eAspectRatio);
 }
@@ -212,7 +212,7 @@ bool UpdateAspectRatio(AL_TEncSettings& settings, AspectRatioType aspectRatio)
   return true;
 }
 
-ScalingListType CreateScalingList(AL_TEncSettings settings)
+ScalingListType CreateScalingList(AL_TEncSettings const& settings)
 {
   return ConvertSoftToModuleScalingList(settings.eScalingList);
 }
@@ -226,7 +226,7 @@ bool UpdateScalingList(AL_TEncSettings& settings, ScalingListType scalingList)
   return true;
 }
 
-QPs CreateQuantizationParameter(AL_TEncSettings settings)
+QPs CreateQuantizationParameter(AL_TEncSettings const& settings)
 {
   QPs qps;
   qps.mode = ConvertSoftToModuleQPControl(settings.eQpCtrlMode);
@@ -261,7 +261,7 @@ bool UpdateQuantizationParameter(AL_TEncSettings& settings, QPs qps)
   return true;
 }
 
-Slices CreateSlicesParameter(AL_TEncSettings settings)
+Slices CreateSlicesParameter(AL_TEncSettings const& settings)
 {
   Slices slices;
   slices.dependent = settings.bDependentSlice;
@@ -284,7 +284,7 @@ bool UpdateSlicesParameter(AL_TEncSettings& settings, Slices slices)
   return true;
 }
 
-Format CreateFormat(AL_TEncSettings settings)
+Format CreateFormat(AL_TEncSettings const& settings)
 {
   Format format;
   auto channel = settings.tChParam[0];
@@ -309,7 +309,7 @@ bool UpdateFormat(AL_TEncSettings& settings, Format format, vector<ColorType> co
   return true;
 }
 
-Resolution CreateResolution(AL_TEncSettings settings, int widthStride, int heightStride)
+Resolution CreateResolution(AL_TEncSettings const& settings, int widthStride, int heightStride)
 {
   auto chan = settings.tChParam[0];
   Resolution resolution;
@@ -348,19 +348,21 @@ bool UpdateResolution(AL_TEncSettings& settings, int& stride, int& sliceHeight,
 }
 
 #if AL_ENABLE_TWOPASS
-LookAhead CreateLookAhead(AL_TEncSettings settings)
+LookAhead CreateLookAhead(AL_TEncSettings const& settings, bool isEarlyStart)
 {
   LookAhead la;
   la.nLookAhead = settings.LookAhead;
+  la.isEarlyStart = isEarlyStart;
   return la;
 }
 
-bool UpdateLookAhead(AL_TEncSettings& settings, LookAhead la)
+bool UpdateLookAhead(AL_TEncSettings& settings, bool& isEarlyStart, LookAhead la)
 {
   if(!CheckLookAhead(la))
     return false;
 
   settings.LookAhead = la.nLookAhead;
+  isEarlyStart = la.isEarlyStart;
 
   return true;
 }
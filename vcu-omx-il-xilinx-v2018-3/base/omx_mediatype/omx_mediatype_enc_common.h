@@ -45,47 +45,47 @@ extern "C"
 #include <lib_common_enc/Settings.h>
 }
 
-Clock CreateClock(AL_TEncSettings settings);
+Clock CreateClock(AL_TEncSettings const& settings);
 bool UpdateClock(AL_TEncSettings& settings, Clock clock);
 
-Gop CreateGroupOfPictures(AL_TEncSettings settings);
+Gop CreateGroupOfPictures(AL_TEncSettings const& settings);
 bool UpdateGroupOfPictures(AL_TEncSettings& settings, Gop gop);
 
-bool CreateConstrainedIntraPrediction(AL_TEncSettings settings);
+bool CreateConstrainedIntraPrediction(AL_TEncSettings const& settings);
 bool UpdateConstrainedIntraPrediction(AL_TEncSettings& settings, bool isConstrainedIntraPredictionEnabled);
 
-VideoModeType CreateVideoMode(AL_TEncSettings settings);
+VideoModeType CreateVideoMode(AL_TEncSettings const& settings);
 bool UpdateVideoMode(AL_TEncSettings& settings, VideoModeType videoMode);
 
-Bitrate CreateBitrate(AL_TEncSettings settings);
+Bitrate CreateBitrate(AL_TEncSettings const& settings);
 bool UpdateBitrate(AL_TEncSettings& settings, Bitrate bitrate);
 
-bool CreateCacheLevel2(AL_TEncSettings settings);
+bool CreateCacheLevel2(AL_TEncSettings const& settings);
 bool UpdateCacheLevel2(AL_TEncSettings& settings, bool isCacheLevel2Enabled);
 
-bool CreateFillerData(AL_TEncSettings settings);
+bool CreateFillerData(AL_TEncSettings const& settings);
 bool UpdateFillerData(AL_TEncSettings& settings, bool isFillerDataEnabled);
 
-AspectRatioType CreateAspectRatio(AL_TEncSettings settings);
+AspectRatioType CreateAspectRatio(AL_TEncSettings const& settings);
 bool UpdateAspectRatio(AL_TEncSettings& settings, AspectRatioType aspectRatio);
 
-ScalingListType CreateScalingList(AL_TEncSettings settings);
+ScalingListType CreateScalingList(AL_TEncSettings const& settings);
 bool UpdateScalingList(AL_TEncSettings& settings, ScalingListType scalingList);
 
-QPs CreateQuantizationParameter(AL_TEncSettings settings);
+QPs CreateQuantizationParameter(AL_TEncSettings const& settings);
 bool UpdateQuantizationParameter(AL_TEncSettings& settings, QPs qps);
 
-Slices CreateSlicesParameter(AL_TEncSettings settings);
+Slices CreateSlicesParameter(AL_TEncSettings const& settings);
 bool UpdateSlicesParameter(AL_TEncSettings& settings, Slices slices);
 
-Format CreateFormat(AL_TEncSettings settings);
+Format CreateFormat(AL_TEncSettings const& settings);
 bool UpdateFormat(AL_TEncSettings& settings, Format format, std::vector<ColorType> colors, std::vector<int> bitdepths, int& stride, Stride strideAlignment);
 
-Resolution CreateResolution(AL_TEncSettings settings, int widthStride, int heightStride);
+Resolution CreateResolution(AL_TEncSettings const& settings, int widthStride, int heightStride);
 bool UpdateResolution(AL_TEncSettings& settings, int& stride, int& sliceHeight, Stride strideAlignment, Resolution resolution);
 
 bool UpdateIsEnabledSubFrame(AL_TEncSettings& settings, bool isEnabledSubFrame);
 
-LookAhead CreateLookAhead(AL_TEncSettings settings);
-bool UpdateLookAhead(AL_TEncSettings& settings, LookAhead la);
+LookAhead CreateLookAhead(AL_TEncSettings const& settings, bool isEarlyStart);
+bool UpdateLookAhead(AL_TEncSettings& settings, bool& isEarlyStart, LookAhead la);
 
@@ -65,6 +65,7 @@ EncMediatypeHEVC::~EncMediatypeHEVC() = default;
 
 void EncMediatypeHEVC::Reset()
 {
+  version++;
   bufferHandles.input = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
   bufferHandles.output = BufferHandleType::BUFFER_HANDLE_CHAR_PTR;
 
@@ -91,6 +92,7 @@ void EncMediatypeHEVC::Reset()
 #if AL_ENABLE_TWOPASS
   settings.LookAhead = 0;
 #endif
+  isLookAheadEarlyStart = false;
 
   stride = RoundUp(AL_EncGetMinPitch(channel.uWidth, AL_GET_BITDEPTH(channel.ePicFormat), AL_FB_RASTER), strideAlignment.widthStride);
   sliceHeight = RoundUp(channel.uHeight, strideAlignment.heightStride);
@@ -117,7 +119,7 @@ static Mimes CreateMimes()
   return mimes;
 }
 
-static int CreateLatency(AL_TEncSettings settings)
+static int CreateLatency(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   auto rateControl = channel.tRCParam;
@@ -139,13 +141,13 @@ static int CreateLatency(AL_TEncSettings settings)
   return ceil(timeInMilliseconds);
 }
 
-static bool CreateLowBandwidth(AL_TEncSettings settings)
+static bool CreateLowBandwidth(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return channel.pMeRange[SLICE_P][1] == 16;
 }
 
-static BufferCounts CreateBufferCounts(AL_TEncSettings settings)
+static BufferCounts CreateBufferCounts(AL_TEncSettings const& settings)
 {
   BufferCounts bufferCounts;
   auto channel = settings.tChParam[0];
@@ -172,13 +174,13 @@ static BufferCounts CreateBufferCounts(AL_TEncSettings settings)
   return bufferCounts;
 }
 
-static LoopFilterType CreateLoopFilter(AL_TEncSettings settings)
+static LoopFilterType CreateLoopFilter(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return ConvertSoftToModuleLoopFilter(channel.eOptions);
 }
 
-static ProfileLevelType CreateProfileLevel(AL_TEncSettings settings)
+static ProfileLevelType CreateProfileLevel(AL_TEncSettings const& settings)
 {
   auto channel = settings.tChParam[0];
   return IsHighTier(channel.uTier) ? CreateHEVCHighTierProfileLevel(channel.eProfile, channel.uLevel) : CreateHEVCMainTierProfileLevel(channel.eProfile, channel.uLevel);
@@ -346,7 +348,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Get(std::string index, v
 
   if(index == "SETTINGS_INDEX_LOOKAHEAD")
   {
-    *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings);
+    *(static_cast<LookAhead*>(settings)) = CreateLookAhead(this->settings, isLookAheadEarlyStart);
     return ERROR_SETTINGS_NONE;
   }
 #endif
@@ -414,6 +416,8 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
   if(!settings)
     return ERROR_SETTINGS_BAD_PARAMETER;
 
+  version++;
+
   if(index == "SETTINGS_INDEX_CLOCK")
   {
     auto clock = *(static_cast<Clock const*>(settings));
@@ -584,7 +588,7 @@ MediatypeInterface::ErrorSettingsType EncMediatypeHEVC::Set(std::string index, v
   {
     auto la = *(static_cast<LookAhead const*>(settings));
 
-    if(!UpdateLookAhead(this->settings, la))
+    if(!UpdateLookAhead(this->settings, this->isLookAheadEarlyStart, la))
       return ERROR_SETTINGS_BAD_PARAMETER;
 
     return ERROR_SETTINGS_NONE;
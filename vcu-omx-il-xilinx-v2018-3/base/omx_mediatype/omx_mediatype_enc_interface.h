@@ -59,5 +59,6 @@ struct EncMediatypeInterface : public MediatypeInterface
   AL_TEncSettings settings;
   int stride;
   int sliceHeight;
+  bool isLookAheadEarlyStart;
 };
 
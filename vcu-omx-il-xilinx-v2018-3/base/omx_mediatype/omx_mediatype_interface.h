@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #define SETTINGS_INDEX_MIMES "SETTINGS_INDEX_MIMES"
@@ -87,6 +88,11 @@ struct MediatypeInterface
   virtual ErrorSettingsType Get(std::string index, void* settings) const = 0;
   virtual ErrorSettingsType Set(std::string index, void const* settings) = 0;
   virtual void Reset() = 0;
+
+  /* bumped each time the settings may have changed: what is translated from
+   * them can be kept as long as the version stays the same. The modules bump
+   * it from their codec threads */
+  std::atomic<int> version { 0 };
 };
 
 #include <map>
@@ -38,6 +38,8 @@
 #include "DummySyncDriver.h"
 #include "SyncLog.h"
 #include <cassert>
+#include <chrono>
+#include <stdexcept>
 
 extern "C"
 {
@@ -52,20 +54,20 @@ typedef uint64_t u64;
 
 using namespace std;
 
-bool isSane(struct xvsfsync_chan_config const& config, int maxChan)
+bool isSane(struct xvsfsync_chan_config const& config, int maxChan, int numFb)
 {
   if(config.channel_id > maxChan)
     return false;
 
-  if(config.fb_id != XVSFSYNC_AUTO_SEARCH && config.fb_id >= MAX_FB_NUMBER)
+  if(config.fb_id != XVSFSYNC_AUTO_SEARCH && config.fb_id >= numFb)
     return false;
 
   return true;
 }
 
-int findAvailableFrameBuffer(ChannelStatus const& channelStatus)
+int findAvailableFrameBuffer(ChannelStatus const& channelStatus, int numFb)
 {
-  for(int fbNum = 0; fbNum < MAX_FB_NUMBER; ++fbNum)
+  for(int fbNum = 0; fbNum < numFb; ++fbNum)
   {
     if(channelStatus.fbAvail[fbNum])
       return fbNum;
@@ -74,9 +76,9 @@ int findAvailableFrameBuffer(ChannelStatus const& channelStatus)
   return -1;
 }
 
-int findFirstBusyFrameBuffer(ChannelStatus const& channelStatus)
+int findFirstBusyFrameBuffer(ChannelStatus const& channelStatus, int numFb)
 {
-  for(int fbNum = 0; fbNum < MAX_FB_NUMBER; ++fbNum)
+  for(int fbNum = 0; fbNum < numFb; ++fbNum)
   {
     if(!channelStatus.fbAvail[fbNum])
       return fbNum;
@@ -171,12 +173,12 @@ static AL_EDriverError xvsfsync_get_chan_status(DummyDriver* pThis, u32* channel
 
 static AL_EDriverError xvsfsync_set_chan_config(DummyDriver* pThis, struct xvsfsync_chan_config* config)
 {
-  assert(isSane(*config, pThis->numChan));
+  assert(isSane(*config, pThis->numChan, pThis->numFb));
   auto& channelStatus = pThis->channelStatuses[config->channel_id];
   int fbNum = config->fb_id;
 
   if(fbNum == XVSFSYNC_AUTO_SEARCH)
-    fbNum = findAvailableFrameBuffer(channelStatus);
+    fbNum = findAvailableFrameBuffer(channelStatus, pThis->numFb);
 
   if(fbNum == -1 || !channelStatus.fbAvail[fbNum])
     return DRIVER_ERROR_UNKNOWN;
@@ -210,23 +212,51 @@ static AL_EDriverError xvsfsync_clear_chan_errors(DummyDriver* pThis, struct xvs
   return DRIVER_SUCCESS;
 }
 
-static AL_EDriverError xvsfsync_poll(DummyDriver* pThis)
+static bool hasErrors(DummyDriver* pThis)
 {
   for(int i = 0; i < pThis->numChan; ++i)
   {
     auto& channelStatus = pThis->channelStatuses[i];
 
     if(channelStatus.watchdogError || channelStatus.syncError)
-      return DRIVER_SUCCESS;
+      return true;
   }
 
-  /* no errors here, we just didn't find anything */
+  return false;
+}
+
+/* must be called with the driver locked */
+static AL_EDriverError xvsfsync_poll(DummyDriver* pThis, unique_lock<mutex>& lock, int timeout)
+{
+  auto isReady = [&] { return pThis->hasEvent || pThis->woken || hasErrors(pThis); };
+
+  if(timeout < 0)
+    pThis->event.wait(lock, isReady);
+  else
+    pThis->event.wait_for(lock, chrono::milliseconds(timeout), isReady);
+
+  pThis->woken = false;
+
+  if(pThis->hasEvent || hasErrors(pThis))
+  {
+    pThis->hasEvent = false;
+    return DRIVER_SUCCESS;
+  }
+
+  /* no events here: timeout or wake up */
   return DRIVER_TIMEOUT;
 }
 
+static void notify(DummyDriver* pThis)
+{
+  pThis->hasEvent = true;
+  pThis->event.notify_all();
+}
+
 AL_EDriverError DummyDriver::PostMessage(int fd, long unsigned int messageId, void* data)
 {
   (void)fd;
+  unique_lock<std::mutex> lock(mutex);
   switch(messageId)
   {
   case XVSFSYNC_GET_CFG:
@@ -248,7 +278,12 @@ AL_EDriverError DummyDriver::PostMessage(int fd, long unsigned int messageId, vo
     return xvsfsync_clear_chan_errors(this, (struct xvsfsync_clr_err*)data);
 
   case AL_POLL_MSG:
-    return xvsfsync_poll(this);
+    return xvsfsync_poll(this, lock, *(int*)data);
+
+  case AL_WAKE_MSG:
+    woken = true;
+    event.notify_all();
+    return DRIVER_SUCCESS;
 
   default:
     return DRIVER_ERROR_UNKNOWN;
@@ -257,39 +292,52 @@ AL_EDriverError DummyDriver::PostMessage(int fd, long unsigned int messageId, vo
 
 void DummyDriver::FinalizeBuffer(int chanId, int fb_id)
 {
+  unique_lock<std::mutex> lock(mutex);
   auto& channelStatus = channelStatuses[chanId];
 
   if(!channelStatus.enable)
     throw runtime_error("Can't finalize a buffer if the channel isn't enabled");
 
   if(fb_id == -1)
-    fb_id = findFirstBusyFrameBuffer(channelStatus);
+    fb_id = findFirstBusyFrameBuffer(channelStatus, numFb);
+
+  if(fb_id == -1)
+    throw runtime_error("No frame buffer is busy");
 
   auto& fbAvail = channelStatus.fbAvail[fb_id];
 
   if(fbAvail)
     throw runtime_error("Frame buffer isn't busy");
   fbAvail = true;
+  notify(this);
 
   Log("framebuffer", "Finalize framebuffer id %d for channel %d\n", fb_id, chanId);
 }
 
 void DummyDriver::SignalSyncError(int chanId)
 {
+  unique_lock<std::mutex> lock(mutex);
   channelStatuses[chanId].syncError = true;
+  notify(this);
 }
 
 void DummyDriver::SignalWatchdogError(int chanId)
 {
+  unique_lock<std::mutex> lock(mutex);
   channelStatuses[chanId].watchdogError = true;
+  notify(this);
 }
 
 static DummyDriver dummyDriver;
 
-DummyDriver* AL_InitDummyDriver(bool encode, int numChan)
+DummyDriver* AL_InitDummyDriver(bool encode, int numChan, int numFb)
 {
+  if(numFb < 1 || numFb > MAX_FB_NUMBER)
+    throw runtime_error("Invalid frame buffer number");
+
   dummyDriver.encode = encode;
   dummyDriver.numChan = numChan;
+  dummyDriver.numFb = numFb;
   dummyDriver.channelStatuses.resize(numChan);
 
   for(auto& channelStatus : dummyDriver.channelStatuses)
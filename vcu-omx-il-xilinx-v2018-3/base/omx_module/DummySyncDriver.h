@@ -43,6 +43,8 @@ extern "C"
 }
 
 #include <vector>
+#include <mutex>
+#include <condition_variable>
 
 #include "SyncIp.h"
 
@@ -57,14 +59,21 @@ struct DummyDriver : public AL_TDriver
 
   /* mock-up interface */
 
+  /* each of them notifies the pollers, like the driver interrupt would */
   void FinalizeBuffer(int chanId, int fb_id = -1);
   void SignalSyncError(int chanId);
   void SignalWatchdogError(int chanId);
   bool encode = true;
   int numChan = 4;
+  int numFb = MAX_FB_NUMBER;
   std::vector<ChannelStatus> channelStatuses {};
+
+  std::mutex mutex {};
+  std::condition_variable event {};
+  bool hasEvent = false;
+  bool woken = false;
 };
 
-DummyDriver* AL_InitDummyDriver(bool encode, int numChan);
+DummyDriver* AL_InitDummyDriver(bool encode, int numChan, int numFb = MAX_FB_NUMBER);
 DummyDriver* AL_GetDummyDriver();
 
@@ -58,6 +58,7 @@ typedef uint64_t u64;
 
 #include "lib_common/BufferSrcMeta.h"
 #include "lib_common/FourCC.h"
+#include "lib_rtos/lib_rtos.h"
 }
 
 #include "SyncLog.h"
@@ -84,8 +85,11 @@ std::unique_lock<L> Lock(L& lockMe)
   return std::unique_lock<L>(lockMe);
 }
 
-SyncIp::SyncIp(AL_TDriver* driver, char const* device) : driver{driver}
+SyncIp::SyncIp(AL_TDriver* driver, char const* device, int fbNumber) : fbNumber{fbNumber}, driver{driver}
 {
+  if(fbNumber < 1 || fbNumber > MAX_FB_NUMBER)
+    throw runtime_error("The sync ip supports 1 to " + to_string(MAX_FB_NUMBER) + " frame buffers per channel");
+
   fd = AL_Driver_Open(driver, device);
 
   if(fd == -1)
@@ -99,14 +103,25 @@ SyncIp::SyncIp(AL_TDriver* driver, char const* device) : driver{driver}
   Log("driver", "[fd: %d] mode: %s, channel number: %d\n", fd, config.encode ? "encode" : "decode", config.max_channels);
   maxChannels = config.max_channels;
   channelStatuses.resize(config.max_channels);
+  notifiedStatuses.resize(config.max_channels);
   eventListeners.resize(config.max_channels);
 
+  /* without a way to wake the thread up on destruction, keep a periodic poll.
+   * The probe only makes the first poll return early */
+  if(AL_Driver_PostMessage(driver, fd, AL_WAKE_MSG, nullptr) != DRIVER_SUCCESS)
+    pollTimeout = 5000;
+
   pollingThread = std::thread(&SyncIp::pollingRoutine, this);
 }
 
 SyncIp::~SyncIp()
 {
-  quit = true;
+  {
+    auto lock = Lock(mutex);
+    quit = true;
+  }
+  quitting.notify_all();
+  AL_Driver_PostMessage(driver, fd, AL_WAKE_MSG, nullptr);
   pollingThread.join();
   AL_Driver_Close(driver, fd);
 }
@@ -144,7 +159,7 @@ int SyncIp::getFreeChannel()
   {
     bool isAvailable = true;
 
-    for(int j = 0; j < MAX_FB_NUMBER; ++j)
+    for(int j = 0; j < fbNumber; ++j)
       isAvailable = isAvailable && channelStatuses[i].fbAvail[j];
 
     if(isAvailable)
@@ -176,7 +191,7 @@ void SyncIp::addBuffer(struct xvsfsync_chan_config* fbConfig)
     throw sync_no_buf_slot_available();
 }
 
-void SyncIp::pollErrors(int timeout)
+void SyncIp::waitEvents(int timeout)
 {
   AL_EDriverError retCode = AL_Driver_PostMessage(driver, fd, AL_POLL_MSG, &timeout);
 
@@ -184,53 +199,72 @@ void SyncIp::pollErrors(int timeout)
     return;
 
   if(retCode != DRIVER_SUCCESS)
-    Log("driver", "Error while polling the errors. (driver error: %d)\n", retCode);
+  {
+    Log("driver", "Error while polling the events. (driver error: %d)\n", retCode);
 
-  auto lock = Lock(mutex);
-  getLatestChanStatus();
+    /* don't spin on a driver which can't be polled */
+    auto lock = Lock(mutex);
+    quitting.wait_for(lock, chrono::milliseconds(5000), [&] { return quit; });
+    return;
+  }
 
-  for(size_t i = 0; i < channelStatuses.size(); ++i)
   {
-    ChannelStatus& status = channelStatuses[i];
+    auto lock = Lock(mutex);
+    getLatestChanStatus();
 
-    if(eventListeners[i] && (status.syncError || status.watchdogError))
+    for(size_t i = 0; i < channelStatuses.size(); ++i)
     {
-      eventListeners[i] (status);
-      resetStatus(i);
+      ChannelStatus& status = channelStatuses[i];
+      notifiedStatuses[i] = status;
+
+      /* the errors are reported once, they would wake us up again otherwise */
+      if(status.syncError || status.watchdogError)
+        resetStatus(i);
     }
   }
+
+  /* the listeners can use the sync ip: call them without its lock */
+  auto lock = Lock(listenersMutex);
+
+  for(size_t i = 0; i < notifiedStatuses.size(); ++i)
+  {
+    if(eventListeners[i])
+      eventListeners[i] (notifiedStatuses[i]);
+  }
 }
 
 void SyncIp::pollingRoutine()
 {
+  Rtos_ApplyThreadConfig("omx_sync_ip");
+
   while(true)
   {
     {
-      Lock(mutex);
+      auto lock = Lock(mutex);
 
       if(quit)
         break;
     }
-    pollErrors(5000);
+    waitEvents(pollTimeout);
   }
 
-  pollErrors(0);
+  waitEvents(0);
 }
 
 template<typename T>
 void SyncIp::addListener(int chanId, T delegate)
 {
-  auto lock = Lock(mutex);
+  auto lock = Lock(listenersMutex);
   eventListeners[chanId] = delegate;
 }
 
 void SyncIp::removeListener(int chanId)
 {
-  auto lock = Lock(mutex);
+  auto lock = Lock(listenersMutex);
   eventListeners[chanId] = nullptr;
 }
 
-ChannelStatus & SyncIp::getStatus(int chanId)
+ChannelStatus SyncIp::getStatus(int chanId)
 {
   auto lock = Lock(mutex);
   getLatestChanStatus();
@@ -317,12 +351,14 @@ SyncChannel::SyncChannel(SyncIp* sync, int id) :  id{id}, sync{sync}
 {
   sync->addListener(id, [&](ChannelStatus& status)
   {
-    Log("channel", "watchdog: %d, sync: %d\n", status.watchdogError, status.syncError);
+    onStatus(status);
   });
 }
 
 SyncChannel::~SyncChannel()
 {
+  sync->removeListener(id);
+
   if(enabled)
     disable();
 
@@ -332,8 +368,6 @@ SyncChannel::~SyncChannel()
     buffers.pop();
     AL_Buffer_Unref(buf);
   }
-
-  sync->removeListener(id);
 }
 
 void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
@@ -356,7 +390,7 @@ void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
    * one of the buffer is finished we replace it with a new one from the queue
    * in a round robin fashion */
 
-  while(isRunning && numFbToEnable > 0 && !buffers.empty())
+  while(isRunning && numFbToEnable > 0 && !buffers.empty() && (int)programmed.size() < sync->fbNumber)
   {
     buf = buffers.front();
 
@@ -366,6 +400,7 @@ void SyncChannel::addBuffer_(AL_TBuffer* buf, int numFbToEnable)
     try
     {
       sync->addBuffer(&config);
+      programmed.push_back(chrono::steady_clock::now());
       Log("framebuffer", "Pushed buffer in sync ip\n");
       printChannelStatus(sync->getStatus(id));
       buffers.pop();
@@ -391,7 +426,7 @@ void SyncChannel::enable()
 {
   auto lock = Lock(mutex);
   isRunning = true;
-  auto numFbToEnable = std::min((int)buffers.size(), MAX_FB_NUMBER);
+  auto numFbToEnable = std::min((int)buffers.size(), sync->fbNumber);
   addBuffer_(nullptr, numFbToEnable);
   sync->enableChannel(id);
   enabled = true;
@@ -406,5 +441,65 @@ void SyncChannel::disable()
   sync->disableChannel(id);
   enabled = false;
   Log("channel", "Disable channel %d\n", id);
+
+  auto lock = Lock(mutex);
+  isRunning = false;
+  programmed.clear();
+  logLatency();
+}
+
+void SyncChannel::onStatus(ChannelStatus const& status)
+{
+  if(status.syncError || status.watchdogError)
+    Log("channel", "watchdog: %d, sync: %d\n", status.watchdogError, status.syncError);
+
+  auto lock = Lock(mutex);
+
+  if(!isRunning)
+    return;
+
+  /* read the status again with the channel locked: no buffer can be
+   * programmed in between */
+  auto const current = sync->getStatus(id);
+  int busy = 0;
+
+  for(int i = 0; i < sync->fbNumber; ++i)
+    busy += current.fbAvail[i] ? 0 : 1;
+
+  /* the sync ip consumes the frame buffers in order */
+  auto consumed = (int)programmed.size() - busy;
+
+  if(consumed <= 0)
+    return;
+
+  auto const now = chrono::steady_clock::now();
+
+  for(int i = 0; i < consumed; ++i)
+  {
+    auto ms = chrono::duration<double, milli>(now - programmed.front()).count();
+    programmed.pop_front();
+
+    latency.minMs = latency.consumed ? std::min(latency.minMs, ms) : ms;
+    latency.maxMs = std::max(latency.maxMs, ms);
+    latency.totalMs += ms;
+    ++latency.consumed;
+  }
+
+  /* refill the slots which were just released */
+  addBuffer_(nullptr, consumed);
+}
+
+SyncLatency SyncChannel::getLatency()
+{
+  auto lock = Lock(mutex);
+  return latency;
+}
+
+void SyncChannel::logLatency()
+{
+  if(!latency.consumed)
+    return;
+
+  Log("latency", "channel %d: %d frame buffers consumed, enable to consume latency min %.3f ms, mean %.3f ms, max %.3f ms\n", id, latency.consumed, latency.minMs, latency.totalMs / latency.consumed, latency.maxMs);
 }
 
@@ -45,10 +45,14 @@ extern "C"
 
 #include <vector>
 #include <queue>
+#include <deque>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
+#include <chrono>
 #include <functional>
 
+/* frame buffer slots of a channel in the sync ip status register */
 static int constexpr MAX_FB_NUMBER = 3;
 struct ChannelStatus
 {
@@ -60,18 +64,22 @@ struct ChannelStatus
 
 struct SyncIp
 {
-  SyncIp(AL_TDriver* driver, char const* device);
+  /* fbNumber: frame buffer slots used per channel, up to MAX_FB_NUMBER */
+  SyncIp(AL_TDriver* driver, char const* device, int fbNumber = MAX_FB_NUMBER);
   ~SyncIp();
   int getFreeChannel();
   void enableChannel(int chanId);
   void disableChannel(int chanId);
   void addBuffer(struct xvsfsync_chan_config* fbConfig);
 
+  /* the listeners are called with the status of their channel on each
+   * notification of the driver, from the sync ip thread */
   template<typename T>
   void addListener(int chanId, T delegate);
   void removeListener(int chanId);
-  ChannelStatus& getStatus(int chanId);
+  ChannelStatus getStatus(int chanId);
   int maxChannels;
+  int fbNumber;
 
 private:
   void getLatestChanStatus();
@@ -79,14 +87,28 @@ private:
   void resetStatus(int chanId);
   int fd = -1;
   bool quit = false;
+  int pollTimeout = -1;
+  std::condition_variable quitting;
   std::thread pollingThread;
   void pollingRoutine();
-  void pollErrors(int timeout);
+  void waitEvents(int timeout);
 
   AL_TDriver* driver;
   std::mutex mutex {};
+  std::mutex listenersMutex {};
   std::vector<std::function<void(ChannelStatus &)>> eventListeners {};
   std::vector<ChannelStatus> channelStatuses {};
+  std::vector<ChannelStatus> notifiedStatuses {};
+};
+
+/* time between the programming of a buffer in the sync ip and the moment
+ * its frame buffer slot is available again */
+struct SyncLatency
+{
+  int consumed = 0;
+  double minMs = 0;
+  double maxMs = 0;
+  double totalMs = 0;
 };
 
 struct SyncChannel
@@ -96,16 +118,20 @@ struct SyncChannel
   void addBuffer(AL_TBuffer* buf);
   void enable();
   void disable();
+  SyncLatency getLatency();
 
   int id;
 
 private:
   bool enabled = false;
   std::queue<AL_TBuffer*> buffers {};
+  std::deque<std::chrono::steady_clock::time_point> programmed {};
+  SyncLatency latency {};
   std::mutex mutex {};
   SyncIp* sync;
   bool isRunning = false;
 
   void addBuffer_(AL_TBuffer* buf, int numFbToEnable);
+  void onStatus(ChannelStatus const& status);
+  void logLatency();
 };
-
@@ -42,6 +42,7 @@ std::map<std::string, bool> g_Categories =
   { "framebuffer", true },
   { "channel", true },
   { "driver", true },
+  { "latency", true },
 };
 
 void printChannelStatus(ChannelStatus const& status)
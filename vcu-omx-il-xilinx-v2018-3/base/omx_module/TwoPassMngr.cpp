@@ -109,6 +109,130 @@ int32_t AL_TwoPassMngr_GetIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc)
   return GetIPRatio(pCurrentMeta, pNextMeta);
 }
 
+/***************************************************************************/
+/*LookAhead fifo*/
+/***************************************************************************/
+void LookAheadFifo::Init(int depth, bool isEarlyStart)
+{
+  assert(iCount == 0);
+  tFrames.assign(depth, Frame {});
+  iHead = 0;
+  iDepth = depth;
+  bEarlyStart = isEarlyStart;
+  iPopped = 0;
+  iWindowSum = 0;
+  iLocalSum = 0;
+  iComplexityCount = 0;
+  iComplexity = 1000;
+  iComplexityDiff = 0;
+}
+
+/***************************************************************************/
+LookAheadFifo::Frame& LookAheadFifo::At(int iIndex)
+{
+  return tFrames[(iHead + iIndex) % iDepth];
+}
+
+/***************************************************************************/
+int LookAheadFifo::WindowSize() const
+{
+  return bEarlyStart ? min(iDepth, iPopped + 1) : iDepth;
+}
+
+/***************************************************************************/
+void LookAheadFifo::Push(AL_TBuffer* pSrc)
+{
+  assert(iCount < iDepth);
+
+  Frame tFrame;
+  tFrame.pSrc = pSrc;
+  tFrame.pMetaData = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_LOOKAHEAD));
+  tFrame.iPictureSize = tFrame.pMetaData ? tFrame.pMetaData->iPictureSize : 0;
+
+  iWindowSum += tFrame.iPictureSize;
+
+  if(iCount < LOCAL_RANGE)
+    iLocalSum += tFrame.iPictureSize;
+
+  ++iCount;
+  At(iCount - 1) = tFrame;
+}
+
+/***************************************************************************/
+AL_TBuffer* LookAheadFifo::Pop(bool bEndOfStream)
+{
+  if(iDepth >= 10)
+    ComputeComplexity(bEndOfStream);
+
+  if(iCount == 0 || (!bEndOfStream && iCount < WindowSize()))
+    return nullptr;
+
+  auto tFrame = At(0);
+  iHead = (iHead + 1) % iDepth;
+  --iCount;
+  ++iPopped;
+
+  iWindowSum -= tFrame.iPictureSize;
+  iLocalSum -= tFrame.iPictureSize;
+
+  if(iCount >= LOCAL_RANGE)
+    iLocalSum += At(LOCAL_RANGE - 1).iPictureSize;
+
+  FillMetaData(tFrame.pMetaData);
+
+  return tFrame.pSrc;
+}
+
+/***************************************************************************/
+void LookAheadFifo::Clear()
+{
+  while(iCount)
+  {
+    AL_Buffer_Unref(At(0).pSrc);
+    iHead = (iHead + 1) % iDepth;
+    --iCount;
+  }
+
+  Init(iDepth, bEarlyStart);
+}
+
+/***************************************************************************/
+void LookAheadFifo::ComputeComplexity(bool bEndOfStream)
+{
+  iComplexityCount++;
+
+  if(iComplexityCount < 5 || !(bEndOfStream || iCount == iDepth))
+    return;
+
+  iComplexityCount = 0;
+  iComplexity = 1000;
+
+  if(iCount >= LOCAL_RANGE && At(0).pMetaData && iWindowSum)
+  {
+    iComplexity = static_cast<int>(((1000 * iCount / LOCAL_RANGE) + iComplexityDiff) * iLocalSum / iWindowSum);
+    iComplexityDiff += (1000 - iComplexity);
+  }
+}
+
+/***************************************************************************/
+void LookAheadFifo::FillMetaData(AL_TLookAheadMetaData* pMetaData)
+{
+  if(!pMetaData)
+    return;
+
+  if(iDepth >= 10)
+    pMetaData->iComplexity = iComplexity;
+
+  if(iCount >= 1)
+  {
+    pMetaData->bNextSceneChange = SceneChangeDetected(pMetaData, At(0).pMetaData);
+    pMetaData->iIPRatio = GetIPRatio(pMetaData, At(0).pMetaData);
+
+    for(int i = 1; i < min(iCount, 3); i++)
+      pMetaData->iIPRatio = min(pMetaData->iIPRatio, GetIPRatio(pMetaData, At(i).pMetaData));
+  }
+}
+
 /***************************************************************************/
 /*Offline TwoPass methods*/
 /***************************************************************************/
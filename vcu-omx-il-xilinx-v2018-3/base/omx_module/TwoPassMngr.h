@@ -60,6 +60,59 @@ bool AL_TwoPassMngr_SceneChangeDetected(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurre
 *****************************************************************************/
 int32_t AL_TwoPassMngr_GetIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNextSrc);
 
+/*
+** Fifo of the frames held back between the lookahead pass and the encoding pass
+** The sizes of the frames in the window are summed as they come in and out,
+** so a frame costs the same whatever the depth
+** In early start, the frames go out before the window is full: the window grows
+** by one frame every two frames until it reaches the depth
+*/
+struct LookAheadFifo
+{
+  void Init(int depth, bool isEarlyStart);
+
+  /* takes over a reference on the source */
+  void Push(AL_TBuffer* pSrc);
+
+  /* gives back the reference of the next source for the encoding pass, with its
+  ** lookahead metadata filled, or nullptr if the window isn't full yet.
+  ** At the end of the stream, the window drains */
+  AL_TBuffer* Pop(bool bEndOfStream);
+
+  /* unrefs the sources left */
+  void Clear();
+
+  int Size() const
+  {
+    return iCount;
+  }
+
+private:
+  struct Frame
+  {
+    AL_TBuffer* pSrc;
+    AL_TLookAheadMetaData* pMetaData;
+    int32_t iPictureSize;
+  };
+
+  Frame& At(int iIndex);
+  int WindowSize() const;
+  void ComputeComplexity(bool bEndOfStream);
+  void FillMetaData(AL_TLookAheadMetaData* pMetaData);
+
+  std::vector<Frame> tFrames;
+  int iHead = 0;
+  int iCount = 0;
+  int iDepth = 0;
+  bool bEarlyStart = false;
+  int iPopped = 0;
+  int64_t iWindowSum = 0; // picture sizes of the whole window
+  int64_t iLocalSum = 0; // picture sizes of its first frames
+  int iComplexityCount = 0;
+  int iComplexity = 1000;
+  int iComplexityDiff = 0;
+};
+
 /***************************************************************************/
 /*Offline TwoPass structures and methods*/
 /***************************************************************************/
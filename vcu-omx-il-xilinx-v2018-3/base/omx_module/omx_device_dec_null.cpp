@@ -0,0 +1,419 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "omx_device_dec_null.h"
+#include "base/omx_utils/ring_queue.h"
+
+#include <cassert>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <sys/mman.h>
+
+extern "C"
+{
+#include <lib_decode/I_DecChannel.h>
+#include <lib_common_dec/DecSliceParam.h>
+}
+
+using namespace std;
+
+/* only the pages which are used get committed */
+static size_t const NULL_ALLOC_MAPPING_SIZE = 1 << 30;
+static size_t const NULL_ALLOC_ALIGNMENT = 64;
+
+namespace
+{
+/* The physical address of a buffer is its offset in the mapping, so the
+ * channel can find its way back to the data */
+struct NullAllocator : public AL_TAllocator
+{
+  NullAllocator();
+  ~NullAllocator();
+
+  AL_HANDLE Alloc(size_t size);
+  bool Free(AL_HANDLE handle);
+  AL_PADDR GetPhysicalAddr(AL_HANDLE handle) const;
+  uint8_t* GetVirtualAddr(AL_PADDR address) const;
+
+private:
+  uint8_t* base;
+  mutex lock {};
+  map<size_t, size_t> freeRanges {}; /* offset -> size */
+};
+
+struct NullDecChannel : public AL_TIDecChannel
+{
+  explicit NullDecChannel(NullAllocator const& allocator);
+  ~NullDecChannel();
+
+  AL_ERR Configure(AL_TDecChanParam* chParam, AL_CB_EndFrameDecoding callback);
+  void SearchSC(AL_TScParam* scParam, AL_TScBufferAddrs* addrs, AL_CB_EndStartCode callback);
+  void Decode(AL_TDecPicParam* picParam);
+
+private:
+  void Process();
+
+  NullAllocator const& allocator;
+  AL_CB_EndFrameDecoding endFrameDecoding {};
+
+  mutex lock {};
+  condition_variable event {};
+  ring_queue<AL_TDecPicStatus> statuses {};
+  bool quit = false;
+  thread worker {};
+};
+}
+
+/* each block is preceded by its size */
+static size_t const NULL_ALLOC_HEADER_SIZE = NULL_ALLOC_ALIGNMENT;
+
+static AL_HANDLE sAlloc(AL_TAllocator* allocator, size_t size)
+{
+  return static_cast<NullAllocator*>(allocator)->Alloc(size);
+}
+
+static bool sFree(AL_TAllocator* allocator, AL_HANDLE handle)
+{
+  return static_cast<NullAllocator*>(allocator)->Free(handle);
+}
+
+static AL_VADDR sGetVirtualAddr(AL_TAllocator*, AL_HANDLE handle)
+{
+  return (AL_VADDR)handle;
+}
+
+static AL_PADDR sGetPhysicalAddr(AL_TAllocator* allocator, AL_HANDLE handle)
+{
+  return static_cast<NullAllocator*>(allocator)->GetPhysicalAddr(handle);
+}
+
+NullAllocator::NullAllocator()
+{
+  static const AL_AllocatorVtable myVtable =
+  {
+    nullptr,
+    &sAlloc,
+    &sFree,
+    &sGetVirtualAddr,
+    &sGetPhysicalAddr,
+    nullptr,
+  };
+
+  vtable = &myVtable;
+
+  auto mapping = mmap(nullptr, NULL_ALLOC_MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+  if(mapping == MAP_FAILED)
+    throw runtime_error("Couldn't map the null device memory");
+
+  base = static_cast<uint8_t*>(mapping);
+  freeRanges[0] = NULL_ALLOC_MAPPING_SIZE;
+}
+
+NullAllocator::~NullAllocator()
+{
+  munmap(base, NULL_ALLOC_MAPPING_SIZE);
+}
+
+AL_HANDLE NullAllocator::Alloc(size_t size)
+{
+  auto const blockSize = NULL_ALLOC_HEADER_SIZE + ((size + NULL_ALLOC_ALIGNMENT - 1) & ~(NULL_ALLOC_ALIGNMENT - 1));
+  lock_guard<mutex> guard(lock);
+
+  for(auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+  {
+    if(it->second < blockSize)
+      continue;
+
+    auto const offset = it->first;
+    auto const remaining = it->second - blockSize;
+    freeRanges.erase(it);
+
+    if(remaining)
+      freeRanges[offset + blockSize] = remaining;
+
+    *(size_t*)(base + offset) = blockSize;
+    return base + offset + NULL_ALLOC_HEADER_SIZE;
+  }
+
+  return nullptr;
+}
+
+bool NullAllocator::Free(AL_HANDLE handle)
+{
+  if(!handle)
+    return true;
+
+  auto offset = (size_t)((uint8_t*)handle - base) - NULL_ALLOC_HEADER_SIZE;
+  auto size = *(size_t*)(base + offset);
+  lock_guard<mutex> guard(lock);
+
+  auto next = freeRanges.lower_bound(offset);
+
+  if(next != freeRanges.end() && offset + size == next->first)
+  {
+    size += next->second;
+    next = freeRanges.erase(next);
+  }
+
+  if(next != freeRanges.begin())
+  {
+    auto prev = std::prev(next);
+
+    if(prev->first + prev->second == offset)
+    {
+      prev->second += size;
+      return true;
+    }
+  }
+
+  freeRanges[offset] = size;
+  return true;
+}
+
+AL_PADDR NullAllocator::GetPhysicalAddr(AL_HANDLE handle) const
+{
+  return (AL_PADDR)((uint8_t*)handle - base);
+}
+
+uint8_t* NullAllocator::GetVirtualAddr(AL_PADDR address) const
+{
+  assert(address < NULL_ALLOC_MAPPING_SIZE);
+  return base + address;
+}
+
+static void sDestroy(AL_TIDecChannel* channel)
+{
+  delete static_cast<NullDecChannel*>(channel);
+}
+
+static AL_ERR sConfigure(AL_TIDecChannel* channel, AL_TDecChanParam* chParam, AL_CB_EndFrameDecoding callback)
+{
+  return static_cast<NullDecChannel*>(channel)->Configure(chParam, callback);
+}
+
+static void sSearchSC(AL_TIDecChannel* channel, AL_TScParam* scParam, AL_TScBufferAddrs* addrs, AL_CB_EndStartCode callback)
+{
+  static_cast<NullDecChannel*>(channel)->SearchSC(scParam, addrs, callback);
+}
+
+static void sDecodeOneFrame(AL_TIDecChannel* channel, AL_TDecPicParam* picParam, AL_TDecPicBufferAddrs*, TMemDesc*)
+{
+  static_cast<NullDecChannel*>(channel)->Decode(picParam);
+}
+
+static void sDecodeOneSlice(AL_TIDecChannel* channel, AL_TDecPicParam* picParam, AL_TDecPicBufferAddrs*, TMemDesc* sliceParam)
+{
+  /* the frame is done with its last slice */
+  if(((AL_TDecSliceParam*)sliceParam->pVirtualAddr)->bIsLastSlice)
+    static_cast<NullDecChannel*>(channel)->Decode(picParam);
+}
+
+NullDecChannel::NullDecChannel(NullAllocator const& allocator) :
+  allocator(allocator)
+{
+  static const AL_TIDecChannelVtable myVtable =
+  {
+    &sDestroy,
+    &sConfigure,
+    &sSearchSC,
+    &sDecodeOneFrame,
+    &sDecodeOneSlice,
+  };
+
+  vtable = &myVtable;
+  worker = thread(&NullDecChannel::Process, this);
+}
+
+NullDecChannel::~NullDecChannel()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    quit = true;
+  }
+  event.notify_one();
+  worker.join();
+}
+
+AL_ERR NullDecChannel::Configure(AL_TDecChanParam* chParam, AL_CB_EndFrameDecoding callback)
+{
+  /* what the mcu would give back */
+  if(chParam->uNumCore == 0)
+    chParam->uNumCore = 1;
+
+  endFrameDecoding = callback;
+  return AL_SUCCESS;
+}
+
+void NullDecChannel::SearchSC(AL_TScParam* scParam, AL_TScBufferAddrs* addrs, AL_CB_EndStartCode callback)
+{
+  auto const stream = allocator.GetVirtualAddr(addrs->pStream);
+  auto const startCodes = (AL_TStartCode*)allocator.GetVirtualAddr(addrs->pBufOut);
+  auto const at = [&](uint32_t i) {
+                    return stream[(addrs->uOffset + i) % addrs->uMaxSize];
+                  };
+
+  /* a start code is only reported with its nal header */
+  uint32_t const headerEnd = scParam->AVC ? 4 : 5;
+  auto const couldStartAt = [&](uint32_t i) {
+                              static uint8_t const prefix[] = { 0x00, 0x00, 0x01 };
+
+                              for(uint32_t k = 0; k < sizeof(prefix) && i + k < addrs->uAvailSize; ++k)
+                              {
+                                if(at(i + k) != prefix[k])
+                                  return false;
+                              }
+
+                              return true;
+                            };
+
+  AL_TScStatus status {};
+  uint32_t i = 0;
+
+  for(; i + headerEnd <= addrs->uAvailSize; ++i)
+  {
+    if(at(i) != 0x00 || at(i + 1) != 0x00 || at(i + 2) != 0x01)
+      continue;
+
+    if(status.uNumSC >= scParam->MaxSize)
+      break;
+
+    auto& startCode = startCodes[status.uNumSC++];
+    startCode.uPosition = (addrs->uOffset + i) % addrs->uMaxSize;
+
+    if(scParam->AVC)
+    {
+      startCode.uNUT = at(i + 3) & 0x1F;
+      startCode.TemporalID = 0;
+    }
+    else
+    {
+      startCode.uNUT = (at(i + 3) >> 1) & 0x3F;
+      startCode.TemporalID = (at(i + 4) & 0x07) - 1;
+    }
+
+    i += 2;
+  }
+
+  /* everything is consumed but what could still be the beginning of a start
+   * code: the end of the last nal unit of the stream has to be seen */
+  while(i < addrs->uAvailSize && !couldStartAt(i))
+    ++i;
+
+  status.uNumBytes = i;
+
+  /* the decoder waits for it, it can come right away */
+  callback.func(callback.userParam, &status);
+}
+
+void NullDecChannel::Decode(AL_TDecPicParam* picParam)
+{
+  AL_TDecPicStatus status {};
+  status.uFrmID = picParam->FrmID;
+  status.uMvID = picParam->MvID;
+
+  {
+    lock_guard<mutex> guard(lock);
+    statuses.push(status);
+  }
+  event.notify_one();
+}
+
+void NullDecChannel::Process()
+{
+  unique_lock<mutex> guard(lock);
+
+  while(true)
+  {
+    event.wait(guard, [&] {
+      return quit || !statuses.empty();
+    });
+
+    /* the frames already sent are still completed, as the mcu would */
+    if(statuses.empty())
+      return;
+
+    auto status = statuses.pop();
+    guard.unlock();
+    endFrameDecoding.func(endFrameDecoding.userParam, &status);
+    guard.lock();
+  }
+}
+
+DecDeviceNull::DecDeviceNull() :
+  allocator(new NullAllocator, [](AL_TAllocator* allocator) {
+    delete static_cast<NullAllocator*>(allocator);
+  })
+{
+}
+
+DecDeviceNull::~DecDeviceNull() = default;
+
+AL_TIDecChannel* DecDeviceNull::Init(AL_TAllocator const& allocator)
+{
+  assert(&allocator == this->allocator.get());
+  return new NullDecChannel(static_cast<NullAllocator const &>(allocator));
+}
+
+void DecDeviceNull::Deinit()
+{
+}
+
+BufferContiguities DecDeviceNull::GetBufferContiguities() const
+{
+  BufferContiguities bufferContiguities;
+  bufferContiguities.input = false;
+  bufferContiguities.output = true;
+  return bufferContiguities;
+}
+
+BufferBytesAlignments DecDeviceNull::GetBufferBytesAlignments() const
+{
+  BufferBytesAlignments bufferBytesAlignments;
+  bufferBytesAlignments.input = 0;
+  bufferBytesAlignments.output = 32;
+  return bufferBytesAlignments;
+}
+
+shared_ptr<AL_TAllocator> DecDeviceNull::GetAllocator() const
+{
+  return allocator;
+}
+
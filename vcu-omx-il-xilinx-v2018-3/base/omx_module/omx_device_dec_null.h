@@ -0,0 +1,63 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "omx_device_dec_interface.h"
+#include <memory>
+
+/* Software stand-in for the decoder: the channel it returns searches the start
+ * codes itself and completes every frame without decoding it, so the omx
+ * layers can be exercised (and measured) on a machine without the ip.
+ *
+ * The channel is given physical addresses, so the module has to allocate with
+ * GetAllocator(): its physical addresses are offsets in a single mapping */
+struct DecDeviceNull : public DecDevice
+{
+  DecDeviceNull();
+  ~DecDeviceNull() override;
+  AL_TIDecChannel* Init(AL_TAllocator const& allocator) override;
+  void Deinit() override;
+  BufferContiguities GetBufferContiguities() const override;
+  BufferBytesAlignments GetBufferBytesAlignments() const override;
+
+  std::shared_ptr<AL_TAllocator> GetAllocator() const;
+
+private:
+  std::shared_ptr<AL_TAllocator> allocator;
+};
+
@@ -0,0 +1,362 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "omx_device_enc_null.h"
+#include "base/omx_utils/ring_queue.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+extern "C"
+{
+#include <lib_encode/IScheduler.h>
+#include <lib_common/BufferAPI.h>
+}
+
+using namespace std;
+
+namespace
+{
+struct NullEncFrame
+{
+  AL_TEncInfo info;
+  bool isEndOfStream;
+};
+
+struct NullEncStream
+{
+  AL_TBuffer* buffer;
+  AL_64U userPtr;
+  uint32_t offset;
+};
+
+struct NullEncChannel
+{
+  NullEncChannel(AL_TEncChanParam const& chParam, AL_TISchedulerCallBacks const& callbacks, int payloadSize, int frameDuration);
+  ~NullEncChannel();
+
+  void Push(NullEncFrame frame);
+  void Push(NullEncStream stream);
+
+private:
+  void Process();
+  void Encode(NullEncFrame const& frame, NullEncStream const& stream, int firstSlice, int sliceCount);
+
+  AL_TEncChanParam const chParam;
+  AL_TISchedulerCallBacks const callbacks;
+  int const payloadSize;
+  int const frameDuration;
+  int const numSlices;
+  int frameNum = 0;
+
+  mutex lock {};
+  condition_variable event {};
+  ring_queue<NullEncFrame> frames {};
+  ring_queue<NullEncStream> streams {};
+  bool quit = false;
+  thread worker {};
+};
+
+struct NullScheduler : public TScheduler
+{
+  NullScheduler(int payloadSize, int frameDuration);
+
+  int const payloadSize;
+  int const frameDuration;
+};
+}
+
+NullEncChannel::NullEncChannel(AL_TEncChanParam const& chParam, AL_TISchedulerCallBacks const& callbacks, int payloadSize, int frameDuration) :
+  chParam(chParam),
+  callbacks(callbacks),
+  payloadSize(payloadSize),
+  frameDuration(frameDuration),
+  numSlices(max((int)chParam.uNumSlices, 1))
+{
+  worker = thread(&NullEncChannel::Process, this);
+}
+
+NullEncChannel::~NullEncChannel()
+{
+  {
+    lock_guard<mutex> guard(lock);
+    quit = true;
+  }
+  event.notify_one();
+  worker.join();
+}
+
+void NullEncChannel::Push(NullEncFrame frame)
+{
+  {
+    lock_guard<mutex> guard(lock);
+    frames.push(frame);
+  }
+  event.notify_one();
+}
+
+void NullEncChannel::Push(NullEncStream stream)
+{
+  {
+    lock_guard<mutex> guard(lock);
+    streams.push(stream);
+  }
+  event.notify_one();
+}
+
+void NullEncChannel::Process()
+{
+  unique_lock<mutex> guard(lock);
+
+  while(true)
+  {
+    event.wait(guard, [&] {
+      return quit || !frames.empty();
+    });
+
+    if(quit)
+      return;
+
+    auto frame = frames.pop();
+
+    if(frame.isEndOfStream)
+    {
+      guard.unlock();
+      callbacks.pfnEndEncodingCallBack(callbacks.pEndEncodingCBParam, nullptr, 0);
+      guard.lock();
+      continue;
+    }
+
+    /* in subframe, the slices come back one by one, each in its own stream buffer */
+    auto const slicesPerStream = chParam.bSubframeLatency ? 1 : numSlices;
+    auto const frameStart = chrono::steady_clock::now();
+
+    for(int slice = 0; slice < numSlices; slice += slicesPerStream)
+    {
+      /* like the mcu, the slices wait for a stream buffer to be encoded in */
+      event.wait(guard, [&] {
+        return quit || !streams.empty();
+      });
+
+      if(quit)
+        return;
+
+      auto stream = streams.pop();
+      guard.unlock();
+
+      if(frameDuration)
+        this_thread::sleep_until(frameStart + chrono::microseconds(frameDuration) * (slice + slicesPerStream) / numSlices);
+
+      Encode(frame, stream, slice, slicesPerStream);
+      guard.lock();
+    }
+
+    ++frameNum;
+  }
+}
+
+static bool isIntra(int frameNum, int gopLength)
+{
+  return gopLength <= 0 ? frameNum == 0 : (frameNum % gopLength) == 0;
+}
+
+void NullEncChannel::Encode(NullEncFrame const& frame, NullEncStream const& stream, int firstSlice, int sliceCount)
+{
+  auto const isAvc = AL_IS_AVC(chParam.eProfile);
+  auto const isIdr = frameNum == 0;
+  auto const type = isIntra(frameNum, chParam.tGopParam.uGopLength) ? SLICE_I : SLICE_P;
+
+  /* the stream part table goes at the end of the buffer, as the mcu does */
+  auto data = AL_Buffer_GetData(stream.buffer);
+  auto const partOffset = (uint32_t)((stream.buffer->zSize - sliceCount * sizeof(AL_TStreamPart)) & ~(size_t)(sizeof(uint32_t) - 1));
+  assert(stream.offset < partOffset);
+  auto parts = (AL_TStreamPart*)(data + partOffset);
+
+  /* a start code and a nal header, then filler standing in for the slice data */
+  uint8_t nal[] = { 0x00, 0x00, 0x00, 0x01, 0x00, 0x01 };
+
+  if(isAvc)
+    nal[4] = isIdr ? 0x65 : 0x41;
+  else
+    nal[4] = isIdr ? 0x26 : 0x02;
+
+  auto const sliceSize = max((uint32_t)(payloadSize / numSlices), (uint32_t)sizeof(nal));
+  auto offset = stream.offset;
+
+  for(int i = 0; i < sliceCount; ++i)
+  {
+    auto const size = min(sliceSize, partOffset - offset);
+    auto const nalSize = min((uint32_t)sizeof(nal), size);
+    memcpy(data + offset, nal, nalSize);
+    memset(data + offset + nalSize, 0x55, size - nalSize);
+
+    parts[i].uOffset = offset;
+    parts[i].uSize = size;
+    offset += size;
+  }
+
+  AL_TEncPicStatus status {};
+  status.UserParam = frame.info.UserParam;
+  status.SrcHandle = frame.info.SrcHandle;
+  status.bIsRef = true;
+  status.uSize = offset - stream.offset;
+  status.iPictureSize = status.uSize;
+  status.iPercentIntra = type == SLICE_I ? 100 : 0;
+  status.iQP = frame.info.iPpsQP;
+  status.iPpsQP = frame.info.iPpsQP;
+  status.uStreamPartOffset = partOffset;
+  status.iNumParts = sliceCount;
+  status.eErrorCode = AL_SUCCESS;
+  status.eType = type;
+  status.ePicStruct = PS_FRM;
+  status.bIsIDR = isIdr;
+  status.bIsFirstSlice = firstSlice == 0;
+  status.bIsLastSlice = firstSlice + sliceCount == numSlices;
+
+  callbacks.pfnEndEncodingCallBack(callbacks.pEndEncodingCBParam, &status, stream.userPtr);
+}
+
+static void sDestroy(TScheduler* scheduler)
+{
+  delete static_cast<NullScheduler*>(scheduler);
+}
+
+static AL_ERR sCreateChannel(AL_HANDLE* hChannel, TScheduler* scheduler, AL_TEncChanParam* chParam, TMemDesc*, AL_TISchedulerCallBacks* callbacks)
+{
+  auto pThis = static_cast<NullScheduler*>(scheduler);
+
+  /* what the mcu would give back */
+  if(chParam->uNumCore == 0)
+    chParam->uNumCore = 1;
+
+  *hChannel = new NullEncChannel(*chParam, *callbacks, pThis->payloadSize, pThis->frameDuration);
+  return AL_SUCCESS;
+}
+
+static bool sDestroyChannel(TScheduler*, AL_HANDLE hChannel)
+{
+  delete static_cast<NullEncChannel*>(hChannel);
+  return true;
+}
+
+static bool sEncodeOneFrame(TScheduler*, AL_HANDLE hChannel, AL_TEncInfo* encInfo, AL_TEncRequestInfo*, AL_TEncPicBufAddrs*)
+{
+  NullEncFrame frame {};
+
+  if(encInfo)
+    frame.info = *encInfo;
+  frame.isEndOfStream = !encInfo;
+  static_cast<NullEncChannel*>(hChannel)->Push(frame);
+  return true;
+}
+
+static void sPutStreamBuffer(TScheduler*, AL_HANDLE hChannel, AL_TBuffer* stream, AL_64U streamUserPtr, uint32_t offset)
+{
+  NullEncStream s { stream, streamUserPtr, offset };
+  static_cast<NullEncChannel*>(hChannel)->Push(s);
+}
+
+static bool sGetRecPicture(TScheduler*, AL_HANDLE, TRecPic*)
+{
+  return false;
+}
+
+static bool sReleaseRecPicture(TScheduler*, AL_HANDLE, TRecPic*)
+{
+  return false;
+}
+
+NullScheduler::NullScheduler(int payloadSize, int frameDuration) :
+  payloadSize(payloadSize),
+  frameDuration(frameDuration)
+{
+  static const TSchedulerVtable myVtable =
+  {
+    &sDestroy,
+    &sCreateChannel,
+    &sDestroyChannel,
+    &sEncodeOneFrame,
+    &sPutStreamBuffer,
+    &sGetRecPicture,
+    &sReleaseRecPicture,
+  };
+
+  vtable = &myVtable;
+}
+
+EncDeviceNull::EncDeviceNull(int payloadSize, int frameDuration) :
+  payloadSize(payloadSize),
+  frameDuration(frameDuration)
+{
+  assert(payloadSize > 0);
+  assert(frameDuration >= 0);
+}
+
+EncDeviceNull::~EncDeviceNull() = default;
+
+TScheduler* EncDeviceNull::Init(AL_TEncSettings, AL_TAllocator const &)
+{
+  return new NullScheduler(payloadSize, frameDuration);
+}
+
+void EncDeviceNull::Deinit(TScheduler* scheduler)
+{
+  if(scheduler)
+    AL_ISchedulerEnc_Destroy(scheduler);
+}
+
+BufferContiguities EncDeviceNull::GetBufferContiguities() const
+{
+  BufferContiguities bufferContiguities;
+  bufferContiguities.input = true;
+  bufferContiguities.output = true;
+  return bufferContiguities;
+}
+
+BufferBytesAlignments EncDeviceNull::GetBufferBytesAlignments() const
+{
+  BufferBytesAlignments bufferBytesAlignments;
+  bufferBytesAlignments.input = 32;
+  bufferBytesAlignments.output = 32;
+  return bufferBytesAlignments;
+}
+
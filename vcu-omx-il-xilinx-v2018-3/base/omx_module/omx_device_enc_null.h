@@ -0,0 +1,62 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "omx_device_enc_interface.h"
+
+/* Software stand-in for the encoder: the scheduler it returns completes every
+ * frame with fake slices instead of talking to the mcu, so the omx layers
+ * can be exercised (and measured) on a machine without the ip.
+ * In subframe, the slices are given back one at a time, as the mcu does */
+struct EncDeviceNull : public EncDevice
+{
+  /* payloadSize is the size of the fake slices written for each frame.
+   * frameDuration (in microseconds) is how long encoding a frame pretends to take,
+   * spread over its slices */
+  explicit EncDeviceNull(int payloadSize = 4096, int frameDuration = 0);
+  ~EncDeviceNull() override;
+  TScheduler* Init(AL_TEncSettings settings, AL_TAllocator const& allocator) override;
+  void Deinit(TScheduler* scheduler) override;
+  BufferContiguities GetBufferContiguities() const override;
+  BufferBytesAlignments GetBufferBytesAlignments() const override;
+
+private:
+  int const payloadSize;
+  int const frameDuration;
+};
+
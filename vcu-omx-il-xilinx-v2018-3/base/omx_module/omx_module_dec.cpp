@@ -64,6 +64,8 @@ DecModule::DecModule(shared_ptr<DecMediatypeInterface> media, shared_ptr<DecDevi
   assert(this->allocator);
   decoder = nullptr;
   isCreated = false;
+  shouldDeferDisplay = false;
+  pendingDisplays = 0;
   ResetRequirements();
 }
 
@@ -194,10 +196,40 @@ void DecModule::CopyIfRequired(AL_TBuffer* frameToDisplay, int size)
   if(shouldBeCopied.Exist(frameToDisplay))
   {
     auto buffer = shouldBeCopied.Get(frameToDisplay);
-    copy(AL_Buffer_GetData(frameToDisplay), AL_Buffer_GetData(frameToDisplay) + size, buffer);
+    assert(copier);
+    copier->Copy(AL_Buffer_GetData(frameToDisplay), size, (uint8_t*)buffer);
   }
 }
 
+void DecModule::DeferDisplay()
+{
+  if(!copier)
+    copier.reset(new ParallelCopy());
+
+  auto display = bind(&DecModule::ProcessDisplayJob, this, placeholders::_1);
+  /* the pending frames are still displayed when the fifo is destroyed */
+  displayFifo.reset(new ProcessorFifo(display, display, "omx_dec_display"));
+  pendingDisplays = 0;
+  shouldDeferDisplay = true;
+}
+
+void DecModule::StopDeferringDisplay()
+{
+  /* the decoder is gone: nothing is queued anymore, the fifo displays what is left */
+  displayFifo.reset();
+  shouldDeferDisplay = false;
+}
+
+void DecModule::ProcessDisplayJob(void* data)
+{
+  auto job = static_cast<DisplayJob*>(data);
+  auto frame = job->frame;
+  auto picStruct = job->picStruct;
+  displayJobs.release(job);
+  DisplayFrame(frame, picStruct);
+  --pendingDisplays;
+}
+
 void DecModule::Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info)
 {
   auto isRelease = (frameToDisplay && info == nullptr);
@@ -205,7 +237,23 @@ void DecModule::Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info)
   if(isRelease)
     return ReleaseBufs(frameToDisplay);
 
-  auto isEOS = (frameToDisplay == nullptr && info == nullptr);
+  auto picStruct = info ? static_cast<int>(info->ePicStruct) : -1;
+
+  /* a frame that isn't copied only waits for the fifo to keep the display
+   * order: once the fifo is empty, it is displayed right away */
+  if(shouldDeferDisplay && (pendingDisplays > 0 || shouldBeCopied.Exist(frameToDisplay)))
+  {
+    ++pendingDisplays;
+    displayFifo->queue(displayJobs.acquire(DisplayJob { frameToDisplay, picStruct }));
+    return;
+  }
+
+  DisplayFrame(frameToDisplay, picStruct);
+}
+
+void DecModule::DisplayFrame(AL_TBuffer* frameToDisplay, int picStruct)
+{
+  auto isEOS = (frameToDisplay == nullptr);
 
   if(isEOS)
   {
@@ -234,10 +282,11 @@ void DecModule::Display(AL_TBuffer* frameToDisplay, AL_TInfoDecode* info)
     return;
   }
 
-  auto size = GetBufferRequirements().output.size;
+  auto size = RawAllocationSize(media->stride, media->sliceHeight, media->settings.tStream.eChroma);
   CopyIfRequired(frameToDisplay, size);
-  currentDisplayPictureType = info->ePicStruct;
-  auto rhandleOut = handlesOut.Pop(frameToDisplay);
+  currentDisplayPictureType = picStruct;
+  auto rhandleOut = handlesOut.Get(frameToDisplay);
+  handlesOut.Set(frameToDisplay, nullptr);
   rhandleOut->offset = 0;
   rhandleOut->payload = size;
   callbacks.filled(rhandleOut, rhandleOut->offset, rhandleOut->payload);
@@ -255,6 +304,7 @@ void DecModule::ResolutionFound(int bufferNumber, int bufferSize, AL_TStreamSett
 
   media->stride = (int)RoundUp(AL_Decoder_GetMinPitch(settings.tDim.iWidth, settings.iBitDepth, media->settings.eFBStorageMode), strideAlignment.widthStride);
   media->sliceHeight = (int)RoundUp(AL_Decoder_GetMinStrideHeight(settings.tDim.iHeight), strideAlignment.heightStride);
+  media->version++;
 
   callbacks.event(CALLBACK_EVENT_RESOLUTION_CHANGE, nullptr);
 }
@@ -267,6 +317,13 @@ ErrorType DecModule::CreateDecoder(bool shouldPrealloc)
     return ERROR_UNDEFINED;
   }
 
+  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &bufferHandles);
+
+  /* the mode is set before the decoder can display: the buffers given by the
+   * application may have to be copied, which mustn't stall the decoder */
+  if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_CHAR_PTR)
+    DeferDisplay();
+
   channel = device->Init(*allocator.get());
   AL_TDecCallBacks decCallbacks {};
   decCallbacks.endDecodingCB = { RedirectionEndDecoding, this };
@@ -278,6 +335,9 @@ ErrorType DecModule::CreateDecoder(bool shouldPrealloc)
   if(errorCode != AL_SUCCESS)
   {
     fprintf(stderr, "Failed to create Decoder: %d\n", errorCode);
+
+    if(shouldDeferDisplay)
+      StopDeferringDisplay();
     return ToModuleError(errorCode);
   }
 
@@ -303,6 +363,10 @@ bool DecModule::DestroyDecoder()
   }
 
   AL_Decoder_Destroy(decoder);
+
+  if(shouldDeferDisplay)
+    StopDeferringDisplay();
+
   device->Deinit();
   decoder = nullptr;
   channel = nullptr;
@@ -342,10 +406,22 @@ void DecModule::Free(void* buffer)
   if(dpb.Exist((char*)buffer))
   {
     auto handle = dpb.Pop((char*)buffer);
-    assert(!handlesOut.Exist(handle));
+    auto rhandleOut = handlesOut.Pop(handle);
+    assert(!rhandleOut);
+    (void)rhandleOut;
     AL_Buffer_Unref(handle);
   }
 
+  if(inputs.Exist((char*)buffer))
+  {
+    auto input = inputs.Pop((char*)buffer);
+    auto rhandleIn = handlesIn.Pop(input);
+    assert(!rhandleIn);
+    (void)rhandleIn;
+    input->hBuf = NULL;
+    AL_Buffer_Destroy(input);
+  }
+
   if(allocated.Exist(buffer))
   {
     auto handle = allocated.Pop(buffer);
@@ -358,12 +434,17 @@ void DecModule::FreeDMA(int fd)
   if(fd < 0)
     return;
 
+  /* the import cache mustn't keep the dmabuf alive once it is given back */
+  AL_LinuxDmaAllocator_ForgetFd((AL_TLinuxDmaAllocator*)allocator.get(), fd);
+
   auto buffer = (char*)((intptr_t)fd);
 
   if(dpb.Exist(buffer))
   {
     auto handle = dpb.Pop(buffer);
-    assert(!handlesOut.Exist(handle));
+    auto rhandleOut = handlesOut.Pop(handle);
+    assert(!rhandleOut);
+    (void)rhandleOut;
     AL_Buffer_Unref(handle);
   }
 
@@ -434,13 +515,20 @@ void DecModule::InputBufferDestroy(AL_TBuffer* input)
   callbacks.emptied(rhandleIn);
 }
 
+void DecModule::InputBufferRelease(AL_TBuffer* input)
+{
+  auto rhandleIn = handlesIn.Get(input);
+  handlesIn.Set(input, nullptr);
+
+  rhandleIn->offset = 0;
+  rhandleIn->payload = 0;
+  callbacks.emptied(rhandleIn);
+}
+
 AL_TBuffer* DecModule::CreateInputBuffer(char* buffer, int size)
 {
   AL_TBuffer* input = nullptr;
 
-  BufferHandles bufferHandles {};
-  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &bufferHandles);
-
   if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
   {
     auto fd = static_cast<int>((intptr_t)buffer);
@@ -460,8 +548,18 @@ AL_TBuffer* DecModule::CreateInputBuffer(char* buffer, int size)
   }
   else
   {
-    if(allocated.Exist(buffer))
-      input = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, RedirectionInputBufferDestroy);
+    if(inputs.Exist(buffer))
+    {
+      input = inputs.Get(buffer);
+      input->zSize = size;
+    }
+    else if(allocated.Exist(buffer))
+    {
+      input = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, RedirectionInputBufferRelease);
+
+      if(input)
+        inputs.Add(buffer, input);
+    }
     else
       input = AL_Buffer_WrapData((uint8_t*)buffer, size, RedirectionInputBufferDestroy);
   }
@@ -486,7 +584,7 @@ bool DecModule::Empty(BufferHandleInterface* handle)
   if(!input)
     return false;
 
-  handlesIn.Add(input, handle);
+  handlesIn.Set(input, handle);
 
   auto eos = (handle->payload == 0);
 
@@ -543,9 +641,6 @@ AL_TBuffer* DecModule::CreateOutputBuffer(char* buffer, int size)
 
   AL_TBuffer* output = nullptr;
 
-  BufferHandles bufferHandles {};
-  media->Get(SETTINGS_INDEX_BUFFER_HANDLES, &bufferHandles);
-
   if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
   {
     auto fd = static_cast<int>((intptr_t)buffer);
@@ -605,7 +700,7 @@ bool DecModule::Fill(BufferHandleInterface* handle)
   if(!output)
     return false;
 
-  handlesOut.Add(output, handle);
+  handlesOut.Set(output, handle);
 
   if(!eosHandles.output)
   {
@@ -41,12 +41,16 @@
 #include "omx_module_enums.h"
 #include "omx_module_codec_structs.h"
 
+#include <atomic>
 #include <vector>
 #include <queue>
 #include <memory>
 
 #include "base/omx_mediatype/omx_mediatype_dec_interface.h"
 #include "base/omx_utils/threadsafe_map.h"
+#include "base/omx_utils/object_pool.h"
+#include "base/omx_utils/parallel_copy.h"
+#include "base/omx_utils/processor_fifo.h"
 
 extern "C"
 {
@@ -94,8 +98,15 @@ private:
   int currentDisplayPictureType = -1;
 
   Callbacks callbacks;
+  /* read once the decoder is created, not on each buffer */
+  BufferHandles bufferHandles {};
+  /* the handles of the buffers kept in inputs or dpb are reset, not erased,
+   * so that the maps stop growing once warm */
   ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*> handlesIn;
   ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*> handlesOut;
+  /* the allocated input buffers are wrapped once, their wrapper and its
+   * metadata are reused on each empty */
+  ThreadSafeMap<char*, AL_TBuffer*> inputs;
   ThreadSafeMap<char*, AL_TBuffer*> dpb;
   ThreadSafeMap<AL_TBuffer*, char*> shouldBeCopied;
 
@@ -113,6 +124,25 @@ private:
   bool isCreated;
   void CopyIfRequired(AL_TBuffer* frameToDisplay, int size);
 
+  /* when the output buffers are the application's, they may have to be
+   * copied: the frames are then displayed in order on displayFifo so that the
+   * copy doesn't stall the decoder. shouldDeferDisplay only changes while
+   * there is no decoder, pendingDisplays counts the frames in displayFifo */
+  struct DisplayJob
+  {
+    AL_TBuffer* frame;
+    int picStruct;
+  };
+  object_pool<DisplayJob> displayJobs;
+  std::unique_ptr<ParallelCopy> copier;
+  std::unique_ptr<ProcessorFifo> displayFifo;
+  bool shouldDeferDisplay;
+  std::atomic<int> pendingDisplays;
+  void DeferDisplay();
+  void StopDeferringDisplay();
+  void ProcessDisplayJob(void* data);
+  void DisplayFrame(AL_TBuffer* frame, int picStruct);
+
   AL_TBuffer* CreateInputBuffer(char* buffer, int size);
   AL_TBuffer* CreateOutputBuffer(char* buffer, int size);
 
@@ -146,6 +176,13 @@ private:
   };
   void InputBufferDestroy(AL_TBuffer* input);
 
+  static void RedirectionInputBufferRelease(AL_TBuffer* input)
+  {
+    auto pThis = static_cast<DecModule*>(AL_Buffer_GetUserData(input));
+    pThis->InputBufferRelease(input);
+  };
+  void InputBufferRelease(AL_TBuffer* input);
+
   static void RedirectionOutputBufferDestroy(AL_TBuffer* output)
   {
     auto pThis = static_cast<DecModule*>(AL_Buffer_GetUserData(output));
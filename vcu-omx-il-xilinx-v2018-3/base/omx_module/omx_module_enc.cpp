@@ -163,9 +163,9 @@ void EncModule::InitEncoders(int numPass)
         AL_Buffer_Ref(encoderPass.streamBuffers.back());
       }
 
-      auto p = bind(&EncModule::_ProcessEmptyFifo, this, placeholders::_1);
+      auto p = bind(&EncModule::_ProcessEmptyFifo, this, pass, placeholders::_1);
       auto d = bind(&EncModule::_DeleteEmptyFifo, this, placeholders::_1);
-      encoderPass.threadFifo.reset(new ProcessorFifo(p, d));
+      encoderPass.threadFifo.reset(new ProcessorFifo(p, d, "omx_enc_pass"));
     }
 
     encoders.push_back(encoderPass);
@@ -180,6 +180,12 @@ ErrorType EncModule::CreateEncoder()
     return ERROR_UNDEFINED;
   }
 
+  {
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    firstSliceLatency = SubframeLatency {};
+    firstSliceLatencyTotal = 0;
+  }
+
   auto chan = media->settings.tChParam[0];
   roiCtx = AL_RoiMngr_Create(chan.uWidth, chan.uHeight, chan.eProfile, AL_ROI_QUALITY_MEDIUM, AL_ROI_INCOMING_ORDER);
 
@@ -189,6 +195,8 @@ ErrorType EncModule::CreateEncoder()
     return ERROR_BAD_PARAMETER;
   }
 
+  bufferHandles = GetBufferHandles();
+
   auto settings = media->settings;
   scheduler = device->Init(settings, *allocator.get());
   auto numPass = 1;
@@ -211,7 +219,7 @@ ErrorType EncModule::CreateEncoder()
     {
       AL_TwoPassMngr_SetPass1Settings(settingsPass);
       callback = { EncModule::RedirectionEndEncodingLookAhead, &(encoderPass.lookAheadParams.callbackParam) };
-      encoderPass.lookAheadParams.fifoSize = settings.LookAhead;
+      encoderPass.fifo.Init(settings.LookAhead, media->isLookAheadEarlyStart);
     }
 #endif
 
@@ -250,7 +258,7 @@ bool EncModule::DestroyEncoder()
 
   for(auto pass = 0; pass < (int)encoders.size(); pass++)
   {
-    GenericEncoder encoder = encoders[pass];
+    GenericEncoder& encoder = encoders[pass];
 
     AL_Encoder_Destroy(encoder.enc);
 
@@ -261,12 +269,9 @@ bool EncModule::DestroyEncoder()
       AL_Buffer_Unref(roiBuffer);
     }
 
-    while(!encoder.fifo.empty())
-    {
-      auto src = encoder.fifo.front();
-      encoder.fifo.pop_front();
-      AL_Buffer_Unref(src);
-    }
+#if AL_ENABLE_TWOPASS
+    encoder.fifo.Clear();
+#endif
 
     for(int i = 0; i < (int)encoder.streamBuffers.size(); i++)
     {
@@ -298,6 +303,7 @@ bool EncModule::CheckParam()
     return false;
 
   LookCoherency(settings);
+  media->version++;
 
   return true;
 }
@@ -442,8 +448,11 @@ void EncModule::Free(void* buffer)
   if(!buffer)
     return;
 
-  auto handle = allocated.Pop(buffer);
-  AL_Allocator_Free(allocator.get(), handle);
+  /* the memory goes with the wrapper, once the encoder is done with it */
+  auto encoderBuffer = allocated.Pop(buffer);
+
+  if(encoderBuffer)
+    AL_Buffer_Unref(encoderBuffer);
 }
 
 void EncModule::FreeDMA(int fd)
@@ -451,9 +460,15 @@ void EncModule::FreeDMA(int fd)
   if(fd < 0)
     return;
 
-  auto handle = allocatedDMA.Pop(fd);
-  AL_Allocator_Free(allocator.get(), handle);
-  close(fd);
+  /* the import cache mustn't keep the dmabuf alive once it is given back */
+  AL_LinuxDmaAllocator_ForgetFd((AL_TLinuxDmaAllocator*)allocator.get(), fd);
+
+  if(allocatedDMA.Exist(fd))
+  {
+    auto handle = allocatedDMA.Pop(fd);
+    AL_Allocator_Free(allocator.get(), handle);
+    close(fd);
+  }
 }
 
 void* EncModule::Allocate(size_t size)
@@ -466,9 +481,20 @@ void* EncModule::Allocate(size_t size)
     return nullptr;
   }
 
+  auto encoderBuffer = AL_Buffer_Create(allocator.get(), handle, size, AL_Buffer_Destroy);
+
+  if(!encoderBuffer)
+  {
+    AL_Allocator_Free(allocator.get(), handle);
+    fprintf(stderr, "No more memory\n");
+    return nullptr;
+  }
+
+  AL_Buffer_Ref(encoderBuffer);
+
   auto addr = AL_Allocator_GetVirtualAddr(allocator.get(), handle);
   assert(addr);
-  allocated.Add(addr, handle);
+  allocated.Add(addr, encoderBuffer);
   return addr;
 }
 
@@ -493,7 +519,7 @@ static void FreeWithoutDestroyingMemory(AL_TBuffer* buffer)
   AL_Buffer_Destroy(buffer);
 }
 
-bool EncModule::Use(BufferHandleInterface* handle, unsigned char* buffer, int size)
+AL_TBuffer* EncModule::Use(BufferHandleInterface* handle, unsigned char* buffer, int size)
 {
   if(!handle)
     throw invalid_argument("handle");
@@ -505,7 +531,8 @@ bool EncModule::Use(BufferHandleInterface* handle, unsigned char* buffer, int si
 
   if(allocated.Exist(buffer))
   {
-    encoderBuffer = AL_Buffer_Create(allocator.get(), allocated.Get(buffer), size, FreeWithoutDestroyingMemory);
+    encoderBuffer = allocated.Get(buffer);
+    encoderBuffer->zSize = size;
   }
   else if(size)
   {
@@ -516,17 +543,18 @@ bool EncModule::Use(BufferHandleInterface* handle, unsigned char* buffer, int si
     encoderBuffer = AL_Buffer_Create(allocator.get(), NULL, size, FreeWithoutDestroyingMemory);
 
   if(!encoderBuffer)
-    return false;
+    return nullptr;
 
-  assert(!pool.Exist(handle));
+  assert(!pool.Get(handle->data));
 
   AL_Buffer_Ref(encoderBuffer);
-  pool.Add(handle, encoderBuffer);
+  AL_Buffer_SetUserData(encoderBuffer, handle);
+  pool.Set(handle->data, encoderBuffer);
 
-  return true;
+  return encoderBuffer;
 }
 
-bool EncModule::UseDMA(BufferHandleInterface* handle, int fd, int size)
+AL_TBuffer* EncModule::UseDMA(BufferHandleInterface* handle, int fd, int size)
 {
   if(!handle)
     throw invalid_argument("handle");
@@ -539,40 +567,43 @@ bool EncModule::UseDMA(BufferHandleInterface* handle, int fd, int size)
   if(!dmaHandle)
   {
     fprintf(stderr, "Failed to import fd : %i\n", fd);
-    return false;
+    return nullptr;
   }
 
   auto encoderBuffer = AL_Buffer_Create(allocator.get(), dmaHandle, size, AL_Buffer_Destroy);
 
   if(!encoderBuffer)
-    return false;
+    return nullptr;
 
-  assert(!pool.Exist(handle));
+  assert(!pool.Get(handle->data));
 
   AL_Buffer_Ref(encoderBuffer);
-  pool.Add(handle, encoderBuffer);
+  AL_Buffer_SetUserData(encoderBuffer, handle);
+  pool.Set(handle->data, encoderBuffer);
 
-  return true;
+  return encoderBuffer;
 }
 
-void EncModule::Unuse(BufferHandleInterface* handle)
+void EncModule::Unuse(AL_TBuffer* encoderBuffer)
 {
-  if(!handle)
-    throw invalid_argument("handle");
+  if(!encoderBuffer)
+    throw invalid_argument("encoderBuffer");
 
-  auto encoderBuffer = pool.Pop(handle);
+  auto handle = static_cast<BufferHandleInterface*>(AL_Buffer_GetUserData(encoderBuffer));
+  pool.Set(handle->data, nullptr);
 
   if(shouldBeCopied.Exist(encoderBuffer))
     shouldBeCopied.Remove(encoderBuffer);
   AL_Buffer_Unref(encoderBuffer);
 }
 
-void EncModule::UnuseDMA(BufferHandleInterface* handle)
+void EncModule::UnuseDMA(AL_TBuffer* encoderBuffer)
 {
-  if(!handle)
-    throw invalid_argument("handle");
+  if(!encoderBuffer)
+    throw invalid_argument("encoderBuffer");
 
-  auto encoderBuffer = pool.Pop(handle);
+  auto handle = static_cast<BufferHandleInterface*>(AL_Buffer_GetUserData(encoderBuffer));
+  pool.Set(handle->data, nullptr);
   AL_Buffer_Unref(encoderBuffer);
 }
 
@@ -646,14 +677,12 @@ bool EncModule::Empty(BufferHandleInterface* handle)
 
   uint8_t* buffer = (uint8_t*)handle->data;
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  AL_TBuffer* input = nullptr;
 
   if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
-    UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->payload);
+    input = UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->payload);
   else
-    Use(handle, buffer, handle->payload);
-
-  auto input = pool.Get(handle);
+    input = Use(handle, buffer, handle->payload);
 
   if(!input)
     return false;
@@ -671,7 +700,7 @@ bool EncModule::Empty(BufferHandleInterface* handle)
       return false;
 #endif
 
-  handles.Add(input, handle);
+  firstSliceStarts.Set(handle->data, std::chrono::steady_clock::now());
 
   if(shouldBeCopied.Exist(input))
   {
@@ -680,14 +709,27 @@ bool EncModule::Empty(BufferHandleInterface* handle)
   }
 
   if(currentEnc.roiBuffers.empty())
-    return AL_Encoder_Process(encoder, input, nullptr);
+  {
+    if(!AL_Encoder_Process(encoder, input, nullptr))
+    {
+      firstSliceStarts.Set(handle->data, {});
+      return false;
+    }
+    return true;
+  }
 
   auto roiBuffer = currentEnc.roiBuffers.front();
   currentEnc.roiBuffers.pop_front();
   auto success = AL_Encoder_Process(encoder, input, roiBuffer);
 
+  if(!success)
+    firstSliceStarts.Set(handle->data, {});
+
   if(currentEnc.index != encoders.back().index)
+  {
+    std::lock_guard<std::mutex> lock(roiMutex);
     encoders[currentEnc.index + 1].roiBuffers.push_back(roiBuffer);
+  }
   else
     AL_Buffer_Unref(roiBuffer);
 
@@ -724,14 +766,12 @@ bool EncModule::Fill(BufferHandleInterface* handle)
 
   auto buffer = (uint8_t*)handle->data;
 
-  BufferHandles bufferHandles = GetBufferHandles();
+  AL_TBuffer* output = nullptr;
 
   if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
-    UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->size);
+    output = UseDMA(handle, static_cast<int>((intptr_t)buffer), handle->size);
   else
-    Use(handle, buffer, handle->size);
-
-  auto output = pool.Get(handle);
+    output = Use(handle, buffer, handle->size);
 
   if(!output)
     return false;
@@ -742,8 +782,6 @@ bool EncModule::Fill(BufferHandleInterface* handle)
       return false;
   }
 
-  handles.Add(output, handle);
-
   return AL_Encoder_PutStreamBuffer(encoder, output);
 }
 
@@ -789,12 +827,16 @@ static int ReconstructStream(AL_TBuffer& stream)
 
 void EncModule::ReleaseBuf(AL_TBuffer const* buf, bool isDma, bool isSrc)
 {
-  auto rhandle = handles.Pop(buf);
+  auto rhandle = static_cast<BufferHandleInterface*>(AL_Buffer_GetUserData((AL_TBuffer*)buf));
+
+  /* a source given back without being encoded, e.g. on flush, has no slice coming */
+  if(isSrc)
+    firstSliceStarts.Set(rhandle->data, {});
 
   if(isDma)
-    UnuseDMA(rhandle);
+    UnuseDMA((AL_TBuffer*)buf);
   else
-    Unuse(rhandle);
+    Unuse((AL_TBuffer*)buf);
 
   callbacks.release(isSrc, rhandle);
 }
@@ -819,8 +861,6 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
       callbacks.event(CALLBACK_EVENT_ERROR, (void*)ToModuleError(errorCode));
   }
 
-  BufferHandles bufferHandles = GetBufferHandles();
-
   auto isSrcRelease = (stream == nullptr && source);
 
   if(isSrcRelease)
@@ -853,25 +893,29 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
     return;
   }
 
-  auto rhandleIn = handles.Get(source);
+  auto rhandleIn = static_cast<BufferHandleInterface*>(AL_Buffer_GetUserData((AL_TBuffer*)source));
   assert(rhandleIn->data);
 
-  auto rhandleOut = handles.Get(stream);
+  auto rhandleOut = static_cast<BufferHandleInterface*>(AL_Buffer_GetUserData(stream));
   assert(rhandleOut->data);
 
-  callbacks.associate(rhandleIn, rhandleOut);
+  /* in subframe, the source comes back once per slice: only the first one counts */
+  auto start = firstSliceStarts.Get(rhandleIn->data);
 
-  if(isEndOfFrame(stream))
-    handles.Remove(source);
+  if(start != std::chrono::steady_clock::time_point {})
+  {
+    firstSliceStarts.Set(rhandleIn->data, {});
+    AddFirstSliceLatency(start);
+  }
 
-  handles.Remove(stream);
+  callbacks.associate(rhandleIn, rhandleOut);
 
   if(isEndOfFrame(stream))
   {
     if(bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD)
-      UnuseDMA(rhandleIn);
+      UnuseDMA((AL_TBuffer*)source);
     else
-      Unuse(rhandleIn);
+      Unuse((AL_TBuffer*)source);
 
     rhandleIn->offset = 0;
     rhandleIn->payload = 0;
@@ -887,15 +931,27 @@ void EncModule::EndEncoding(AL_TBuffer* stream, AL_TBuffer const* source)
   }
 
   if(bufferHandles.output == BufferHandleType::BUFFER_HANDLE_FD)
-    UnuseDMA(rhandleOut);
+    UnuseDMA(stream);
   else
-    Unuse(rhandleOut);
+    Unuse(stream);
 
   rhandleOut->offset = 0;
   rhandleOut->payload = size;
   callbacks.filled(rhandleOut, rhandleOut->offset, rhandleOut->payload);
 }
 
+void EncModule::AddFirstSliceLatency(std::chrono::steady_clock::time_point start)
+{
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(latencyMutex);
+  firstSliceLatencyTotal += latency;
+  firstSliceLatency.frames++;
+  firstSliceLatency.last = static_cast<int>(latency);
+  firstSliceLatency.mean = static_cast<int>(firstSliceLatencyTotal / firstSliceLatency.frames);
+  firstSliceLatency.max = std::max(firstSliceLatency.max, firstSliceLatency.last);
+}
+
 void EncModule::EndEncodingLookAhead(AL_TBuffer* stream, AL_TBuffer const* source, int index)
 {
   assert(index < (int)encoders.size() - 1);
@@ -922,8 +978,6 @@ void EncModule::EndEncodingLookAhead(AL_TBuffer* stream, AL_TBuffer const* sourc
     return;
   }
 
-  BufferHandles bufferHandles = GetBufferHandles();
-
   if(isSrcRelease)
   {
     ReleaseBuf(source, bufferHandles.input == BufferHandleType::BUFFER_HANDLE_FD, true);
@@ -942,63 +996,72 @@ void EncModule::EndEncodingLookAhead(AL_TBuffer* stream, AL_TBuffer const* sourc
 
 void EncModule::AddFifo(GenericEncoder& encoder, AL_TBuffer* src)
 {
-  bool isEOS = (src == nullptr);
-
-  if(!isEOS)
-  {
+  /* the fifo itself is only touched from the pass thread */
+  if(src)
     AL_Buffer_Ref(src);
-    encoder.fifo.push_back(src);
-  }
-  encoder.threadFifo->queue(new EmptyFifoParam(&encoder, isEOS));
+  encoder.threadFifo->queue(src);
 }
 
-void EncModule::EmptyFifo(GenericEncoder& encoder, bool isEOS)
+void EncModule::ProcessNextPass(GenericEncoder& nextEnc, AL_TBuffer* src)
 {
-  assert(encoder.index < (int)encoders.size() - 1);
-
-  GenericEncoder nextEnc = encoders[encoder.index + 1];
+  AL_TBuffer* roiBuffer = nullptr;
 
-#if AL_ENABLE_TWOPASS
-
-  if(encoder.lookAheadParams.fifoSize >= 10)
-    encoder.ComputeComplexity(isEOS);
-#endif
-
-  if(isEOS && encoder.fifo.size() == 0)
-    AL_Encoder_Process(nextEnc.enc, nullptr, nullptr);
-
-  else if(isEOS || (int)encoder.fifo.size() == encoder.lookAheadParams.fifoSize)
   {
-    auto src = encoder.fifo.front();
-    encoder.fifo.pop_front();
-
-#if AL_ENABLE_TWOPASS
-    encoder.ProcessLookAheadParams(src);
-#endif
-
-    AL_TBuffer* roiBuffer = nullptr;
+    std::lock_guard<std::mutex> lock(roiMutex);
 
     if(!nextEnc.roiBuffers.empty())
     {
       roiBuffer = nextEnc.roiBuffers.front();
       nextEnc.roiBuffers.pop_front();
     }
+  }
 
-    AL_Encoder_Process(nextEnc.enc, src, roiBuffer);
+  AL_Encoder_Process(nextEnc.enc, src, roiBuffer);
 
-    if(roiBuffer)
+  if(roiBuffer)
+  {
+    if(nextEnc.index != encoders.back().index)
     {
-      if(nextEnc.index != encoders.back().index)
-        encoders[nextEnc.index + 1].roiBuffers.push_back(roiBuffer);
-      else
-        AL_Buffer_Unref(roiBuffer);
+      std::lock_guard<std::mutex> lock(roiMutex);
+      encoders[nextEnc.index + 1].roiBuffers.push_back(roiBuffer);
     }
+    else
+      AL_Buffer_Unref(roiBuffer);
+  }
 
-    AL_Buffer_Unref(src);
+  AL_Buffer_Unref(src);
+}
 
-    if(isEOS)
-      EmptyFifo(encoder, isEOS);
+void EncModule::EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src)
+{
+  assert(encoder.index < (int)encoders.size() - 1);
+
+  GenericEncoder& nextEnc = encoders[encoder.index + 1];
+  auto isEOS = (src == nullptr);
+
+#if AL_ENABLE_TWOPASS
+
+  if(!isEOS)
+  {
+    encoder.fifo.Push(src);
+
+    if(auto next = encoder.fifo.Pop(false))
+      ProcessNextPass(nextEnc, next);
+    return;
+  }
+
+  while(auto next = encoder.fifo.Pop(true))
+    ProcessNextPass(nextEnc, next);
+#else
+
+  if(!isEOS)
+  {
+    ProcessNextPass(nextEnc, src);
+    return;
   }
+#endif
+
+  AL_Encoder_Process(nextEnc.enc, nullptr, nullptr);
 }
 
 Resolution EncModule::GetResolution() const
@@ -1039,10 +1102,11 @@ Flags EncModule::GetFlags(AL_TBuffer* stream)
 
 Flags EncModule::GetFlags(BufferHandleInterface* handle)
 {
-  AL_TBuffer* stream = nullptr;
+  /* the end of stream buffer may never have been used */
+  if(!pool.Exist(handle->data))
+    return Flags {};
 
-  if(pool.Exist(handle))
-    stream = pool.Get(handle);
+  auto stream = pool.Get(handle->data);
 
   if(!stream)
     return Flags {};
@@ -1187,73 +1251,26 @@ ErrorType EncModule::GetDynamic(std::string index, void* param)
     return SUCCESS;
   }
 
-  return ERROR_NOT_IMPLEMENTED;
-}
-
-#if AL_ENABLE_TWOPASS
-
-void GenericEncoder::ProcessLookAheadParams(AL_TBuffer* src)
-{
-  auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(src, AL_META_TYPE_LOOKAHEAD);
-  auto fifoSize = (int)fifo.size();
-
-  if(pPictureMetaLA)
+  if(index == "DYNAMIC_INDEX_SUBFRAME_LATENCY")
   {
-    if(lookAheadParams.fifoSize >= 10)
-      pPictureMetaLA->iComplexity = lookAheadParams.complexity;
-
-    if(fifoSize >= 1)
-    {
-      pPictureMetaLA->bNextSceneChange = AL_TwoPassMngr_SceneChangeDetected(src, fifo[0]);
-      pPictureMetaLA->iIPRatio = AL_TwoPassMngr_GetIPRatio(src, fifo[0]);
-
-      for(int i = 1; (i < std::min(fifoSize, 3)); i++)
-        pPictureMetaLA->iIPRatio = std::min(pPictureMetaLA->iIPRatio, AL_TwoPassMngr_GetIPRatio(src, fifo[i]));
-    }
+    std::lock_guard<std::mutex> lock(latencyMutex);
+    *static_cast<SubframeLatency*>(param) = firstSliceLatency;
+    return SUCCESS;
   }
-}
 
-void GenericEncoder::ComputeComplexity(bool isEOS)
-{
-  lookAheadParams.complexityCount++;
-  int fifoSize = static_cast<int>(fifo.size());
-
-  if(lookAheadParams.complexityCount >= 5 && (isEOS || fifoSize == lookAheadParams.fifoSize))
-  {
-    lookAheadParams.complexityCount = 0;
-    lookAheadParams.complexity = 1000;
-
-    if(fifoSize >= 5 && AL_Buffer_GetMetaData(fifo.front(), AL_META_TYPE_LOOKAHEAD))
-    {
-      int iComp[2] = { 0, 0 };
-
-      for(int i = 0; i < fifoSize; i++)
-      {
-        auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(fifo[i], AL_META_TYPE_LOOKAHEAD);
-        iComp[(i < 5) ? 0 : 1] += pPictureMetaLA->iPictureSize;
-      }
-
-      lookAheadParams.complexity = ((1000 * fifoSize / 5) + lookAheadParams.complexityDiff) * iComp[0] / (iComp[0] + iComp[1]);
-      lookAheadParams.complexityDiff += (1000 - lookAheadParams.complexity);
-    }
-  }
+  return ERROR_NOT_IMPLEMENTED;
 }
 
-#endif
-
-void EncModule::_ProcessEmptyFifo(void* data)
+void EncModule::_ProcessEmptyFifo(int pass, void* data)
 {
-  auto param = static_cast<EmptyFifoParam*>(data);
-  assert(param);
-  assert(param->encoder);
-  GenericEncoder& encoder = *(param->encoder);
-  EmptyFifo(encoder, param->isEOS);
-  delete param;
+  EmptyFifo(encoders[pass], static_cast<AL_TBuffer*>(data));
 }
 
 void EncModule::_DeleteEmptyFifo(void* data)
 {
-  auto param = static_cast<EmptyFifoParam*>(data);
-  delete param;
+  auto src = static_cast<AL_TBuffer*>(data);
+
+  if(src)
+    AL_Buffer_Unref(src);
 }
 
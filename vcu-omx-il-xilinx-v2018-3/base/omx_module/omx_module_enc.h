@@ -44,12 +44,13 @@
 
 #include "ROIMngr.h"
 
+#include <chrono>
 #include <cstring>
 #include <vector>
-#include <deque>
 #include <list>
 #include <future>
 #include <memory>
+#include <mutex>
 
 #include "base/omx_utils/threadsafe_map.h"
 #include "base/omx_utils/processor_fifo.h"
@@ -84,10 +85,6 @@ struct LookAheadCallBackParam
 struct LookAheadParams
 {
   LookAheadCallBackParam callbackParam;
-  int fifoSize;
-  int complexityCount;
-  int complexity;
-  int complexityDiff;
 };
 
 struct GenericEncoder
@@ -99,13 +96,11 @@ struct GenericEncoder
   int index {};
   std::list<AL_TBuffer*> roiBuffers {};
   std::vector<AL_TBuffer*> streamBuffers {};
-  std::deque<AL_TBuffer*> fifo {};
   std::shared_ptr<ProcessorFifo> threadFifo {};
   LookAheadParams lookAheadParams {};
 
 #if AL_ENABLE_TWOPASS
-  void ProcessLookAheadParams(AL_TBuffer* src);
-  void ComputeComplexity(bool isEOS);
+  LookAheadFifo fifo {};
 #endif
 };
 
@@ -125,7 +120,7 @@ struct EncModule : public ModuleInterface
 
   bool CreateAndAttachStreamMeta(AL_TBuffer& buf);
   void AddFifo(GenericEncoder& encoder, AL_TBuffer* src);
-  void EmptyFifo(GenericEncoder& encoder, bool isEOS);
+  void EmptyFifo(GenericEncoder& encoder, AL_TBuffer* src);
 
   bool CheckParam() override;
   bool Create() override;
@@ -137,8 +132,8 @@ struct EncModule : public ModuleInterface
   void FreeDMA(int fd);
   int AllocateDMA(int size);
 
-  bool UseDMA(BufferHandleInterface* handle, int fd, int size);
-  void UnuseDMA(BufferHandleInterface* handle);
+  AL_TBuffer* UseDMA(BufferHandleInterface* handle, int fd, int size);
+  void UnuseDMA(AL_TBuffer* buffer);
 
   bool Empty(BufferHandleInterface* handle) override;
   bool Fill(BufferHandleInterface* handle) override;
@@ -163,14 +158,16 @@ private:
   EOSHandles<BufferHandleInterface*> eosHandles;
 
   void InitEncoders(int numPass);
-  bool Use(BufferHandleInterface* handle, uint8_t* buffer, int size);
-  void Unuse(BufferHandleInterface* handle);
+  AL_TBuffer* Use(BufferHandleInterface* handle, uint8_t* buffer, int size);
+  void Unuse(AL_TBuffer* buffer);
   ErrorType CreateEncoder();
   bool DestroyEncoder();
   bool isCreated;
   void ReleaseBuf(AL_TBuffer const* buf, bool isDma, bool isSrc);
   bool isEndOfFrame(AL_TBuffer* stream);
   Flags GetFlags(AL_TBuffer* handle);
+  void AddFirstSliceLatency(std::chrono::steady_clock::time_point start);
+  void ProcessNextPass(GenericEncoder& nextEnc, AL_TBuffer* src);
 
   static void RedirectionEndEncoding(void* userParam, AL_TBuffer* pStream, AL_TBuffer const* pSource, int)
   {
@@ -185,23 +182,30 @@ private:
     pThis->EndEncodingLookAhead(pStream, pSource, params->index);
   };
   void EndEncodingLookAhead(AL_TBuffer* pStream, AL_TBuffer const* pSource, int index);
-  void _ProcessEmptyFifo(void* data);
+  /* the pass fifos carry the sources themselves, nullptr for the end of stream */
+  void _ProcessEmptyFifo(int pass, void* data);
   void _DeleteEmptyFifo(void* data);
   void FlushEosHandles();
 
-  ThreadSafeMap<AL_TBuffer const*, BufferHandleInterface*> handles;
-  ThreadSafeMap<void*, AL_HANDLE> allocated;
+  /* read once the encoder is created, not on each buffer */
+  BufferHandles bufferHandles {};
+
+  /* the encoder buffers keep their handle as user data. The buffers allocated
+   * here are wrapped once and the wrapper, with its metadata, is reused on
+   * each use */
+  ThreadSafeMap<void*, AL_TBuffer*> allocated;
   ThreadSafeMap<int, AL_HANDLE> allocatedDMA;
   ThreadSafeMap<AL_TBuffer*, AL_VADDR> shouldBeCopied;
-  ThreadSafeMap<BufferHandleInterface*, AL_TBuffer*> pool;
-};
-
-struct EmptyFifoParam
-{
-  EmptyFifoParam(GenericEncoder* encoder, bool isEOS) :
-    encoder{encoder}, isEOS{isEOS} {};
-
-  GenericEncoder* encoder;
-  bool isEOS;
+  /* keyed by the data of the handles, which comes back on each use of a
+   * buffer, and reset instead of erased so that the map stops growing once warm */
+  ThreadSafeMap<char*, AL_TBuffer*> pool;
+
+  /* the roi buffers of the later passes are queued and taken on different threads */
+  std::mutex roiMutex;
+
+  /* when each source was emptied, keyed and reset as pool */
+  ThreadSafeMap<char*, std::chrono::steady_clock::time_point> firstSliceStarts;
+  std::mutex latencyMutex;
+  SubframeLatency firstSliceLatency {};
+  int64_t firstSliceLatencyTotal = 0;
 };
-
@@ -105,6 +105,7 @@ static std::map<ErrorType, const char*> ToStringError
 #define DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE "DYNAMIC_INDEX_NOTIFY_SCENE_CHANGE"
 #define DYNAMIC_INDEX_IS_LONG_TERM "DYNAMIC_INDEX_IS_LONG_TERM"
 #define DYNAMIC_INDEX_USE_LONG_TERM "DYNAMIC_INDEX_USE_LONG_TERM"
+#define DYNAMIC_INDEX_SUBFRAME_LATENCY "DYNAMIC_INDEX_SUBFRAME_LATENCY"
 
 enum CallbackEventType
 {
@@ -114,6 +114,11 @@ struct Resolution
 
     return false;
   }
+
+  bool operator == (Resolution const& resolution) const
+  {
+    return !(*this != resolution);
+  }
 };
 
 struct Clock
@@ -211,6 +216,11 @@ struct Bitrate
   int ird; // InitialRemovalDelay in milliseconds
   RateControlType mode;
   RateControlOptionType option;
+
+  bool operator == (Bitrate const& bitrate) const
+  {
+    return target == bitrate.target && max == bitrate.max && cpb == bitrate.cpb && ird == bitrate.ird && mode == bitrate.mode && option == bitrate.option;
+  }
 };
 
 struct Slices
@@ -237,5 +247,14 @@ struct RegionQuality
 struct LookAhead
 {
   int nLookAhead;
+  bool isEarlyStart;
+};
+
+struct SubframeLatency
+{
+  int frames;
+  int last; /* in microseconds */
+  int mean;
+  int max;
 };
 
@@ -37,6 +37,7 @@
 
 #include "omx_sync_ip.h"
 #include <cassert>
+#include <cstdlib>
 #include "DummySyncDriver.h"
 
 extern "C"
@@ -63,15 +64,25 @@ using namespace std;
 static char const* syncDevice = "/dev/xvsfsync0";
 static constexpr bool usingDummy = false;
 
+int getFbNumber()
+{
+  auto env = getenv("OMX_ALLEGRO_SYNC_FB_NUMBER");
+
+  if(!env)
+    return MAX_FB_NUMBER;
+
+  return atoi(env);
+}
+
 AL_TDriver* getDriver()
 {
   if(usingDummy)
-    return AL_InitDummyDriver(true, 4);
+    return AL_InitDummyDriver(true, 4, getFbNumber());
 
   return AL_GetHardwareDriver();
 }
 
-OMXSyncIp::OMXSyncIp(shared_ptr<MediatypeInterface> media, shared_ptr<AL_TAllocator> allocator) : media(media), allocator(allocator), syncIp(getDriver(), syncDevice), sync{&syncIp, syncIp.getFreeChannel()}
+OMXSyncIp::OMXSyncIp(shared_ptr<MediatypeInterface> media, shared_ptr<AL_TAllocator> allocator) : media(media), allocator(allocator), syncIp(getDriver(), syncDevice, getFbNumber()), sync{&syncIp, syncIp.getFreeChannel()}
 {
   assert(media);
   assert(allocator);
@@ -48,6 +48,10 @@ extern "C"
 #include <lib_common/Allocator.h>
 }
 
+/* number of frame buffers kept programmed ahead in the sync ip, read from
+ * OMX_ALLEGRO_SYNC_FB_NUMBER. SyncIp rejects what isn't 1 to MAX_FB_NUMBER */
+int getFbNumber();
+
 struct OMXSyncIp : SyncIpInterface
 {
   OMXSyncIp(std::shared_ptr<MediatypeInterface> media, std::shared_ptr<AL_TAllocator> allocator);
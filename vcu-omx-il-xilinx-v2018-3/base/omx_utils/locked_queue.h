@@ -37,12 +37,13 @@
 
 #pragma once
 
-#include <queue>
+#include "ring_queue.h"
 #include "semaphore.h"
 
 /**
  * @brief A generic thread-safe FIFO queue. Does not copy its elements (they
- * must be moveable).
+ * must be moveable). Elements are kept in a ring_queue, so a queue that
+ * reached its working depth does not allocate anymore.
  *
  * Don't add a "size" function to it : its result would be obsolete as soon
  * as the call would have returned.
@@ -59,7 +60,7 @@ public:
   void push(T val)
   {
     auto lock = Lock(m_Mutex);
-    m_Queue.push(val);
+    m_Queue.push(std::move(val));
     m_Semaphore.notify();
   }
 
@@ -76,14 +77,11 @@ public:
   {
     m_Semaphore.wait();
     auto lock = Lock(m_Mutex);
-    auto val = std::move(m_Queue.front());
-    m_Queue.pop();
-    return val;
+    return m_Queue.pop();
   }
 
 private:
   semaphore m_Semaphore;
-  std::queue<T> m_Queue;
+  ring_queue<T> m_Queue;
   std::mutex m_Mutex;
 };
-
@@ -0,0 +1,141 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "semaphore.h"
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A thread-safe pool of T. Objects are constructed in recycled storage
+ * so that, once the pool is warm, acquiring and releasing an object does not
+ * reach the heap.
+ *
+ * Objects still acquired when the pool is destroyed are not reclaimed.
+ */
+template<typename T>
+class object_pool
+{
+public:
+  object_pool() = default;
+  object_pool(object_pool const &) = delete;
+  object_pool & operator = (object_pool const &) = delete;
+
+  ~object_pool()
+  {
+    for(auto storage : m_Free)
+      ::operator delete (storage);
+  }
+
+  /**
+   * @brief Makes sure that count objects can be alive at the same time
+   * without allocating
+   */
+  void reserve(size_t count)
+  {
+    auto lock = Lock(m_Mutex);
+
+    m_Free.reserve(count);
+
+    while(m_Allocated < count)
+    {
+      m_Free.push_back(::operator new (sizeof(T)));
+      ++m_Allocated;
+    }
+  }
+
+  /**
+   * @brief Constructs a T from args in a recycled storage, or in a new one if
+   * the pool is empty
+   */
+  template<typename ... Args>
+  T* acquire(Args && ... args)
+  {
+    void* storage = nullptr;
+    {
+      auto lock = Lock(m_Mutex);
+
+      if(m_Free.empty())
+      {
+        /* the storage comes back on release: keep room for it beforehand */
+        m_Free.reserve(m_Allocated + 1);
+        storage = ::operator new (sizeof(T));
+        ++m_Allocated;
+      }
+      else
+      {
+        storage = m_Free.back();
+        m_Free.pop_back();
+      }
+    }
+
+    try
+    {
+      return new (storage) T(std::forward<Args>(args) ...);
+    }
+    catch(...)
+    {
+      recycle(storage);
+      throw;
+    }
+  }
+
+  /**
+   * @brief Destroys an object acquired from this pool and recycles its storage
+   */
+  void release(T* object)
+  {
+    if(!object)
+      return;
+
+    object->~T();
+    recycle(object);
+  }
+
+private:
+  void recycle(void* storage)
+  {
+    auto lock = Lock(m_Mutex);
+    m_Free.push_back(storage);
+  }
+
+  std::mutex m_Mutex;
+  std::vector<void*> m_Free;
+  size_t m_Allocated = 0;
+};
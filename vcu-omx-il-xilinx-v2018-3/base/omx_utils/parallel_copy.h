@@ -0,0 +1,154 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "processor_executor.h"
+#include "semaphore.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Copies large buffers with the calling thread and the workers of the
+ * shared ProcessorExecutor.
+ *
+ * The buffer is cut in chunks that fit in the cache of one core. The helpers
+ * are strands of the executor: each claims the next chunk until none are left,
+ * so a helper that isn't run in time doesn't delay the copy, the calling
+ * thread copies its chunks instead. Without executor, the copy is a memcpy.
+ */
+class ParallelCopy
+{
+public:
+  explicit ParallelCopy(std::shared_ptr<ProcessorExecutor> executor = ProcessorExecutor::Shared()) :
+    executor(executor),
+    helpers(executor ? std::max(0, std::min(executor->ThreadCount(), 4) - 1) : 0)
+  {
+    for(auto& helper : helpers)
+      helper.copy = this;
+  }
+
+  ~ParallelCopy()
+  {
+    /* a helper scheduled by the last copy may not have run yet */
+    auto lock = Lock(mutex);
+    done.wait(lock, [&] { return std::none_of(helpers.begin(), helpers.end(), [](Helper const& helper) { return helper.scheduled; }); });
+  }
+
+  /* not reentrant: one copy at a time */
+  void Copy(uint8_t const* source, size_t size, uint8_t* destination)
+  {
+    if(helpers.empty() || size <= chunkSize)
+    {
+      std::memcpy(destination, source, size);
+      return;
+    }
+
+    auto lock = Lock(mutex);
+    this->source = source;
+    this->destination = destination;
+    this->size = size;
+    next = 0;
+    chunks = (size + chunkSize - 1) / chunkSize;
+    pending = chunks;
+
+    for(auto& helper : helpers)
+    {
+      if(helper.scheduled)
+        continue;
+      helper.scheduled = true;
+      executor->Schedule(&helper);
+    }
+
+    CopyChunks(lock);
+    done.wait(lock, [&] { return pending == 0; });
+  }
+
+private:
+  static size_t const chunkSize = 256 * 1024;
+
+  struct Helper : ProcessorExecutor::Strand
+  {
+    ParallelCopy* copy = nullptr;
+    bool scheduled = false;
+
+    bool Run() override
+    {
+      auto lock = Lock(copy->mutex);
+      copy->CopyChunks(lock);
+      scheduled = false;
+      copy->done.notify_all();
+      return false;
+    }
+  };
+
+  std::shared_ptr<ProcessorExecutor> executor;
+  std::vector<Helper> helpers;
+  std::mutex mutex;
+  std::condition_variable done;
+
+  uint8_t const* source = nullptr;
+  uint8_t* destination = nullptr;
+  size_t size = 0;
+  size_t chunks = 0;
+  size_t next = 0;
+  size_t pending = 0;
+
+  /* must be called with the mutex locked, which is released during the copies */
+  void CopyChunks(std::unique_lock<std::mutex>& lock)
+  {
+    size_t const chunk = chunkSize;
+
+    while(next < chunks)
+    {
+      auto const offset = next++ * chunk;
+      auto const length = std::min(chunk, size - offset);
+      auto const from = source + offset;
+      auto const to = destination + offset;
+
+      lock.unlock();
+      std::memcpy(to, from, length);
+      lock.lock();
+
+      if(--pending == 0)
+        done.notify_all();
+    }
+  }
+};
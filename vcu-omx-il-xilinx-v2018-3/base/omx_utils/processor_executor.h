@@ -0,0 +1,265 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include "semaphore.h"
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <lib_rtos/lib_rtos.h>
+}
+
+/**
+ * @brief A fixed set of worker threads shared by the processors.
+ *
+ * A processor is scheduled as a strand: it is queued at most once at a time,
+ * so it never runs on two workers concurrently and its tasks keep their order.
+ *
+ * The omx tasks may block (pause fences, flushes, port population) on another
+ * strand. When strands are waiting but no worker made progress for a while,
+ * a spare worker is added so that the blocked strands cannot starve the
+ * others. Spare workers stay until the executor is destroyed.
+ */
+class ProcessorExecutor
+{
+public:
+  struct Strand
+  {
+    virtual ~Strand() = default;
+
+    /**
+     * @brief Runs some of the pending tasks of the strand
+     *
+     * @return true if the strand still has tasks and must be scheduled again
+     */
+    virtual bool Run() = 0;
+
+  private:
+    friend class ProcessorExecutor;
+    Strand* next = nullptr;
+  };
+
+  explicit ProcessorExecutor(int workers) :
+    state(std::make_shared<State>())
+  {
+    auto lock = Lock(state->mutex);
+
+    for(int i = 0; i < workers; ++i)
+      Spawn(state);
+
+    supervisor = std::thread(&ProcessorExecutor::Supervise, state);
+  }
+
+  ~ProcessorExecutor()
+  {
+    {
+      auto lock = Lock(state->mutex);
+      state->quit = true;
+    }
+    state->ready.notify_all();
+    state->starving.notify_all();
+    supervisor.join();
+
+    /* the workers list doesn't change anymore: the supervisor is gone */
+    for(auto& worker : state->workers)
+    {
+      /* the last processor was destroyed by one of our tasks: the worker
+       * keeps the state alive until it leaves */
+      if(worker.get_id() == std::this_thread::get_id())
+        worker.detach();
+      else
+        worker.join();
+    }
+  }
+
+  /**
+   * @brief Gets the executor shared by the processors
+   *
+   * @return nullptr if the OMX_ALLEGRO_WORKERS environment variable doesn't
+   * ask for a positive number of workers. The processors then keep their
+   * dedicated thread.
+   */
+  static std::shared_ptr<ProcessorExecutor> Shared()
+  {
+    static int const workers = getenv("OMX_ALLEGRO_WORKERS") ? atoi(getenv("OMX_ALLEGRO_WORKERS")) : 0;
+
+    if(workers <= 0)
+      return nullptr;
+
+    static std::mutex mutex;
+    static std::weak_ptr<ProcessorExecutor> shared;
+
+    auto lock = Lock(mutex);
+    auto executor = shared.lock();
+
+    if(!executor)
+    {
+      executor = std::make_shared<ProcessorExecutor>(workers);
+      shared = executor;
+    }
+    return executor;
+  }
+
+  void Schedule(Strand* strand)
+  {
+    auto lock = Lock(state->mutex);
+    Enqueue(*state, strand);
+  }
+
+  int ThreadCount()
+  {
+    auto lock = Lock(state->mutex);
+    return static_cast<int>(state->workers.size());
+  }
+
+private:
+  struct State
+  {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable starving;
+    Strand* head = nullptr;
+    Strand* tail = nullptr;
+    std::vector<std::thread> workers;
+    int idle = 0;
+    bool watching = false;
+    uint64_t completed = 0;
+    bool quit = false;
+  };
+
+  std::shared_ptr<State> state;
+  std::thread supervisor;
+
+  static void Enqueue(State& state, Strand* strand)
+  {
+    strand->next = nullptr;
+
+    if(state.tail)
+      state.tail->next = strand;
+    else
+      state.head = strand;
+    state.tail = strand;
+
+    if(state.idle > 0)
+      state.ready.notify_one();
+    else if(!state.watching)
+      state.starving.notify_one();
+  }
+
+  static Strand* Dequeue(State& state)
+  {
+    auto strand = state.head;
+    state.head = strand->next;
+
+    if(!state.head)
+      state.tail = nullptr;
+    return strand;
+  }
+
+  /* must be called with the state locked */
+  static void Spawn(std::shared_ptr<State> const& state)
+  {
+    state->workers.push_back(std::thread(&ProcessorExecutor::Work, state));
+  }
+
+  static void Work(std::shared_ptr<State> state)
+  {
+    Rtos_ApplyThreadConfig("omx_worker");
+
+    auto lock = Lock(state->mutex);
+
+    while(true)
+    {
+      if(!state->head)
+      {
+        if(state->quit)
+          return;
+
+        ++state->idle;
+        state->ready.wait(lock);
+        --state->idle;
+        continue;
+      }
+
+      auto strand = Dequeue(*state);
+      lock.unlock();
+      auto again = strand->Run();
+      lock.lock();
+
+      ++state->completed;
+
+      if(again)
+        Enqueue(*state, strand);
+    }
+  }
+
+  static void Supervise(std::shared_ptr<State> state)
+  {
+    /* how long ready strands may wait for a worker before a spare is added */
+    auto const delay = std::chrono::milliseconds(20);
+
+    auto lock = Lock(state->mutex);
+
+    while(!state->quit)
+    {
+      if(!state->head || state->idle > 0)
+      {
+        state->starving.wait(lock);
+        continue;
+      }
+
+      auto const completed = state->completed;
+      auto const deadline = std::chrono::steady_clock::now() + delay;
+      state->watching = true;
+
+      while(!state->quit && state->starving.wait_until(lock, deadline) == std::cv_status::no_timeout)
+      {
+      }
+
+      state->watching = false;
+
+      if(!state->quit && state->head && state->idle == 0 && state->completed == completed)
+        Spawn(state);
+    }
+  }
+};
@@ -38,35 +38,70 @@
 #pragma once
 
 #include "processor_interface.h"
+#include "processor_executor.h"
 #include "locked_queue.h"
+#include "ring_queue.h"
 #include <thread>
 #include <cassert>
 #include <functional>
+#include <string>
 
-class ProcessorFifo : ProcessorInterface
+extern "C"
+{
+#include <lib_rtos/lib_rtos.h>
+}
+
+/**
+ * @brief Processes the queued data in order, on a dedicated thread or, when
+ * there is one, as a strand of the shared ProcessorExecutor
+ */
+class ProcessorFifo : ProcessorInterface, ProcessorExecutor::Strand
 {
 public:
-  ProcessorFifo(std::function<void(void*)> _process, std::function<void(void*)> _delete) :
-    _process(_process), _delete(_delete)
+  ProcessorFifo(std::function<void(void*)> _process, std::function<void(void*)> _delete, std::string name = "omx_fifo", std::shared_ptr<ProcessorExecutor> executor = ProcessorExecutor::Shared()) :
+    name(name), _process(_process), _delete(_delete), deleting(false), executor(executor), scheduled(false)
   {
     assert(_process);
     assert(_delete);
-    thread = std::thread(&ProcessorFifo::Worker, this);
+
+    if(!executor)
+      thread = std::thread(&ProcessorFifo::Worker, this);
   }
 
   ~ProcessorFifo()
   {
+    std::unique_lock<std::mutex> sync(mutex);
+    deleting = true;
+
+    if(executor)
     {
-      std::unique_lock<std::mutex> sync(mutex);
-      _process = _delete;
+      /* the remaining data goes to _delete on the executor */
+      drained.wait(sync, [&] { return !scheduled; });
+      return;
     }
+
+    sync.unlock();
     tasks.push(Task { true, nullptr });
     thread.join();
   }
 
   void queue(void* process)
   {
-    tasks.push(Task { false, process });
+    if(!executor)
+    {
+      tasks.push(Task { false, process });
+      return;
+    }
+
+    {
+      std::unique_lock<std::mutex> sync(mutex);
+      pending.push(process);
+
+      if(scheduled)
+        return;
+      scheduled = true;
+    }
+    executor->Schedule(this);
   }
 
 private:
@@ -76,14 +111,60 @@ private:
     void* data;
   };
 
+  /* data processed by a strand before it lets the other strands run */
+  static int const dataPerTurn = 16;
+
+  std::string name;
   std::thread thread;
   locked_queue<Task> tasks;
   std::mutex mutex;
   std::function<void(void*)> _process;
   std::function<void(void*)> _delete;
+  bool deleting;
+
+  std::shared_ptr<ProcessorExecutor> executor;
+  ring_queue<void*> pending;
+  bool scheduled;
+  std::condition_variable drained;
+
+  void Dispatch(void* data, bool shouldDelete)
+  {
+    /* don't copy the callbacks: a bound member function doesn't fit in
+     * std::function small buffer and each copy would hit the heap */
+    if(shouldDelete)
+      _delete(data);
+    else
+      _process(data);
+  }
+
+  bool Run() override
+  {
+    for(int i = 0; i < dataPerTurn; ++i)
+    {
+      void* data;
+      bool shouldDelete;
+      {
+        std::unique_lock<std::mutex> sync(mutex);
+
+        if(pending.empty())
+        {
+          scheduled = false;
+          drained.notify_all();
+          return false;
+        }
+        data = pending.pop();
+        shouldDelete = deleting;
+      }
+      Dispatch(data, shouldDelete);
+    }
+
+    return true;
+  }
 
   void Worker(void)
   {
+    Rtos_ApplyThreadConfig(name.c_str());
+
     while(true)
     {
       auto task = tasks.pop();
@@ -91,13 +172,12 @@ private:
       if(task.quit)
         break;
 
-      std::function<void(void*)> p;
+      bool shouldDelete;
       {
         std::unique_lock<std::mutex> sync(mutex);
-        p = _process;
+        shouldDelete = deleting;
       }
-      p(task.data);
+      Dispatch(task.data, shouldDelete);
     }
   }
 };
-
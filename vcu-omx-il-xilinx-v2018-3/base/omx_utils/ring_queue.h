@@ -0,0 +1,100 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A FIFO queue kept in a ring which only grows: a queue that reached
+ * its working depth does not allocate anymore. Not thread-safe.
+ */
+template<typename T>
+class ring_queue
+{
+public:
+  bool empty() const
+  {
+    return m_Count == 0;
+  }
+
+  void push(T val)
+  {
+    if(m_Count == m_Ring.size())
+      grow();
+
+    m_Ring[(m_Head + m_Count) % m_Ring.size()] = std::move(val);
+    ++m_Count;
+  }
+
+  T& front()
+  {
+    return m_Ring[m_Head];
+  }
+
+  T pop()
+  {
+    auto val = std::move(m_Ring[m_Head]);
+    m_Head = (m_Head + 1) % m_Ring.size();
+    --m_Count;
+    return val;
+  }
+
+  /* keeps the ring: a cleared queue does not allocate when filled again */
+  void clear()
+  {
+    while(!empty())
+      pop();
+  }
+
+private:
+  void grow()
+  {
+    std::vector<T> ring(m_Ring.empty() ? 16 : m_Ring.size() * 2);
+
+    for(size_t i = 0; i < m_Count; ++i)
+      ring[i] = std::move(m_Ring[(m_Head + i) % m_Ring.size()]);
+
+    m_Ring.swap(ring);
+    m_Head = 0;
+  }
+
+  std::vector<T> m_Ring;
+  size_t m_Head = 0;
+  size_t m_Count = 0;
+};
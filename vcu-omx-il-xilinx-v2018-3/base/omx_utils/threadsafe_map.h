@@ -36,61 +36,103 @@
 ******************************************************************************/
 
 #pragma once
-#include <map>
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <unordered_map>
 
+/**
+ * @brief A map shared by the omx threads and the codec callback threads.
+ *
+ * The keys are spread over independent stripes, each one a hash map behind
+ * its own mutex, so that lookups on different buffers don't contend.
+ * As with std::map::operator[], getting a missing key inserts a default value.
+ */
 template<class K, class V>
 class ThreadSafeMap
 {
 public:
+  ThreadSafeMap()
+  {
+    for(auto& stripe : stripes)
+      stripe.map.reserve(reservedPerStripe);
+  }
+
   void Add(K const& key, V value)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    map.insert(std::pair<K, V>(key, value));
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.map.insert(std::pair<K, V>(key, value));
+  }
+
+  /* unlike Add, replaces the value of a key already there */
+  void Set(K const& key, V value)
+  {
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.map[key] = value;
   }
 
   void Remove(K const& key)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    _Remove(key);
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.map.erase(key);
   }
 
   V Get(K const& key)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    return _Get(key);
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    return stripe.map[key];
   }
 
   V Pop(K const& key)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    auto val = _Get(key);
-    _Remove(key);
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.map.find(key);
+
+    if(it == stripe.map.end())
+      return V();
+
+    auto val = it->second;
+    stripe.map.erase(it);
     return val;
   }
 
   bool Exist(K const& key)
   {
-    std::lock_guard<std::mutex> lock(mutex);
+    auto& stripe = StripeOf(key);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
 
-    if(map.find(key) != map.end())
+    if(stripe.map.find(key) != stripe.map.end())
       return true;
 
     return false;
   }
 
 private:
-  V _Get(K const& key)
+  static int const stripeBits = 4;
+  static int const reservedPerStripe = 8;
+
+  /* the padding keeps two stripes out of the same cache line whatever the
+   * address of the map: the modules are allocated with new, which doesn't
+   * honour an over-aligned type before c++17 */
+  static int const cacheLineSize = 64;
+  struct Stripe
   {
-    return map[key];
-  }
+    std::mutex mutex;
+    std::unordered_map<K, V> map;
+    char pad[cacheLineSize];
+  };
 
-  void _Remove(K const& key)
+  Stripe stripes[1 << stripeBits];
+
+  Stripe& StripeOf(K const& key)
   {
-    map.erase(key);
+    /* buffer addresses are aligned: take the high bits of a fibonacci hash */
+    auto hash = static_cast<uint64_t>(std::hash<K>()(key)) * 0x9E3779B97F4A7C15ull;
+    return stripes[hash >> (64 - stripeBits)];
   }
-
-  std::mutex mutex;
-  std::map<K, V> map;
 };
-
@@ -0,0 +1,1898 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+/* Measures what the omx layers cost per buffer: the components are built
+ * around the null devices, which complete each frame right away, so what is
+ * left is the task dispatch of the component, the handle mapping and stream
+ * reconstruction of the module and the settings conversion.
+ *
+ * With --subframe, the encoder gives back each slice in its own buffer: the
+ * latency of the first slice is reported next to the one of the whole frame.
+ *
+ * With --lookahead, the frames go through the lookahead pass first: the latency
+ * of the first frame shows how long the window takes to fill, or not with
+ * --early-start. --lookahead-fifo times the lookahead fifo alone for a range
+ * of depths.
+ *
+ * With --use-buffer, the decoder writes in output buffers given by the
+ * application, so each frame is copied out of the buffer the decoder wrote:
+ * the copies run on the shared executor when OMX_ALLEGRO_WORKERS asks for one.
+ *
+ * --reconfigure times the parameter changes an application makes between two
+ * streams, on a loaded encoder.
+ *
+ * --handoff times the hand-offs between the processors of 1 to 32 components
+ * and counts their threads, with a thread per processor and with the shared
+ * executor.
+ *
+ * --map-contention times the buffer maps of the modules when several threads
+ * look buffers up at once, next to a map behind a single mutex.
+ *
+ * --sync checks which OMX_ALLEGRO_SYNC_FB_NUMBER values the sync ip takes and
+ * times, on the dummy sync driver, how fast a channel refills a frame buffer
+ * slot after the driver reports it and how fast the sync ip thread leaves.
+ * It also times how fast the eventfd of the hardware driver wakes up a poll.
+ *
+ * --file-io reads a yuv file into a frame with the padded stride of the
+ * components, with preadv and with mmap, writes its rows back and compares
+ * the copy with the file. The rows of a 1080p frame take more iovecs than
+ * IOV_MAX, the last frame of the file is truncated, and a last write goes
+ * through a fifo while a timer interrupts it, so that it comes back short.
+ *
+ * The benchmark is its own executable: this file is built with the library
+ * include paths and linked against the omx library and the control software.
+ * It provides the component factory itself, so the omx_wrapper_*.cpp
+ * factories of the library aren't pulled in. The library project excludes
+ * exe_omx/bench, as the malloc counters below would end up in every program
+ * linked against it */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+
+extern "C"
+{
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Types.h>
+#include <OMX_Video.h>
+#include <OMX_VideoExt.h>
+#include <OMX_ComponentExt.h>
+#include <OMX_IndexExt.h>
+#include <OMX_IndexAlg.h>
+#include <OMX_IVCommonAlg.h>
+
+#include <lib_common/BufferSrcMeta.h>
+#include <lib_common/HardwareDriver.h>
+}
+
+#include "base/omx_component/omx_component_enc.h"
+#include "base/omx_component/omx_component_dec.h"
+#include "base/omx_component/omx_expertise_avc.h"
+#include "base/omx_component/omx_expertise_hevc.h"
+#include "base/omx_mediatype/omx_mediatype_enc_avc.h"
+#include "base/omx_mediatype/omx_mediatype_enc_hevc.h"
+#include "base/omx_mediatype/omx_mediatype_dec_avc.h"
+#include "base/omx_module/omx_module_enc.h"
+#include "base/omx_module/omx_module_dec.h"
+#include "base/omx_module/omx_device_enc_null.h"
+#include "base/omx_module/omx_device_dec_null.h"
+#include "base/omx_module/null_sync_ip.h"
+#include "base/omx_module/omx_sync_ip.h"
+#include "base/omx_module/DummySyncDriver.h"
+#include "base/omx_module/SyncLog.h"
+#include "base/omx_module/TwoPassMngr.h"
+
+#include "base/omx_utils/locked_queue.h"
+#include "base/omx_utils/processor_fifo.h"
+#include "base/omx_utils/processor_executor.h"
+#include "base/omx_utils/semaphore.h"
+#include "base/omx_utils/threadsafe_map.h"
+#include "base/omx_utils/omx_log.h"
+
+#include "common/file_io.h"
+#include "common/helpers.h"
+#include "common/setters.h"
+#include "common/CommandLineParser.h"
+
+/* every allocation goes through malloc, operator new included: they are
+ * counted while a run is measured */
+static atomic<bool> countAllocations(false);
+static atomic<uint64_t> allocations(0);
+
+#if defined(__GLIBC__)
+extern "C"
+{
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t num, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) __THROW
+{
+  if(countAllocations.load(memory_order_relaxed))
+    allocations.fetch_add(1, memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) __THROW
+{
+  if(countAllocations.load(memory_order_relaxed))
+    allocations.fetch_add(1, memory_order_relaxed);
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW
+{
+  if(countAllocations.load(memory_order_relaxed))
+    allocations.fetch_add(1, memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+}
+#endif
+
+static char const* const NULL_AVC_ENCODER = "OMX.allegro.h264.null.encoder";
+static char const* const NULL_HEVC_ENCODER = "OMX.allegro.h265.null.encoder";
+static char const* const NULL_AVC_DECODER = "OMX.allegro.h264.null.decoder";
+
+static int payloadSize = 4096;
+static int frameDuration = 0;
+static int const framerate = 60;
+
+extern "C"
+{
+OMX_API OMX_ERRORTYPE CreateComponent(OMX_IN OMX_HANDLETYPE hComponent, OMX_IN OMX_STRING cComponentName, OMX_IN OMX_STRING cRole, OMX_IN OMX_PTR pAppPrivate, OMX_IN OMX_CALLBACKTYPE* pCallbacks);
+
+OMX_PTR CreateComponentPrivate(OMX_IN OMX_HANDLETYPE hComponent, OMX_IN OMX_STRING cComponentName, OMX_IN OMX_STRING cRole)
+{
+  /* the encoder device never looks at the buffers content */
+  shared_ptr<AL_TAllocator> encAllocator(AL_GetDefaultAllocator(), [](AL_TAllocator*) {});
+
+  if(!strcmp(cComponentName, NULL_AVC_ENCODER))
+  {
+    shared_ptr<EncMediatypeAVC> media(new EncMediatypeAVC());
+    shared_ptr<EncDeviceNull> device(new EncDeviceNull(payloadSize, frameDuration));
+    unique_ptr<EncModule> module(new EncModule(media, device, encAllocator));
+    unique_ptr<ExpertiseAVC> expertise(new ExpertiseAVC());
+    shared_ptr<SyncIpInterface> syncIp(new NullSyncIp());
+    return static_cast<OMXComponentInterface*>(new EncComponent(hComponent, media, move(module), cComponentName, cRole, move(expertise), syncIp));
+  }
+
+  if(!strcmp(cComponentName, NULL_HEVC_ENCODER))
+  {
+    shared_ptr<EncMediatypeHEVC> media(new EncMediatypeHEVC());
+    shared_ptr<EncDeviceNull> device(new EncDeviceNull(payloadSize, frameDuration));
+    unique_ptr<EncModule> module(new EncModule(media, device, encAllocator));
+    unique_ptr<ExpertiseHEVC> expertise(new ExpertiseHEVC());
+    shared_ptr<SyncIpInterface> syncIp(new NullSyncIp());
+    return static_cast<OMXComponentInterface*>(new EncComponent(hComponent, media, move(module), cComponentName, cRole, move(expertise), syncIp));
+  }
+
+  if(!strcmp(cComponentName, NULL_AVC_DECODER))
+  {
+    shared_ptr<DecMediatypeAVC> media(new DecMediatypeAVC());
+    shared_ptr<DecDeviceNull> device(new DecDeviceNull);
+    unique_ptr<DecModule> module(new DecModule(media, device, device->GetAllocator()));
+    unique_ptr<ExpertiseAVC> expertise(new ExpertiseAVC());
+    return static_cast<OMXComponentInterface*>(new DecComponent(hComponent, media, move(module), cComponentName, cRole, move(expertise)));
+  }
+
+  return nullptr;
+}
+
+void DestroyComponentPrivate(OMX_IN OMX_PTR pComponentPrivate)
+{
+  delete static_cast<OMXComponentInterface*>(pComponentPrivate);
+}
+}
+
+struct Settings
+{
+  int frames;
+  int warmup;
+  int width;
+  int height;
+  int subframe;
+  int lookahead;
+  bool earlyStart;
+  bool lookaheadFifo;
+  bool handoff;
+  int workers;
+  bool mapContention;
+  bool sync;
+  bool reconfigure;
+  bool fileIo;
+  bool useBuffer;
+  bool hevc;
+  bool encoder;
+  bool decoder;
+};
+
+struct Bench
+{
+  OMX_HANDLETYPE handle;
+  semaphore stateChanged;
+  semaphore commandDone;
+  semaphore eos;
+  atomic<bool> stopping;
+
+  locked_queue<OMX_BUFFERHEADERTYPE*> freeInputs;
+  vector<OMX_BUFFERHEADERTYPE*> inputs;
+  vector<OMX_BUFFERHEADERTYPE*> outputs;
+
+  /* the output buffers are the bench's instead of the component's */
+  bool useOutputBuffers;
+  vector<unique_ptr<OMX_U8[]>> clientBuffers;
+
+  /* indexed by frame, the frame number travels as the timestamp.
+   * latencies is up to the first buffer of the frame, frameLatencies up to its end */
+  vector<chrono::steady_clock::time_point> sentAt;
+  vector<double> latencies;
+  vector<double> frameLatencies;
+  int filled;
+  int slices;
+};
+
+struct Result
+{
+  int buffers;
+  int slices;
+  double seconds;
+  vector<double> latencies;
+  vector<double> frameLatencies;
+  double firstLatency;
+  uint64_t allocations; // once warm
+  int warmBuffers;
+  bool hasComponentLatency;
+  OMX_ALG_VIDEO_CONFIG_SUBFRAME_LATENCY componentLatency;
+};
+
+static OMX_ERRORTYPE onComponentEvent(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_EVENTTYPE eEvent, OMX_U32 Data1, OMX_U32, OMX_PTR)
+{
+  auto bench = static_cast<Bench*>(pAppData);
+
+  switch(eEvent)
+  {
+  case OMX_EventCmdComplete:
+  {
+    if(Data1 == OMX_CommandStateSet)
+      bench->stateChanged.notify();
+    else
+      bench->commandDone.notify();
+    break;
+  }
+  case OMX_EventError:
+  {
+    LOGE("Comp %p : error 0x%.8X", hComponent, Data1);
+    exit(1);
+  }
+  default:
+    break;
+  }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE onInputBufferAvailable(OMX_HANDLETYPE, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+  auto bench = static_cast<Bench*>(pAppData);
+  bench->freeInputs.push(pBuffer);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE onOutputBufferAvailable(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE* pBuffer)
+{
+  auto bench = static_cast<Bench*>(pAppData);
+  auto const now = chrono::steady_clock::now();
+
+  if(bench->stopping)
+    return OMX_ErrorNone;
+
+  auto const frame = (size_t)pBuffer->nTimeStamp;
+
+  if(pBuffer->nFilledLen && frame < bench->latencies.size())
+  {
+    auto const latency = chrono::duration<double, micro>(now - bench->sentAt[frame]).count();
+    ++bench->slices;
+
+    if(bench->latencies[frame] < 0)
+    {
+      bench->latencies[frame] = latency;
+      ++bench->filled;
+    }
+
+    if(pBuffer->nFlags & OMX_BUFFERFLAG_ENDOFFRAME)
+      bench->frameLatencies[frame] = latency;
+  }
+
+  if(pBuffer->nFlags & OMX_BUFFERFLAG_EOS)
+  {
+    bench->eos.notify();
+    return OMX_ErrorNone;
+  }
+
+  pBuffer->nFilledLen = 0;
+  pBuffer->nFlags = 0;
+  pBuffer->nTimeStamp = 0;
+  OMX_CALL(OMX_FillThisBuffer(hComponent, pBuffer));
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE setBufferCount(OMX_HANDLETYPE handle, OMX_U32 port, int extra)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE param;
+  initHeader(param);
+  param.nPortIndex = port;
+  OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &param));
+  param.nBufferCountActual = param.nBufferCountMin + extra;
+  OMX_CALL(OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &param));
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE allocateBuffers(Bench& bench, OMX_U32 port, vector<OMX_BUFFERHEADERTYPE*>& buffers)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE param;
+  initHeader(param);
+  param.nPortIndex = port;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamPortDefinition, &param));
+
+  for(OMX_U32 i = 0; i < param.nBufferCountActual; ++i)
+  {
+    OMX_BUFFERHEADERTYPE* header;
+
+    if(port == 1 && bench.useOutputBuffers)
+    {
+      bench.clientBuffers.push_back(unique_ptr<OMX_U8[]>(new OMX_U8[param.nBufferSize]));
+      OMX_CALL(OMX_UseBuffer(bench.handle, &header, port, &bench, param.nBufferSize, bench.clientBuffers.back().get()));
+    }
+    else
+      OMX_CALL(OMX_AllocateBuffer(bench.handle, &header, port, &bench, param.nBufferSize));
+    buffers.push_back(header);
+  }
+
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE configureEncoder(Bench& bench, Settings const& settings)
+{
+  OMX_VIDEO_PARAM_PORTFORMATTYPE format;
+  initHeader(format);
+  format.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+  format.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+  format.xFramerate = framerate << 16;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+
+  OMX_PARAM_PORTDEFINITIONTYPE param;
+  initHeader(param);
+  param.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamPortDefinition, &param));
+  param.format.video.nFrameWidth = settings.width;
+  param.format.video.nFrameHeight = settings.height;
+  param.format.video.nStride = settings.width;
+  param.format.video.nSliceHeight = (settings.height + 7) & ~7;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamPortDefinition, &param));
+
+  Setters setter(&bench.handle);
+
+  if(!setter.SetBufferMode(0, OMX_ALG_BUF_NORMAL) || !setter.SetBufferMode(1, OMX_ALG_BUF_NORMAL))
+    return OMX_ErrorUndefined;
+
+  if(settings.subframe)
+  {
+    OMX_ALG_VIDEO_PARAM_SLICES slices;
+    initHeader(slices);
+    slices.nPortIndex = 1;
+    OMX_CALL(OMX_GetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoSlices), &slices));
+    slices.nNumSlices = settings.subframe;
+    OMX_CALL(OMX_SetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoSlices), &slices));
+
+    OMX_ALG_VIDEO_PARAM_SUBFRAME subframe;
+    initHeader(subframe);
+    subframe.nPortIndex = 1;
+    subframe.bEnableSubframe = OMX_TRUE;
+    OMX_CALL(OMX_SetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoSubframe), &subframe));
+  }
+
+  if(settings.lookahead)
+  {
+    OMX_ALG_VIDEO_PARAM_LOOKAHEAD la;
+    initHeader(la);
+    la.nPortIndex = 1;
+    OMX_CALL(OMX_GetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoLookAhead), &la));
+    la.nLookAhead = settings.lookahead;
+    la.bEnableEarlyStart = settings.earlyStart ? OMX_TRUE : OMX_FALSE;
+    OMX_CALL(OMX_SetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamVideoLookAhead), &la));
+  }
+
+  /* the sources stay held while they wait in the lookahead window */
+  OMX_CALL(setBufferCount(bench.handle, 0, 4 + settings.lookahead));
+  OMX_CALL(setBufferCount(bench.handle, 1, 4));
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE configureDecoder(Bench& bench, Settings const& settings)
+{
+  OMX_VIDEO_PARAM_PORTFORMATTYPE format;
+  initHeader(format);
+  format.nPortIndex = 1;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+  format.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+
+  Setters setter(&bench.handle);
+
+  if(!setter.SetBufferMode(0, OMX_ALG_BUF_NORMAL) || !setter.SetBufferMode(1, OMX_ALG_BUF_NORMAL))
+    return OMX_ErrorUndefined;
+
+  /* preallocate for the generated stream, as the decoder application does */
+  OMX_VIDEO_PARAM_PROFILELEVELTYPE profileLevel;
+  initHeader(profileLevel);
+  profileLevel.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamVideoProfileLevelCurrent, &profileLevel));
+  profileLevel.eProfile = OMX_VIDEO_AVCProfileMain;
+  profileLevel.eLevel = OMX_VIDEO_AVCLevel4;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamVideoProfileLevelCurrent, &profileLevel));
+
+  OMX_PARAM_PORTDEFINITIONTYPE param;
+  initHeader(param);
+  param.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamPortDefinition, &param));
+  param.format.video.nFrameWidth = settings.width;
+  param.format.video.nFrameHeight = settings.height;
+  param.format.video.nStride = settings.width;
+  param.format.video.nSliceHeight = settings.height;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamPortDefinition, &param));
+
+  initHeader(format);
+  format.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+  format.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+  format.xFramerate = framerate << 16;
+  OMX_CALL(OMX_SetParameter(bench.handle, OMX_IndexParamVideoPortFormat, &format));
+
+  OMX_ALG_COMMON_PARAM_SEQUENCE_PICTURE_MODE sequence;
+  initHeader(sequence);
+  sequence.nPortIndex = 0;
+  OMX_CALL(OMX_GetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamCommonSequencePictureModeCurrent), &sequence));
+  sequence.eMode = OMX_ALG_SEQUENCE_PICTURE_FRAME;
+  OMX_CALL(OMX_SetParameter(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexParamCommonSequencePictureModeCurrent), &sequence));
+
+  OMX_CALL(setBufferCount(bench.handle, 1, 1));
+  bench.useOutputBuffers = settings.useBuffer;
+  return OMX_ErrorNone;
+}
+
+/* Minimal avc stream: a main profile sps/pps and one slice per frame. Only
+ * the headers are parsed by the control software, the slice data is filler */
+struct BitWriter
+{
+  vector<uint8_t> rbsp;
+  uint8_t current = 0;
+  int bits = 0;
+
+  void u(int n, uint32_t value)
+  {
+    for(int i = n - 1; i >= 0; --i)
+    {
+      current = (current << 1) | ((value >> i) & 1);
+
+      if(++bits == 8)
+      {
+        rbsp.push_back(current);
+        current = 0;
+        bits = 0;
+      }
+    }
+  }
+
+  void ue(uint32_t value)
+  {
+    ++value;
+    int len = 0;
+
+    while((value >> len) > 1)
+      ++len;
+
+    u(len, 0);
+    u(len + 1, value);
+  }
+
+  void se(int value)
+  {
+    ue(value <= 0 ? -2 * value : 2 * value - 1);
+  }
+
+  void trailingBits()
+  {
+    u(1, 1);
+
+    while(bits)
+      u(1, 0);
+  }
+};
+
+static void appendNal(vector<uint8_t>& stream, uint8_t header, vector<uint8_t> const& rbsp)
+{
+  static uint8_t const startCode[] = { 0x00, 0x00, 0x00, 0x01 };
+  stream.insert(stream.end(), begin(startCode), end(startCode));
+  stream.push_back(header);
+
+  int zeros = 0;
+
+  for(auto byte : rbsp)
+  {
+    if(zeros == 2 && byte <= 0x03)
+    {
+      stream.push_back(0x03);
+      zeros = 0;
+    }
+
+    stream.push_back(byte);
+    zeros = byte ? 0 : zeros + 1;
+  }
+}
+
+static vector<vector<uint8_t>> generateAvcStream(Settings const& settings)
+{
+  auto const widthInMbs = (settings.width + 15) / 16;
+  auto const heightInMbs = (settings.height + 15) / 16;
+  auto const cropBottom = (heightInMbs * 16 - settings.height) / 2;
+
+  BitWriter sps;
+  sps.u(8, 77); // main
+  sps.u(8, 0);
+  sps.u(8, 40); // level 4.0
+  sps.ue(0); // seq_parameter_set_id
+  sps.ue(0); // log2_max_frame_num_minus4
+  sps.ue(2); // pic_order_cnt_type
+  sps.ue(1); // max_num_ref_frames
+  sps.u(1, 0); // gaps_in_frame_num_value_allowed_flag
+  sps.ue(widthInMbs - 1);
+  sps.ue(heightInMbs - 1);
+  sps.u(1, 1); // frame_mbs_only_flag
+  sps.u(1, 1); // direct_8x8_inference_flag
+  sps.u(1, cropBottom ? 1 : 0);
+
+  if(cropBottom)
+  {
+    sps.ue(0);
+    sps.ue(0);
+    sps.ue(0);
+    sps.ue(cropBottom);
+  }
+  sps.u(1, 0); // vui_parameters_present_flag
+  sps.trailingBits();
+
+  BitWriter pps;
+  pps.ue(0); // pic_parameter_set_id
+  pps.ue(0); // seq_parameter_set_id
+  pps.u(1, 0); // entropy_coding_mode_flag
+  pps.u(1, 0); // bottom_field_pic_order_in_frame_present_flag
+  pps.ue(0); // num_slice_groups_minus1
+  pps.ue(0); // num_ref_idx_l0_default_active_minus1
+  pps.ue(0); // num_ref_idx_l1_default_active_minus1
+  pps.u(1, 0); // weighted_pred_flag
+  pps.u(2, 0); // weighted_bipred_idc
+  pps.se(0); // pic_init_qp_minus26
+  pps.se(0); // pic_init_qs_minus26
+  pps.se(0); // chroma_qp_index_offset
+  pps.u(1, 1); // deblocking_filter_control_present_flag
+  pps.u(1, 0); // constrained_intra_pred_flag
+  pps.u(1, 0); // redundant_pic_cnt_present_flag
+  pps.trailingBits();
+
+  vector<vector<uint8_t>> accessUnits(settings.frames);
+
+  for(int frame = 0; frame < settings.frames; ++frame)
+  {
+    auto& au = accessUnits[frame];
+    auto const isIdr = frame == 0;
+
+    if(isIdr)
+    {
+      appendNal(au, 0x67, sps.rbsp);
+      appendNal(au, 0x68, pps.rbsp);
+    }
+
+    BitWriter slice;
+    slice.ue(0); // first_mb_in_slice
+    slice.ue(isIdr ? 7 : 5); // I or P
+    slice.ue(0); // pic_parameter_set_id
+    slice.u(4, frame % 16); // frame_num
+
+    if(isIdr)
+      slice.ue(0); // idr_pic_id
+    else
+    {
+      slice.u(1, 0); // num_ref_idx_active_override_flag
+      slice.u(1, 0); // ref_pic_list_modification_flag_l0
+    }
+
+    if(isIdr)
+    {
+      slice.u(1, 0); // no_output_of_prior_pics_flag
+      slice.u(1, 0); // long_term_reference_flag
+    }
+    else
+      slice.u(1, 0); // adaptive_ref_pic_marking_mode_flag
+
+    slice.se(0); // slice_qp_delta
+    slice.ue(1); // disable_deblocking_filter_idc
+    slice.trailingBits();
+    slice.rbsp.insert(slice.rbsp.end(), payloadSize, 0x55);
+
+    appendNal(au, isIdr ? 0x65 : 0x41, slice.rbsp);
+  }
+
+  return accessUnits;
+}
+
+static bool fillEncoderInput(OMX_BUFFERHEADERTYPE* header, int)
+{
+  /* the null device doesn't read the picture */
+  header->nOffset = 0;
+  header->nFilledLen = header->nAllocLen;
+  header->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+  return true;
+}
+
+template<typename Fill>
+static OMX_ERRORTYPE run(char const* name, char const* role, Settings const& settings, function<OMX_ERRORTYPE(Bench &, Settings const &)> configure, Fill fill, Result& result)
+{
+  Bench bench;
+  bench.stopping = false;
+  bench.useOutputBuffers = false;
+  bench.filled = 0;
+  bench.slices = 0;
+  bench.sentAt.resize(settings.frames);
+  bench.latencies.assign(settings.frames, -1.0);
+  bench.frameLatencies.assign(settings.frames, -1.0);
+
+  OMX_CALLBACKTYPE callbacks;
+  callbacks.EventHandler = onComponentEvent;
+  callbacks.EmptyBufferDone = onInputBufferAvailable;
+  callbacks.FillBufferDone = onOutputBufferAvailable;
+
+  unique_ptr<OMX_COMPONENTTYPE> component(new OMX_COMPONENTTYPE());
+  bench.handle = component.get();
+  OMX_CALL(CreateComponent(bench.handle, (OMX_STRING)name, (OMX_STRING)role, &bench, &callbacks));
+  auto scopeHandle = scopeExit([&]() {
+    component->ComponentDeInit(bench.handle);
+  });
+
+  OMX_CALL(configure(bench, settings));
+
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandStateSet, OMX_StateIdle, nullptr));
+  OMX_CALL(allocateBuffers(bench, 0, bench.inputs));
+  OMX_CALL(allocateBuffers(bench, 1, bench.outputs));
+  bench.stateChanged.wait();
+
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandStateSet, OMX_StateExecuting, nullptr));
+  bench.stateChanged.wait();
+
+  for(auto output : bench.outputs)
+    OMX_CALL(OMX_FillThisBuffer(bench.handle, output));
+
+  for(auto input : bench.inputs)
+    bench.freeInputs.push(input);
+
+  allocations = 0;
+  auto const start = chrono::steady_clock::now();
+
+  for(int frame = 0; frame < settings.frames; ++frame)
+  {
+    /* the first buffers fill the pools and maps of the component */
+    if(frame == settings.warmup)
+      countAllocations = true;
+
+    /* with a frame time, frames come at the pace of a live source instead of queuing */
+    if(frameDuration)
+      this_thread::sleep_until(start + chrono::microseconds(1000000 / framerate) * frame);
+
+    auto input = bench.freeInputs.pop();
+
+    if(!fill(input, frame))
+      return OMX_ErrorInsufficientResources;
+
+    input->nTimeStamp = frame;
+    bench.sentAt[frame] = chrono::steady_clock::now();
+    OMX_CALL(OMX_EmptyThisBuffer(bench.handle, input));
+  }
+
+  auto input = bench.freeInputs.pop();
+  input->nFilledLen = 0;
+  input->nFlags = OMX_BUFFERFLAG_EOS;
+  input->nTimeStamp = settings.frames;
+  /* the end of stream flushes the codec once, it isn't a per buffer cost */
+  countAllocations = false;
+  OMX_CALL(OMX_EmptyThisBuffer(bench.handle, input));
+
+  bench.eos.wait();
+  auto const end = chrono::steady_clock::now();
+
+  initHeader(result.componentLatency);
+  result.componentLatency.nPortIndex = 1;
+  result.hasComponentLatency = OMX_GetConfig(bench.handle, static_cast<OMX_INDEXTYPE>(OMX_ALG_IndexConfigVideoSubframeLatency), &result.componentLatency) == OMX_ErrorNone;
+
+  bench.stopping = true;
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandFlush, 0, nullptr));
+  bench.commandDone.wait();
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandFlush, 1, nullptr));
+  bench.commandDone.wait();
+
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandStateSet, OMX_StateIdle, nullptr));
+  bench.stateChanged.wait();
+  OMX_CALL(OMX_SendCommand(bench.handle, OMX_CommandStateSet, OMX_StateLoaded, nullptr));
+
+  for(auto input : bench.inputs)
+    OMX_CALL(OMX_FreeBuffer(bench.handle, 0, input));
+
+  for(auto output : bench.outputs)
+    OMX_CALL(OMX_FreeBuffer(bench.handle, 1, output));
+
+  bench.stateChanged.wait();
+
+  result.buffers = bench.filled;
+  result.slices = bench.slices;
+  result.seconds = chrono::duration<double>(end - start).count();
+  result.allocations = allocations;
+  result.warmBuffers = settings.frames - settings.warmup;
+  result.firstLatency = bench.latencies.empty() ? -1 : bench.latencies[0];
+
+  for(auto latency : bench.latencies)
+  {
+    if(latency >= 0)
+      result.latencies.push_back(latency);
+  }
+
+  for(auto latency : bench.frameLatencies)
+  {
+    if(latency >= 0)
+      result.frameLatencies.push_back(latency);
+  }
+
+  return OMX_ErrorNone;
+}
+
+static double percentile(vector<double> const& sorted, int percent)
+{
+  if(sorted.empty())
+    return 0;
+  return sorted[min(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+
+static void report(char const* name, Result result, Settings const& settings)
+{
+  sort(result.latencies.begin(), result.latencies.end());
+  cout << left << setw(10) << name << right << fixed
+       << setw(7) << result.buffers << " buffers"
+       << setw(10) << setprecision(1) << result.buffers / result.seconds << " buffers/s"
+       << "  latency p50" << setw(8) << percentile(result.latencies, 50)
+       << " p90" << setw(8) << percentile(result.latencies, 90)
+       << " p99" << setw(8) << percentile(result.latencies, 99) << " us"
+       << setw(8) << setprecision(2) << (double)result.allocations / max(result.warmBuffers, 1) << " allocations/buffer" << endl;
+
+  if(settings.lookahead)
+    cout << setw(10) << "" << "lookahead " << settings.lookahead << (settings.earlyStart ? " with early start" : "")
+         << ", first frame out after" << setw(10) << setprecision(1) << result.firstLatency << " us" << endl;
+
+  /* only worth a line when the frames come back in several buffers */
+  if(result.slices == result.buffers)
+    return;
+
+  sort(result.frameLatencies.begin(), result.frameLatencies.end());
+  cout << setw(10) << "" << setw(7) << setprecision(1) << (double)result.slices / max(result.buffers, 1) << " slices/frame"
+       << "  first slice p50" << setw(8) << percentile(result.latencies, 50)
+       << " p99" << setw(8) << percentile(result.latencies, 99)
+       << "  end of frame p50" << setw(8) << percentile(result.frameLatencies, 50)
+       << " p99" << setw(8) << percentile(result.frameLatencies, 99) << " us" << endl;
+
+  if(result.hasComponentLatency)
+    cout << setw(10) << "" << "component first slice latency: " << result.componentLatency.nFrames << " frames"
+         << ", last " << result.componentLatency.nLastLatency
+         << " mean " << result.componentLatency.nMeanLatency
+         << " max " << result.componentLatency.nMaxLatency << " us" << endl;
+}
+
+/* Pushes frames of varying sizes through a fifo of each depth, the way the
+ * pass thread does, and reports what a frame costs */
+static void benchLookAheadFifo(Settings const& settings)
+{
+  static int const depths[] = { 2, 10, 20, 40, 60, 120 };
+
+  for(auto depth : depths)
+  {
+    /* enough sources for the ones held in the window and the one being pushed */
+    vector<AL_TBuffer*> sources(depth + 2);
+
+    for(auto& source : sources)
+    {
+      source = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), 16, [](AL_TBuffer*) {});
+      AL_Buffer_AddMetaData(source, (AL_TMetaData*)AL_LookAheadMetaData_Create());
+    }
+
+    LookAheadFifo fifo;
+    fifo.Init(depth, settings.earlyStart);
+
+    uint32_t seed = 1;
+    int out = 0;
+    auto const start = chrono::steady_clock::now();
+
+    for(int frame = 0; frame < settings.frames; ++frame)
+    {
+      auto source = sources[frame % sources.size()];
+      auto meta = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(source, AL_META_TYPE_LOOKAHEAD);
+      seed = seed * 1103515245 + 12345;
+      meta->iPictureSize = 20000 + (seed >> 16) % 100000;
+      meta->iPercentIntra = frame % 30 ? 10 : 100;
+
+      AL_Buffer_Ref(source);
+      fifo.Push(source);
+
+      if(auto next = fifo.Pop(false))
+      {
+        AL_Buffer_Unref(next);
+        ++out;
+      }
+    }
+
+    while(auto next = fifo.Pop(true))
+    {
+      AL_Buffer_Unref(next);
+      ++out;
+    }
+
+    auto const ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    cout << left << setw(10) << "fifo" << right << fixed << "depth" << setw(5) << depth
+         << setw(10) << out << " frames" << setw(10) << setprecision(1) << ns / max(out, 1) << " ns/frame" << endl;
+
+    for(auto source : sources)
+      AL_Buffer_Destroy(source);
+  }
+}
+
+static int countThreads()
+{
+  ifstream status("/proc/self/status");
+  string line;
+
+  while(getline(status, line))
+  {
+    if(line.compare(0, 8, "Threads:") == 0)
+      return atoi(line.c_str() + 8);
+  }
+
+  return -1;
+}
+
+/* a component hands a buffer from its main processor to its empty one and
+ * then to its fill one, as a buffer going through it does */
+struct HandOffComponent
+{
+  unique_ptr<ProcessorFifo> main;
+  unique_ptr<ProcessorFifo> empty;
+  unique_ptr<ProcessorFifo> fill;
+  chrono::steady_clock::time_point sentAt;
+  vector<double> latencies;
+  semaphore* done;
+};
+
+struct HandOffResult
+{
+  int threads;
+  double p50;
+  double p99;
+};
+
+/* without workers, each processor has its own thread */
+static HandOffResult runHandOff(int componentCount, int rounds, int workers)
+{
+  auto const threadsBefore = countThreads();
+  shared_ptr<ProcessorExecutor> executor;
+
+  if(workers)
+    executor = make_shared<ProcessorExecutor>(workers);
+
+  semaphore done;
+  vector<unique_ptr<HandOffComponent>> components;
+
+  for(int i = 0; i < componentCount; ++i)
+  {
+    auto component = new HandOffComponent;
+    component->done = &done;
+    component->latencies.reserve(rounds);
+    auto drop = [](void*) {};
+    component->fill.reset(new ProcessorFifo([component](void*) {
+      component->latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - component->sentAt).count());
+      component->done->notify();
+    }, drop, "omx_fill", executor));
+    component->empty.reset(new ProcessorFifo([component](void* data) {
+      component->fill->queue(data);
+    }, drop, "omx_empty", executor));
+    component->main.reset(new ProcessorFifo([component](void* data) {
+      component->empty->queue(data);
+    }, drop, "omx_main", executor));
+    components.emplace_back(component);
+  }
+
+  /* one buffer in flight per component */
+  for(int round = 0; round < rounds; ++round)
+  {
+    for(auto& component : components)
+    {
+      component->sentAt = chrono::steady_clock::now();
+      component->main->queue(nullptr);
+    }
+
+    for(int i = 0; i < componentCount; ++i)
+      done.wait();
+  }
+
+  /* the shared executor may have added spare workers while running */
+  HandOffResult result {};
+  result.threads = countThreads() - threadsBefore;
+
+  vector<double> latencies;
+
+  for(auto& component : components)
+    latencies.insert(latencies.end(), component->latencies.begin(), component->latencies.end());
+
+  sort(latencies.begin(), latencies.end());
+  result.p50 = percentile(latencies, 50);
+  result.p99 = percentile(latencies, 99);
+
+  return result;
+}
+
+static void benchHandOff(Settings const& settings)
+{
+  static int const componentCounts[] = { 1, 2, 4, 8, 16, 32 };
+
+  for(auto componentCount : componentCounts)
+  {
+    auto dedicated = runHandOff(componentCount, settings.frames, 0);
+    auto shared = runHandOff(componentCount, settings.frames, settings.workers);
+
+    cout << left << setw(10) << "handoff" << right << fixed << "components" << setw(4) << componentCount
+         << "  dedicated threads" << setw(4) << dedicated.threads
+         << " p50" << setw(8) << setprecision(1) << dedicated.p50 << " p99" << setw(8) << dedicated.p99 << " us"
+         << "  shared threads" << setw(4) << shared.threads
+         << " p50" << setw(8) << shared.p50 << " p99" << setw(8) << shared.p99 << " us" << endl;
+  }
+}
+
+/* the map the modules used before it was striped */
+template<class K, class V>
+class SingleLockMap
+{
+public:
+  void Set(K const& key, V value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    map[key] = value;
+  }
+
+  V Get(K const& key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map[key];
+  }
+
+  bool Exist(K const& key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return map.find(key) != map.end();
+  }
+
+private:
+  std::mutex mutex;
+  std::map<K, V> map;
+};
+
+/* each thread stands for a codec channel: it sets the handle of its buffers
+ * when they are queued, looks them up and resets them as their callbacks
+ * come, as the modules do */
+template<typename Map>
+static double runMapContention(int threadCount, int frames)
+{
+  static int const buffersPerThread = 16;
+  Map map;
+  vector<AL_TBuffer> buffers(threadCount * buffersPerThread);
+  atomic<int> ready(0);
+  atomic<bool> go(false);
+  vector<thread> threads;
+
+  for(int t = 0; t < threadCount; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      ++ready;
+
+      while(!go)
+        this_thread::yield();
+
+      for(int frame = 0; frame < frames; ++frame)
+      {
+        auto buffer = &buffers[t * buffersPerThread + frame % buffersPerThread];
+        map.Set(buffer, reinterpret_cast<BufferHandleInterface*>(buffer));
+
+        if(!map.Exist(buffer) || !map.Get(buffer))
+          abort();
+        map.Set(buffer, nullptr);
+      }
+    });
+  }
+
+  while(ready != threadCount)
+    this_thread::yield();
+
+  auto const start = chrono::steady_clock::now();
+  go = true;
+
+  for(auto& t : threads)
+    t.join();
+
+  auto const ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+  return ns / ((double)frames * threadCount);
+}
+
+static void benchMapContention(Settings const& settings)
+{
+  static int const threadCounts[] = { 1, 2, 4, 8 };
+
+  for(auto threadCount : threadCounts)
+  {
+    auto single = runMapContention<SingleLockMap<AL_TBuffer*, BufferHandleInterface*>>(threadCount, settings.frames);
+    auto striped = runMapContention<ThreadSafeMap<AL_TBuffer*, BufferHandleInterface*>>(threadCount, settings.frames);
+
+    cout << left << setw(10) << "map" << right << fixed << "threads" << setw(4) << threadCount
+         << "  single lock" << setw(10) << setprecision(1) << single << " ns/buffer"
+         << "  striped" << setw(10) << striped << " ns/buffer" << endl;
+  }
+}
+
+/* Each change alternates between two values, so that every call changes
+ * something, except for the ones reapplying the current parameters */
+/* a source buffer the sync ip can be programmed with */
+static AL_TBuffer* createSyncSource(Settings const& settings)
+{
+  auto const stride = settings.width;
+  auto const sliceHeight = settings.height;
+  auto buffer = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), stride * sliceHeight * 3 / 2, AL_Buffer_Destroy);
+
+  if(!buffer)
+    return nullptr;
+
+  AL_TPitches const pitches = { stride, stride };
+  AL_TOffsetYC const offsetYC = { 0, stride * sliceHeight };
+  auto meta = AL_SrcMetaData_Create({ settings.width, settings.height }, pitches, offsetYC, FOURCC(NV12));
+
+  if(!meta || !AL_Buffer_AddMetaData(buffer, (AL_TMetaData*)meta))
+  {
+    if(meta)
+      meta->tMeta.MetaDestroy((AL_TMetaData*)meta);
+    AL_Buffer_Destroy(buffer);
+    return nullptr;
+  }
+
+  return buffer;
+}
+
+/* the dummy driver finalizes the oldest frame buffer of the channel, the
+ * channel refills the slot from the notification of the sync ip thread */
+static bool runSync(Settings const& settings, int fbNumber, vector<double>& refills, double& teardown)
+{
+  static int const bufferCount = 4;
+  auto driver = AL_InitDummyDriver(true, 4, fbNumber);
+  unique_ptr<SyncIp> sync(new SyncIp(driver, "dummy", fbNumber));
+  unique_ptr<SyncChannel> channel(new SyncChannel(sync.get(), sync->getFreeChannel()));
+
+  for(int i = 0; i < bufferCount; ++i)
+  {
+    auto buffer = createSyncSource(settings);
+
+    if(!buffer)
+      return false;
+
+    /* the channel holds the only reference */
+    channel->addBuffer(buffer);
+  }
+
+  channel->enable();
+
+  for(int frame = 0; frame < settings.frames; ++frame)
+  {
+    auto const start = chrono::steady_clock::now();
+    driver->FinalizeBuffer(channel->id);
+
+    /* the slot was refilled by the time the consumption is counted */
+    while(channel->getLatency().consumed <= frame)
+      this_thread::yield();
+
+    refills.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+  }
+
+  auto const start = chrono::steady_clock::now();
+  channel.reset();
+  sync.reset();
+  teardown = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+  return true;
+}
+
+/* a poll of the hardware driver on an empty fifo, woken up by AL_WAKE_MSG */
+static bool runDriverWake(int rounds, vector<double>& wakes)
+{
+  auto const path = "/tmp/omx_bench_sync." + to_string(getpid());
+
+  if(mkfifo(path.c_str(), 0600) != 0)
+    return false;
+
+  auto driver = AL_GetHardwareDriver();
+  auto fd = AL_Driver_Open(driver, path.c_str());
+  unlink(path.c_str());
+
+  if(fd == -1)
+    return false;
+
+  semaphore polling;
+  semaphore woken;
+  atomic<bool> timedOut(true);
+  chrono::steady_clock::time_point wokenAt;
+
+  thread poller([&]() {
+    for(int round = 0; round < rounds; ++round)
+    {
+      int timeout = -1;
+      polling.notify();
+
+      /* nothing is ever written in the fifo: only the wake up returns */
+      if(AL_Driver_PostMessage(driver, fd, AL_POLL_MSG, &timeout) != DRIVER_TIMEOUT)
+        timedOut = false;
+      wokenAt = chrono::steady_clock::now();
+      woken.notify();
+    }
+  });
+
+  for(int round = 0; round < rounds; ++round)
+  {
+    polling.wait();
+    auto const start = chrono::steady_clock::now();
+
+    if(AL_Driver_PostMessage(driver, fd, AL_WAKE_MSG, nullptr) != DRIVER_SUCCESS)
+      timedOut = false;
+    woken.wait();
+    wakes.push_back(chrono::duration<double, micro>(wokenAt - start).count());
+  }
+
+  poller.join();
+  AL_Driver_Close(driver, fd);
+  return timedOut;
+}
+
+static OMX_ERRORTYPE benchSync(Settings const& settings)
+{
+  static char const* const fbNumbers[] = { "0", "1", "2", "3", "4", "three" };
+  auto failed = false;
+
+  /* the sync ip traces each programmed buffer */
+  for(auto& category : g_Categories)
+    category.second = false;
+
+  for(auto fbNumber : fbNumbers)
+  {
+    setenv("OMX_ALLEGRO_SYNC_FB_NUMBER", fbNumber, 1);
+    auto const value = getFbNumber();
+    auto const isSupported = value >= 1 && value <= MAX_FB_NUMBER;
+    bool accepted;
+
+    try
+    {
+      SyncIp sync(AL_InitDummyDriver(true, 4), "dummy", value);
+      accepted = true;
+    }
+    catch(runtime_error const&)
+    {
+      accepted = false;
+    }
+
+    cout << left << setw(10) << "sync" << "OMX_ALLEGRO_SYNC_FB_NUMBER=" << setw(6) << fbNumber << (accepted ? "accepted" : "rejected") << endl;
+
+    if(accepted != isSupported)
+    {
+      cerr << "[Error] the sync ip " << (accepted ? "accepted" : "rejected") << " " << value << " frame buffers" << endl;
+      failed = true;
+    }
+  }
+
+  unsetenv("OMX_ALLEGRO_SYNC_FB_NUMBER");
+
+  for(int fbNumber = 1; fbNumber <= MAX_FB_NUMBER; ++fbNumber)
+  {
+    vector<double> refills;
+    double teardown;
+
+    if(!runSync(settings, fbNumber, refills, teardown))
+      return OMX_ErrorInsufficientResources;
+
+    sort(refills.begin(), refills.end());
+    cout << left << setw(10) << "sync" << right << fixed << "frame buffers" << setw(2) << fbNumber
+         << "  refill p50" << setw(8) << setprecision(1) << percentile(refills, 50)
+         << " p99" << setw(8) << percentile(refills, 99) << " us"
+         << "  teardown" << setw(10) << teardown << " us" << endl;
+
+    /* without the wake up, the thread only leaves on its 5 seconds poll */
+    if(teardown > 1000000)
+    {
+      cerr << "[Error] the sync ip thread wasn't woken up on destruction" << endl;
+      failed = true;
+    }
+  }
+
+  vector<double> wakes;
+
+  if(!runDriverWake(settings.frames, wakes))
+  {
+    cerr << "[Error] the hardware driver poll wasn't woken up by AL_WAKE_MSG" << endl;
+    return OMX_ErrorUndefined;
+  }
+
+  sort(wakes.begin(), wakes.end());
+  cout << left << setw(10) << "sync" << right << fixed << "driver wake"
+       << "      p50" << setw(8) << setprecision(1) << percentile(wakes, 50)
+       << " p99" << setw(8) << percentile(wakes, 99) << " us" << endl;
+
+  return failed ? OMX_ErrorUndefined : OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE benchReconfigure(Settings const& settings)
+{
+  Bench bench;
+  OMX_CALLBACKTYPE callbacks;
+  callbacks.EventHandler = onComponentEvent;
+  callbacks.EmptyBufferDone = onInputBufferAvailable;
+  callbacks.FillBufferDone = onOutputBufferAvailable;
+
+  unique_ptr<OMX_COMPONENTTYPE> component(new OMX_COMPONENTTYPE());
+  bench.handle = component.get();
+  auto name = settings.hevc ? NULL_HEVC_ENCODER : NULL_AVC_ENCODER;
+  auto role = settings.hevc ? "video_encoder.hevc" : "video_encoder.avc";
+  OMX_CALL(CreateComponent(bench.handle, (OMX_STRING)name, (OMX_STRING)role, &bench, &callbacks));
+  auto scopeHandle = scopeExit([&]() {
+    component->ComponentDeInit(bench.handle);
+  });
+
+  OMX_CALL(configureEncoder(bench, settings));
+
+  auto handle = bench.handle;
+  auto measure = [&](char const* change, function<OMX_ERRORTYPE(int)> apply) -> OMX_ERRORTYPE
+                 {
+                   vector<double> durations(settings.frames);
+                   allocations = 0;
+                   countAllocations = true;
+
+                   for(int i = 0; i < settings.frames; ++i)
+                   {
+                     auto const start = chrono::steady_clock::now();
+                     OMX_CALL(apply(i));
+                     durations[i] = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                   }
+
+                   countAllocations = false;
+                   sort(durations.begin(), durations.end());
+                   cout << left << setw(24) << change << right << fixed << setprecision(0)
+                        << "p50" << setw(8) << percentile(durations, 50)
+                        << " p99" << setw(8) << percentile(durations, 99) << " ns"
+                        << setw(8) << setprecision(1) << (double)allocations / settings.frames << " allocations/change" << endl;
+                   return OMX_ErrorNone;
+                 };
+
+  OMX_CALL(measure("get port definition", [&](int) {
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    initHeader(param);
+    param.nPortIndex = 1;
+    return OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &param);
+  }));
+
+  OMX_CALL(measure("get bitrate", [&](int) {
+    OMX_VIDEO_PARAM_BITRATETYPE bitrate;
+    initHeader(bitrate);
+    bitrate.nPortIndex = 1;
+    return OMX_GetParameter(handle, OMX_IndexParamVideoBitrate, &bitrate);
+  }));
+
+  OMX_CALL(measure("set bitrate", [&](int i) {
+    OMX_VIDEO_PARAM_BITRATETYPE bitrate;
+    initHeader(bitrate);
+    bitrate.nPortIndex = 1;
+    OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamVideoBitrate, &bitrate));
+    bitrate.nTargetBitrate = i % 2 ? 4000000 : 8000000;
+    return OMX_SetParameter(handle, OMX_IndexParamVideoBitrate, &bitrate);
+  }));
+
+  OMX_CALL(measure("set framerate", [&](int i) {
+    OMX_VIDEO_PARAM_PORTFORMATTYPE format;
+    initHeader(format);
+    format.nPortIndex = 0;
+    OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamVideoPortFormat, &format));
+    format.xFramerate = (i % 2 ? 30 : 60) << 16;
+    return OMX_SetParameter(handle, OMX_IndexParamVideoPortFormat, &format);
+  }));
+
+  OMX_CALL(measure("set resolution", [&](int i) {
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    initHeader(param);
+    param.nPortIndex = 0;
+    OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &param));
+    param.format.video.nFrameWidth = param.format.video.nStride = i % 2 ? 1280 : settings.width;
+    param.format.video.nFrameHeight = param.format.video.nSliceHeight = i % 2 ? 720 : (settings.height + 7) & ~7;
+    return OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &param);
+  }));
+
+  OMX_CALL(measure("reapply port definition", [&](int) {
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    initHeader(param);
+    param.nPortIndex = 0;
+    OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &param));
+    return OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &param);
+  }));
+
+  OMX_CALL(measure("reapply bitrate", [&](int) {
+    OMX_VIDEO_PARAM_BITRATETYPE bitrate;
+    initHeader(bitrate);
+    bitrate.nPortIndex = 1;
+    OMX_CALL(OMX_GetParameter(handle, OMX_IndexParamVideoBitrate, &bitrate));
+    return OMX_SetParameter(handle, OMX_IndexParamVideoBitrate, &bitrate);
+  }));
+
+  return OMX_ErrorNone;
+}
+
+/* a frame with the padded stride and slice height of the components: the
+ * rows of a 1080p nv12 frame take more iovecs than IOV_MAX */
+struct PaddedFrame
+{
+  vector<char> buffer;
+  vector<bool> inRows;
+  vector<StridedPlane> planes;
+  size_t frameSize;
+};
+
+static char const framePadding = 0x5a;
+
+static void createPaddedFrame(Settings const& settings, PaddedFrame& frame)
+{
+  auto const stride = (size_t)((settings.width + 255) / 256 * 256);
+  auto const sliceHeight = (size_t)((settings.height + 15) / 16 * 16);
+  frame.buffer.assign(stride * sliceHeight * 3 / 2, framePadding);
+  frame.inRows.assign(frame.buffer.size(), false);
+
+  auto data = frame.buffer.data();
+  frame.planes.clear();
+  frame.planes.push_back({ data, (size_t)settings.width, stride, settings.height });
+  frame.planes.push_back({ data + sliceHeight * stride, (size_t)settings.width, stride, settings.height / 2 });
+  frame.frameSize = 0;
+
+  for(auto& plane : frame.planes)
+  {
+    for(int row = 0; row < plane.rows; ++row)
+    {
+      auto first = (plane.data - data) + row * plane.stride;
+      fill(frame.inRows.begin() + first, frame.inRows.begin() + first + plane.rowSize, true);
+    }
+
+    frame.frameSize += plane.rowSize * plane.rows;
+  }
+}
+
+/* bytes the reads wrote outside the rows */
+static size_t countDirtyPadding(PaddedFrame const& frame)
+{
+  size_t dirty = 0;
+
+  for(size_t i = 0; i < frame.buffer.size(); ++i)
+    dirty += !frame.inRows[i] && frame.buffer[i] != framePadding;
+
+  return dirty;
+}
+
+/* the planes of the first bytes of the frame, the last row cut where they end */
+static vector<StridedPlane> headOfPlanes(vector<StridedPlane> const& planes, size_t bytes)
+{
+  vector<StridedPlane> head;
+
+  for(auto& plane : planes)
+  {
+    auto rows = (int)min<size_t>(plane.rows, bytes / plane.rowSize);
+
+    if(rows)
+      head.push_back({ plane.data, plane.rowSize, plane.stride, rows });
+    bytes -= rows * plane.rowSize;
+
+    if(rows < plane.rows)
+    {
+      if(bytes)
+        head.push_back({ plane.data + rows * plane.stride, bytes, plane.stride, 1 });
+      break;
+    }
+  }
+
+  return head;
+}
+
+static bool readWholeFile(string const& path, vector<char>& data)
+{
+  ifstream file(path, ios::binary);
+  data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+struct RoundTrip
+{
+  int frames;
+  size_t dirtyPadding;
+  double readUs;
+  double writeUs;
+};
+
+/* reads the file into the padded frame and writes its rows back, the way the
+ * applications do with their yuv files */
+static bool roundTrip(string const& source, string const& destination, bool useMmap, PaddedFrame& frame, RoundTrip& trip)
+{
+  InputFile input;
+  OutputFile output;
+
+  if(!input.open(source, useMmap) || !output.open(destination))
+    return false;
+
+  while(!input.isEof())
+  {
+    auto const start = chrono::steady_clock::now();
+    auto const bytes = input.readPlanes(frame.planes);
+    auto const read = chrono::steady_clock::now();
+
+    if(bytes == 0)
+      return false;
+
+    /* a truncated last frame comes back short, cut in the middle of a row */
+    auto const written = bytes < frame.frameSize ? output.writePlanes(headOfPlanes(frame.planes, bytes)) : output.writePlanes(frame.planes);
+    auto const end = chrono::steady_clock::now();
+
+    if(!written)
+      return false;
+
+    trip.readUs += chrono::duration<double, micro>(read - start).count();
+    trip.writeUs += chrono::duration<double, micro>(end - read).count();
+    trip.dirtyPadding += countDirtyPadding(frame);
+    ++trip.frames;
+  }
+
+  return true;
+}
+
+static volatile sig_atomic_t writeInterrupts;
+
+static void onWriteInterrupt(int)
+{
+  ++writeInterrupts;
+}
+
+/* Writes the frames in a fifo drained a page at a time, while a timer keeps
+ * interrupting the writer: the writes that were under way come back short
+ * and have to resume where they stopped */
+static bool writeInterrupted(string const& path, PaddedFrame const& frame, int frames, vector<char>& received)
+{
+  if(mkfifo(path.c_str(), 0600) != 0)
+    return false;
+
+  /* only the writer is interrupted */
+  sigset_t alarm;
+  sigemptyset(&alarm);
+  sigaddset(&alarm, SIGALRM);
+  pthread_sigmask(SIG_BLOCK, &alarm, nullptr);
+
+  thread reader([&]() {
+    auto fd = open(path.c_str(), O_RDONLY);
+
+    if(fd < 0)
+      return;
+
+    fcntl(fd, F_SETPIPE_SZ, 4096);
+    char page[4096];
+    ssize_t bytes;
+
+    while((bytes = read(fd, page, sizeof(page))) != 0)
+    {
+      if(bytes < 0 && errno == EINTR)
+        continue;
+
+      if(bytes < 0)
+        break;
+      received.insert(received.end(), page, page + bytes);
+    }
+
+    close(fd);
+  });
+
+  pthread_sigmask(SIG_UNBLOCK, &alarm, nullptr);
+
+  OutputFile output;
+  auto written = output.open(path);
+  unlink(path.c_str());
+
+  /* no SA_RESTART: the writes are interrupted */
+  struct sigaction action {};
+  struct sigaction previous;
+  action.sa_handler = onWriteInterrupt;
+  sigaction(SIGALRM, &action, &previous);
+  struct itimerval timer {};
+  timer.it_interval.tv_usec = 50;
+  timer.it_value.tv_usec = 50;
+  writeInterrupts = 0;
+  setitimer(ITIMER_REAL, &timer, nullptr);
+
+  for(int i = 0; written && i < frames; ++i)
+    written = output.writePlanes(frame.planes);
+
+  timer = {};
+  setitimer(ITIMER_REAL, &timer, nullptr);
+  sigaction(SIGALRM, &previous, nullptr);
+  output.close();
+  reader.join();
+
+  return written;
+}
+
+static OMX_ERRORTYPE benchFileIo(Settings const& settings)
+{
+  static int const fileFrames = 8;
+  auto const base = "/tmp/omx_bench_file_io." + to_string(getpid());
+  auto const source = base + ".yuv";
+  auto const destination = base + ".out";
+  auto failed = false;
+
+  PaddedFrame frame;
+  createPaddedFrame(settings, frame);
+
+  /* the last frame stops in the middle of a chroma row */
+  vector<char> data(fileFrames * frame.frameSize + frame.frameSize * 3 / 4 + 7);
+
+  for(size_t i = 0; i < data.size(); ++i)
+    data[i] = (char)((i * 2654435761u) >> 24);
+
+  OutputFile sourceFile;
+
+  if(!sourceFile.open(source) || !sourceFile.write(data.data(), data.size()))
+    return OMX_ErrorInsufficientResources;
+  sourceFile.close();
+
+  auto const rounds = max(1, settings.frames / fileFrames);
+
+  for(auto useMmap : { false, true })
+  {
+    RoundTrip trip {};
+    vector<char> copy;
+
+    for(int round = 0; round < rounds; ++round)
+    {
+      if(!roundTrip(source, destination, useMmap, frame, trip))
+      {
+        cerr << "[Error] the " << (useMmap ? "mmap" : "preadv") << " round trip failed" << endl;
+        failed = true;
+        break;
+      }
+    }
+
+    if(!readWholeFile(destination, copy) || copy != data)
+    {
+      cerr << "[Error] the " << (useMmap ? "mmap" : "preadv") << " round trip didn't give the file back" << endl;
+      failed = true;
+    }
+
+    if(trip.dirtyPadding)
+    {
+      cerr << "[Error] the " << (useMmap ? "mmap" : "preadv") << " reads wrote " << trip.dirtyPadding << " bytes of padding" << endl;
+      failed = true;
+    }
+
+    cout << left << setw(10) << "file io" << setw(8) << (useMmap ? "mmap" : "preadv") << right << fixed
+         << setw(6) << trip.frames << " frames  read" << setw(8) << setprecision(1) << trip.readUs / max(trip.frames, 1) << " us/frame"
+         << "  write" << setw(8) << trip.writeUs / max(trip.frames, 1) << " us/frame" << endl;
+  }
+
+  unlink(source.c_str());
+  unlink(destination.c_str());
+
+  vector<char> received;
+  auto const fifoFrames = 4;
+
+  if(!writeInterrupted(base + ".fifo", frame, fifoFrames, received))
+  {
+    cerr << "[Error] the interrupted writes failed" << endl;
+    failed = true;
+  }
+
+  auto expected = true;
+
+  for(int i = 0; i < fifoFrames && expected; ++i)
+  {
+    auto offset = i * frame.frameSize;
+
+    for(auto& plane : frame.planes)
+    {
+      for(int row = 0; row < plane.rows && expected; ++row, offset += plane.rowSize)
+        expected = offset + plane.rowSize <= received.size() && !memcmp(&received[offset], plane.data + row * plane.stride, plane.rowSize);
+    }
+  }
+
+  if(!expected || received.size() != fifoFrames * frame.frameSize)
+  {
+    cerr << "[Error] the interrupted writes didn't resume where they stopped" << endl;
+    failed = true;
+  }
+
+  cout << left << setw(10) << "file io" << setw(8) << "fifo" << right
+       << setw(6) << fifoFrames << " frames  written through " << writeInterrupts << " interrupts" << endl;
+
+  return failed ? OMX_ErrorUndefined : OMX_ErrorNone;
+}
+
+static void Usage(CommandLineParser& opt, char* ExeName)
+{
+  cerr << "Usage: " << ExeName << " [options]" << endl;
+  cerr << "Options:" << endl;
+
+  for(auto& command: opt.displayOrder)
+    cerr << "  " << opt.descs[command] << endl;
+}
+
+static void parseCommandLine(int argc, char** argv, Settings& settings)
+{
+  bool help = false;
+  bool encoderOnly = false;
+  bool decoderOnly = false;
+
+  auto opt = CommandLineParser();
+  opt.addFlag("--help", &help, "Show this help");
+  opt.addInt("--frames", &settings.frames, "Number of buffers to pump through each component ('1000')");
+  opt.addInt("--warmup", &settings.warmup, "Number of buffers sent before counting the allocations ('100')");
+  opt.addInt("--width", &settings.width, "Picture width ('1920')");
+  opt.addInt("--height", &settings.height, "Picture height ('1080')");
+  opt.addInt("--payload", &payloadSize, "Size in bytes of each compressed frame ('4096')");
+  opt.addInt("--subframe", &settings.subframe, "<4 || 8 || 16>: give the encoded frames back slice by slice ('0')");
+  opt.addInt("--frame-time", &frameDuration, "Time in microseconds the null encoder takes per frame, spread over its slices. Frames are then sent at 60 fps ('0')");
+  opt.addInt("--lookahead", &settings.lookahead, "Depth of the lookahead pass of the encoder ('0')");
+  opt.addFlag("--early-start", &settings.earlyStart, "Encode the first frames before the lookahead window is full");
+  opt.addFlag("--lookahead-fifo", &settings.lookaheadFifo, "Only time the lookahead fifo, for a range of depths");
+  opt.addFlag("--handoff", &settings.handoff, "Only time the hand-offs between the processors of 1 to 32 components, --frames times each");
+  opt.addInt("--workers", &settings.workers, "Number of workers of the shared executor with --handoff ('4')");
+  opt.addFlag("--sync", &settings.sync, "Only check the frame buffer numbers of the sync ip and time its channels on the dummy driver, --frames times each");
+  opt.addFlag("--map-contention", &settings.mapContention, "Only time the buffer maps of the modules used by 1 to 8 threads at once, --frames times each");
+  opt.addFlag("--file-io", &settings.fileIo, "Only check and time the strided reads and writes of yuv files, with preadv and with mmap, about --frames frames each");
+  opt.addFlag("--use-buffer", &settings.useBuffer, "Give the decoder output buffers of the application, which it copies each frame to");
+  opt.addFlag("--reconfigure", &settings.reconfigure, "Only time the parameter changes of a loaded encoder, --frames times each");
+  opt.addFlag("--hevc", &settings.hevc, "Benchmark the hevc encoder instead of the avc one (the decoder is always fed avc)");
+  opt.addFlag("--enc-only", &encoderOnly, "Only benchmark the encoder");
+  opt.addFlag("--dec-only", &decoderOnly, "Only benchmark the decoder");
+
+  opt.parse(argc, argv);
+
+  if(help)
+  {
+    Usage(opt, argv[0]);
+    exit(0);
+  }
+
+  if(settings.frames <= 0 || settings.width <= 0 || settings.height <= 0 || payloadSize <= 0)
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] frames, dimensions and payload have to be positive" << endl;
+    exit(1);
+  }
+
+  if(settings.warmup < 0 || settings.warmup >= settings.frames)
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] warmup has to leave some of the frames to count" << endl;
+    exit(1);
+  }
+
+  if(settings.workers <= 0)
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] the executor needs at least one worker" << endl;
+    exit(1);
+  }
+
+  if(settings.lookahead < 0)
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] lookahead can't be negative" << endl;
+    exit(1);
+  }
+
+  if(!(settings.subframe == 0 || settings.subframe == 4 || settings.subframe == 8 || settings.subframe == 16) || frameDuration < 0 || frameDuration >= 1000000 / framerate)
+  {
+    Usage(opt, argv[0]);
+    cerr << "[Error] subframe parameter or frame time was incorrectly set (the frame time has to fit in a frame period)" << endl;
+    exit(1);
+  }
+
+  settings.encoder = !decoderOnly;
+  settings.decoder = !encoderOnly;
+}
+
+/* once warm, a buffer going through a component is expected not to reach the heap */
+static bool isAllocationFree(char const* name, Result const& result)
+{
+  if(result.allocations == 0)
+    return true;
+
+  cerr << "[Error] the " << name << " allocated " << result.allocations << " times over its last " << result.warmBuffers << " buffers" << endl;
+  return false;
+}
+
+static OMX_ERRORTYPE safeMain(int argc, char** argv)
+{
+  Settings settings;
+  settings.frames = 1000;
+  settings.warmup = 100;
+  settings.width = 1920;
+  settings.height = 1080;
+  settings.subframe = 0;
+  settings.lookahead = 0;
+  settings.earlyStart = false;
+  settings.lookaheadFifo = false;
+  settings.handoff = false;
+  settings.workers = 4;
+  settings.mapContention = false;
+  settings.sync = false;
+  settings.reconfigure = false;
+  settings.fileIo = false;
+  settings.useBuffer = false;
+  settings.hevc = false;
+  parseCommandLine(argc, argv, settings);
+
+  if(settings.lookaheadFifo)
+  {
+    benchLookAheadFifo(settings);
+    return OMX_ErrorNone;
+  }
+
+  if(settings.handoff)
+  {
+    benchHandOff(settings);
+    return OMX_ErrorNone;
+  }
+
+  if(settings.mapContention)
+  {
+    benchMapContention(settings);
+    return OMX_ErrorNone;
+  }
+
+  if(settings.sync)
+    return benchSync(settings);
+
+  if(settings.reconfigure)
+    return benchReconfigure(settings);
+
+  if(settings.fileIo)
+    return benchFileIo(settings);
+
+  auto allocationFree = true;
+
+  if(settings.encoder)
+  {
+    Result result {};
+    auto name = settings.hevc ? NULL_HEVC_ENCODER : NULL_AVC_ENCODER;
+    auto role = settings.hevc ? "video_encoder.hevc" : "video_encoder.avc";
+    OMX_CALL(run(name, role, settings, configureEncoder, fillEncoderInput, result));
+    report("encoder", result, settings);
+    allocationFree &= isAllocationFree("encoder", result);
+  }
+
+  if(settings.decoder)
+  {
+    auto const accessUnits = generateAvcStream(settings);
+    auto fillDecoderInput = [&](OMX_BUFFERHEADERTYPE* header, int frame) {
+                              auto const& au = accessUnits[frame];
+
+                              if(au.size() > header->nAllocLen)
+                                return false;
+                              memcpy(header->pBuffer, au.data(), au.size());
+                              header->nOffset = 0;
+                              header->nFilledLen = au.size();
+                              header->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+                              return true;
+                            };
+
+    Result result {};
+    OMX_CALL(run(NULL_AVC_DECODER, "video_decoder.avc", settings, configureDecoder, fillDecoderInput, result));
+    report("decoder", result, settings);
+
+    /* a copied output is decoded in a frame buffer created on each fill */
+    if(!settings.useBuffer)
+      allocationFree &= isAllocationFree("decoder", result);
+  }
+
+  return allocationFree ? OMX_ErrorNone : OMX_ErrorUndefined;
+}
+
+int main(int argc, char** argv)
+{
+  try
+  {
+    auto ret = safeMain(argc, argv);
+
+    if(ret != OMX_ErrorNone)
+    {
+      cerr << "Benchmark failed with error 0x" << hex << ret << endl;
+      return 1;
+    }
+  }
+  catch(runtime_error const& error)
+  {
+    cerr << endl << "Exception caught: " << error.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
+
@@ -0,0 +1,264 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#include "file_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* one iovec per row, the contiguous rows are merged together */
+static void buildIovecs(std::vector<StridedPlane> const& planes, std::vector<struct iovec>& iovecs)
+{
+  iovecs.clear();
+
+  for(auto& plane : planes)
+  {
+    for(int row = 0; row < plane.rows; ++row)
+    {
+      auto data = plane.data + row * plane.stride;
+
+      if(!iovecs.empty() && (char*)iovecs.back().iov_base + iovecs.back().iov_len == data)
+      {
+        iovecs.back().iov_len += plane.rowSize;
+        continue;
+      }
+
+      iovecs.push_back({ data, plane.rowSize });
+    }
+  }
+}
+
+/* calls transfer on IOV_MAX iovecs at most, until all the iovecs are done
+ * or transfer stops making progress. Returns the number of bytes transferred */
+template<typename Transfer>
+static size_t transferIovecs(std::vector<struct iovec>& iovecs, Transfer transfer)
+{
+  size_t total = 0;
+  size_t first = 0;
+
+  while(first < iovecs.size())
+  {
+    auto count = std::min<size_t>(iovecs.size() - first, IOV_MAX);
+    auto done = transfer(&iovecs[first], (int)count, total);
+
+    if(done < 0 && errno == EINTR)
+      continue;
+
+    if(done <= 0)
+      break;
+
+    total += done;
+
+    while(first < iovecs.size() && (size_t)done >= iovecs[first].iov_len)
+    {
+      done -= iovecs[first].iov_len;
+      ++first;
+    }
+
+    if(done)
+    {
+      iovecs[first].iov_base = (char*)iovecs[first].iov_base + done;
+      iovecs[first].iov_len -= done;
+    }
+  }
+
+  return total;
+}
+
+InputFile::~InputFile()
+{
+  close();
+}
+
+bool InputFile::open(std::string const& path, bool useMmap)
+{
+  close();
+  fd = ::open(path.c_str(), O_RDONLY);
+
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+
+  if(fstat(fd, &st) != 0)
+  {
+    close();
+    return false;
+  }
+
+  size = st.st_size;
+  offset = 0;
+
+  if(useMmap && size > 0)
+  {
+    auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if(mapped == MAP_FAILED)
+    {
+      close();
+      return false;
+    }
+    map = (char*)mapped;
+    madvise(map, size, MADV_SEQUENTIAL);
+  }
+  else
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  return true;
+}
+
+void InputFile::close()
+{
+  if(map)
+    munmap(map, size);
+  map = nullptr;
+
+  if(fd >= 0)
+    ::close(fd);
+  fd = -1;
+}
+
+bool InputFile::isOpen() const
+{
+  return fd >= 0;
+}
+
+bool InputFile::isEof() const
+{
+  return offset >= size;
+}
+
+size_t InputFile::read(char* data, size_t bytes)
+{
+  iovecs.clear();
+  iovecs.push_back({ data, bytes });
+  return readIovecs();
+}
+
+size_t InputFile::readPlanes(std::vector<StridedPlane> const& planes)
+{
+  buildIovecs(planes, iovecs);
+  return readIovecs();
+}
+
+size_t InputFile::readIovecs()
+{
+  size_t total;
+
+  if(map)
+  {
+    total = 0;
+
+    for(auto& iov : iovecs)
+    {
+      auto len = std::min<size_t>(iov.iov_len, size - (offset + total));
+      memcpy(iov.iov_base, map + offset + total, len);
+      total += len;
+
+      if(len < iov.iov_len)
+        break;
+    }
+  }
+  else
+  {
+    total = transferIovecs(iovecs, [&](struct iovec const* iov, int count, size_t done)
+    {
+      return preadv(fd, iov, count, offset + done);
+    });
+  }
+
+  offset += total;
+  return total;
+}
+
+OutputFile::~OutputFile()
+{
+  close();
+}
+
+bool OutputFile::open(std::string const& path)
+{
+  close();
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  return fd >= 0;
+}
+
+void OutputFile::close()
+{
+  if(fd >= 0)
+    ::close(fd);
+  fd = -1;
+}
+
+bool OutputFile::isOpen() const
+{
+  return fd >= 0;
+}
+
+bool OutputFile::write(char const* data, size_t size)
+{
+  iovecs.clear();
+  iovecs.push_back({ const_cast<char*>(data), size });
+  return writeIovecs();
+}
+
+bool OutputFile::writePlanes(std::vector<StridedPlane> const& planes)
+{
+  buildIovecs(planes, iovecs);
+  return writeIovecs();
+}
+
+bool OutputFile::writeIovecs()
+{
+  size_t expected = 0;
+
+  for(auto& iov : iovecs)
+    expected += iov.iov_len;
+
+  auto written = transferIovecs(iovecs, [&](struct iovec const* iov, int count, size_t)
+  {
+    return writev(fd, iov, count);
+  });
+
+  return written == expected;
+}
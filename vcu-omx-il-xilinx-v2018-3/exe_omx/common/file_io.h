@@ -0,0 +1,106 @@
+/******************************************************************************
+*
+* Copyright (C) 2018 Allegro DVT2.  All rights reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* Use of the Software is limited solely to applications:
+* (a) running on a Xilinx device, or
+* (b) that interact with a Xilinx device through a bus or interconnect.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+* XILINX OR ALLEGRO DVT2 BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+* OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*
+* Except as contained in this notice, the name of  Xilinx shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Xilinx.
+*
+*
+* Except as contained in this notice, the name of Allegro DVT2 shall not be used
+* in advertising or otherwise to promote the sale, use or other dealings in
+* this Software without prior written authorization from Allegro DVT2.
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* rows of rowSize bytes, stride bytes apart */
+struct StridedPlane
+{
+  char* data;
+  size_t rowSize;
+  size_t stride;
+  int rows;
+};
+
+/* Reads a file straight into the (strided) buffers of the components,
+ * with a preadv per buffer, or a copy from the mapped file */
+class InputFile
+{
+public:
+  InputFile() = default;
+  ~InputFile();
+  InputFile(InputFile const &) = delete;
+  InputFile & operator = (InputFile const &) = delete;
+
+  bool open(std::string const& path, bool useMmap);
+  void close();
+  bool isOpen() const;
+  bool isEof() const;
+
+  /* returns the number of bytes read, less than asked at the end of the file */
+  size_t read(char* data, size_t bytes);
+  size_t readPlanes(std::vector<StridedPlane> const& planes);
+
+private:
+  size_t readIovecs();
+
+  int fd = -1;
+  off_t offset = 0;
+  off_t size = 0;
+  char* map = nullptr;
+  std::vector<struct iovec> iovecs {};
+};
+
+/* Writes the (strided) buffers of the components with a writev per buffer */
+class OutputFile
+{
+public:
+  OutputFile() = default;
+  ~OutputFile();
+  OutputFile(OutputFile const &) = delete;
+  OutputFile & operator = (OutputFile const &) = delete;
+
+  bool open(std::string const& path);
+  void close();
+  bool isOpen() const;
+
+  /* returns false if the data couldn't be written entirely */
+  bool write(char const* data, size_t size);
+  bool writePlanes(std::vector<StridedPlane> const& planes);
+
+private:
+  bool writeIovecs();
+
+  int fd = -1;
+  std::vector<struct iovec> iovecs {};
+};
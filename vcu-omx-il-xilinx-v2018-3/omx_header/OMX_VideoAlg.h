@@ -270,6 +270,8 @@ typedef struct OMX_ALG_VIDEO_PARAM_SLICES
  *  nVersion         		          : OMX specification version information
  *  nPortIndex       		          : Port that this structure applies to
  *  nLookAhead                    : Indicate the Lookahead size, disabled if 0
+ *  bEnableEarlyStart             : If enabled, the first frames are encoded before
+ *                                  the lookahead is full, with a window growing up to nLookAhead
  */
 typedef struct OMX_ALG_VIDEO_PARAM_LOOKAHEAD
 {
@@ -277,6 +279,7 @@ typedef struct OMX_ALG_VIDEO_PARAM_LOOKAHEAD
   OMX_VERSIONTYPE nVersion;
   OMX_U32 nPortIndex;
   OMX_U32 nLookAhead;
+  OMX_BOOL bEnableEarlyStart;
 }OMX_ALG_VIDEO_PARAM_LOOKAHEAD;
 
 /**
@@ -719,6 +722,31 @@ typedef struct OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE
   OMX_U32 nLookAhead;
 }OMX_ALG_VIDEO_CONFIG_NOTIFY_SCENE_CHANGE;
 
+/**
+ * Structure for reading the latency of the first slice of the frames: the
+ * time between a frame being emptied and its first output buffer being
+ * filled. Read only. Without subframe, the first buffer holds the whole frame
+ *
+ * STRUCT MEMBERS:
+ *  nSize        : Size of the structure in bytes
+ *  nVersion     : OMX specification version information
+ *  nPortIndex   : Port that this structure applies to
+ *  nFrames      : Number of frames measured since the component started
+ *  nLastLatency : Latency of the last measured frame, in microseconds
+ *  nMeanLatency : Mean latency of the measured frames, in microseconds
+ *  nMaxLatency  : Max latency of the measured frames, in microseconds
+ */
+typedef struct OMX_ALG_VIDEO_CONFIG_SUBFRAME_LATENCY
+{
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nFrames;
+  OMX_U32 nLastLatency;
+  OMX_U32 nMeanLatency;
+  OMX_U32 nMaxLatency;
+}OMX_ALG_VIDEO_CONFIG_SUBFRAME_LATENCY;
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */